@@ -0,0 +1,546 @@
+/*
+ * CompressedVolume.cpp - Methods for CompressedVolume class.
+ *
+ * Author: Patrick O'Leary
+ * Created: October 19, 2026
+ * Copyright 2007. All rights reserved.
+ */
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <pthread.h>
+
+/* Vrui includes */
+#include <Misc/Timer.h>
+
+#include <DATA/CompressedVolume.h>
+#include <DATA/ValueMask.h>
+
+/*
+ * CompressedVolume - Constructor for CompressedVolume class.
+ */
+CompressedVolume::CompressedVolume(void) :
+    bits(NULL), data(NULL), dataSize(0), maximums(NULL), minimums(NULL), numberOfBlocks(0), offsets(NULL) {
+    for (int i = 0; i < 3; i++) {
+        blocks[i] = 0;
+        size[i] = 0;
+    } // end for
+} // end CompressedVolume()
+
+/*
+ * ~CompressedVolume - Destructor for CompressedVolume class.
+ */
+CompressedVolume::~CompressedVolume(void) {
+    clear();
+} // end ~CompressedVolume()
+
+/*
+ * accumulate - Sum a lookup table over a region, collapsing uniform and fully transparent blocks.
+ *
+ * parameter column - int
+ * parameter row - int
+ * parameter slab - int
+ * parameter width - int
+ * parameter height - int
+ * parameter depth - int
+ * parameter table - const float*
+ * parameter sum - float&
+ * parameter zeros - float&
+ */
+void CompressedVolume::accumulate(int column, int row, int slab, int width, int height, int depth, const float* table,
+        float& sum, float& zeros) const {
+    sum = 0.0f;
+    zeros = 0.0f;
+    for (int bz = slab / BLOCK_SIZE; bz <= (slab + depth - 1) / BLOCK_SIZE; bz++) {
+        int z0 = std::max(slab, bz * BLOCK_SIZE);
+        int z1 = std::min(slab + depth, bz * BLOCK_SIZE + getBlockExtent(bz, 2));
+        for (int by = row / BLOCK_SIZE; by <= (row + height - 1) / BLOCK_SIZE; by++) {
+            int y0 = std::max(row, by * BLOCK_SIZE);
+            int y1 = std::min(row + height, by * BLOCK_SIZE + getBlockExtent(by, 1));
+            for (int bx = column / BLOCK_SIZE; bx <= (column + width - 1) / BLOCK_SIZE; bx++) {
+                int x0 = std::max(column, bx * BLOCK_SIZE);
+                int x1 = std::min(column + width, bx * BLOCK_SIZE + getBlockExtent(bx, 0));
+                int block = (bz * blocks[1] + by) * blocks[0] + bx;
+                float count = float((x1 - x0) * (y1 - y0) * (z1 - z0));
+                bool transparent = true;
+                for (int value = minimums[block]; value <= maximums[block] && transparent; value++) {
+                    if (table[value] != 0.0f)
+                        transparent = false;
+                } // end for
+                if (transparent) {
+                    zeros += count;
+                } else if (bits[block] == 0) {
+                    sum += count * table[minimums[block]];
+                } else {
+                    int bw = getBlockExtent(bx, 0);
+                    int bh = getBlockExtent(by, 1);
+                    for (int k = z0; k < z1; k++) {
+                        for (int j = y0; j < y1; j++) {
+                            for (int i = x0; i < x1; i++) {
+                                float value = table[unpack(block, ((k - bz * BLOCK_SIZE) * bh + (j - by * BLOCK_SIZE)) * bw
+                                        + (i - bx * BLOCK_SIZE))];
+                                sum += value;
+                                if (value == 0.0f)
+                                    zeros += 1.0f;
+                            } // end for
+                        } // end for
+                    } // end for
+                }
+            } // end for
+        } // end for
+    } // end for
+} // end accumulate()
+
+/*
+ * benchmark - Report the decode throughput of the whole volume for 1, 2, 4, ... threads.
+ *
+ * parameter numberOfThreads - int
+ * parameter numberOfIterations - int
+ */
+void CompressedVolume::benchmark(int numberOfThreads, int numberOfIterations) const {
+    unsigned char* voxels = new unsigned char[getUncompressedSize()];
+    std::cout << "Compressed volume: " << getUncompressedSize() << " bytes -> " << getCompressedSize() << " bytes ("
+            << float(getUncompressedSize()) / float(getCompressedSize()) << ":1)" << std::endl;
+    for (int threads = 1; threads <= numberOfThreads; threads *= 2) {
+        Misc::Timer timer;
+        for (int iteration = 0; iteration < numberOfIterations; iteration++) {
+            decode(0, 0, 0, size[0], size[1], size[2], voxels, size[0], size[0] * size[1], threads);
+        } // end for
+        timer.elapse();
+        double megaBytes = double(getUncompressedSize()) * double(numberOfIterations) / (1024.0 * 1024.0);
+        std::cout << "Decode throughput (" << threads << " threads): " << megaBytes / timer.getTime() << " MB/s" << std::endl;
+    } // end for
+    delete[] voxels;
+} // end benchmark()
+
+/*
+ * calculateMaximum
+ *
+ * parameter column - int
+ * parameter row - int
+ * parameter slab - int
+ * parameter width - int
+ * parameter height - int
+ * parameter depth - int
+ * return - int
+ */
+int CompressedVolume::calculateMaximum(int column, int row, int slab, int width, int height, int depth) const {
+    int maximum = 0;
+    for (int bz = slab / BLOCK_SIZE; bz <= (slab + depth - 1) / BLOCK_SIZE; bz++) {
+        int z0 = std::max(slab, bz * BLOCK_SIZE);
+        int z1 = std::min(slab + depth, bz * BLOCK_SIZE + getBlockExtent(bz, 2));
+        for (int by = row / BLOCK_SIZE; by <= (row + height - 1) / BLOCK_SIZE; by++) {
+            int y0 = std::max(row, by * BLOCK_SIZE);
+            int y1 = std::min(row + height, by * BLOCK_SIZE + getBlockExtent(by, 1));
+            for (int bx = column / BLOCK_SIZE; bx <= (column + width - 1) / BLOCK_SIZE; bx++) {
+                int x0 = std::max(column, bx * BLOCK_SIZE);
+                int x1 = std::min(column + width, bx * BLOCK_SIZE + getBlockExtent(bx, 0));
+                int block = (bz * blocks[1] + by) * blocks[0] + bx;
+                if (maximums[block] <= maximum)
+                    continue;
+                int bw = getBlockExtent(bx, 0);
+                int bh = getBlockExtent(by, 1);
+                bool covered = (x1 - x0 == bw) && (y1 - y0 == bh) && (z1 - z0 == getBlockExtent(bz, 2));
+                if (covered || bits[block] == 0) {
+                    maximum = maximums[block];
+                } else {
+                    for (int k = z0; k < z1; k++) {
+                        for (int j = y0; j < y1; j++) {
+                            for (int i = x0; i < x1; i++) {
+                                int tmp = minimums[block] + unpack(block, ((k - bz * BLOCK_SIZE) * bh + (j - by
+                                        * BLOCK_SIZE)) * bw + (i - bx * BLOCK_SIZE));
+                                if (maximum < tmp) {
+                                    maximum = tmp;
+                                } // end if
+                            } // end for
+                        } // end for
+                    } // end for
+                }
+            } // end for
+        } // end for
+    } // end for
+    return maximum;
+} // end calculateMaximum()
+
+/*
+ * calculateMinimum
+ *
+ * parameter column - int
+ * parameter row - int
+ * parameter slab - int
+ * parameter width - int
+ * parameter height - int
+ * parameter depth - int
+ * return - int
+ */
+int CompressedVolume::calculateMinimum(int column, int row, int slab, int width, int height, int depth) const {
+    int minimum = 255;
+    for (int bz = slab / BLOCK_SIZE; bz <= (slab + depth - 1) / BLOCK_SIZE; bz++) {
+        int z0 = std::max(slab, bz * BLOCK_SIZE);
+        int z1 = std::min(slab + depth, bz * BLOCK_SIZE + getBlockExtent(bz, 2));
+        for (int by = row / BLOCK_SIZE; by <= (row + height - 1) / BLOCK_SIZE; by++) {
+            int y0 = std::max(row, by * BLOCK_SIZE);
+            int y1 = std::min(row + height, by * BLOCK_SIZE + getBlockExtent(by, 1));
+            for (int bx = column / BLOCK_SIZE; bx <= (column + width - 1) / BLOCK_SIZE; bx++) {
+                int x0 = std::max(column, bx * BLOCK_SIZE);
+                int x1 = std::min(column + width, bx * BLOCK_SIZE + getBlockExtent(bx, 0));
+                int block = (bz * blocks[1] + by) * blocks[0] + bx;
+                if (minimums[block] >= minimum)
+                    continue;
+                int bw = getBlockExtent(bx, 0);
+                int bh = getBlockExtent(by, 1);
+                bool covered = (x1 - x0 == bw) && (y1 - y0 == bh) && (z1 - z0 == getBlockExtent(bz, 2));
+                if (covered || bits[block] == 0) {
+                    minimum = minimums[block];
+                } else {
+                    for (int k = z0; k < z1; k++) {
+                        for (int j = y0; j < y1; j++) {
+                            for (int i = x0; i < x1; i++) {
+                                int tmp = minimums[block] + unpack(block, ((k - bz * BLOCK_SIZE) * bh + (j - by
+                                        * BLOCK_SIZE)) * bw + (i - bx * BLOCK_SIZE));
+                                if (minimum > tmp) {
+                                    minimum = tmp;
+                                } // end if
+                            } // end for
+                        } // end for
+                    } // end for
+                }
+            } // end for
+        } // end for
+    } // end for
+    return minimum;
+} // end calculateMinimum()
+
+/*
+ * calculateValueMask - Value bins of the voxels in a region, see ValueMask.h.
+ *
+ * A block the region covers, or a uniform one, contributes the bins of its value range
+ * without being unpacked.
+ *
+ * parameter column - int
+ * parameter row - int
+ * parameter slab - int
+ * parameter width - int
+ * parameter height - int
+ * parameter depth - int
+ * return - unsigned int
+ */
+unsigned int CompressedVolume::calculateValueMask(int column, int row, int slab, int width, int height, int depth) const {
+    unsigned int valueMask = 0;
+    for (int bz = slab / BLOCK_SIZE; bz <= (slab + depth - 1) / BLOCK_SIZE; bz++) {
+        int z0 = std::max(slab, bz * BLOCK_SIZE);
+        int z1 = std::min(slab + depth, bz * BLOCK_SIZE + getBlockExtent(bz, 2));
+        for (int by = row / BLOCK_SIZE; by <= (row + height - 1) / BLOCK_SIZE; by++) {
+            int y0 = std::max(row, by * BLOCK_SIZE);
+            int y1 = std::min(row + height, by * BLOCK_SIZE + getBlockExtent(by, 1));
+            for (int bx = column / BLOCK_SIZE; bx <= (column + width - 1) / BLOCK_SIZE; bx++) {
+                int x0 = std::max(column, bx * BLOCK_SIZE);
+                int x1 = std::min(column + width, bx * BLOCK_SIZE + getBlockExtent(bx, 0));
+                int block = (bz * blocks[1] + by) * blocks[0] + bx;
+                unsigned int blockMask = VALUE_RANGE_MASK(minimums[block], maximums[block]);
+                if ((valueMask & blockMask) == blockMask)
+                    continue;
+                int bw = getBlockExtent(bx, 0);
+                int bh = getBlockExtent(by, 1);
+                bool covered = (x1 - x0 == bw) && (y1 - y0 == bh) && (z1 - z0 == getBlockExtent(bz, 2));
+                if (covered || bits[block] == 0) {
+                    valueMask |= blockMask;
+                } else {
+                    for (int k = z0; k < z1; k++) {
+                        for (int j = y0; j < y1; j++) {
+                            for (int i = x0; i < x1; i++) {
+                                valueMask |= VALUE_BIT(minimums[block] + unpack(block, ((k - bz * BLOCK_SIZE) * bh + (j - by
+                                        * BLOCK_SIZE)) * bw + (i - bx * BLOCK_SIZE)));
+                            } // end for
+                        } // end for
+                    } // end for
+                }
+            } // end for
+        } // end for
+    } // end for
+    return valueMask;
+} // end calculateValueMask()
+
+/*
+ * compress - Encode a width x height x depth byte volume (x fastest).
+ *
+ * parameter voxels - const unsigned char*
+ * parameter width - int
+ * parameter height - int
+ * parameter depth - int
+ */
+void CompressedVolume::compress(const unsigned char* voxels, int width, int height, int depth) {
+    clear();
+    size[0] = width;
+    size[1] = height;
+    size[2] = depth;
+    for (int i = 0; i < 3; i++) {
+        blocks[i] = (size[i] + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    } // end for
+    numberOfBlocks = blocks[0] * blocks[1] * blocks[2];
+    bits = new unsigned char[numberOfBlocks];
+    maximums = new unsigned char[numberOfBlocks];
+    minimums = new unsigned char[numberOfBlocks];
+    offsets = new size_t[numberOfBlocks];
+    /* First pass: block ranges and packed sizes */
+    dataSize = 0;
+    for (int bz = 0; bz < blocks[2]; bz++) {
+        for (int by = 0; by < blocks[1]; by++) {
+            for (int bx = 0; bx < blocks[0]; bx++) {
+                int block = (bz * blocks[1] + by) * blocks[0] + bx;
+                int bw = getBlockExtent(bx, 0);
+                int bh = getBlockExtent(by, 1);
+                int bd = getBlockExtent(bz, 2);
+                int minimum = 255;
+                int maximum = 0;
+                for (int k = 0; k < bd; k++) {
+                    for (int j = 0; j < bh; j++) {
+                        const unsigned char* line = voxels + ((bz * BLOCK_SIZE + k) * height + (by * BLOCK_SIZE + j))
+                                * width + bx * BLOCK_SIZE;
+                        for (int i = 0; i < bw; i++) {
+                            if (minimum > line[i])
+                                minimum = line[i];
+                            if (maximum < line[i])
+                                maximum = line[i];
+                        } // end for
+                    } // end for
+                } // end for
+                int numberOfBits = 0;
+                while ((maximum - minimum) >> numberOfBits)
+                    numberOfBits++;
+                minimums[block] = (unsigned char) minimum;
+                maximums[block] = (unsigned char) maximum;
+                bits[block] = (unsigned char) numberOfBits;
+                offsets[block] = dataSize;
+                dataSize += (size_t(bw * bh * bd) * numberOfBits + 7) / 8;
+            } // end for
+        } // end for
+    } // end for
+    /* Second pass: pack the non-uniform blocks; one spare byte lets unpack() always read two bytes */
+    data = new unsigned char[dataSize + 1];
+    memset(data, 0, dataSize + 1);
+    for (int bz = 0; bz < blocks[2]; bz++) {
+        for (int by = 0; by < blocks[1]; by++) {
+            for (int bx = 0; bx < blocks[0]; bx++) {
+                int block = (bz * blocks[1] + by) * blocks[0] + bx;
+                if (bits[block] == 0)
+                    continue;
+                int bw = getBlockExtent(bx, 0);
+                int bh = getBlockExtent(by, 1);
+                int bd = getBlockExtent(bz, 2);
+                unsigned char* packed = data + offsets[block];
+                int index = 0;
+                for (int k = 0; k < bd; k++) {
+                    for (int j = 0; j < bh; j++) {
+                        const unsigned char* line = voxels + ((bz * BLOCK_SIZE + k) * height + (by * BLOCK_SIZE + j))
+                                * width + bx * BLOCK_SIZE;
+                        for (int i = 0; i < bw; i++, index++) {
+                            int position = index * bits[block];
+                            unsigned int value = (unsigned int) (line[i] - minimums[block]) << (position & 7);
+                            packed[position >> 3] |= (unsigned char) (value & 0xff);
+                            packed[(position >> 3) + 1] |= (unsigned char) (value >> 8);
+                        } // end for
+                    } // end for
+                } // end for
+            } // end for
+        } // end for
+    } // end for
+} // end compress()
+
+/*
+ * decode - Decode a region into a caller supplied buffer.
+ *
+ * parameter column - int
+ * parameter row - int
+ * parameter slab - int
+ * parameter width - int
+ * parameter height - int
+ * parameter depth - int
+ * parameter voxels - unsigned char*
+ * parameter rowPitch - int
+ * parameter slicePitch - int
+ */
+void CompressedVolume::decode(int column, int row, int slab, int width, int height, int depth, unsigned char* voxels,
+        int rowPitch, int slicePitch) const {
+    for (int bz = slab / BLOCK_SIZE; bz <= (slab + depth - 1) / BLOCK_SIZE; bz++) {
+        int z0 = std::max(slab, bz * BLOCK_SIZE);
+        int z1 = std::min(slab + depth, bz * BLOCK_SIZE + getBlockExtent(bz, 2));
+        for (int by = row / BLOCK_SIZE; by <= (row + height - 1) / BLOCK_SIZE; by++) {
+            int y0 = std::max(row, by * BLOCK_SIZE);
+            int y1 = std::min(row + height, by * BLOCK_SIZE + getBlockExtent(by, 1));
+            for (int bx = column / BLOCK_SIZE; bx <= (column + width - 1) / BLOCK_SIZE; bx++) {
+                int x0 = std::max(column, bx * BLOCK_SIZE);
+                int x1 = std::min(column + width, bx * BLOCK_SIZE + getBlockExtent(bx, 0));
+                int block = (bz * blocks[1] + by) * blocks[0] + bx;
+                int bw = getBlockExtent(bx, 0);
+                int bh = getBlockExtent(by, 1);
+                for (int k = z0; k < z1; k++) {
+                    for (int j = y0; j < y1; j++) {
+                        unsigned char* line = voxels + (k - slab) * slicePitch + (j - row) * rowPitch - column;
+                        if (bits[block] == 0) {
+                            memset(line + x0, minimums[block], x1 - x0);
+                        } else {
+                            int index = ((k - bz * BLOCK_SIZE) * bh + (j - by * BLOCK_SIZE)) * bw - bx * BLOCK_SIZE;
+                            for (int i = x0; i < x1; i++) {
+                                line[i] = (unsigned char) (minimums[block] + unpack(block, index + i));
+                            } // end for
+                        }
+                    } // end for
+                } // end for
+            } // end for
+        } // end for
+    } // end for
+} // end decode()
+
+/*
+ * decode - Decode a region into a caller supplied buffer, splitting the slabs across threads.
+ *
+ * parameter column - int
+ * parameter row - int
+ * parameter slab - int
+ * parameter width - int
+ * parameter height - int
+ * parameter depth - int
+ * parameter voxels - unsigned char*
+ * parameter rowPitch - int
+ * parameter slicePitch - int
+ * parameter numberOfThreads - int
+ */
+void CompressedVolume::decode(int column, int row, int slab, int width, int height, int depth, unsigned char* voxels,
+        int rowPitch, int slicePitch, int numberOfThreads) const {
+    if (numberOfThreads > depth)
+        numberOfThreads = depth;
+    if (numberOfThreads <= 1) {
+        decode(column, row, slab, width, height, depth, voxels, rowPitch, slicePitch);
+        return;
+    }
+    DecodeTask* tasks = new DecodeTask[numberOfThreads];
+    pthread_t* threads = new pthread_t[numberOfThreads];
+    for (int t = 0; t < numberOfThreads; t++) {
+        int k0 = (depth * t) / numberOfThreads;
+        int k1 = (depth * (t + 1)) / numberOfThreads;
+        tasks[t].compressedVolume = this;
+        tasks[t].column = column;
+        tasks[t].row = row;
+        tasks[t].slab = slab + k0;
+        tasks[t].width = width;
+        tasks[t].height = height;
+        tasks[t].depth = k1 - k0;
+        tasks[t].voxels = voxels + k0 * slicePitch;
+        tasks[t].rowPitch = rowPitch;
+        tasks[t].slicePitch = slicePitch;
+        pthread_create(&threads[t], NULL, decodeThread, &tasks[t]);
+    } // end for
+    for (int t = 0; t < numberOfThreads; t++) {
+        pthread_join(threads[t], NULL);
+    } // end for
+    delete[] threads;
+    delete[] tasks;
+} // end decode()
+
+/*
+ * getCompressedSize - Bytes held by the block headers and the packed stream.
+ *
+ * return - size_t
+ */
+size_t CompressedVolume::getCompressedSize(void) const {
+    return dataSize + 1 + size_t(numberOfBlocks) * (3 + sizeof(size_t));
+} // end getCompressedSize()
+
+/*
+ * getUncompressedSize
+ *
+ * return - size_t
+ */
+size_t CompressedVolume::getUncompressedSize(void) const {
+    return size_t(size[0]) * size_t(size[1]) * size_t(size[2]);
+} // end getUncompressedSize()
+
+/*
+ * getVoxel
+ *
+ * parameter i - int
+ * return - unsigned char
+ */
+unsigned char CompressedVolume::getVoxel(int i) const {
+    int column = i % size[0];
+    int row = (i / size[0]) % size[1];
+    int slab = i / (size[0] * size[1]);
+    return getVoxel(column, row, slab);
+} // end getVoxel()
+
+/*
+ * getVoxel
+ *
+ * parameter column - int
+ * parameter row - int
+ * parameter slab - int
+ * return - unsigned char
+ */
+unsigned char CompressedVolume::getVoxel(int column, int row, int slab) const {
+    int bx = column / BLOCK_SIZE;
+    int by = row / BLOCK_SIZE;
+    int bz = slab / BLOCK_SIZE;
+    int block = (bz * blocks[1] + by) * blocks[0] + bx;
+    if (bits[block] == 0)
+        return minimums[block];
+    int index = ((slab - bz * BLOCK_SIZE) * getBlockExtent(by, 1) + (row - by * BLOCK_SIZE)) * getBlockExtent(bx, 0) + (column
+            - bx * BLOCK_SIZE);
+    return (unsigned char) (minimums[block] + unpack(block, index));
+} // end getVoxel()
+
+/*
+ * clear
+ */
+void CompressedVolume::clear(void) {
+    delete[] bits;
+    delete[] data;
+    delete[] maximums;
+    delete[] minimums;
+    delete[] offsets;
+    bits = NULL;
+    data = NULL;
+    maximums = NULL;
+    minimums = NULL;
+    offsets = NULL;
+    dataSize = 0;
+    numberOfBlocks = 0;
+} // end clear()
+
+/*
+ * decodeThread
+ *
+ * parameter parameter - void*
+ * return - void*
+ */
+void* CompressedVolume::decodeThread(void* parameter) {
+    DecodeTask* task = static_cast<DecodeTask*> (parameter);
+    task->compressedVolume->decode(task->column, task->row, task->slab, task->width, task->height, task->depth, task->voxels,
+            task->rowPitch, task->slicePitch);
+    return NULL;
+} // end decodeThread()
+
+/*
+ * getBlockExtent - Number of voxels of a block along a dimension; the last block may be partial.
+ *
+ * parameter block - int
+ * parameter dimension - int
+ * return - int
+ */
+int CompressedVolume::getBlockExtent(int block, int dimension) const {
+    return std::min(BLOCK_SIZE, size[dimension] - block * BLOCK_SIZE);
+} // end getBlockExtent()
+
+/*
+ * unpack - Offset of a voxel from its block minimum.
+ *
+ * parameter block - int
+ * parameter index - int
+ * return - unsigned char
+ */
+unsigned char CompressedVolume::unpack(int block, int index) const {
+    int position = index * bits[block];
+    const unsigned char* packed = data + offsets[block] + (position >> 3);
+    unsigned int value = (unsigned int) (packed[0]) | ((unsigned int) (packed[1]) << 8);
+    return (unsigned char) ((value >> (position & 7)) & ((1u << bits[block]) - 1));
+} // end unpack()
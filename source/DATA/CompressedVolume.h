@@ -0,0 +1,67 @@
+/*
+ * CompressedVolume.h - Class for a block compressed in-memory copy of a byte volume.
+ *
+ * The volume is cut into BLOCK_SIZE^3 blocks. A block whose voxels all share
+ * one value collapses to its block header; any other block stores each voxel
+ * as an offset from the block minimum, bit packed to the width of the block range.
+ * Both encodings allow random access, so getVoxel() never decodes a whole block.
+ *
+ * Author: Patrick O'Leary
+ * Created: October 19, 2026
+ * Copyright 2007. All rights reserved.
+ */
+#ifndef COMPRESSEDVOLUME_H_
+#define COMPRESSEDVOLUME_H_
+
+#include <cstddef>
+
+#define BLOCK_SIZE 16
+
+class CompressedVolume {
+public:
+    CompressedVolume(void);
+    ~CompressedVolume(void);
+    void accumulate(int column, int row, int slab, int width, int height, int depth, const float* table, float& sum,
+            float& zeros) const;
+    void benchmark(int numberOfThreads, int numberOfIterations) const;
+    int calculateMaximum(int column, int row, int slab, int width, int height, int depth) const;
+    int calculateMinimum(int column, int row, int slab, int width, int height, int depth) const;
+    unsigned int calculateValueMask(int column, int row, int slab, int width, int height, int depth) const;
+    void compress(const unsigned char* voxels, int width, int height, int depth);
+    void decode(int column, int row, int slab, int width, int height, int depth, unsigned char* voxels, int rowPitch,
+            int slicePitch) const;
+    void decode(int column, int row, int slab, int width, int height, int depth, unsigned char* voxels, int rowPitch,
+            int slicePitch, int numberOfThreads) const;
+    size_t getCompressedSize(void) const;
+    size_t getUncompressedSize(void) const;
+    unsigned char getVoxel(int i) const;
+    unsigned char getVoxel(int column, int row, int slab) const;
+private:
+    struct DecodeTask {
+        const CompressedVolume* compressedVolume;
+        int column;
+        int row;
+        int slab;
+        int width;
+        int height;
+        int depth;
+        unsigned char* voxels;
+        int rowPitch;
+        int slicePitch;
+    };
+    unsigned char* bits;
+    int blocks[3];
+    unsigned char* data;
+    size_t dataSize;
+    unsigned char* maximums;
+    unsigned char* minimums;
+    int numberOfBlocks;
+    size_t* offsets;
+    int size[3];
+    void clear(void);
+    static void* decodeThread(void* parameter);
+    int getBlockExtent(int block, int dimension) const;
+    unsigned char unpack(int block, int index) const;
+};
+
+#endif /*COMPRESSEDVOLUME_H_*/
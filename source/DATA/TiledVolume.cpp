@@ -0,0 +1,319 @@
+/*
+ * TiledVolume.cpp - Methods for TiledVolume class.
+ *
+ * Author: Patrick O'Leary
+ * Created: October 19, 2026
+ * Copyright 2007. All rights reserved.
+ */
+#include <algorithm>
+#include <cstring>
+
+#include <DATA/TiledVolume.h>
+#include <DATA/ValueMask.h>
+
+/*
+ * Iterator - Constructor for TiledVolume::Iterator class.
+ *
+ * parameter _tiledVolume - const TiledVolume*
+ * parameter column - int
+ * parameter row - int
+ * parameter slab - int
+ * parameter width - int
+ * parameter height - int
+ * parameter depth - int
+ */
+TiledVolume::Iterator::Iterator(const TiledVolume* _tiledVolume, int column, int row, int slab, int width, int height,
+        int depth) :
+    j(0), k(0), length(0), mode(0), run(NULL), tiledVolume(_tiledVolume) {
+    region[0] = column;
+    region[1] = row;
+    region[2] = slab;
+    region[3] = column + width;
+    region[4] = row + height;
+    region[5] = slab + depth;
+    if (width <= 0 || height <= 0 || depth <= 0)
+        return;
+    for (int i = 0; i < 3; i++) {
+        first[i] = region[i] >> TILE_SHIFT;
+        last[i] = (region[i + 3] - 1) >> TILE_SHIFT;
+        tile[i] = first[i];
+    } // end for
+    enterTile();
+} // end Iterator()
+
+/*
+ * enterTile - Clip the region to the current tile and pick the longest runs it allows.
+ */
+void TiledVolume::Iterator::enterTile(void) {
+    for (int i = 0; i < 3; i++) {
+        lower[i] = std::max(region[i], tile[i] << TILE_SHIFT) - (tile[i] << TILE_SHIFT);
+        upper[i] = std::min(region[i + 3], (tile[i] + 1) << TILE_SHIFT) - (tile[i] << TILE_SHIFT);
+    } // end for
+    bool wholeRows = lower[0] == 0 && upper[0] == TILE_SIZE;
+    bool wholeSlices = wholeRows && lower[1] == 0 && upper[1] == TILE_SIZE;
+    mode = wholeSlices ? 2 : (wholeRows ? 1 : 0);
+    j = lower[1];
+    k = lower[2];
+    setRun();
+} // end enterTile()
+
+/*
+ * next - Move to the next run; isDone() afterwards when the region is exhausted.
+ */
+void TiledVolume::Iterator::next(void) {
+    if (mode == 0) {
+        if (++j < upper[1]) {
+            setRun();
+            return;
+        } // end if
+        j = lower[1];
+    } // end if
+    if (mode != 2 && ++k < upper[2]) {
+        setRun();
+        return;
+    } // end if
+    if (++tile[0] > last[0]) {
+        tile[0] = first[0];
+        if (++tile[1] > last[1]) {
+            tile[1] = first[1];
+            if (++tile[2] > last[2]) {
+                run = NULL;
+                length = 0;
+                return;
+            } // end if
+        } // end if
+    } // end if
+    enterTile();
+} // end next()
+
+/*
+ * setRun
+ */
+void TiledVolume::Iterator::setRun(void) {
+    const unsigned char* voxels = tiledVolume->getTile(tile[0], tile[1], tile[2]);
+    if (mode == 2) {
+        run = voxels + k * TILE_SIZE * TILE_SIZE;
+        length = (upper[2] - lower[2]) * TILE_SIZE * TILE_SIZE;
+    } else if (mode == 1) {
+        run = voxels + (k * TILE_SIZE + lower[1]) * TILE_SIZE;
+        length = (upper[1] - lower[1]) * TILE_SIZE;
+    } else {
+        run = voxels + (k * TILE_SIZE + j) * TILE_SIZE + lower[0];
+        length = upper[0] - lower[0];
+    }
+} // end setRun()
+
+/*
+ * TiledVolume - Constructor for TiledVolume class.
+ */
+TiledVolume::TiledVolume(void) :
+    base(NULL), data(NULL) {
+    for (int i = 0; i < 3; i++) {
+        size[i] = 0;
+        tiles[i] = 0;
+    } // end for
+} // end TiledVolume()
+
+/*
+ * ~TiledVolume - Destructor for TiledVolume class.
+ */
+TiledVolume::~TiledVolume(void) {
+    delete[] base;
+} // end ~TiledVolume()
+
+/*
+ * accumulate - Sum a lookup table over a region and count the voxels it maps to zero.
+ *
+ * parameter column - int
+ * parameter row - int
+ * parameter slab - int
+ * parameter width - int
+ * parameter height - int
+ * parameter depth - int
+ * parameter table - const float*
+ * parameter sum - float&
+ * parameter zeros - float&
+ */
+void TiledVolume::accumulate(int column, int row, int slab, int width, int height, int depth, const float* table,
+        float& sum, float& zeros) const {
+    sum = 0.0f;
+    zeros = 0.0f;
+    for (Iterator iterator(this, column, row, slab, width, height, depth); !iterator.isDone(); iterator.next()) {
+        const unsigned char* run = iterator.getRun();
+        for (int i = 0; i < iterator.getLength(); i++) {
+            float value = table[run[i]];
+            sum += value;
+            if (value == 0.0f)
+                zeros += 1.0f;
+        } // end for
+    } // end for
+} // end accumulate()
+
+/*
+ * calculateMaximum
+ *
+ * parameter column - int
+ * parameter row - int
+ * parameter slab - int
+ * parameter width - int
+ * parameter height - int
+ * parameter depth - int
+ * return - int
+ */
+int TiledVolume::calculateMaximum(int column, int row, int slab, int width, int height, int depth) const {
+    int maximum = 0;
+    for (Iterator iterator(this, column, row, slab, width, height, depth); !iterator.isDone(); iterator.next()) {
+        const unsigned char* run = iterator.getRun();
+        maximum = std::max(maximum, int(*std::max_element(run, run + iterator.getLength())));
+    } // end for
+    return maximum;
+} // end calculateMaximum()
+
+/*
+ * calculateMinimum
+ *
+ * parameter column - int
+ * parameter row - int
+ * parameter slab - int
+ * parameter width - int
+ * parameter height - int
+ * parameter depth - int
+ * return - int
+ */
+int TiledVolume::calculateMinimum(int column, int row, int slab, int width, int height, int depth) const {
+    int minimum = 255;
+    for (Iterator iterator(this, column, row, slab, width, height, depth); !iterator.isDone(); iterator.next()) {
+        const unsigned char* run = iterator.getRun();
+        minimum = std::min(minimum, int(*std::min_element(run, run + iterator.getLength())));
+    } // end for
+    return minimum;
+} // end calculateMinimum()
+
+/*
+ * calculateValueMask - Value bins of the voxels in a region, see ValueMask.h.
+ *
+ * parameter column - int
+ * parameter row - int
+ * parameter slab - int
+ * parameter width - int
+ * parameter height - int
+ * parameter depth - int
+ * return - unsigned int
+ */
+unsigned int TiledVolume::calculateValueMask(int column, int row, int slab, int width, int height, int depth) const {
+    unsigned int valueMask = 0;
+    for (Iterator iterator(this, column, row, slab, width, height, depth); !iterator.isDone() && valueMask != VALUE_MASK_ALL; iterator.next()) {
+        const unsigned char* run = iterator.getRun();
+        for (int i = 0; i < iterator.getLength(); i++)
+            valueMask |= VALUE_BIT(run[i]);
+    } // end for
+    return valueMask;
+} // end calculateValueMask()
+
+/*
+ * extract - Copy a region into a caller supplied x fastest buffer.
+ *
+ * parameter column - int
+ * parameter row - int
+ * parameter slab - int
+ * parameter width - int
+ * parameter height - int
+ * parameter depth - int
+ * parameter voxels - unsigned char*
+ * parameter rowPitch - int
+ * parameter slicePitch - int
+ */
+void TiledVolume::extract(int column, int row, int slab, int width, int height, int depth, unsigned char* voxels,
+        int rowPitch, int slicePitch) const {
+    for (int tz = slab >> TILE_SHIFT; tz <= (slab + depth - 1) >> TILE_SHIFT; tz++) {
+        int z0 = std::max(slab, tz << TILE_SHIFT);
+        int z1 = std::min(slab + depth, (tz + 1) << TILE_SHIFT);
+        for (int ty = row >> TILE_SHIFT; ty <= (row + height - 1) >> TILE_SHIFT; ty++) {
+            int y0 = std::max(row, ty << TILE_SHIFT);
+            int y1 = std::min(row + height, (ty + 1) << TILE_SHIFT);
+            for (int tx = column >> TILE_SHIFT; tx <= (column + width - 1) >> TILE_SHIFT; tx++) {
+                int x0 = std::max(column, tx << TILE_SHIFT);
+                int x1 = std::min(column + width, (tx + 1) << TILE_SHIFT);
+                const unsigned char* voxelTile = getTile(tx, ty, tz);
+                for (int k = z0; k < z1; k++) {
+                    for (int j = y0; j < y1; j++) {
+                        const unsigned char* source = voxelTile + ((((k & (TILE_SIZE - 1)) << TILE_SHIFT) + (j & (TILE_SIZE
+                                - 1))) << TILE_SHIFT) + (x0 & (TILE_SIZE - 1));
+                        memcpy(voxels + (k - slab) * slicePitch + (j - row) * rowPitch + (x0 - column), source, x1 - x0);
+                    } // end for
+                } // end for
+            } // end for
+        } // end for
+    } // end for
+} // end extract()
+
+/*
+ * getSize - Bytes held by the tiles, padding included.
+ *
+ * return - size_t
+ */
+size_t TiledVolume::getSize(void) const {
+    return size_t(tiles[0]) * size_t(tiles[1]) * size_t(tiles[2]) * TILE_VOXELS;
+} // end getSize()
+
+/*
+ * getVoxel
+ *
+ * parameter i - int (x fastest index)
+ * return - unsigned char
+ */
+unsigned char TiledVolume::getVoxel(int i) const {
+    int column = i % size[0];
+    int row = (i / size[0]) % size[1];
+    int slab = i / (size[0] * size[1]);
+    return getVoxel(column, row, slab);
+} // end getVoxel()
+
+/*
+ * getVoxel
+ *
+ * parameter column - int
+ * parameter row - int
+ * parameter slab - int
+ * return - unsigned char
+ */
+unsigned char TiledVolume::getVoxel(int column, int row, int slab) const {
+    return getTile(column >> TILE_SHIFT, row >> TILE_SHIFT, slab >> TILE_SHIFT)[((((slab & (TILE_SIZE - 1)) << TILE_SHIFT)
+            + (row & (TILE_SIZE - 1))) << TILE_SHIFT) + (column & (TILE_SIZE - 1))];
+} // end getVoxel()
+
+/*
+ * tile - Copy an x fastest byte volume into tiles.
+ *
+ * parameter voxels - const unsigned char*
+ * parameter width - int
+ * parameter height - int
+ * parameter depth - int
+ */
+void TiledVolume::tile(const unsigned char* voxels, int width, int height, int depth) {
+    delete[] base;
+    size[0] = width;
+    size[1] = height;
+    size[2] = depth;
+    for (int i = 0; i < 3; i++)
+        tiles[i] = (size[i] + TILE_SIZE - 1) >> TILE_SHIFT;
+    // One spare tile lets the tiles start on a cache line
+    base = new unsigned char[getSize() + TILE_VOXELS];
+    data = base + ((TILE_VOXELS - (size_t(base) % TILE_VOXELS)) % TILE_VOXELS);
+    memset(data, 0, getSize());
+    for (int tz = 0; tz < tiles[2]; tz++) {
+        for (int ty = 0; ty < tiles[1]; ty++) {
+            for (int tx = 0; tx < tiles[0]; tx++) {
+                unsigned char* voxelTile = data + (size_t((tz * tiles[1] + ty) * tiles[0] + tx) << (3 * TILE_SHIFT));
+                int x0 = tx << TILE_SHIFT;
+                int x1 = std::min(width, x0 + TILE_SIZE);
+                for (int k = tz << TILE_SHIFT; k < std::min(depth, (tz + 1) << TILE_SHIFT); k++) {
+                    for (int j = ty << TILE_SHIFT; j < std::min(height, (ty + 1) << TILE_SHIFT); j++) {
+                        memcpy(voxelTile + ((((k & (TILE_SIZE - 1)) << TILE_SHIFT) + (j & (TILE_SIZE - 1))) << TILE_SHIFT),
+                                voxels + (size_t(k) * height + j) * width + x0, x1 - x0);
+                    } // end for
+                } // end for
+            } // end for
+        } // end for
+    } // end for
+} // end tile()
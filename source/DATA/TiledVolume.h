@@ -0,0 +1,98 @@
+/*
+ * TiledVolume.h - Class for a byte volume stored in small cubic tiles.
+ *
+ * The volume is cut into TILE_SIZE^3 tiles that each fill one cache line; the
+ * tiles are stored x fastest, and so are the voxels inside a tile. A slice or a
+ * brick along any axis then reads whole cache lines, so extracting an X slice
+ * touches as many lines as extracting a Z slice. Tiles on the far faces are
+ * padded to the full tile size. Iterator visits the voxels of a region as runs
+ * of contiguous memory, in storage order, for order independent reductions.
+ *
+ * Author: Patrick O'Leary
+ * Created: October 19, 2026
+ * Copyright 2007. All rights reserved.
+ */
+#ifndef TILEDVOLUME_H_
+#define TILEDVOLUME_H_
+
+#include <cstddef>
+
+#define TILE_SIZE 4
+#define TILE_SHIFT 2
+#define TILE_VOXELS (TILE_SIZE * TILE_SIZE * TILE_SIZE)
+
+class TiledVolume {
+public:
+    class Iterator {
+    public:
+        Iterator(const TiledVolume* _tiledVolume, int column, int row, int slab, int width, int height, int depth);
+        /*
+         * getLength - Number of voxels in the current run.
+         *
+         * return - int
+         */
+        int getLength(void) const {
+            return length;
+        }
+        /*
+         * getRun - First voxel of the current run.
+         *
+         * return - const unsigned char*
+         */
+        const unsigned char* getRun(void) const {
+            return run;
+        }
+        /*
+         * isDone
+         *
+         * return - bool
+         */
+        bool isDone(void) const {
+            return run == NULL;
+        }
+        void next(void);
+    private:
+        int first[3]; // first tile of the region
+        int j; // current row inside the tile
+        int k; // current slice inside the tile
+        int last[3]; // last tile of the region
+        int length;
+        int lower[3]; // region inside the current tile
+        int mode; // 0: one row per run, 1: one slice per run, 2: the whole tile range per run
+        int region[6];
+        const unsigned char* run;
+        int tile[3];
+        const TiledVolume* tiledVolume;
+        int upper[3];
+        void enterTile(void);
+        void setRun(void);
+    };
+    TiledVolume(void);
+    ~TiledVolume(void);
+    void accumulate(int column, int row, int slab, int width, int height, int depth, const float* table, float& sum,
+            float& zeros) const;
+    int calculateMaximum(int column, int row, int slab, int width, int height, int depth) const;
+    int calculateMinimum(int column, int row, int slab, int width, int height, int depth) const;
+    unsigned int calculateValueMask(int column, int row, int slab, int width, int height, int depth) const;
+    void extract(int column, int row, int slab, int width, int height, int depth, unsigned char* voxels, int rowPitch,
+            int slicePitch) const;
+    size_t getSize(void) const;
+    unsigned char getVoxel(int i) const;
+    unsigned char getVoxel(int column, int row, int slab) const;
+    void tile(const unsigned char* voxels, int width, int height, int depth);
+private:
+    unsigned char* base; // allocation holding the cache line aligned tiles
+    unsigned char* data;
+    int size[3];
+    int tiles[3];
+    /*
+     * getTile - First voxel of a tile.
+     *
+     * return - const unsigned char*
+     */
+    const unsigned char* getTile(int tx, int ty, int tz) const {
+        return data + (size_t((tz * tiles[1] + ty) * tiles[0] + tx) << (3 * TILE_SHIFT));
+    }
+};
+
+#endif /*TILEDVOLUME_H_*/
@@ -0,0 +1,20 @@
+/*
+ * ValueMask.h - Coarse masks of the byte voxel values a region holds.
+ *
+ * Bit b of a value mask is set when the region may hold a value in
+ * [b << VALUE_BIN_SHIFT, (b + 1) << VALUE_BIN_SHIFT), so 32 bits cover 0-255.
+ *
+ * Author: Patrick O'Leary
+ * Created: October 19, 2026
+ * Copyright 2007. All rights reserved.
+ */
+#ifndef VALUEMASK_H_
+#define VALUEMASK_H_
+
+#define VALUE_BIN_SHIFT 3
+#define VALUE_MASK_ALL 0xffffffffu
+
+#define VALUE_BIT(value) (1u << ((value) >> VALUE_BIN_SHIFT))
+#define VALUE_RANGE_MASK(minimum,maximum) ((VALUE_MASK_ALL >> (31 - ((maximum) >> VALUE_BIN_SHIFT))) & (VALUE_MASK_ALL << ((minimum) >> VALUE_BIN_SHIFT)))
+
+#endif /*VALUEMASK_H_*/
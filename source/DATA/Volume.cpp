@@ -5,19 +5,29 @@
  * Created: October 19, 2007
  * Copyright: 2007
  */
+#include <algorithm>
 #include <cfloat>
-
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#include <DATA/ComponentKernels.h>
+#include <DATA/CompressedVolume.h>
+#include <DATA/TiledVolume.h>
+#include <DATA/ValueMask.h>
 #include <DATA/Volume.h>
 #include <DATASTRUCTURE/BoundingBox.h>
+#include <UTILITY/MemoryAccount.h>
 #include <UTILITY/Stringify.h>
 
 /*
  *  Volume - Constructor for Volume class.
  */
 Volume::Volume() :
-    blueByteVoxelsBase(NULL), blueVoxels(NULL), byteVoxelsBase(NULL), floatVoxelsBase(NULL), gradients(NULL), greenByteVoxelsBase(
-            NULL), greenVoxels(NULL), intVoxelsBase(NULL), leafSize(4), maximumPriorityQueueSize(0), numberOfComponents(0),
-            ratioOfVisibilityThreshold(1.0), redByteVoxelsBase(NULL), redVoxels(NULL), sliceFactor(1.5), textureSize(32), voxels(
+    adaptiveBricks(false), blueByteVoxelsBase(NULL), blueVoxels(NULL), byteVoxelsBase(NULL), compressedBlueVoxels(NULL), compressedGreenVoxels(NULL),
+            compressedRedVoxels(NULL), compressedVoxels(NULL), floatVoxelsBase(NULL), gradients(NULL), gradientStride(4), gradientTexels(NULL), gradientTexture(false),
+            greenByteVoxelsBase(NULL), greenVoxels(NULL), illuminationCache(false), intVoxelsBase(NULL), interleavedVoxels(NULL), leafSize(4), maximumPriorityQueueSize(0),
+            memoryBudget(0), numberOfComponents(0), numberOfDecodeThreads(4), quantizedGradient(false), ratioOfVisibilityThreshold(1.0), redByteVoxelsBase(NULL), redVoxels(NULL), regionOfInterest(NULL), sliceFactor(1.5), textureAtlas(false), textureSize(32), tiledVoxels(NULL), voxels(
                     NULL) {
     increments = new int[3];
     scale = new float[3];
@@ -40,11 +50,17 @@ Volume::~Volume() {
     if (hasByteVoxelsBase()) {
         delete[] byteVoxelsBase;
     }
+    delete compressedBlueVoxels;
+    delete compressedGreenVoxels;
+    delete compressedRedVoxels;
+    delete compressedVoxels;
+    delete tiledVoxels;
     if (hasFloatVoxelsBase()) {
         delete[] floatVoxelsBase;
     }
     if (gradients != NULL)
         delete[] gradients;
+    delete[] gradientTexels;
     if (hasGreenByteVoxelsBase()) {
         delete[] greenByteVoxelsBase;
     }
@@ -52,37 +68,110 @@ Volume::~Volume() {
     if (hasIntVoxelsBase()) {
         delete[] intVoxelsBase;
     }
+    delete[] interleavedVoxels;
     if (hasRedByteVoxelsBase()) {
         delete[] redByteVoxelsBase;
     }
+    delete[] regionOfInterest;
     delete[] size;
     delete[] scale;
     delete volumeBox;
 } // end ~Volume
 
 /*
- * calculateGradient
+ * isAdaptiveBricks
+ *
+ * return - bool
+ */
+bool Volume::isAdaptiveBricks(void) const {
+    return adaptiveBricks;
+} // end isAdaptiveBricks()
+
+/*
+ * setAdaptiveBricks
+ *
+ * parameter _adaptiveBricks - bool
+ */
+void Volume::setAdaptiveBricks(bool _adaptiveBricks) {
+    adaptiveBricks = _adaptiveBricks;
+} // end setAdaptiveBricks()
+
+/*
+ * accountMemory - Add the bytes of the voxels, the voxels they were converted from and the gradients.
+ *
+ * parameter memoryAccount - MemoryAccount&
+ */
+void Volume::accountMemory(MemoryAccount& memoryAccount) const {
+    size_t n = size_t(size[0]) * size[1] * size[2];
+    const unsigned char* byteBases[] = { byteVoxelsBase, redByteVoxelsBase, greenByteVoxelsBase, blueByteVoxelsBase };
+    for (int i = 0; i < 4; i++)
+        if (byteBases[i] != NULL)
+            memoryAccount.add(MEMORY_VOXELS, size_t(numberOfVoxels));
+    const CompressedVolume* compressed[] = { compressedVoxels, compressedRedVoxels, compressedGreenVoxels,
+            compressedBlueVoxels };
+    for (int i = 0; i < 4; i++)
+        if (compressed[i] != NULL)
+            memoryAccount.add(MEMORY_VOXELS, compressed[i]->getCompressedSize());
+    if (interleavedVoxels != NULL)
+        memoryAccount.add(MEMORY_VOXELS, COMPONENT_STRIDE * n);
+    if (tiledVoxels != NULL)
+        memoryAccount.add(MEMORY_VOXELS, tiledVoxels->getSize());
+    if (floatVoxelsBase != NULL)
+        memoryAccount.add(MEMORY_SOURCE_VOXELS, sizeof(float) * size_t(numberOfVoxels));
+    if (intVoxelsBase != NULL)
+        memoryAccount.add(MEMORY_SOURCE_VOXELS, sizeof(int) * size_t(numberOfVoxels));
+    if (gradients != NULL)
+        memoryAccount.add(MEMORY_GRADIENTS, sizeof(float) * gradientStride * n);
+    if (gradientTexels != NULL)
+        memoryAccount.add(MEMORY_GRADIENTS, gradientStride * n);
+} // end accountMemory()
+
+/*
+ * allocateGradient - Allocate the zeroed gradient array and reset the gradient range.
+ */
+void Volume::allocateGradient(void) {
+    int n = getWidth() * getHeight() * getDepth();
+    maximumGradient = FLT_MIN;
+    minimumGradient = FLT_MAX;
+    delete[] gradients;
+    gradients = new float[4 * n];
+    gradientStride = 4;
+    for (int i = 0; i < 4 * n; i++)
+        gradients[i] = 0.0f;
+} // end allocateGradient()
+
+/*
+ * calculateGradient - Calculate the gradients of every voxel, unless they have been calculated already.
  */
 void Volume::calculateGradient(void) {
+    if (gradients != NULL || gradientTexels != NULL)
+        return;
+    if (quantizedGradient) {
+        calculateQuantizedGradient();
+        return;
+    }
+    allocateGradient();
+    calculateGradient(1, getDepth() - 1);
+} // end calculateGradient()
+
+/*
+ * calculateGradient - Calculate the gradients of slabs [firstSlab, lastSlab) into the allocated gradient array.
+ *
+ * Slab k only reads slabs k - 1 to k + 1 of the voxels.
+ *
+ * parameter firstSlab - int
+ * parameter lastSlab - int
+ */
+void Volume::calculateGradient(int firstSlab, int lastSlab) {
     int depth = getDepth();
     int height = getHeight();
     int width = getWidth();
-    maximumGradient = FLT_MIN;
-    minimumGradient = FLT_MAX;
-    gradients = new float[4 * (width * height * depth)];
-    for (int i = 0; i < 4 * (width * height * depth); i++)
-        gradients[i] = 0.0f;
-    for (int k = 1; k < depth - 1; k++) {
+    for (int k = std::max(firstSlab, 1); k < std::min(lastSlab, depth - 1); k++) {
         for (int j = 1; j < height - 1; j++) {
             for (int i = 1; i < width - 1; i++) {
-                float x = float(getVoxel(i+1 + j * width + k * (width * height))) - float(getVoxel(i-1 + j * width + k * (width * height)));
-                float y = float(getVoxel(i + (j+1) * width + k * (width * height))) - float(getVoxel(i + (j-1) * width + k * (width * height)));
-                float z = float(getVoxel(i + j * width + (k+1) * (width * height))) - float(getVoxel(i + j * width + (k-1) * (width * height)));
-                float m = x*x + y*y + z*z;
-                gradients[4 * (i + j * width + k * (width * height)) + 0] = x;
-                gradients[4 * (i + j * width + k * (width * height)) + 1] = y;
-                gradients[4 * (i + j * width + k * (width * height)) + 2] = z;
-                gradients[4 * (i + j * width + k * (width * height)) + 3] = m;
+                float* gradient = gradients + 4 * (i + j * width + k * (width * height));
+                calculateDifference(i, j, k, gradient);
+                float m = gradient[3];
                 if (maximumGradient < m) {
                     maximumGradient = m;
                 }
@@ -94,6 +183,65 @@ void Volume::calculateGradient(void) {
     } // end for
 } // end calculateGradient()
 
+/*
+ * calculateDifference - Central differences of voxel (i, j, k) and their squared magnitude.
+ *
+ * parameter i - int
+ * parameter j - int
+ * parameter k - int
+ * parameter gradient - float* (x, y, z and m)
+ */
+void Volume::calculateDifference(int i, int j, int k, float* gradient) const {
+    int width = size[0];
+    int slice = size[0] * size[1];
+    gradient[0] = float(getVoxel(i+1 + j * width + k * slice)) - float(getVoxel(i-1 + j * width + k * slice));
+    gradient[1] = float(getVoxel(i + (j+1) * width + k * slice)) - float(getVoxel(i + (j-1) * width + k * slice));
+    gradient[2] = float(getVoxel(i + j * width + (k+1) * slice)) - float(getVoxel(i + j * width + (k-1) * slice));
+    gradient[3] = gradient[0] * gradient[0] + gradient[1] * gradient[1] + gradient[2] * gradient[2];
+} // end calculateDifference()
+
+/*
+ * calculateQuantizedGradient - Calculate the gradients of every voxel straight into RGBA8 texels.
+ *
+ * The first pass finds the gradient range the texels are scaled by, the second quantizes, so
+ * the float gradients are never held; a quarter of their memory at the cost of a second pass.
+ */
+void Volume::calculateQuantizedGradient(void) {
+    int depth = getDepth();
+    int height = getHeight();
+    int width = getWidth();
+    size_t n = size_t(width) * height * depth;
+    maximumGradient = FLT_MIN;
+    minimumGradient = FLT_MAX;
+    float gradient[4];
+    for (int k = 1; k < depth - 1; k++) {
+        for (int j = 1; j < height - 1; j++) {
+            for (int i = 1; i < width - 1; i++) {
+                calculateDifference(i, j, k, gradient);
+                if (maximumGradient < gradient[3])
+                    maximumGradient = gradient[3];
+                if (minimumGradient > gradient[3])
+                    minimumGradient = gradient[3];
+            } // end for
+        } // end for
+    } // end for
+    gradientTexels = new unsigned char[4 * n];
+    gradientStride = 4;
+    // The border voxels keep a zero gradient, as allocateGradient() leaves them
+    const float zero[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    quantizeTexel(zero, gradientTexels);
+    for (size_t i = 1; i < n; i++)
+        std::memcpy(gradientTexels + 4 * i, gradientTexels, 4);
+    for (int k = 1; k < depth - 1; k++) {
+        for (int j = 1; j < height - 1; j++) {
+            for (int i = 1; i < width - 1; i++) {
+                calculateDifference(i, j, k, gradient);
+                quantizeTexel(gradient, gradientTexels + 4 * (i + j * size_t(width) + k * size_t(width) * height));
+            } // end for
+        } // end for
+    } // end for
+} // end calculateQuantizedGradient()
+
 /*
  * calculateMaximum
  *
@@ -106,6 +254,10 @@ void Volume::calculateGradient(void) {
  * return - int
  */
 int Volume::calculateMaximum(int column, int row, int slab, int width, int height, int depth) {
+    if (compressedVoxels != NULL)
+        return compressedVoxels->calculateMaximum(column, row, slab, width, height, depth);
+    if (tiledVoxels != NULL)
+        return tiledVoxels->calculateMaximum(column, row, slab, width, height, depth);
     int maximum = 0;
     int w = getWidth();
     int h = getHeight();
@@ -135,6 +287,10 @@ int Volume::calculateMaximum(int column, int row, int slab, int width, int heigh
  * return - int
  */
 int Volume::calculateMinimum(int column, int row, int slab, int width, int height, int depth) {
+    if (compressedVoxels != NULL)
+        return compressedVoxels->calculateMinimum(column, row, slab, width, height, depth);
+    if (tiledVoxels != NULL)
+        return tiledVoxels->calculateMinimum(column, row, slab, width, height, depth);
     int minimum = 255;
     int w = getWidth();
     int h = getHeight();
@@ -152,6 +308,246 @@ int Volume::calculateMinimum(int column, int row, int slab, int width, int heigh
     return minimum;
 } // end calculateMinimum()
 
+/*
+ * calculateComponentVisibility - Sum the opacity of a region over the present channels and count its transparent voxels.
+ *
+ * parameter column - int
+ * parameter row - int
+ * parameter slab - int
+ * parameter width - int
+ * parameter height - int
+ * parameter depth - int
+ * parameter red - const float*
+ * parameter green - const float*
+ * parameter blue - const float*
+ * parameter visibility - float&
+ * parameter transparent - float&
+ */
+void Volume::calculateComponentVisibility(int column, int row, int slab, int width, int height, int depth,
+        const float* red, const float* green, const float* blue, float& visibility, float& transparent) {
+    visibility = 0.0f;
+    transparent = 0.0f;
+    int w = getWidth();
+    int h = getHeight();
+    if (interleavedVoxels != NULL) {
+        for (int k = 0; k < depth; k++) {
+            for (int j = 0; j < height; j++) {
+                const unsigned char* run = interleavedVoxels + COMPONENT_STRIDE * ((size_t(slab + k) * h + (row + j)) * w
+                        + column);
+                classifyComponents(typeOfComponents, run, width, red, green, blue, visibility, transparent);
+            } // end for
+        } // end for
+        return;
+    } // end if
+    unsigned char* region = new unsigned char[COMPONENT_STRIDE * size_t(width) * height * depth];
+    getComponentRegion(column, row, slab, width, height, depth, region);
+    classifyComponents(typeOfComponents, region, width * height * depth, red, green, blue, visibility, transparent);
+    delete[] region;
+} // end calculateComponentVisibility()
+
+/*
+ * calculateValueMask - Value bins of the voxels in a region, see ValueMask.h.
+ *
+ * parameter column - int
+ * parameter row - int
+ * parameter slab - int
+ * parameter width - int
+ * parameter height - int
+ * parameter depth - int
+ * return - unsigned int
+ */
+unsigned int Volume::calculateValueMask(int column, int row, int slab, int width, int height, int depth) {
+    if (compressedVoxels != NULL)
+        return compressedVoxels->calculateValueMask(column, row, slab, width, height, depth);
+    if (tiledVoxels != NULL)
+        return tiledVoxels->calculateValueMask(column, row, slab, width, height, depth);
+    unsigned int valueMask = 0;
+    int w = getWidth();
+    int h = getHeight();
+    for (int k = 0; k < depth; k++) {
+        for (int j = 0; j < height; j++) {
+            const unsigned char* line = voxels + ((slab + k) * (w * h)) + ((row + j) * (w)) + column;
+            for (int i = 0; i < width; i++) {
+                valueMask |= VALUE_BIT(line[i]);
+            } // end for
+        } // end for
+    } // end for
+    return valueMask;
+} // end calculateValueMask()
+
+/*
+ * compress - Replace the byte voxels of every channel with a block compressed copy.
+ *
+ * Only the gradient magnitudes are kept, which is all getGradient() returns, unless the
+ * gradient texture needs the directions as well.
+ */
+void Volume::compress(void) {
+    if (isCompressed())
+        return;
+    int w = getWidth();
+    int h = getHeight();
+    int d = getDepth();
+    size_t uncompressedSize = 0;
+    size_t compressedSize = 0;
+    if (hasVoxels()) {
+        compressedVoxels = new CompressedVolume();
+        compressedVoxels->compress(voxels, w, h, d);
+        uncompressedSize += compressedVoxels->getUncompressedSize();
+        compressedSize += compressedVoxels->getCompressedSize();
+        delete[] byteVoxelsBase;
+        byteVoxelsBase = NULL;
+        voxels = NULL;
+    }
+    if (hasRedVoxels()) {
+        compressedRedVoxels = new CompressedVolume();
+        compressedRedVoxels->compress(redVoxels, w, h, d);
+        uncompressedSize += compressedRedVoxels->getUncompressedSize();
+        compressedSize += compressedRedVoxels->getCompressedSize();
+        delete[] redByteVoxelsBase;
+        redByteVoxelsBase = NULL;
+        redVoxels = NULL;
+    }
+    if (hasGreenVoxels()) {
+        compressedGreenVoxels = new CompressedVolume();
+        compressedGreenVoxels->compress(greenVoxels, w, h, d);
+        uncompressedSize += compressedGreenVoxels->getUncompressedSize();
+        compressedSize += compressedGreenVoxels->getCompressedSize();
+        delete[] greenByteVoxelsBase;
+        greenByteVoxelsBase = NULL;
+        greenVoxels = NULL;
+    }
+    if (hasBlueVoxels()) {
+        compressedBlueVoxels = new CompressedVolume();
+        compressedBlueVoxels->compress(blueVoxels, w, h, d);
+        uncompressedSize += compressedBlueVoxels->getUncompressedSize();
+        compressedSize += compressedBlueVoxels->getCompressedSize();
+        delete[] blueByteVoxelsBase;
+        blueByteVoxelsBase = NULL;
+        blueVoxels = NULL;
+    }
+    // The gradient texture and the illumination cache need the gradient vectors, not only their magnitudes
+    if (gradients != NULL && gradientStride != 1 && !gradientTexture && !illuminationCache) {
+        float* magnitudes = new float[w * h * d];
+        for (int i = 0; i < w * h * d; i++)
+            magnitudes[i] = gradients[gradientStride * i + gradientStride - 1];
+        delete[] gradients;
+        gradients = magnitudes;
+        gradientStride = 1;
+    }
+    if (gradientTexels != NULL && gradientStride != 1 && !gradientTexture && !illuminationCache) {
+        unsigned char* magnitudes = new unsigned char[w * h * d];
+        for (int i = 0; i < w * h * d; i++)
+            magnitudes[i] = gradientTexels[gradientStride * i + gradientStride - 1];
+        delete[] gradientTexels;
+        gradientTexels = magnitudes;
+        gradientStride = 1;
+    }
+    if (compressedSize != 0)
+        std::cout << "Compressed voxels: " << uncompressedSize << " bytes -> " << compressedSize << " bytes ("
+                << float(uncompressedSize) / float(compressedSize) << ":1)" << std::endl;
+} // end compress()
+
+/*
+ * isCompressed
+ *
+ * return - bool
+ */
+bool Volume::isCompressed(void) const {
+    return compressedVoxels != NULL || compressedRedVoxels != NULL || compressedGreenVoxels != NULL || compressedBlueVoxels
+            != NULL;
+} // end isCompressed()
+
+/*
+ * getCompressedBlueVoxels
+ *
+ * return - const CompressedVolume*
+ */
+const CompressedVolume* Volume::getCompressedBlueVoxels(void) const {
+    return compressedBlueVoxels;
+} // end getCompressedBlueVoxels()
+
+/*
+ * getCompressedGreenVoxels
+ *
+ * return - const CompressedVolume*
+ */
+const CompressedVolume* Volume::getCompressedGreenVoxels(void) const {
+    return compressedGreenVoxels;
+} // end getCompressedGreenVoxels()
+
+/*
+ * getCompressedRedVoxels
+ *
+ * return - const CompressedVolume*
+ */
+const CompressedVolume* Volume::getCompressedRedVoxels(void) const {
+    return compressedRedVoxels;
+} // end getCompressedRedVoxels()
+
+/*
+ * getCompressedVoxels
+ *
+ * return - const CompressedVolume*
+ */
+const CompressedVolume* Volume::getCompressedVoxels(void) const {
+    return compressedVoxels;
+} // end getCompressedVoxels()
+
+/*
+ * decompress - Restore the byte voxels of every compressed channel, and of a tiled volume.
+ */
+void Volume::decompress(void) {
+    int w = getWidth();
+    int h = getHeight();
+    int d = getDepth();
+    int increments[3];
+    increments[2] = 1;
+    increments[1] = w;
+    increments[0] = w * h;
+    if (compressedVoxels != NULL) {
+        unsigned char* _voxels = new unsigned char[w * h * d];
+        compressedVoxels->decode(0, 0, 0, w, h, d, _voxels, w, w * h);
+        delete compressedVoxels;
+        compressedVoxels = NULL;
+        byteVoxelsBase = _voxels;
+        voxels = _voxels;
+    }
+    if (tiledVoxels != NULL) {
+        unsigned char* _voxels = new unsigned char[w * h * d];
+        tiledVoxels->extract(0, 0, 0, w, h, d, _voxels, w, w * h);
+        delete tiledVoxels;
+        tiledVoxels = NULL;
+        byteVoxelsBase = _voxels;
+        voxels = _voxels;
+    }
+    if (compressedRedVoxels != NULL) {
+        unsigned char* _voxels = new unsigned char[w * h * d];
+        compressedRedVoxels->decode(0, 0, 0, w, h, d, _voxels, w, w * h);
+        delete compressedRedVoxels;
+        compressedRedVoxels = NULL;
+        redByteVoxelsBase = _voxels;
+        redVoxels = _voxels;
+    }
+    if (compressedGreenVoxels != NULL) {
+        unsigned char* _voxels = new unsigned char[w * h * d];
+        compressedGreenVoxels->decode(0, 0, 0, w, h, d, _voxels, w, w * h);
+        delete compressedGreenVoxels;
+        compressedGreenVoxels = NULL;
+        greenByteVoxelsBase = _voxels;
+        greenVoxels = _voxels;
+    }
+    if (compressedBlueVoxels != NULL) {
+        unsigned char* _voxels = new unsigned char[w * h * d];
+        compressedBlueVoxels->decode(0, 0, 0, w, h, d, _voxels, w, w * h);
+        delete compressedBlueVoxels;
+        compressedBlueVoxels = NULL;
+        blueByteVoxelsBase = _voxels;
+        blueVoxels = _voxels;
+    }
+    setBorderSize(0);
+    setIncrements(increments);
+} // end decompress()
+
 /*
  * getBlueByteVoxelsBase
  *
@@ -186,6 +582,10 @@ void Volume::setBlueByteVoxelsBase(unsigned char* _blueByteVoxelsBase) {
  * return - unsigned char
  */
 unsigned char Volume::getBlueVoxel(int i) const {
+    if (interleavedVoxels != NULL)
+        return interleavedVoxels[COMPONENT_STRIDE * i + 2];
+    if (compressedBlueVoxels != NULL)
+        return compressedBlueVoxels->getVoxel(i);
     return blueVoxels[i];
 } // getBlueVoxel()
 
@@ -198,6 +598,10 @@ unsigned char Volume::getBlueVoxel(int i) const {
  * return - unsigned char
  */
 unsigned char Volume::getBlueVoxel(int i, int j, int k) const {
+    if (interleavedVoxels != NULL)
+        return interleavedVoxels[COMPONENT_STRIDE * (i * increments[0] + j * increments[1] + k) + 2];
+    if (compressedBlueVoxels != NULL)
+        return compressedBlueVoxels->getVoxel(i * increments[0] + j * increments[1] + k);
     return blueVoxels[i * increments[0] + j * increments[1] + k];
 } // getBlueVoxel()
 
@@ -339,7 +743,7 @@ void Volume::setFloatVoxelsBase(float* _floatVoxelsBase) {
  * return - float
  */
 float Volume::getGradient(int i, int j, int k) {
-    return gradients[4 * (i * increments[0] + j * increments[1] + k) + 3];
+    return getGradient(i * increments[0] + j * increments[1] + k);
 } // getGradient()
 
 /*
@@ -349,9 +753,79 @@ float Volume::getGradient(int i, int j, int k) {
  * return - float
  */
 float Volume::getGradient(int i) {
-    return gradients[4 * i + 3];
+    if (gradientTexels != NULL) {
+        // Invert the log scaling of the quantized magnitude
+        unsigned char alpha = gradientTexels[gradientStride * i + gradientStride - 1];
+        return (maximumGradient > 1.0f) ? std::pow(maximumGradient, float(alpha) / 255.0f) : 1.0f;
+    }
+    return gradients[gradientStride * i + gradientStride - 1];
 } // getGradient()
 
+/*
+ * getGradientTexel - Quantize the gradient of voxel i to an RGBA8 texel.
+ *
+ * RGB is the unit gradient mapped from [-1,1] to [0,255]; A is the log scaled squared magnitude
+ * the two dimensional transfer function is indexed with, log2(m)/log2(maximumGradient).
+ *
+ * parameter i - int
+ * parameter texel - unsigned char* (four bytes)
+ */
+void Volume::getGradientTexel(int i, unsigned char* texel) {
+    if (gradientTexels != NULL)
+        std::memcpy(texel, gradientTexels + 4 * i, 4);
+    else
+        quantizeTexel(gradients + 4 * i, texel);
+} // end getGradientTexel()
+
+/*
+ * hasGradientVectors - Whether the gradient directions are kept, as floats or as texels.
+ *
+ * return - bool
+ */
+bool Volume::hasGradientVectors(void) const {
+    return (gradients != NULL || gradientTexels != NULL) && gradientStride == 4;
+} // end hasGradientVectors()
+
+/*
+ * quantizeTexel - Quantize a gradient and its squared magnitude to an RGBA8 texel.
+ *
+ * parameter gradient - const float* (x, y, z and m)
+ * parameter texel - unsigned char* (four bytes)
+ */
+void Volume::quantizeTexel(const float* gradient, unsigned char* texel) const {
+    float length = std::sqrt(gradient[3]);
+    float inverse = (length > 0.0f) ? 1.0f / length : 0.0f;
+    for (int c = 0; c < 3; c++)
+        texel[c] = (unsigned char) (127.5f * (gradient[c] * inverse + 1.0f) + 0.5f);
+    float magnitude = 0.0f;
+    if (gradient[3] > 1.0f && maximumGradient > 1.0f)
+        magnitude = std::log(gradient[3]) / std::log(maximumGradient);
+    if (magnitude > 1.0f)
+        magnitude = 1.0f;
+    texel[3] = (unsigned char) (255.0f * magnitude + 0.5f);
+} // end quantizeTexel()
+
+/*
+ * isGradientTexture - Whether the bricks carry a gradient texture.
+ *
+ * Gradients are only calculated for scalar volumes, and the texture atlas has no gradient
+ * counterpart, so the option is ignored for multi-component volumes and in atlas mode.
+ *
+ * return - bool
+ */
+bool Volume::isGradientTexture(void) {
+    return gradientTexture && hasGradientVectors() && numberOfComponents == 0 && !textureAtlas;
+} // end isGradientTexture()
+
+/*
+ * setGradientTexture
+ *
+ * parameter _gradientTexture - bool
+ */
+void Volume::setGradientTexture(bool _gradientTexture) {
+    gradientTexture = _gradientTexture;
+} // end setGradientTexture()
+
 /*
  * getGreenByteVoxelsBase
  *
@@ -386,6 +860,10 @@ void Volume::setGreenByteVoxelsBase(unsigned char* _greenByteVoxelsBasee) {
  * return - unsigned char
  */
 unsigned char Volume::getGreenVoxel(int i) const {
+    if (interleavedVoxels != NULL)
+        return interleavedVoxels[COMPONENT_STRIDE * i + 1];
+    if (compressedGreenVoxels != NULL)
+        return compressedGreenVoxels->getVoxel(i);
     return greenVoxels[i];
 } // getGreenVoxel()
 
@@ -398,6 +876,10 @@ unsigned char Volume::getGreenVoxel(int i) const {
  * return - unsigned char
  */
 unsigned char Volume::getGreenVoxel(int i, int j, int k) const {
+    if (interleavedVoxels != NULL)
+        return interleavedVoxels[COMPONENT_STRIDE * (i * increments[0] + j * increments[1] + k) + 1];
+    if (compressedGreenVoxels != NULL)
+        return compressedGreenVoxels->getVoxel(i * increments[0] + j * increments[1] + k);
     return greenVoxels[i * increments[0] + j * increments[1] + k];
 } // getGreenVoxel()
 
@@ -440,6 +922,26 @@ void Volume::setGreenVoxels(unsigned char* _greenVoxels) {
     greenVoxels = _greenVoxels;
 } // end setGreenVoxels()
 
+/*
+ * isIlluminationCache - Whether the lit colors of the bricks are baked while the shading stays the same.
+ *
+ * The bake shades with the gradient vectors, which are only calculated for scalar volumes.
+ *
+ * return - bool
+ */
+bool Volume::isIlluminationCache(void) {
+    return illuminationCache && hasGradientVectors() && numberOfComponents == 0;
+} // end isIlluminationCache()
+
+/*
+ * setIlluminationCache
+ *
+ * parameter _illuminationCache - bool
+ */
+void Volume::setIlluminationCache(bool _illuminationCache) {
+    illuminationCache = _illuminationCache;
+} // end setIlluminationCache()
+
 /*
  * getHeight
  *
@@ -515,6 +1017,56 @@ void Volume::setIntVoxelsBase(int* _intVoxelsBase) {
     intVoxelsBase = _intVoxelsBase;
 } // end setIntVoxelsBase()
 
+/*
+ * interleave - Replace the separate channel arrays with one array holding the channels of each voxel side by side.
+ *
+ * Absent channels are stored as zero. Compressed channels are left alone; they are decoded
+ * one channel at a time.
+ */
+void Volume::interleave(void) {
+    if (isInterleaved() || isCompressed() || numberOfComponents == 0)
+        return;
+    size_t n = size_t(getWidth()) * getHeight() * getDepth();
+    interleavedVoxels = new unsigned char[COMPONENT_STRIDE * n];
+    const unsigned char* channels[] = { redVoxels, greenVoxels, blueVoxels };
+    for (int c = 0; c < COMPONENT_STRIDE; c++) {
+        unsigned char* destination = interleavedVoxels + c;
+        if (channels[c] != NULL) {
+            const unsigned char* source = channels[c];
+            for (size_t i = 0; i < n; i++)
+                destination[COMPONENT_STRIDE * i] = source[i];
+        } else {
+            for (size_t i = 0; i < n; i++)
+                destination[COMPONENT_STRIDE * i] = 0;
+        } // end if
+    } // end for
+    delete[] redByteVoxelsBase;
+    delete[] greenByteVoxelsBase;
+    delete[] blueByteVoxelsBase;
+    redByteVoxelsBase = greenByteVoxelsBase = blueByteVoxelsBase = NULL;
+    redVoxels = greenVoxels = blueVoxels = NULL;
+    voxels = NULL; // aliased one of the channels
+    std::cout << "Interleaved voxels: " << COMPONENT_STRIDE * n << " bytes" << std::endl;
+} // end interleave()
+
+/*
+ * isInterleaved
+ *
+ * return - bool
+ */
+bool Volume::isInterleaved(void) const {
+    return interleavedVoxels != NULL;
+} // end isInterleaved()
+
+/*
+ * getInterleavedVoxels
+ *
+ * return - const unsigned char*
+ */
+const unsigned char* Volume::getInterleavedVoxels(void) const {
+    return interleavedVoxels;
+} // end getInterleavedVoxels()
+
 /*
  * getLeafSize
  *
@@ -560,6 +1112,65 @@ void Volume::setMaximumPriorityQueueSize(int _maximumPriorityQueueSize) {
     maximumPriorityQueueSize = _maximumPriorityQueueSize;
 } // end setMaximumPriorityQueueSize()
 
+/*
+ * fitMemoryBudget - Fall back to compact formats while the volume would not fit the memory budget.
+ *
+ * Call once the voxels are loaded, or allocated on a render node about to receive them, and
+ * before the gradients are calculated. The float and int voxels the byte voxels were converted
+ * from are released first, then the gradients are quantized to RGBA8 texels, a quarter of the
+ * float gradients they would otherwise take.
+ */
+void Volume::fitMemoryBudget(void) {
+    if (memoryBudget == 0)
+        return;
+    MemoryAccount memoryAccount;
+    accountMemory(memoryAccount);
+    size_t n = size_t(size[0]) * size[1] * size[2];
+    size_t projected = memoryAccount.getHostBytes();
+    // Only scalar volumes have gradients
+    bool pendingGradient = numberOfComponents == 0 && gradients == NULL && gradientTexels == NULL;
+    if (pendingGradient && !quantizedGradient)
+        projected += 4 * sizeof(float) * n;
+    if (projected > memoryBudget && (floatVoxelsBase != NULL || intVoxelsBase != NULL)) {
+        delete[] floatVoxelsBase;
+        floatVoxelsBase = NULL;
+        delete[] intVoxelsBase;
+        intVoxelsBase = NULL;
+        projected -= memoryAccount.getBytes(MEMORY_SOURCE_VOXELS);
+        std::cout << "Memory budget: released " << memoryAccount.getBytes(MEMORY_SOURCE_VOXELS)
+                << " bytes of source voxels" << std::endl;
+    }
+    if (projected > memoryBudget && numberOfComponents == 0 && !quantizedGradient) {
+        quantizedGradient = true;
+        if (gradients != NULL && gradientStride == 4)
+            quantizeGradient(); // calculated while loading
+        if (pendingGradient || gradientTexels != NULL)
+            projected -= 3 * sizeof(float) * n;
+        std::cout << "Memory budget: quantizing gradients to " << 4 * n << " bytes" << std::endl;
+    }
+    if (projected > memoryBudget)
+        std::cout << "Memory budget: " << projected << " bytes still exceed the budget of " << memoryBudget << " bytes"
+                << std::endl;
+} // end fitMemoryBudget()
+
+/*
+ * getMemoryBudget
+ *
+ * return - size_t (host bytes, 0 for no budget)
+ */
+size_t Volume::getMemoryBudget(void) const {
+    return memoryBudget;
+} // end getMemoryBudget()
+
+/*
+ * setMemoryBudget
+ *
+ * parameter _memoryBudget - size_t (host bytes, 0 for no budget)
+ */
+void Volume::setMemoryBudget(size_t _memoryBudget) {
+    memoryBudget = _memoryBudget;
+} // end setMemoryBudget()
+
 /*
  * getMinimumGradient
  *
@@ -569,6 +1180,29 @@ float Volume::getMinimumGradient(void) {
     return minimumGradient;
 } // end getMinimumGradient()
 
+/*
+ * quantizeGradient - Replace the float gradient vectors with RGBA8 texels.
+ */
+void Volume::quantizeGradient(void) {
+    if (gradients == NULL || gradientStride != 4)
+        return;
+    size_t n = size_t(size[0]) * size[1] * size[2];
+    gradientTexels = new unsigned char[4 * n];
+    for (size_t i = 0; i < n; i++)
+        quantizeTexel(gradients + 4 * i, gradientTexels + 4 * i);
+    delete[] gradients;
+    gradients = NULL;
+} // end quantizeGradient()
+
+/*
+ * isQuantizedGradient - Whether the gradients are calculated straight into RGBA8 texels.
+ *
+ * return - bool
+ */
+bool Volume::isQuantizedGradient(void) const {
+    return quantizedGradient;
+} // end isQuantizedGradient()
+
 /*
  * getNumberOfComponents
  *
@@ -587,6 +1221,24 @@ void Volume::setNumberOfComponents(int _numberOfComponents) {
     numberOfComponents = _numberOfComponents;
 } // end setNumberOfComponents()
 
+/*
+ * getNumberOfDecodeThreads
+ *
+ * return - int
+ */
+int Volume::getNumberOfDecodeThreads(void) const {
+    return numberOfDecodeThreads;
+} // end getNumberOfDecodeThreads()
+
+/*
+ * setNumberOfDecodeThreads
+ *
+ * parameter _numberOfDecodeThreads - int
+ */
+void Volume::setNumberOfDecodeThreads(int _numberOfDecodeThreads) {
+    numberOfDecodeThreads = _numberOfDecodeThreads;
+} // end setNumberOfDecodeThreads()
+
 /*
  * getNumberOfVoxels
  *
@@ -657,6 +1309,10 @@ void Volume::setRedByteVoxelsBase(unsigned char* _redByteVoxelsBase) {
  * return - unsigned char
  */
 unsigned char Volume::getRedVoxel(int i) const {
+    if (interleavedVoxels != NULL)
+        return interleavedVoxels[COMPONENT_STRIDE * i + 0];
+    if (compressedRedVoxels != NULL)
+        return compressedRedVoxels->getVoxel(i);
     return redVoxels[i];
 } // getRedVoxel()
 
@@ -669,6 +1325,10 @@ unsigned char Volume::getRedVoxel(int i) const {
  * return - unsigned char
  */
 unsigned char Volume::getRedVoxel(int i, int j, int k) const {
+    if (interleavedVoxels != NULL)
+        return interleavedVoxels[COMPONENT_STRIDE * (i * increments[0] + j * increments[1] + k) + 0];
+    if (compressedRedVoxels != NULL)
+        return compressedRedVoxels->getVoxel(i * increments[0] + j * increments[1] + k);
     return redVoxels[i * increments[0] + j * increments[1] + k];
 } // getRedVoxel()
 
@@ -711,6 +1371,36 @@ void Volume::setRedVoxels(unsigned char* _redVoxels) {
     redVoxels = _redVoxels;
 } // end setRedVoxels()
 
+/*
+ * getRegionOfInterest
+ *
+ * return - const int* (first and last inline, crossline and sample)
+ */
+const int* Volume::getRegionOfInterest(void) const {
+    return regionOfInterest;
+} // end getRegionOfInterest()
+
+/*
+ * hasRegionOfInterest
+ *
+ * return - bool
+ */
+bool Volume::hasRegionOfInterest(void) const {
+    return regionOfInterest != NULL;
+} // end hasRegionOfInterest()
+
+/*
+ * setRegionOfInterest
+ *
+ * parameter _regionOfInterest - const int[6] (first and last inline, crossline and sample)
+ */
+void Volume::setRegionOfInterest(const int _regionOfInterest[6]) {
+    if (regionOfInterest == NULL)
+        regionOfInterest = new int[6];
+    for (int i = 0; i < 6; i++)
+        regionOfInterest[i] = _regionOfInterest[i];
+} // end setRegionOfInterest()
+
 /*
  * getScale
  *
@@ -789,6 +1479,24 @@ void Volume::setSliceFactor(float _sliceFactor) {
     sliceFactor = _sliceFactor;
 } // end setSliceFactor()
 
+/*
+ * isTextureAtlas
+ *
+ * return - bool
+ */
+bool Volume::isTextureAtlas(void) {
+    return textureAtlas;
+} // end isTextureAtlas()
+
+/*
+ * setTextureAtlas
+ *
+ * parameter _textureAtlas - bool
+ */
+void Volume::setTextureAtlas(bool _textureAtlas) {
+    textureAtlas = _textureAtlas;
+} // end setTextureAtlas()
+
 /*
  * getTextureSize
  *
@@ -807,6 +1515,38 @@ void Volume::setTextureSize(int _textureSize) {
     textureSize = _textureSize;
 } // end setTextureSize()
 
+/*
+ * tile - Replace the byte voxels of a scalar volume with a cache line tiled copy.
+ */
+void Volume::tile(void) {
+    if (isTiled() || !hasVoxels())
+        return;
+    tiledVoxels = new TiledVolume();
+    tiledVoxels->tile(voxels, getWidth(), getHeight(), getDepth());
+    delete[] byteVoxelsBase;
+    byteVoxelsBase = NULL;
+    voxels = NULL;
+    std::cout << "Tiled voxels: " << tiledVoxels->getSize() << " bytes in " << TILE_SIZE << "^3 tiles" << std::endl;
+} // end tile()
+
+/*
+ * isTiled
+ *
+ * return - bool
+ */
+bool Volume::isTiled(void) const {
+    return tiledVoxels != NULL;
+} // end isTiled()
+
+/*
+ * getTiledVoxels
+ *
+ * return - const TiledVolume*
+ */
+const TiledVolume* Volume::getTiledVoxels(void) const {
+    return tiledVoxels;
+} // end getTiledVoxels()
+
 /*
  * getTypeOfComponents
  *
@@ -848,6 +1588,10 @@ void Volume::setVolumeBox(void) {
  * return - unsigned char
  */
 unsigned char Volume::getVoxel(int i) const {
+    if (compressedVoxels != NULL)
+        return compressedVoxels->getVoxel(i);
+    if (tiledVoxels != NULL)
+        return tiledVoxels->getVoxel(i);
     return voxels[i];
 } // getVoxel()
 
@@ -860,9 +1604,94 @@ unsigned char Volume::getVoxel(int i) const {
  * return - unsigned char
  */
 unsigned char Volume::getVoxel(int i, int j, int k) const {
+    if (compressedVoxels != NULL)
+        return compressedVoxels->getVoxel(i * increments[0] + j * increments[1] + k);
+    if (tiledVoxels != NULL)
+        return tiledVoxels->getVoxel(i * increments[0] + j * increments[1] + k);
     return voxels[i * increments[0] + j * increments[1] + k];
 } // getVoxel()
 
+/*
+ * getComponentRegion - Copy a region of a multi-component volume into an x fastest buffer of red, green, blue triples.
+ *
+ * parameter column - int
+ * parameter row - int
+ * parameter slab - int
+ * parameter width - int
+ * parameter height - int
+ * parameter depth - int
+ * parameter destination - unsigned char*
+ */
+void Volume::getComponentRegion(int column, int row, int slab, int width, int height, int depth,
+        unsigned char* destination) {
+    int w = getWidth();
+    int h = getHeight();
+    if (interleavedVoxels != NULL) {
+        for (int k = 0; k < depth; k++) {
+            for (int j = 0; j < height; j++) {
+                memcpy(destination + COMPONENT_STRIDE * ((k * height) + j) * width, interleavedVoxels + COMPONENT_STRIDE
+                        * ((size_t(slab + k) * h + (row + j)) * w + column), COMPONENT_STRIDE * width);
+            } // end for
+        } // end for
+        return;
+    } // end if
+    const CompressedVolume* compressedChannels[] = { compressedRedVoxels, compressedGreenVoxels, compressedBlueVoxels };
+    const unsigned char* channels[] = { redVoxels, greenVoxels, blueVoxels };
+    size_t n = size_t(width) * height * depth;
+    unsigned char* channel = new unsigned char[n];
+    for (int c = 0; c < COMPONENT_STRIDE; c++) {
+        if (compressedChannels[c] != NULL) {
+            compressedChannels[c]->decode(column, row, slab, width, height, depth, channel, width, width * height,
+                    numberOfDecodeThreads);
+        } else if (channels[c] != NULL) {
+            for (int k = 0; k < depth; k++) {
+                for (int j = 0; j < height; j++) {
+                    memcpy(channel + ((k * height) + j) * width, channels[c] + (size_t(slab + k) * h + (row + j)) * w
+                            + column, width);
+                } // end for
+            } // end for
+        } else {
+            memset(channel, 0, n);
+        } // end if
+        for (size_t i = 0; i < n; i++)
+            destination[COMPONENT_STRIDE * i + c] = channel[i];
+    } // end for
+    delete[] channel;
+} // end getComponentRegion()
+
+/*
+ * getVoxelRegion - Copy a region of the byte voxels into an x fastest buffer, whatever the storage.
+ *
+ * parameter column - int
+ * parameter row - int
+ * parameter slab - int
+ * parameter width - int
+ * parameter height - int
+ * parameter depth - int
+ * parameter destination - unsigned char*
+ * parameter rowPitch - int
+ * parameter slicePitch - int
+ */
+void Volume::getVoxelRegion(int column, int row, int slab, int width, int height, int depth, unsigned char* destination,
+        int rowPitch, int slicePitch) const {
+    if (compressedVoxels != NULL) {
+        compressedVoxels->decode(column, row, slab, width, height, depth, destination, rowPitch, slicePitch,
+                numberOfDecodeThreads);
+        return;
+    }
+    if (tiledVoxels != NULL) {
+        tiledVoxels->extract(column, row, slab, width, height, depth, destination, rowPitch, slicePitch);
+        return;
+    }
+    int w = size[0];
+    int h = size[1];
+    for (int k = 0; k < depth; k++) {
+        for (int j = 0; j < height; j++) {
+            memcpy(destination + k * slicePitch + j * rowPitch, voxels + (size_t(slab + k) * h + (row + j)) * w + column, width);
+        } // end for
+    } // end for
+} // end getVoxelRegion()
+
 /*
  * getVoxelPtr
  *
@@ -966,80 +1795,6 @@ int Volume::nextPowerOfTwo(int n) {
     return number;
 } // end nextPowerOfTwo()
 
-/*
- * resize
- */
-void Volume::resize(void) {
-    int w = 0;
-    int h = 0;
-    int d = 0;
-    int start_width = 0;
-    int start_height = 0;
-    int start_depth = 0;
-    if (!isPowerOfTwo(getWidth())) {
-        w = nextPowerOfTwo(getWidth());
-        start_width = (w - getWidth()) / 2;
-    }
-    if (!isPowerOfTwo(getHeight())) {
-        h = nextPowerOfTwo(getHeight());
-        start_height = (h - getHeight()) / 2;
-    }
-    if (!isPowerOfTwo(getDepth())) {
-        d = nextPowerOfTwo(getDepth());
-        start_depth = (d - getDepth()) / 2;
-    }
-    if ((w != 0) || (h != 0) || (d != 0)) {
-        if (w == 0) {
-            w = getWidth();
-        }
-        if (h == 0) {
-            h = getHeight();
-        }
-        if (d == 0) {
-            d = getDepth();
-        }
-        int _size[3];
-        _size[0] = w;
-        _size[1] = h;
-        _size[2] = d;
-        int _borderSize = 0;
-        int _numberOfVoxels = (_size[0] + 2 * _borderSize) * (_size[1] + 2 * _borderSize) * (_size[2] + 2 * _borderSize);
-        unsigned char* _voxelsBase = new unsigned char[_numberOfVoxels];
-        for (int k = 0; k < getDepth(); k++) {
-            for (int j = 0; j < getHeight(); j++) {
-                for (int i = 0; i < getWidth(); i++) {
-                    _voxelsBase[((start_depth + k) * (w * h)) + ((start_height + j) * w) + (start_width + i)] = voxels[(k
-                            * (getWidth() * getHeight())) + (j * getWidth()) + i];
-                }
-            }
-        }
-        Point _origin = Point::origin;
-        Size _extent;
-        Point _center;
-        for (int i = 0; i < 3; ++i) {
-            _extent[i] = Scalar(_size[i]) * scale[i];
-            _center[i] = _origin[i] + _extent[i] * Scalar(0.5);
-        }
-        unsigned char* _voxels = _voxelsBase + borderSize;
-        int _increments[3];
-        _increments[2] = 1;
-        for (int i = 2; i > 0; --i) {
-            _increments[i - 1] = _increments[i] * (_size[i] + 2 * _borderSize);
-            _voxels += _borderSize * _increments[i - 1];
-        }
-        setNumberOfVoxels(_numberOfVoxels);
-        setSize(_size);
-        setOrigin(_origin);
-        setExtent(_extent);
-        setCenter(_center);
-        delete byteVoxelsBase;
-        setByteVoxelsBase(_voxelsBase);
-        setBorderSize(_borderSize);
-        setIncrements(_increments);
-        setVoxels(_voxels);
-    }
-} // end resize()
-
 /*
  * resize
  */
@@ -17,6 +17,9 @@
 #include <DATA/DataSet.h>
 // begin Forward Declarations
 class BoundingBox;
+class CompressedVolume;
+class MemoryAccount;
+class TiledVolume;
 // end Forward Declarations
 
 class Volume: public DataSet {
@@ -26,9 +29,24 @@ public:
     typedef Geometry::Point<Scalar,3> Point;
     explicit Volume();
     ~Volume();
+    bool isAdaptiveBricks(void) const;
+    void setAdaptiveBricks(bool _adaptiveBricks);
+    void accountMemory(MemoryAccount& memoryAccount) const;
+    void allocateGradient(void);
     void calculateGradient(void);
+    void calculateGradient(int firstSlab, int lastSlab);
     int calculateMaximum(int column, int row, int slab, int width, int height, int depth);
     int calculateMinimum(int column, int row, int slab, int width, int height, int depth);
+    void calculateComponentVisibility(int column, int row, int slab, int width, int height, int depth, const float* red,
+            const float* green, const float* blue, float& visibility, float& transparent);
+    unsigned int calculateValueMask(int column, int row, int slab, int width, int height, int depth);
+    void compress(void);
+    bool isCompressed(void) const;
+    const CompressedVolume* getCompressedBlueVoxels(void) const;
+    const CompressedVolume* getCompressedGreenVoxels(void) const;
+    const CompressedVolume* getCompressedRedVoxels(void) const;
+    const CompressedVolume* getCompressedVoxels(void) const;
+    void decompress(void);
     const unsigned char* getBlueByteVoxelsBase(void) const;
     bool hasBlueByteVoxelsBase(void) const;
     void setBlueByteVoxelsBase(unsigned char* _blueByteVoxelsBase);
@@ -104,8 +122,13 @@ public:
     const float* getFloatVoxelsBase(void) const;
     bool hasFloatVoxelsBase(void) const;
     void setFloatVoxelsBase(float* _floatVoxelsBase);
+    void fitMemoryBudget(void);
     float getGradient(int i, int j, int k);
     float getGradient(int i);
+    void getGradientTexel(int i, unsigned char* texel);
+    bool hasGradientVectors(void) const;
+    bool isGradientTexture(void);
+    void setGradientTexture(bool _gradientTexture);
     const unsigned char* getGreenByteVoxelsBase(void) const;
     bool hasGreenByteVoxelsBase(void) const;
     void setGreenByteVoxelsBase(unsigned char* _greenByteVoxelsBase);
@@ -115,6 +138,8 @@ public:
     const unsigned char* getGreenVoxels(void) const;
     bool hasGreenVoxels(void) const;
     void setGreenVoxels(unsigned char* _greenVoxels);
+    bool isIlluminationCache(void);
+    void setIlluminationCache(bool _illuminationCache);
     int getWidth(void);
     int getHeight(void);
     void setHeight(int height);
@@ -126,6 +151,9 @@ public:
     const int* getIntVoxelsBase(void) const;
     bool hasIntVoxelsBase(void) const;
     void setIntVoxelsBase(int* _intVoxelsBase);
+    void interleave(void);
+    bool isInterleaved(void) const;
+    const unsigned char* getInterleavedVoxels(void) const;
     /*
      * getMaximum
      *
@@ -141,6 +169,8 @@ public:
     float getMaximumGradient(void);
     int getMaximumPriorityQueueSize(void);
     void setMaximumPriorityQueueSize(int _maximumPriorityQueueSize);
+    size_t getMemoryBudget(void) const;
+    void setMemoryBudget(size_t _memoryBudget);
     /*
      * getMinimum
      *
@@ -151,8 +181,12 @@ public:
     }
     ; // end getMinimum()
     float getMinimumGradient(void);
+    void quantizeGradient(void);
+    bool isQuantizedGradient(void) const;
     int getNumberOfComponents(void) const;
     void setNumberOfComponents(int _numberOfComponents);
+    int getNumberOfDecodeThreads(void) const;
+    void setNumberOfDecodeThreads(int _numberOfDecodeThreads);
     int getNumberOfVoxels(void) const;
     void setNumberOfVoxels(int _numberOfVoxels);
     /*
@@ -193,6 +227,9 @@ public:
     const unsigned char* getRedVoxels(void) const;
     bool hasRedVoxels(void) const;
     void setRedVoxels(unsigned char* _redVoxels);
+    const int* getRegionOfInterest(void) const;
+    bool hasRegionOfInterest(void) const;
+    void setRegionOfInterest(const int _regionOfInterest[6]);
     const float* getScale(void) const;
     float getScale(int dimension);
     void setScale(float _scale[3]);
@@ -201,12 +238,20 @@ public:
     void setSize(int _size[3]);
     float getSliceFactor(void) const;
     void setSliceFactor(float _sliceFactor);
+    bool isTextureAtlas(void);
+    void setTextureAtlas(bool _textureAtlas);
     int getTextureSize(void);
     void setTextureSize(int _textureSize);
+    void tile(void);
+    bool isTiled(void) const;
+    const TiledVolume* getTiledVoxels(void) const;
     int getTypeOfComponents(void);
     void setTypeOfComponents(int _typeOfComponents);
     BoundingBox* getVolumeBox(void);
     void setVolumeBox(void);
+    void getComponentRegion(int column, int row, int slab, int width, int height, int depth, unsigned char* destination);
+    void getVoxelRegion(int column, int row, int slab, int width, int height, int depth, unsigned char* destination,
+            int rowPitch, int slicePitch) const;
     unsigned char getVoxel(int i) const;
     unsigned char getVoxel(int i, int j, int k) const;
     const unsigned char* getVoxelPtr(int i, int j, int k) const;
@@ -217,7 +262,6 @@ public:
     bool isPowerOfTwo(int n);
     int nextPowerOfTwo(int n);
     void resize(unsigned char tmpByte);
-    void resize(void);
     std::string toString();
     void setSliceIndexDir (int sliceIndDir[3]);
     void setSliceIndexDir (int dimension, int sliceIndDir);
@@ -225,36 +269,55 @@ public:
     int getSliceIndexDir (int dimension);
 
 private:
+    bool adaptiveBricks; // partition the occupied voxels into bricks with a kd-tree instead of a regular grid
     const unsigned char* blueByteVoxelsBase;
     const unsigned char* blueVoxels;
     int borderSize;
     const unsigned char* byteVoxelsBase;
     Point center;
+    CompressedVolume* compressedBlueVoxels;
+    CompressedVolume* compressedGreenVoxels;
+    CompressedVolume* compressedRedVoxels;
+    CompressedVolume* compressedVoxels;
     Size extent;
     const float* floatVoxelsBase;
     float* gradients;
+    int gradientStride;
+    unsigned char* gradientTexels; // RGBA8 quantized gradients replacing gradients, NULL unless quantized
+    bool gradientTexture; // upload quantized gradients with the bricks instead of differencing in the shaders
     const unsigned char* greenByteVoxelsBase;
     const unsigned char* greenVoxels;
+    bool illuminationCache; // bake the lit colors of the bricks, keeping the gradient vectors
     int leafSize;
     int* increments;
     const int* intVoxelsBase;
+    unsigned char* interleavedVoxels; // red, green and blue of each voxel side by side, NULL unless interleaved
     float maximumGradient;
     float minimumGradient;
     int maximumPriorityQueueSize;
+    size_t memoryBudget; // host bytes the loaders fall back to compact formats to fit, 0 for no budget
     int numberOfComponents;
+    int numberOfDecodeThreads;
     int numberOfVoxels;
     Point origin;
+    bool quantizedGradient; // calculate the gradients straight into RGBA8 texels
     float ratioOfVisibilityThreshold;
     const unsigned char* redByteVoxelsBase;
     const unsigned char* redVoxels;
+    int* regionOfInterest; // inline, crossline and sample ranges to load, NULL for everything
     float* scale;
     int* size;
     float sliceFactor;
+    bool textureAtlas; // pack the occupied octree blocks into one shared texture
     int textureSize;
+    TiledVolume* tiledVoxels; // cache line tiled copy replacing voxels, NULL unless tiled
     int typeOfComponents;
     BoundingBox* volumeBox;
     const unsigned char* voxels;
+    void calculateDifference(int i, int j, int k, float* gradient) const;
+    void calculateQuantizedGradient(void);
     void initialize(void);
+    void quantizeTexel(const float* gradient, unsigned char* texel) const;
     int *sliceIndexDir;
 };
 
@@ -15,7 +15,8 @@
 /*
  * BoundingBox
  */
-BoundingBox::BoundingBox(void) {
+BoundingBox::BoundingBox(void) :
+	ownsData(true) {
 	data = new float[24];
 	setCorners(0, 0, 0, 1, 1, 1);
 	maximumIndex = 7;
@@ -32,19 +33,39 @@ BoundingBox::BoundingBox(void) {
  * parameter extentY - float
  * parameter extentZ - float
  */
-BoundingBox::BoundingBox(float originX, float originY, float originZ, float extentX, float extentY, float extentZ) {
+BoundingBox::BoundingBox(float originX, float originY, float originZ, float extentX, float extentY, float extentZ) :
+	ownsData(true) {
 	data = new float[24];
 	setCorners(originX, originY, originZ, extentX, extentY, extentZ);
 	maximumIndex = 7;
 	minimumIndex = 0;
 } // end BoundingBox()
 
+/*
+ * BoundingBox - Keep the corners in caller owned storage of 24 floats, e.g. an OcNodePool.
+ *
+ * parameter originX - float
+ * parameter originY - float
+ * parameter originZ - float
+ * parameter extentX - float
+ * parameter extentY - float
+ * parameter extentZ - float
+ * parameter _data - float*
+ */
+BoundingBox::BoundingBox(float originX, float originY, float originZ, float extentX, float extentY, float extentZ, float* _data) :
+	data(_data), ownsData(false) {
+	setCorners(originX, originY, originZ, extentX, extentY, extentZ);
+	maximumIndex = 7;
+	minimumIndex = 0;
+} // end BoundingBox()
+
 /*
  * BoundingBox
  * 
  * parameter _data - float*
  */
-BoundingBox::BoundingBox(float* _data) {
+BoundingBox::BoundingBox(float* _data) :
+	ownsData(true) {
 	data = new float[24];
 	for (int i = 0; i< 24; i++)
 		data[i] = _data[i];
@@ -53,7 +74,8 @@ BoundingBox::BoundingBox(float* _data) {
 } // end BoundingBox()
 
 BoundingBox::~BoundingBox(void) {
-	delete[] data;
+	if (ownsData)
+		delete[] data;
 } // end ~BoundingBox()
 
 /*
@@ -715,6 +737,21 @@ float* BoundingBox::midPoint(float* p, float* q) {
 	return point;
 } // end midPoint()
 
+/*
+ * scaleCoordinates
+ *
+ * parameter sx - float
+ * parameter sy - float
+ * parameter sz - float
+ */
+void BoundingBox::scaleCoordinates(float sx, float sy, float sz) {
+	for (int i = 0; i < 8; i++) {
+		data[corner(i,0)] *= sx;
+		data[corner(i,1)] *= sy;
+		data[corner(i,2)] *= sz;
+	}
+} // end scaleCoordinates()
+
 /*
  * subtract
  * 
@@ -39,6 +39,7 @@ public:
 	BoundingBox(void);
 	BoundingBox(float* _data);
 	BoundingBox(float originX, float originY, float originZ, float extentX, float extentY, float extentZ);
+	BoundingBox(float originX, float originY, float originZ, float extentX, float extentY, float extentZ, float* _data);
 	~BoundingBox(void);
 	void adjustCoordinates(float dx, float dy, float dz);
 	bool collision(float* point);
@@ -71,6 +72,7 @@ public:
 	float getY(int which);
 	float getZ(int which);
 	float* midPoint(float* p, float* q);
+	void scaleCoordinates(float sx, float sy, float sz);
 	float* subtract(float* a, float* b);
 	std::string toString(void) ;
 	void transform(const Matrix4x4 & matrix);
@@ -79,6 +81,7 @@ private:
 	float* data;
 	int maximumIndex;
 	int minimumIndex;
+	bool ownsData; // false when data lives in an OcNodePool
 };
 
 #endif /*BOUNDINGBOX_H_*/
@@ -10,7 +10,8 @@
 /*
  * BoundingSphere - Constructor for BoundingSphere class
  */
-BoundingSphere::BoundingSphere(void) {
+BoundingSphere::BoundingSphere(void) :
+	ownsCenter(true) {
 	center = new float[3];
 	center[0] = 0.0f;
 	center[1] = 0.0f;
@@ -26,7 +27,8 @@ BoundingSphere::BoundingSphere(void) {
  * parameter z - float
  * parameter _radius - float
  */
-BoundingSphere::BoundingSphere(float x, float y, float z, float _radius) {
+BoundingSphere::BoundingSphere(float x, float y, float z, float _radius) :
+	ownsCenter(true) {
 	center = new float[3];
 	center[0] = x;
 	center[1] = y;
@@ -34,13 +36,31 @@ BoundingSphere::BoundingSphere(float x, float y, float z, float _radius) {
 	radius = _radius;
 } // end BoundingSphere()
 
+/*
+ * BoundingSphere - Constructor for BoundingSphere class keeping the center in caller owned storage.
+ * 
+ * parameter x - float
+ * parameter y - float
+ * parameter z - float
+ * parameter _radius - float
+ * parameter _center - float* (3 floats, e.g. from an OcNodePool)
+ */
+BoundingSphere::BoundingSphere(float x, float y, float z, float _radius, float* _center) :
+	center(_center), ownsCenter(false) {
+	center[0] = x;
+	center[1] = y;
+	center[2] = z;
+	radius = _radius;
+} // end BoundingSphere()
+
 /*
  * BoundingSphere - Constructor for BoundingSphere class
  * 
  * parameter _center - float*
  * parameter _radius - float
  */
-BoundingSphere::BoundingSphere(float* _center, float _radius) {
+BoundingSphere::BoundingSphere(float* _center, float _radius) :
+	ownsCenter(true) {
 	center = new float[3];
 	center[0] = _center[0];
 	center[1] = _center[1];
@@ -52,7 +72,8 @@ BoundingSphere::BoundingSphere(float* _center, float _radius) {
  * ~BoundingSphere - Destructor for BoundingSphere class
  */
 BoundingSphere::~BoundingSphere(void) {
-	delete[] center;
+	if (ownsCenter)
+		delete[] center;
 } // end ~BoundingSphere()
 
 /*
@@ -12,6 +12,7 @@ class BoundingSphere {
 public:
 	BoundingSphere();
 	BoundingSphere(float x, float y, float z, float _radius);
+	BoundingSphere(float x, float y, float z, float _radius, float* _center);
 	BoundingSphere(float* _center, float _radius);
 	~BoundingSphere();
 	float* getCenter(void);
@@ -21,6 +22,7 @@ public:
 	void setRadius(float _radius);
 private:
 	float* center;
+	bool ownsCenter; // false when center lives in an OcNodePool
 	float radius;
 };
 
@@ -5,15 +5,19 @@
  * Created: December 31, 2007
  * Copyright 2007. All rights reserved.
  */
-#include <queue>
+#include <algorithm>
+#include <cstring>
 
+#include <DATA/ComponentKernels.h>
+#include <DATA/CompressedVolume.h>
+#include <DATA/TiledVolume.h>
 #include <DATA/Volume.h>
 #include <DATASTRUCTURE/Brick.h>
 #include <DATASTRUCTURE/BoundingBox.h>
 #include <DATASTRUCTURE/BoundingSphere.h>
-#include <DATASTRUCTURE/ComparableOcNode.h>
 #include <DATASTRUCTURE/OcNode.h>
 #include <DATASTRUCTURE/OcTree.h>
+#include <DATASTRUCTURE/StagingCache.h>
 #include <GRAPHIC/CFrustum.h>
 #include <MATH/Matrix4x4.h>
 #include <SHADER/ShaderObject.h>
@@ -21,33 +25,70 @@
 Brick::DataItem::DataItem(void) {
     texture3DName = 0;
     downSamplingTexture3DName = 0;
+    gradientTexture3DName = 0;
+    illuminatedTexture3DName = 0;
+    illuminationVersion = 0;
 }
 
 Brick::DataItem::~DataItem(void) {
+    if (illuminatedTexture3DName != 0)
+        glDeleteTextures(1, &illuminatedTexture3DName);
     texture3DName = 0;
     downSamplingTexture3DName = 0;
+    gradientTexture3DName = 0;
+    illuminatedTexture3DName = 0;
 }
 
 Brick::Brick(void) :
     borderSize(1), column(0), depth(0), downSamplingChanged(false), empty(false), height(0), interactive(false),
-            maximumPriorityQueueSize(0), ocTree(NULL), row(0), showBricks(false), showXSlice(false), showYSlice(false), showZSlice(
-                    false), slab(0), sliceFactor(1.5), slicingScale(2.0), volume(NULL), volumeBox(NULL), volumeSphere(NULL), width(
+            ocTree(NULL), paddedDepth(0), paddedHeight(0), paddedWidth(0), powerOfTwo(false), resident(true), row(0), showBricks(false), showXSlice(false), showYSlice(false), showZSlice(
+                    false), slab(0), sliceFactor(1.5), slicingScale(2.0), stagingCache(NULL), volume(NULL), volumeBox(NULL), volumeSphere(NULL), width(
                     0), x(0), xSlice(0), xStep(2), y(0), ySlice(0), yStep(2), z(0), zSlice(0), zStep(2) {
 }
 
 Brick::~Brick(void) {
     volume = 0;
     delete ocTree;
+    delete volumeBox;
+    delete volumeSphere;
 }
 
 /*
- * adjustTextureCoordinates
+ * acquireStaging - Get the host copy of a texture, built once and shared by all GL contexts.
+ *
+ * parameter level - int (STAGING_TEXTURE, STAGING_DOWN_SAMPLED_TEXTURE or STAGING_GRADIENT_TEXTURE)
+ * parameter bordersize - int
+ * return - const unsigned char*
+ */
+const unsigned char* Brick::acquireStaging(int level, int bordersize) const {
+    if (stagingCache != NULL) {
+        const unsigned char* voxels = stagingCache->lookup(this, level);
+        if (voxels != NULL)
+            return voxels;
+    } // end if
+    unsigned char* voxels = stage3DTexture(level, bordersize);
+    if (powerOfTwo)
+        voxels = padTexture(level, bordersize, voxels);
+    if (stagingCache != NULL) {
+        int voxelSize[3];
+        int textureSize[3];
+        getTextureSize(level, bordersize, voxelSize, textureSize);
+        const int* stagedSize = powerOfTwo ? textureSize : voxelSize;
+        stagingCache->insert(this, level, voxels, getComponents(level) * size_t(stagedSize[0]) * stagedSize[1]
+                * stagedSize[2]);
+    } // end if
+    return voxels;
+} // end acquireStaging()
+
+/*
+ * adjustTextureCoordinates - Fit the texture coordinates of the octree nodes to the voxels of a padded texture.
  */
 void Brick::adjustTextureCoordinates(void) {
     float dx = 0.0f; // 1.0f/float(width + 2 * borderSize)/2.0f;
     float dy = 0.0f; // 1.0f/float(height + 2 * borderSize)/2.0f;
     float dz = 0.0f; // 1.0f/float(depth + 2 * borderSize)/2.0f;
-    ocTree->getRoot()->adjustTextureCoordinatesTraversal(dx, dy, dz);
+    ocTree->getRoot()->adjustTextureCoordinatesTraversal(dx, dy, dz, float(width) / float(paddedWidth), float(height)
+            / float(paddedHeight), float(depth) / float(paddedDepth));
 } // end adjustTextureCoordinates()
 
 /*
@@ -90,11 +131,10 @@ GLuint Brick::create3DTexture(void) const {
  * return - GLuint
  */
 GLuint Brick::create3DTexture(int bordersize) const {
-    unsigned char *voxels = new unsigned char[(width+(2*bordersize))*
-                                              (height+(2*bordersize))*
-                                              (depth+(2*bordersize))];
-
-    fill3DTexture (bordersize, voxels);
+    const unsigned char* voxels = acquireStaging(STAGING_TEXTURE, bordersize);
+    int voxelSize[3];
+    int textureSize[3];
+    getTextureSize(STAGING_TEXTURE, bordersize, voxelSize, textureSize);
 
     GLuint name;
     glEnable(GL_TEXTURE_3D);
@@ -105,13 +145,11 @@ GLuint Brick::create3DTexture(int bordersize) const {
     glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_BORDER);
     glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR); // GL_LINEAR GL_NEAREST
     glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexImage3D(GL_TEXTURE_3D, 0, GL_LUMINANCE_ALPHA,
-            (width+(2*bordersize)), (height+(2*bordersize)),
-            (depth+(2*bordersize)), bordersize,
+    glTexImage3D(GL_TEXTURE_3D, 0, GL_LUMINANCE_ALPHA, textureSize[0], textureSize[1], textureSize[2], bordersize,
             GL_LUMINANCE, GL_UNSIGNED_BYTE, voxels);
     glBindTexture(GL_TEXTURE_3D, 0);
     glDisable(GL_TEXTURE_3D);
-    delete[] voxels;
+    releaseStaging(STAGING_TEXTURE, voxels);
     return name;
 } // end create3DTexture()
 
@@ -121,36 +159,10 @@ GLuint Brick::create3DTexture(int bordersize) const {
  * return - GLuint
  */
 GLuint Brick::createDownSampling3DTexture(void) const {
-    unsigned char* voxels = new unsigned char[width * height * depth];
-    int w = volume->getWidth();
-    int h = volume->getHeight();
-    for (int k = 0; k < depth; k++) {
-        for (int j = 0; j < height; j++) {
-            for (int i = 0; i < width; i++) {
-                voxels[(k * ((width) * (height))) + (j *( width)) +i] = volume->getVoxel(((slab + (k)) * (w * h)) + ((row + (j))
-                        * (w)) + (column + (i)));
-            } // end for
-        } // end for
-    } // end for
-    int newWidth = int(width / xStep);
-    int newHeight = int(height / yStep);
-    int newDepth = int(depth / zStep);
-    unsigned char* downSamplingVoxels = new unsigned char[newWidth * newHeight * newDepth];
-    int ktmp;
-    int jtmp;
-    int itmp;
-    for (int k = 0; k < newDepth; k++) {
-        k == 0 ? ktmp = 0 : ktmp = k * zStep - 1;
-        for (int j = 0; j < newHeight; j++) {
-            j == 0 ? jtmp = 0 : jtmp = j * yStep - 1;
-            for (int i = 0; i < newWidth; i++) {
-                i == 0 ? itmp = 0 : itmp = i * xStep - 1;
-                downSamplingVoxels[(k * ((newWidth) * (newHeight))) + (j *( newWidth)) +i] = voxels[(ktmp * ((width) * (height)))
-                        + (jtmp *( width)) +itmp];
-            } // end for
-        } // end for
-    } // end for
-    delete[] voxels;
+    int voxelSize[3];
+    int textureSize[3];
+    getTextureSize(STAGING_DOWN_SAMPLED_TEXTURE, 0, voxelSize, textureSize);
+    const unsigned char* downSamplingVoxels = acquireStaging(STAGING_DOWN_SAMPLED_TEXTURE, 0);
     GLuint name;
     glEnable(GL_TEXTURE_3D);
     glGenTextures(1, &name);
@@ -160,11 +172,11 @@ GLuint Brick::createDownSampling3DTexture(void) const {
     glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexImage3D(GL_TEXTURE_3D, 0, GL_LUMINANCE_ALPHA, newWidth, newHeight, newDepth, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE,
-            downSamplingVoxels);
+    glTexImage3D(GL_TEXTURE_3D, 0, GL_LUMINANCE_ALPHA, textureSize[0], textureSize[1], textureSize[2], 0, GL_LUMINANCE,
+            GL_UNSIGNED_BYTE, downSamplingVoxels);
     glBindTexture(GL_TEXTURE_3D, 0);
     glDisable(GL_TEXTURE_3D);
-    delete[] downSamplingVoxels;
+    releaseStaging(STAGING_DOWN_SAMPLED_TEXTURE, downSamplingVoxels);
     return name;
 } // end createDownSampling3DTexture()
 
@@ -174,86 +186,10 @@ GLuint Brick::createDownSampling3DTexture(void) const {
  * return - GLuint
  */
 GLuint Brick::createDownSamplingMultiComponent3DTexture(void) const {
-    unsigned char* voxels = new unsigned char[3 * (width) * (height) * (depth)];
-    int w = volume->getWidth();
-    int h = volume->getHeight();
-    if (volume->hasRedByteVoxelsBase()) {
-        for (int k = 0; k < depth; k++) { // red
-            for (int j = 0; j < height; j++) {
-                for (int i = 0; i < width; i++) {
-                    voxels[3 * ((k * ((width) * (height))) + (j *( width)) +i) + 0] = volume->getRedVoxel(((slab + (k)) * (w * h))
-                            + ((row + (j)) * (w)) + (column + (i)));
-                } // end for
-            } // end for
-        } // end for
-    } else {
-        for (int k = 0; k < depth; k++) { // red
-            for (int j = 0; j < height; j++) {
-                for (int i = 0; i < width; i++) {
-                    voxels[3 * ((k * ((width) * (height))) + (j *( width)) +i) + 0] = 0;
-                } // end for
-            } // end for
-        } // end for
-    }
-    if (volume->hasGreenByteVoxelsBase()) {
-        for (int k = 0; k < depth; k++) { // red
-            for (int j = 0; j < height; j++) {
-                for (int i = 0; i < width; i++) {
-                    voxels[3 * ((k * ((width) * (height))) + (j *( width)) +i) + 1] = volume->getGreenVoxel(
-                            ((slab + (k)) * (w * h)) + ((row + (j)) * (w)) + (column + (i)));
-                } // end for
-            } // end for
-        } // end for
-    } else {
-        for (int k = 0; k < depth; k++) { // red
-            for (int j = 0; j < height; j++) {
-                for (int i = 0; i < width; i++) {
-                    voxels[3 * ((k * ((width) * (height))) + (j *( width)) +i) + 1] = 0;
-                } // end for
-            } // end for
-        } // end for
-    }
-    if (volume->hasBlueByteVoxelsBase()) {
-        for (int k = 0; k < depth; k++) { // red
-            for (int j = 0; j < height; j++) {
-                for (int i = 0; i < width; i++) {
-                    voxels[3 * ((k * ((width) * (height))) + (j *( width)) +i) + 2] = volume->getBlueVoxel(((slab + (k)) * (w * h))
-                            + ((row + (j)) * (w)) + (column + (i)));
-                } // end for
-            } // end for
-        } // end for
-    } else {
-        for (int k = 0; k < depth; k++) { // red
-            for (int j = 0; j < height; j++) {
-                for (int i = 0; i < width; i++) {
-                    voxels[3 * ((k * ((width) * (height))) + (j *( width)) +i) + 2] = 0;
-                } // end for
-            } // end for
-        } // end for
-    }
-    int newWidth = int(width / xStep);
-    int newHeight = int(height / yStep);
-    int newDepth = int(depth / zStep);
-    unsigned char* downSamplingVoxels = new unsigned char[3 * newWidth * newHeight * newDepth];
-    int ktmp;
-    int jtmp;
-    int itmp;
-    for (int k = 0; k < newDepth; k++) {
-        k == 0 ? ktmp = 0 : ktmp = k * zStep - 1;
-        for (int j = 0; j < newHeight; j++) {
-            j == 0 ? jtmp = 0 : jtmp = j * yStep - 1;
-            for (int i = 0; i < newWidth; i++) {
-                i == 0 ? itmp = 0 : itmp = i * xStep - 1;
-                downSamplingVoxels[3 * ((k * ((newWidth) * (newHeight))) + (j *( newWidth)) +i) + 0] = voxels[3 * ((ktmp * ((width)
-                        * (height))) + (jtmp *( width)) +itmp) + 0];
-                downSamplingVoxels[3 * ((k * ((newWidth) * (newHeight))) + (j *( newWidth)) +i) + 1] = voxels[3 * ((ktmp * ((width)
-                        * (height))) + (jtmp *( width)) +itmp) + 1];
-                downSamplingVoxels[3 * ((k * ((newWidth) * (newHeight))) + (j *( newWidth)) +i) + 2] = voxels[3 * ((ktmp * ((width)
-                        * (height))) + (jtmp *( width)) +itmp) + 2];
-            } // end for
-        } // end for
-    } // end for
-    delete[] voxels;
+    int voxelSize[3];
+    int textureSize[3];
+    getTextureSize(STAGING_DOWN_SAMPLED_TEXTURE, 0, voxelSize, textureSize);
+    const unsigned char* downSamplingVoxels = acquireStaging(STAGING_DOWN_SAMPLED_TEXTURE, 0);
     GLuint name;
     glEnable(GL_TEXTURE_3D);
     glGenTextures(1, &name);
@@ -263,76 +199,63 @@ GLuint Brick::createDownSamplingMultiComponent3DTexture(void) const {
     glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexImage3D(GL_TEXTURE_3D, 0, GL_RGB, newWidth, newHeight, newDepth, 0, GL_RGB, GL_UNSIGNED_BYTE, downSamplingVoxels);
+    glTexImage3D(GL_TEXTURE_3D, 0, GL_RGB, textureSize[0], textureSize[1], textureSize[2], 0, GL_RGB, GL_UNSIGNED_BYTE,
+            downSamplingVoxels);
     glBindTexture(GL_TEXTURE_3D, 0);
     glDisable(GL_TEXTURE_3D);
-    delete[] downSamplingVoxels;
+    releaseStaging(STAGING_DOWN_SAMPLED_TEXTURE, downSamplingVoxels);
     return name;
 } // end createDownSamplingMultiComponent3DTexture()
 
+/*
+ * createGradient3DTexture - Upload the quantized gradients, laid out like the voxels of create3DTexture(bordersize).
+ *
+ * parameter bordersize - int
+ * return - GLuint
+ */
+GLuint Brick::createGradient3DTexture(int bordersize) const {
+    const unsigned char* texels = acquireStaging(STAGING_GRADIENT_TEXTURE, bordersize);
+    int voxelSize[3];
+    int textureSize[3];
+    getTextureSize(STAGING_GRADIENT_TEXTURE, bordersize, voxelSize, textureSize);
+    GLuint name;
+    glEnable(GL_TEXTURE_3D);
+    glGenTextures(1, &name);
+    glBindTexture(GL_TEXTURE_3D, name);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA8, textureSize[0], textureSize[1], textureSize[2], bordersize, GL_RGBA,
+            GL_UNSIGNED_BYTE, texels);
+    glBindTexture(GL_TEXTURE_3D, 0);
+    glDisable(GL_TEXTURE_3D);
+    releaseStaging(STAGING_GRADIENT_TEXTURE, texels);
+    return name;
+} // end createGradient3DTexture()
+
 /*
  * createMultiComponent3DTexture
  *
  * return - GLuint
  */
 GLuint Brick::createMultiComponent3DTexture(void) const {
-    unsigned char* voxels = new unsigned char[3 * (width) * (height) * (depth)];
-    int w = volume->getWidth();
-    int h = volume->getHeight();
-    if (volume->hasRedByteVoxelsBase()) {
-        for (int k = 0; k < depth; k++) { // red
-            for (int j = 0; j < height; j++) {
-                for (int i = 0; i < width; i++) {
-                    voxels[3 * ((k * ((width) * (height))) + (j *( width)) +i) + 0] = volume->getRedVoxel(((slab + (k)) * (w * h))
-                            + ((row + (j)) * (w)) + (column + (i)));
-                } // end for
-            } // end for
-        } // end for
+    const unsigned char* voxels = volume->getInterleavedVoxels();
+    unsigned char* region = NULL;
+    glPushClientAttrib(GL_CLIENT_PIXEL_STORE_BIT);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (voxels != NULL) { // upload straight from the interleaved volume
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, volume->getWidth());
+        glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, volume->getHeight());
+        glPixelStorei(GL_UNPACK_SKIP_PIXELS, column);
+        glPixelStorei(GL_UNPACK_SKIP_ROWS, row);
+        glPixelStorei(GL_UNPACK_SKIP_IMAGES, slab);
     } else {
-        for (int k = 0; k < depth; k++) { // red
-            for (int j = 0; j < height; j++) {
-                for (int i = 0; i < width; i++) {
-                    voxels[3 * ((k * ((width) * (height))) + (j *( width)) +i) + 0] = 0;
-                } // end for
-            } // end for
-        } // end for
-    }
-    if (volume->hasGreenByteVoxelsBase()) {
-        for (int k = 0; k < depth; k++) { // red
-            for (int j = 0; j < height; j++) {
-                for (int i = 0; i < width; i++) {
-                    voxels[3 * ((k * ((width) * (height))) + (j *( width)) +i) + 1] = volume->getGreenVoxel(
-                            ((slab + (k)) * (w * h)) + ((row + (j)) * (w)) + (column + (i)));
-                } // end for
-            } // end for
-        } // end for
-    } else {
-        for (int k = 0; k < depth; k++) { // red
-            for (int j = 0; j < height; j++) {
-                for (int i = 0; i < width; i++) {
-                    voxels[3 * ((k * ((width) * (height))) + (j *( width)) +i) + 1] = 0;
-                } // end for
-            } // end for
-        } // end for
-    }
-    if (volume->hasBlueByteVoxelsBase()) {
-        for (int k = 0; k < depth; k++) { // red
-            for (int j = 0; j < height; j++) {
-                for (int i = 0; i < width; i++) {
-                    voxels[3 * ((k * ((width) * (height))) + (j *( width)) +i) + 2] = volume->getBlueVoxel(((slab + (k)) * (w * h))
-                            + ((row + (j)) * (w)) + (column + (i)));
-                } // end for
-            } // end for
-        } // end for
-    } else {
-        for (int k = 0; k < depth; k++) { // red
-            for (int j = 0; j < height; j++) {
-                for (int i = 0; i < width; i++) {
-                    voxels[3 * ((k * ((width) * (height))) + (j *( width)) +i) + 2] = 0;
-                } // end for
-            } // end for
-        } // end for
-    }
+        region = new unsigned char[COMPONENT_STRIDE * (width) * (height) * (depth)];
+        volume->getComponentRegion(column, row, slab, width, height, depth, region);
+        voxels = region;
+    } // end if
     GLuint name;
     glEnable(GL_TEXTURE_3D);
     glGenTextures(1, &name);
@@ -345,7 +268,8 @@ GLuint Brick::createMultiComponent3DTexture(void) const {
     glTexImage3D(GL_TEXTURE_3D, 0, GL_RGB, width, height, depth, 0, GL_RGB, GL_UNSIGNED_BYTE, voxels);
     glBindTexture(GL_TEXTURE_3D, 0);
     glDisable(GL_TEXTURE_3D);
-    delete[] voxels;
+    glPopClientAttrib();
+    delete[] region;
     return name;
 } // end createMultiComponent3DTexture()
 
@@ -356,22 +280,10 @@ GLuint Brick::createMultiComponent3DTexture(void) const {
  * return - GLuint
  */
 GLuint Brick::createMultiComponent3DTexture(int bordersize) const {
-    unsigned char *voxels = new unsigned char[3*(width+(2*bordersize))*
-                                                (height+(2*bordersize))*
-                                                (depth+(2*bordersize))];
-
-    if (volume->hasRedByteVoxelsBase())
-    {
-        fillMultiComponent3DTexture (bordersize, voxels, 0);
-    }
-    if (volume->hasGreenByteVoxelsBase())
-    {
-        fillMultiComponent3DTexture (bordersize, voxels, 1);
-    }
-    if (volume->hasBlueByteVoxelsBase())
-    {
-        fillMultiComponent3DTexture (bordersize, voxels, 2);
-    }
+    const unsigned char* voxels = acquireStaging(STAGING_TEXTURE, bordersize);
+    int voxelSize[3];
+    int textureSize[3];
+    getTextureSize(STAGING_TEXTURE, bordersize, voxelSize, textureSize);
 
     GLuint name;
     glEnable(GL_TEXTURE_3D);
@@ -382,48 +294,28 @@ GLuint Brick::createMultiComponent3DTexture(int bordersize) const {
     glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexImage3D(GL_TEXTURE_3D, 0, GL_RGB,
-            (width+(2*bordersize)), (height+(2*bordersize)),
-            (depth+(2*bordersize)), bordersize,
-            GL_RGB, GL_UNSIGNED_BYTE, voxels);
+    glTexImage3D(GL_TEXTURE_3D, 0, GL_RGB, textureSize[0], textureSize[1], textureSize[2], bordersize, GL_RGB,
+            GL_UNSIGNED_BYTE, voxels);
     glBindTexture(GL_TEXTURE_3D, 0);
     glDisable(GL_TEXTURE_3D);
-    delete[] voxels;
+    releaseStaging(STAGING_TEXTURE, voxels);
     return name;
 } // end createMultiComponent3DTexture()
 
 /*
- * determineOcNodesToDisplay
+ * drawAtlasVolume - Draw the packed octree blocks of this brick; the texture atlas must be bound.
+ *
+ * parameter cFrustum - const CFrustum &
+ * parameter shaderObject - ShaderObject*
+ * parameter point - float *
+ * parameter minimumIndex - int
+ * parameter maximumIndex - int
+ * parameter modelviewInverse - const Matrix4x4 *
  */
-void Brick::determineOcNodesToDisplay(void) {
-    ComparableOcNode comparableOcNode;
-    comparableOcNode.minimum(); // use the standard less operator<
-    std::priority_queue<ComparableOcNode> maximumPriorityQueue;
-    OcNode * ocNode = ocTree->getRoot();
-    if (ocNode->getRatioOfVisibility() != 0.0f) {
-        setEmpty(false);
-        ocNode->setDisplayed(true);
-        maximumPriorityQueue.push(ComparableOcNode(0, ocNode->getPercentageOfEmptyVolume(), ocNode));
-        while (maximumPriorityQueue.size() < maximumPriorityQueueSize && !maximumPriorityQueue.empty()) {
-            maximumPriorityQueue.pop();
-            if (!ocNode->isLeaf()) {
-                ocNode->setDisplayed(false);
-                OcNode * child = ocNode->getChildren();
-                for (int i = 0; i < 8; i++) {
-                    if (child[i].getRatioOfVisibility() != 0.0f) {
-                        child[i].setDisplayed(true);
-                        maximumPriorityQueue.push(ComparableOcNode(i, child[i].getPercentageOfEmptyVolume(), &child[i]));
-                    } else
-                        child[i].setDisplayed(false);
-                }
-            }
-            ocNode = ((const ComparableOcNode &) maximumPriorityQueue.top()).getOcNode();
-        }
-    } else {
-        setEmpty(true);
-        ocNode->setDisplayed(false);
-    }
-} // end determineOcNodesToDisplay()
+void Brick::drawAtlasVolume(const CFrustum & cFrustum, ShaderObject* shaderObject, float * point, int minimumIndex,
+        int maximumIndex, const Matrix4x4 * modelviewInverse) {
+    ocTree->drawAtlasVolume(cFrustum, shaderObject, point, minimumIndex, maximumIndex, modelviewInverse);
+} // end drawAtlasVolume()
 
 /*
  * drawBrick
@@ -533,7 +425,8 @@ void Brick::drawSlices(GLContextData & glContextData, const CFrustum & cFrustum,
     }
     if (showXSlice || showYSlice || showZSlice) {
         glActiveTexture(GL_TEXTURE0);
-        if (interactive)
+        // In texture atlas mode there is no full resolution brick texture
+        if (interactive || dataItem->texture3DName == 0)
             glBindTexture(GL_TEXTURE_3D, dataItem->downSamplingTexture3DName);
         else
             glBindTexture(GL_TEXTURE_3D, dataItem->texture3DName);
@@ -554,6 +447,30 @@ void Brick::drawSlices(GLContextData & glContextData, const CFrustum & cFrustum,
     }
 } // end drawSlices()
 
+/*
+ * drawIlluminatedVolume - Draw the full resolution octree nodes with the colors baked by the illumination cache.
+ *
+ * The bake held by this context is drawn, which may be older than the published one; see
+ * uploadIlluminatedTexture().
+ *
+ * parameter glContextData - GLContextData &
+ * parameter cFrustum - const CFrustum &
+ * parameter shaderObject - ShaderObject*
+ * parameter point - float *
+ * parameter minimumIndex - int
+ * parameter maximumIndex - int
+ * parameter modelviewInverse - const Matrix4x4 *
+ */
+void Brick::drawIlluminatedVolume(GLContextData & glContextData, const CFrustum & cFrustum, ShaderObject* shaderObject,
+        float * point, int minimumIndex, int maximumIndex, const Matrix4x4 * modelviewInverse) {
+    DataItem * dataItem = glContextData.retrieveDataItem<DataItem> (this);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_3D, dataItem->illuminatedTexture3DName);
+    shaderObject->sendUniform1i("volume", 0);
+    ocTree->drawVolume(cFrustum, shaderObject, point, minimumIndex, maximumIndex, modelviewInverse);
+    glBindTexture(GL_TEXTURE_3D, 0);
+} // end drawIlluminatedVolume()
+
 /*
  * drawVolume
  *
@@ -568,17 +485,35 @@ void Brick::drawSlices(GLContextData & glContextData, const CFrustum & cFrustum,
 void Brick::drawVolume(GLContextData & glContextData, const CFrustum & cFrustum, ShaderObject* shaderObject, float * point,
         int minimumIndex, int maximumIndex, const Matrix4x4 * modelviewInverse) {
     DataItem * dataItem = glContextData.retrieveDataItem<DataItem> (this);
+    bool downSampled = interactive || dataItem->texture3DName == 0;
+    if (dataItem->gradientTexture3DName != 0) {
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_3D, dataItem->gradientTexture3DName);
+    }
     glActiveTexture(GL_TEXTURE0);
-    if (interactive)
+    if (downSampled)
         glBindTexture(GL_TEXTURE_3D, dataItem->downSamplingTexture3DName);
     else
         glBindTexture(GL_TEXTURE_3D, dataItem->texture3DName);
     shaderObject->sendUniform1i("volume", 0);
-    if (interactive) {
+    // The central differences of the lit shaders step one texel of the bound texture
+    if (shaderObject->hasUniform("texelSize")) {
+        int voxelSize[3];
+        int textureSize[3];
+        getTextureSize(downSampled ? STAGING_DOWN_SAMPLED_TEXTURE : STAGING_TEXTURE, 0, voxelSize, textureSize);
+        shaderObject->sendUniform3f("texelSize", GLfloat(1.0f / textureSize[0]), GLfloat(1.0f / textureSize[1]),
+                GLfloat(1.0f / textureSize[2]));
+    } // end if
+    if (downSampled) {
         ocTree->getRoot()->drawVolume(shaderObject, minimumIndex, maximumIndex, modelviewInverse);
     } else
         ocTree->drawVolume(cFrustum, shaderObject, point, minimumIndex, maximumIndex, modelviewInverse);
     glBindTexture(GL_TEXTURE_3D, 0);
+    if (dataItem->gradientTexture3DName != 0) {
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_3D, 0);
+        glActiveTexture(GL_TEXTURE0);
+    }
 } // end drawVolume()
 
 /*
@@ -610,13 +545,16 @@ void Brick::drawXSlice(const CFrustum & cFrustum) {
             zEnd = float(slab + depth) * volume->getScale(2);
         glBegin(GL_QUADS);
         glNormal3f(0.0f, 0.0f, -1.0f);
+        weight *= float(width) / float(paddedWidth);
+        float t = float(height) / float(paddedHeight);
+        float r = float(depth) / float(paddedDepth);
         glTexCoord3f(weight, 0.0f, 0.0f);
         glVertex3f(xValue, yStart, zStart);
-        glTexCoord3f(weight, 1.0f, 0.0f);
+        glTexCoord3f(weight, t, 0.0f);
         glVertex3f(xValue, yEnd, zStart);
-        glTexCoord3f(weight, 1.0f, 1.0f);
+        glTexCoord3f(weight, t, r);
         glVertex3f(xValue, yEnd, zEnd);
-        glTexCoord3f(weight, 0.0f, 1.0f);
+        glTexCoord3f(weight, 0.0f, r);
         glVertex3f(xValue, yStart, zEnd);
         glEnd();
     }
@@ -651,13 +589,16 @@ void Brick::drawYSlice(const CFrustum & cFrustum) {
             zEnd = float(slab + depth) * volume->getScale(2);
         glBegin(GL_QUADS);
         glNormal3f(0.0f, 0.0f, -1.0f);
+        weight *= float(height) / float(paddedHeight);
+        float s = float(width) / float(paddedWidth);
+        float r = float(depth) / float(paddedDepth);
         glTexCoord3f(0.0f, weight, 0.0f);
         glVertex3f(xStart, yValue, zStart);
-        glTexCoord3f(1.0f, weight, 0.0f);
+        glTexCoord3f(s, weight, 0.0f);
         glVertex3f(xEnd, yValue, zStart);
-        glTexCoord3f(1.0f, weight, 1.0f);
+        glTexCoord3f(s, weight, r);
         glVertex3f(xEnd, yValue, zEnd);
-        glTexCoord3f(0.0f, weight, 1.0f);
+        glTexCoord3f(0.0f, weight, r);
         glVertex3f(xStart, yValue, zEnd);
         glEnd();
     }
@@ -692,19 +633,31 @@ void Brick::drawZSlice(const CFrustum & cFrustum) {
             yEnd = float(row + height) * volume->getScale(1);
         glBegin(GL_QUADS);
         glNormal3f(0.0f, 0.0f, -1.0f);
+        weight *= float(depth) / float(paddedDepth);
+        float s = float(width) / float(paddedWidth);
+        float t = float(height) / float(paddedHeight);
         glTexCoord3f(0.0f, 0.0f, weight);
         glVertex3f(xStart, yStart, zValue);
-        glTexCoord3f(1.0f, 0.0f, weight);
+        glTexCoord3f(s, 0.0f, weight);
         glVertex3f(xEnd, yStart, zValue);
-        glTexCoord3f(1.0f, 1.0f, weight);
+        glTexCoord3f(s, t, weight);
         glVertex3f(xEnd, yEnd, zValue);
-        glTexCoord3f(0.0f, 1.0f, weight);
+        glTexCoord3f(0.0f, t, weight);
         glVertex3f(xStart, yEnd, zValue);
         glEnd();
 
     }
 } // end drawZSlice()
 
+/*
+ * getBorderSize - Voxels of border around the full resolution textures.
+ *
+ * return - int
+ */
+int Brick::getBorderSize(void) const {
+    return borderSize;
+} // end getBorderSize()
+
 /*
  * setBrick
  *
@@ -723,9 +676,11 @@ void Brick::setBrick(int _column, int _row, int _slab, int _width, int _height,
     width = _width;
     height = _height;
     depth = _depth;
+    paddedWidth = width;
+    paddedHeight = height;
+    paddedDepth = depth;
     volume = _volume;
     sliceFactor = volume->getSliceFactor();
-    maximumPriorityQueueSize = volume->getMaximumPriorityQueueSize();
     float xOrigin = volume->getOrigin(0);
     float yOrigin = volume->getOrigin(1);
     float zOrigin = volume->getOrigin(2);
@@ -774,17 +729,26 @@ bool Brick::isEmpty(void) {
  * parameter _empty - bool
  */
 void Brick::setEmpty(bool _empty) {
-    empty - _empty;
+    empty = _empty;
 } // end setEmpty()
 
 /*
- * setMaximumPriorityQueueSize
+ * isResident
  *
- * parameter _maximumPriorityQueueSize - int
+ * return - bool
  */
-void Brick::setMaximumPriorityQueueSize(int _maximumPriorityQueueSize) {
-    maximumPriorityQueueSize = _maximumPriorityQueueSize;
-} // end setMaximumPriorityQueueSize()
+bool Brick::isResident(void) {
+    return resident;
+} // end isResident()
+
+/*
+ * setResident
+ *
+ * parameter _resident - bool
+ */
+void Brick::setResident(bool _resident) {
+    resident = _resident;
+} // end setResident()
 
 /*
  * setMaximumPriorityQueueTest
@@ -799,18 +763,46 @@ void Brick::setMaximumPriorityQueueTest(bool _maximumPriorityQueueTest) {
  * setPercentageOfEmptyVolume
  *
  * parameter _alpha - float*
+ * parameter minimumChanged - int
+ * parameter maximumChanged - int
+ * parameter visibleValues - const VisibleValues &
  */
-void Brick::setPercentageOfEmptyVolume(float* _alpha) {
-    ocTree->setPercentageOfEmptyVolume(_alpha);
+void Brick::setPercentageOfEmptyVolume(float* _alpha, int minimumChanged, int maximumChanged,
+        const VisibleValues & visibleValues) {
+    ocTree->setPercentageOfEmptyVolume(_alpha, minimumChanged, maximumChanged, visibleValues);
 } // end setPercentageOfEmptyVolume()
 
+/*
+ * setPowerOfTwo - Pad the textures of this brick to power of two sizes for GL contexts that need them.
+ *
+ * parameter _powerOfTwo - bool
+ */
+void Brick::setPowerOfTwo(bool _powerOfTwo) {
+    powerOfTwo = _powerOfTwo;
+    paddedWidth = width;
+    paddedHeight = height;
+    paddedDepth = depth;
+    if (powerOfTwo) {
+        paddedWidth = 1;
+        while (paddedWidth < width)
+            paddedWidth <<= 1;
+        paddedHeight = 1;
+        while (paddedHeight < height)
+            paddedHeight <<= 1;
+        paddedDepth = 1;
+        while (paddedDepth < depth)
+            paddedDepth <<= 1;
+    } // end if
+} // end setPowerOfTwo()
+
 /*
  * setPercentageOfEmptyVolume2_5D
  *
  * parameter _alpha - float*
+ * parameter visibleValues - const VisibleValues &
  */
-void Brick::setPercentageOfEmptyVolume2_5D(float* _alpha) {
-    ocTree->setPercentageOfEmptyVolume2_5D(_alpha);
+void Brick::setPercentageOfEmptyVolume2_5D(float* _alpha, const VisibleValues & visibleValues) {
+    ocTree->setPercentageOfEmptyVolume2_5D(_alpha, visibleValues);
 } // end setPercentageOfEmptyVolume2_5D()
 
 /*
@@ -828,9 +820,13 @@ void Brick::setPercentageOfEmptyVolume(float* _red, float* _green, float* _blue)
  * setRatioOfVisibility
  *
  * parameter _alpha - float*
+ * parameter minimumChanged - int
+ * parameter maximumChanged - int
+ * parameter visibleValues - const VisibleValues &
  */
-void Brick::setRatioOfVisibility(float* _alpha) {
-    ocTree->setRatioOfVisibility(_alpha);
+void Brick::setRatioOfVisibility(float* _alpha, int minimumChanged, int maximumChanged,
+        const VisibleValues & visibleValues) {
+    ocTree->setRatioOfVisibility(_alpha, minimumChanged, maximumChanged, visibleValues);
     if (ocTree->getRoot()->getRatioOfVisibility() == 0.0f)
         setEmpty(true);
     else
@@ -841,9 +837,10 @@ void Brick::setRatioOfVisibility(float* _alpha) {
  * setRatioOfVisibility2_5D
  *
  * parameter _alpha - float*
+ * parameter visibleValues - const VisibleValues &
  */
-void Brick::setRatioOfVisibility2_5D(float* _alpha) {
-    ocTree->setRatioOfVisibility2_5D(_alpha);
+void Brick::setRatioOfVisibility2_5D(float* _alpha, const VisibleValues & visibleValues) {
+    ocTree->setRatioOfVisibility2_5D(_alpha, visibleValues);
     if (ocTree->getRoot()->getRatioOfVisibility() == 0.0f)
         setEmpty(true);
     else
@@ -896,9 +893,14 @@ void Brick::setRenderingCost(float _renderingCost) {
  * setRenderingCostFunction
  *
  * parameter _alpha - float*
- */
-void Brick::setRenderingCostFunction(float* _alpha) {
-    ocTree->setRenderingCostFunction(_alpha);
+ * parameter minimumChanged - int
+ * parameter maximumChanged - int
+ * parameter visibleValues - const VisibleValues &
+ */
+void Brick::setRenderingCostFunction(float* _alpha, int minimumChanged, int maximumChanged,
+        const VisibleValues & visibleValues) {
+    ocTree->setRenderingCostFunction(_alpha, minimumChanged, maximumChanged, visibleValues);
+    setEmpty(ocTree->getRoot()->isEmpty());
 } // end setRenderingCostFunction()
 
 /*
@@ -910,15 +912,18 @@ void Brick::setRenderingCostFunction(float* _alpha) {
  */
 void Brick::setRenderingCostFunction(float * red, float * green, float * blue) {
     ocTree->setRenderingCostFunction(red, green, blue);
+    setEmpty(ocTree->getRoot()->isEmpty());
 } // end setRenderingCostFunction()
 
 /*
  * setRenderingCostFunction2_5D
  *
  * parameter _alpha - float*
+ * parameter visibleValues - const VisibleValues &
  */
-void Brick::setRenderingCostFunction2_5D(float* _alpha) {
-    ocTree->setRenderingCostFunction2_5D(_alpha);
+void Brick::setRenderingCostFunction2_5D(float* _alpha, const VisibleValues & visibleValues) {
+    ocTree->setRenderingCostFunction2_5D(_alpha, visibleValues);
+    setEmpty(ocTree->getRoot()->isEmpty());
 } // end setRenderingCostFunction()
 
 /*
@@ -996,6 +1001,15 @@ void Brick::setSlicingScale(float slicingScale) {
         ocTree->setSliceFactor(sliceFactor * slicingScale);
 } // end setSlicingScale()
 
+/*
+ * setStagingCache
+ *
+ * parameter _stagingCache - StagingCache*
+ */
+void Brick::setStagingCache(StagingCache* _stagingCache) {
+    stagingCache = _stagingCache;
+} // end setStagingCache()
+
 /*
  * getColumn
  *
@@ -1045,6 +1059,17 @@ OcTree* Brick::getOcTree(void) {
     return ocTree;
 } // end getOcTree()
 
+/*
+ * getIlluminationVersion - Version of the bake this context holds, 0 before the first upload.
+ *
+ * parameter glContextData - GLContextData &
+ * return - int
+ */
+int Brick::getIlluminationVersion(GLContextData & glContextData) const {
+    DataItem * dataItem = glContextData.retrieveDataItem<DataItem> (this);
+    return dataItem->illuminationVersion;
+} // end getIlluminationVersion()
+
 /*
  * getRow
  *
@@ -1238,12 +1263,24 @@ void Brick::initContext(GLContextData& glContextData) const {
  * parameter dataItem - DataItem *
  */
 void Brick::initialize(DataItem * dataItem) const {
+    if (!resident) {
+        dataItem->texture3DName = 0;
+        dataItem->downSamplingTexture3DName = 0;
+        dataItem->gradientTexture3DName = 0;
+        return;
+    }
     if (volume->getNumberOfComponents() != 0) {
         dataItem->texture3DName = createMultiComponent3DTexture(borderSize);
         dataItem->downSamplingTexture3DName = createDownSamplingMultiComponent3DTexture();
     } else {
-        dataItem->texture3DName = create3DTexture(borderSize);
+        // The texture atlas holds the full resolution voxels of scalar volumes
+        if (volume->isTextureAtlas())
+            dataItem->texture3DName = 0;
+        else
+            dataItem->texture3DName = create3DTexture(borderSize);
         dataItem->downSamplingTexture3DName = createDownSampling3DTexture();
+        if (volume->isGradientTexture())
+            dataItem->gradientTexture3DName = createGradient3DTexture(borderSize);
     }
 }
 // end drawVolume()
@@ -1273,6 +1310,288 @@ void Brick::update3DTexture(GLuint texture3DName) {
     delete[] voxels;
 } // end updateBrick()
 
+/*
+ * releaseIlluminatedTexture - Free the baked colors of this context; the next upload starts over.
+ *
+ * parameter glContextData - GLContextData &
+ */
+void Brick::releaseIlluminatedTexture(GLContextData & glContextData) const {
+    DataItem * dataItem = glContextData.retrieveDataItem<DataItem> (this);
+    if (dataItem->illuminatedTexture3DName != 0)
+        glDeleteTextures(1, &dataItem->illuminatedTexture3DName);
+    dataItem->illuminatedTexture3DName = 0;
+    dataItem->illuminationVersion = 0;
+} // end releaseIlluminatedTexture()
+
+/*
+ * uploadIlluminatedTexture - Upload the baked colors into this context unless it already holds them.
+ *
+ * parameter glContextData - GLContextData &
+ * parameter texels - const unsigned char* (laid out like the voxels of create3DTexture(borderSize))
+ * parameter version - int
+ * return - size_t (bytes uploaded)
+ */
+size_t Brick::uploadIlluminatedTexture(GLContextData & glContextData, const unsigned char* texels, int version) const {
+    DataItem * dataItem = glContextData.retrieveDataItem<DataItem> (this);
+    if (dataItem->illuminationVersion == version)
+        return 0;
+    int voxelSize[3];
+    int textureSize[3];
+    getTextureSize(STAGING_TEXTURE, borderSize, voxelSize, textureSize);
+    glActiveTexture(GL_TEXTURE0);
+    if (dataItem->illuminatedTexture3DName == 0) {
+        glGenTextures(1, &dataItem->illuminatedTexture3DName);
+        glBindTexture(GL_TEXTURE_3D, dataItem->illuminatedTexture3DName);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_BORDER);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA8, textureSize[0], textureSize[1], textureSize[2], borderSize, GL_RGBA,
+                GL_UNSIGNED_BYTE, texels);
+    } else {
+        glBindTexture(GL_TEXTURE_3D, dataItem->illuminatedTexture3DName);
+        glTexSubImage3D(GL_TEXTURE_3D, 0, -borderSize, -borderSize, -borderSize, textureSize[0], textureSize[1],
+                textureSize[2], GL_RGBA, GL_UNSIGNED_BYTE, texels);
+    } // end if
+    glBindTexture(GL_TEXTURE_3D, 0);
+    dataItem->illuminationVersion = version;
+    return 4 * size_t(textureSize[0]) * size_t(textureSize[1]) * size_t(textureSize[2]);
+} // end uploadIlluminatedTexture()
+
+/*
+ * getComponents - Bytes per voxel of the staged voxels of a texture level.
+ *
+ * parameter level - int
+ * return - int
+ */
+int Brick::getComponents(int level) const {
+    if (level == STAGING_GRADIENT_TEXTURE)
+        return 4;
+    else if (volume->getNumberOfComponents() != 0)
+        return 3;
+    return 1;
+} // end getComponents()
+
+/*
+ * getStep - The down sampling step used for a requested step.
+ *
+ * Power of two textures round the step down to a power of two, so the down sampled voxels fill
+ * the same fraction of a padded texture as the full resolution voxels do.
+ *
+ * parameter step - int
+ * return - int
+ */
+int Brick::getStep(int step) const {
+    if (!powerOfTwo)
+        return step;
+    int powerOfTwoStep = 1;
+    while (2 * powerOfTwoStep <= step)
+        powerOfTwoStep <<= 1;
+    return powerOfTwoStep;
+} // end getStep()
+
+/*
+ * getTextureSize - The size of the voxels of a texture level and the size of the texture holding them, borders included.
+ *
+ * parameter level - int (STAGING_TEXTURE, STAGING_DOWN_SAMPLED_TEXTURE or STAGING_GRADIENT_TEXTURE)
+ * parameter bordersize - int
+ * parameter voxelSize - int*
+ * parameter textureSize - int*
+ */
+void Brick::getTextureSize(int level, int bordersize, int* voxelSize, int* textureSize) const {
+    int size[3] = { width, height, depth };
+    int paddedSize[3] = { paddedWidth, paddedHeight, paddedDepth };
+    int step[3] = { getStep(xStep), getStep(yStep), getStep(zStep) };
+    for (int i = 0; i < 3; i++) {
+        if (level == STAGING_DOWN_SAMPLED_TEXTURE) {
+            voxelSize[i] = size[i] / step[i];
+            textureSize[i] = paddedSize[i] / step[i];
+        } else {
+            voxelSize[i] = size[i] + 2 * bordersize;
+            textureSize[i] = paddedSize[i] + 2 * bordersize;
+        } // end if
+    } // end for
+} // end getTextureSize()
+
+/*
+ * getTextureMemory - Estimated bytes one GL context holds for a texture level of the brick.
+ *
+ * Scalar voxels are uploaded as GL_LUMINANCE_ALPHA, two bytes per texel; GL_RGB is counted as
+ * four, as the drivers align it like the GL_RGBA8 of the gradients.
+ *
+ * parameter level - int (STAGING_TEXTURE, STAGING_DOWN_SAMPLED_TEXTURE or STAGING_GRADIENT_TEXTURE)
+ * return - size_t
+ */
+size_t Brick::getTextureMemory(int level) const {
+    if (!resident)
+        return 0;
+    bool scalar = volume->getNumberOfComponents() == 0;
+    if (level == STAGING_TEXTURE && scalar && volume->isTextureAtlas())
+        return 0;
+    if (level == STAGING_GRADIENT_TEXTURE && (!scalar || !volume->isGradientTexture()))
+        return 0;
+    int voxelSize[3];
+    int textureSize[3];
+    getTextureSize(level, (level == STAGING_DOWN_SAMPLED_TEXTURE) ? 0 : borderSize, voxelSize, textureSize);
+    size_t texels = size_t(textureSize[0]) * textureSize[1] * textureSize[2];
+    if (level == STAGING_GRADIENT_TEXTURE || !scalar)
+        return 4 * texels;
+    return 2 * texels;
+} // end getTextureMemory()
+
+/*
+ * padTexture - Pad the staged voxels of a texture level to the power of two texture size.
+ *
+ * The voxels keep the low corner of the texture and the last voxel of every row, column and
+ * slab is repeated into the padding, so filtering at the edge of the voxels sees what it saw
+ * at the edge of an unpadded texture. adjustTextureCoordinates() keeps the octree nodes within
+ * the voxels.
+ *
+ * parameter level - int
+ * parameter bordersize - int
+ * parameter voxels - unsigned char* (deleted when a padded copy is returned)
+ * return - unsigned char*
+ */
+unsigned char* Brick::padTexture(int level, int bordersize, unsigned char* voxels) const {
+    int voxelSize[3];
+    int textureSize[3];
+    getTextureSize(level, bordersize, voxelSize, textureSize);
+    if (voxelSize[0] == textureSize[0] && voxelSize[1] == textureSize[1] && voxelSize[2] == textureSize[2])
+        return voxels;
+    int components = getComponents(level);
+    unsigned char* texels = new unsigned char[components * textureSize[0] * textureSize[1] * textureSize[2]];
+    for (int k = 0; k < textureSize[2]; k++) {
+        int _k = std::min(k, voxelSize[2] - 1);
+        for (int j = 0; j < textureSize[1]; j++) {
+            int _j = std::min(j, voxelSize[1] - 1);
+            const unsigned char* source = voxels + components * ((_k * voxelSize[1] + _j) * voxelSize[0]);
+            unsigned char* destination = texels + components * ((k * textureSize[1] + j) * textureSize[0]);
+            memcpy(destination, source, components * voxelSize[0]);
+            for (int i = voxelSize[0]; i < textureSize[0]; i++)
+                memcpy(destination + components * i, source + components * (voxelSize[0] - 1), components);
+        } // end for
+    } // end for
+    delete[] voxels;
+    return texels;
+} // end padTexture()
+
+/*
+ * releaseStaging - This context has uploaded the texture acquired with acquireStaging().
+ *
+ * parameter level - int
+ * parameter voxels - const unsigned char*
+ */
+void Brick::releaseStaging(int level, const unsigned char* voxels) const {
+    if (stagingCache != NULL)
+        stagingCache->release(this, level);
+    else
+        delete[] voxels;
+} // end releaseStaging()
+
+/*
+ * stage3DTexture - Build the voxels of a brick texture in host memory.
+ *
+ * parameter level - int (STAGING_TEXTURE, STAGING_DOWN_SAMPLED_TEXTURE or STAGING_GRADIENT_TEXTURE)
+ * parameter bordersize - int
+ * return - unsigned char*
+ */
+unsigned char* Brick::stage3DTexture(int level, int bordersize) const {
+    if (level == STAGING_GRADIENT_TEXTURE) {
+        unsigned char* texels = new unsigned char[4 * (width + (2 * bordersize)) * (height + (2 * bordersize)) * (depth + (2
+                * bordersize))];
+        fillGradient3DTexture(bordersize, texels);
+        return texels;
+    } // end if
+    if (level == STAGING_TEXTURE) {
+        if (volume->getNumberOfComponents() != 0) {
+            unsigned char* voxels = new unsigned char[3*(width+(2*bordersize))*
+                                                        (height+(2*bordersize))*
+                                                        (depth+(2*bordersize))];
+
+            if (volume->isInterleaved())
+            {
+                fillInterleaved3DTexture (bordersize, voxels);
+                return voxels;
+            }
+            memset (voxels, 0, 3*(width+(2*bordersize))*
+                                 (height+(2*bordersize))*
+                                 (depth+(2*bordersize)));
+            if (volume->hasRedByteVoxelsBase() || volume->getCompressedRedVoxels() != NULL)
+            {
+                fillMultiComponent3DTexture (bordersize, voxels, 0);
+            }
+            if (volume->hasGreenByteVoxelsBase() || volume->getCompressedGreenVoxels() != NULL)
+            {
+                fillMultiComponent3DTexture (bordersize, voxels, 1);
+            }
+            if (volume->hasBlueByteVoxelsBase() || volume->getCompressedBlueVoxels() != NULL)
+            {
+                fillMultiComponent3DTexture (bordersize, voxels, 2);
+            }
+            return voxels;
+        } // end if
+        unsigned char* voxels = new unsigned char[(width + (2 * bordersize)) * (height + (2 * bordersize)) * (depth + (2
+                * bordersize))];
+        fill3DTexture(bordersize, voxels);
+        return voxels;
+    } // end if
+    // Power of two textures down sample by power of two steps; see getStep()
+    int _xStep = getStep(xStep);
+    int _yStep = getStep(yStep);
+    int _zStep = getStep(zStep);
+    if (volume->getNumberOfComponents() != 0) {
+        unsigned char* voxels = new unsigned char[COMPONENT_STRIDE * (width) * (height) * (depth)];
+        volume->getComponentRegion(column, row, slab, width, height, depth, voxels);
+        int newWidth = int(width / _xStep);
+        int newHeight = int(height / _yStep);
+        int newDepth = int(depth / _zStep);
+        unsigned char* downSamplingVoxels = new unsigned char[3 * newWidth * newHeight * newDepth];
+        int ktmp;
+        int jtmp;
+        int itmp;
+        for (int k = 0; k < newDepth; k++) {
+            k == 0 ? ktmp = 0 : ktmp = k * _zStep - 1;
+            for (int j = 0; j < newHeight; j++) {
+                j == 0 ? jtmp = 0 : jtmp = j * _yStep - 1;
+                for (int i = 0; i < newWidth; i++) {
+                    i == 0 ? itmp = 0 : itmp = i * _xStep - 1;
+                    downSamplingVoxels[3 * ((k * ((newWidth) * (newHeight))) + (j *( newWidth)) +i) + 0] = voxels[3 * ((ktmp * ((width)
+                            * (height))) + (jtmp *( width)) +itmp) + 0];
+                    downSamplingVoxels[3 * ((k * ((newWidth) * (newHeight))) + (j *( newWidth)) +i) + 1] = voxels[3 * ((ktmp * ((width)
+                            * (height))) + (jtmp *( width)) +itmp) + 1];
+                    downSamplingVoxels[3 * ((k * ((newWidth) * (newHeight))) + (j *( newWidth)) +i) + 2] = voxels[3 * ((ktmp * ((width)
+                            * (height))) + (jtmp *( width)) +itmp) + 2];
+                } // end for
+            } // end for
+        } // end for
+        delete[] voxels;
+        return downSamplingVoxels;
+    } // end if
+    unsigned char* voxels = new unsigned char[width * height * depth];
+    volume->getVoxelRegion(column, row, slab, width, height, depth, voxels, width, width * height);
+    int newWidth = int(width / _xStep);
+    int newHeight = int(height / _yStep);
+    int newDepth = int(depth / _zStep);
+    unsigned char* downSamplingVoxels = new unsigned char[newWidth * newHeight * newDepth];
+    int ktmp;
+    int jtmp;
+    int itmp;
+    for (int k = 0; k < newDepth; k++) {
+        k == 0 ? ktmp = 0 : ktmp = k * _zStep - 1;
+        for (int j = 0; j < newHeight; j++) {
+            j == 0 ? jtmp = 0 : jtmp = j * _yStep - 1;
+            for (int i = 0; i < newWidth; i++) {
+                i == 0 ? itmp = 0 : itmp = i * _xStep - 1;
+                downSamplingVoxels[(k * ((newWidth) * (newHeight))) + (j *( newWidth)) +i] = voxels[(ktmp * ((width) * (height)))
+                        + (jtmp *( width)) +itmp];
+            } // end for
+        } // end for
+    } // end for
+    delete[] voxels;
+    return downSamplingVoxels;
+} // end stage3DTexture()
+
 /*
  * fill3DTexture
  *
@@ -1304,16 +1623,30 @@ void Brick::fill3DTexture (int bordersize, unsigned char *voxels) const
     i1 = width + bordersize;
 
 //  Fill the core voxels with values from the volume
-    for (k = bordersize; k < depth + bordersize; k++)
+    if (volume->getCompressedVoxels() != NULL)
     {
-        for (j = bordersize; j < height + bordersize; j++)
+        volume->getCompressedVoxels()->decode(column, row, slab, width, height, depth,
+                &VOXEL(bordersize,bordersize,bordersize), w2b, w2b * h2b,
+                volume->getNumberOfDecodeThreads());
+    }
+    else if (volume->getTiledVoxels() != NULL)
+    {
+        volume->getTiledVoxels()->extract(column, row, slab, width, height, depth,
+                &VOXEL(bordersize,bordersize,bordersize), w2b, w2b * h2b);
+    }
+    else
+    {
+        for (k = bordersize; k < depth + bordersize; k++)
         {
-            for (i = bordersize; i < width + bordersize; i++)
+            for (j = bordersize; j < height + bordersize; j++)
             {
-                VOXEL(k,j,i) = VOL_VOXEL(k,j,i);
-            } // end for i
-        } // end for j
-    } // end for k
+                for (i = bordersize; i < width + bordersize; i++)
+                {
+                    VOXEL(k,j,i) = VOL_VOXEL(k,j,i);
+                } // end for i
+            } // end for j
+        } // end for k
+    }
 
 //  Fill the face voxels
     if (slab == 0)
@@ -1485,6 +1818,34 @@ void Brick::fill3DTexture (int bordersize, unsigned char *voxels) const
     return;
 } // end fill3DTexture()
 
+/*
+ * fillGradient3DTexture - Quantize the gradients of the brick and its border into RGBA8 texels.
+ *
+ * Border texels outside the volume repeat the nearest face, like fill3DTexture().
+ *
+ * parameter bordersize - int
+ * parameter texels - unsigned char *
+ */
+void Brick::fillGradient3DTexture(int bordersize, unsigned char* texels) const {
+    int w = volume->getWidth();
+    int h = volume->getHeight();
+    int d = volume->getDepth();
+    int w2b = width + (2 * bordersize);
+    int h2b = height + (2 * bordersize);
+    int d2b = depth + (2 * bordersize);
+    for (int k = 0; k < d2b; k++) {
+        int z = std::max(0, std::min(d - 1, slab + k - bordersize));
+        for (int j = 0; j < h2b; j++) {
+            int y = std::max(0, std::min(h - 1, row + j - bordersize));
+            unsigned char* texel = texels + 4 * ((k * h2b + j) * w2b);
+            for (int i = 0; i < w2b; i++, texel += 4) {
+                int x = std::max(0, std::min(w - 1, column + i - bordersize));
+                volume->getGradientTexel((z * h + y) * w + x, texel);
+            } // end for
+        } // end for
+    } // end for
+} // end fillGradient3DTexture()
+
 unsigned char getRed (Volume *volume, int ivoxel)
 {
     return volume->getRedVoxel (ivoxel);
@@ -1511,6 +1872,9 @@ void Brick::fillMultiComponent3DTexture (int bordersize, unsigned char *voxels,
                                          int icomp) const
 {
     unsigned char (*getVoxelFunc[])(Volume*, int) = { getRed, getGrn, getBlu };
+    const CompressedVolume *compressedVoxels[] = { volume->getCompressedRedVoxels(),
+                                                   volume->getCompressedGreenVoxels(),
+                                                   volume->getCompressedBlueVoxels() };
 
     int         i, j, k, i0, i1, j0, j1, k0, k1;
     int         w   = volume->getWidth();
@@ -1537,16 +1901,36 @@ void Brick::fillMultiComponent3DTexture (int bordersize, unsigned char *voxels,
     i1 = width + bordersize;
 
 //  Fill the core voxels with values from the volume
-    for (k = bordersize; k < depth + bordersize; k++)
+    if (compressedVoxels[icomp] != NULL)
     {
-        for (j = bordersize; j < height + bordersize; j++)
+        unsigned char *core = new unsigned char[width * height * depth];
+        compressedVoxels[icomp]->decode(column, row, slab, width, height, depth,
+                core, width, width * height, volume->getNumberOfDecodeThreads());
+        for (k = bordersize; k < depth + bordersize; k++)
         {
-            for (i = bordersize; i < width + bordersize; i++)
+            for (j = bordersize; j < height + bordersize; j++)
             {
-                VOXEL(k,j,i) = VOL_VOXEL(k,j,i);
-            } // end for i
-        } // end for j
-    } // end for k
+                for (i = bordersize; i < width + bordersize; i++)
+                {
+                    VOXEL(k,j,i) = core[(((k - bordersize) * height) + (j - bordersize)) * width + (i - bordersize)];
+                } // end for i
+            } // end for j
+        } // end for k
+        delete[] core;
+    }
+    else
+    {
+        for (k = bordersize; k < depth + bordersize; k++)
+        {
+            for (j = bordersize; j < height + bordersize; j++)
+            {
+                for (i = bordersize; i < width + bordersize; i++)
+                {
+                    VOXEL(k,j,i) = VOL_VOXEL(k,j,i);
+                } // end for i
+            } // end for j
+        } // end for k
+    }
 
 //  Fill the face voxels
     if (slab == 0)
@@ -1717,3 +2101,47 @@ void Brick::fillMultiComponent3DTexture (int bordersize, unsigned char *voxels,
 
     return;
 } // end fillMultiComponent3DTexture()
+
+/*
+ * fillInterleaved3DTexture - Fill all channels of a bordered texture from an interleaved volume.
+ *
+ * Border voxels take the neighbouring voxels of the volume, clamped at its faces, so each
+ * row is a clamped border, one copy of the core run and another clamped border.
+ *
+ * parameter bordersize - int
+ * parameter voxels - unsigned char *
+ */
+void Brick::fillInterleaved3DTexture (int bordersize, unsigned char *voxels) const
+{
+    const unsigned char *interleaved = volume->getInterleavedVoxels();
+
+    int         i, j, k, x, y, z;
+    int         w   = volume->getWidth();
+    int         h   = volume->getHeight();
+    int         d   = volume->getDepth();
+    int         w2b = width  + (2 * bordersize);
+    int         h2b = height + (2 * bordersize);
+    int         d2b = depth  + (2 * bordersize);
+
+    for (k = 0; k < d2b; k++)
+    {
+        z = std::min (std::max (slab + k - bordersize, 0), d - 1);
+        for (j = 0; j < h2b; j++)
+        {
+            y = std::min (std::max (row + j - bordersize, 0), h - 1);
+            const unsigned char *line  = interleaved + COMPONENT_STRIDE * (((size_t) z * h + y) * w);
+            unsigned char       *texel = voxels + COMPONENT_STRIDE * (((size_t) k * h2b + j) * w2b);
+            for (i = 0; i < bordersize; i++)
+            {
+                x = std::max (column - bordersize + i, 0);
+                memcpy (texel + COMPONENT_STRIDE * i, line + COMPONENT_STRIDE * x, COMPONENT_STRIDE);
+            } // end for i
+            memcpy (texel + COMPONENT_STRIDE * bordersize, line + COMPONENT_STRIDE * column, COMPONENT_STRIDE * width);
+            for (i = 0; i < bordersize; i++)
+            {
+                x = std::min (column + width + i, w - 1);
+                memcpy (texel + COMPONENT_STRIDE * (bordersize + width + i), line + COMPONENT_STRIDE * x, COMPONENT_STRIDE);
+            } // end for i
+        } // end for j
+    } // end for k
+} // end fillInterleaved3DTexture()
@@ -35,6 +35,8 @@ class CFrustum;
 class Matrix4x4;
 class OcTree;
 class ShaderObject;
+class StagingCache;
+class VisibleValues;
 class Volume;
 // end Forward Declarations
 
@@ -43,6 +45,9 @@ protected:
     struct DataItem: public GLObject::DataItem {
         GLuint texture3DName;
         GLuint downSamplingTexture3DName;
+        GLuint gradientTexture3DName; // quantized gradients, 0 unless the volume has a gradient texture
+        GLuint illuminatedTexture3DName; // baked lit colors, 0 until the illumination cache has baked
+        int illuminationVersion; // version of the bake held by illuminatedTexture3DName
         DataItem(void);
         virtual ~DataItem(void);
     };
@@ -55,35 +60,45 @@ public:
     GLuint create3DTexture(int bordersize) const;
     GLuint createDownSampling3DTexture(void) const;
     GLuint createDownSamplingMultiComponent3DTexture(void) const;
+    GLuint createGradient3DTexture(int bordersize) const;
     GLuint createMultiComponent3DTexture(void) const;
     GLuint createMultiComponent3DTexture(int bordersize) const;
-    void determineOcNodesToDisplay(void);
+    void drawAtlasVolume(const CFrustum & cFrustum, ShaderObject* shaderObject, float * point, int minimumIndex, int maximumIndex,
+            const Matrix4x4 * modelviewInverse);
     void drawBrick(void) const;
     void drawGrid(const CFrustum & cFrustum) const;
+    void drawIlluminatedVolume(GLContextData & glContextData, const CFrustum & cFrustum, ShaderObject* shaderObject, float * point,
+            int minimumIndex, int maximumIndex, const Matrix4x4 * modelviewInverse);
     void drawSlices(GLContextData & glContextData, const CFrustum & cFrustum, ShaderObject* shaderObject);
     void drawVolume(GLContextData & glContextData, const CFrustum & cFrustum, ShaderObject* shaderObject, float * point, int minimumIndex, int maximumIndex,
             const Matrix4x4 * modelviewInverse);
     void drawXSlice(const CFrustum & cFrustum);
     void drawYSlice(const CFrustum & cFrustum);
     void drawZSlice(const CFrustum & cFrustum);
+    int getBorderSize(void) const;
     void setBrick(int _column, int _row, int _slab, int _width, int _height, int _depth, Volume* _volume);
     void setDownSamplingChanged(bool downSamplingChanged);
     bool isEmpty(void);
     void setEmpty(bool _empty);
-    void setMaximumPriorityQueueSize(int _maximumPriorityQueueSize);
+    bool isResident(void);
+    void setResident(bool _resident);
     void setMaximumPriorityQueueTest(bool _maximumPriorityQueueTest);
-    void setPercentageOfEmptyVolume(float* _alpha);
+    void setPercentageOfEmptyVolume(float* _alpha, int minimumChanged, int maximumChanged,
+            const VisibleValues & visibleValues);
     void setPercentageOfEmptyVolume(float* _red, float* _green, float* _blue);
-    void setPercentageOfEmptyVolume2_5D(float* _alpha);
-    void setRatioOfVisibility(float* _alpha);
+    void setPercentageOfEmptyVolume2_5D(float* _alpha, const VisibleValues & visibleValues);
+    void setPowerOfTwo(bool _powerOfTwo);
+    void setRatioOfVisibility(float* _alpha, int minimumChanged, int maximumChanged,
+            const VisibleValues & visibleValues);
     void setRatioOfVisibility(float* _red, float* _green, float* _blue);
-    void setRatioOfVisibility2_5D(float* _alpha);
+    void setRatioOfVisibility2_5D(float* _alpha, const VisibleValues & visibleValues);
     void setRatioOfVisibilityTest(bool _ratioOfVisibilityTest);
     void setRatioOfVisibilityThreshold(float _ratioOfVisibilityThreshold);
     void setRenderingCost(float _renderingCost);
-    void setRenderingCostFunction(float* _alpha);
+    void setRenderingCostFunction(float* _alpha, int minimumChanged, int maximumChanged,
+            const VisibleValues & visibleValues);
     void setRenderingCostFunction(float* _red, float* _green, float* _blue);
-    void setRenderingCostFunction2_5D(float* _alpha);
+    void setRenderingCostFunction2_5D(float* _alpha, const VisibleValues & visibleValues);
     void setRenderingCostFunctionTest(bool _renderingCostFunctionTest);
     void setShowBricks(bool _showBricks);
     void setShowOcNodes(bool _showOcNodes);
@@ -92,13 +107,17 @@ public:
     void setShowYSlice(bool _showYSlice);
     void setShowZSlice(bool _showZSlice);
     void setSliceFactor(float _sliceFactor);
+    void setStagingCache(StagingCache* _stagingCache);
     int getColumn(void);
     int getDepth(void);
     int getHeight(void);
+    int getIlluminationVersion(GLContextData & glContextData) const;
     void setInteractive(bool _interactive);
     OcTree* getOcTree(void);
     int getRow(void);
     int getSlab(void);
+    void getTextureSize(int level, int bordersize, int* voxelSize, int* textureSize) const;
+    size_t getTextureMemory(int level) const;
     void setSlicingScale(float slicingScale);
     Volume* getVolume(void);
     BoundingBox* getVolumeBox(void);
@@ -119,7 +138,9 @@ public:
     void setZStep(int zStep);
     void initContext(GLContextData& glContextData) const;
     void initialize(DataItem * dataItem) const;
+    void releaseIlluminatedTexture(GLContextData & glContextData) const;
     void update3DTexture(GLuint texture3DName);
+    size_t uploadIlluminatedTexture(GLContextData & glContextData, const unsigned char* texels, int version) const;
 private:
     int borderSize;
     int column;
@@ -128,8 +149,12 @@ private:
     bool empty;
     int height;
     bool interactive;
-    int maximumPriorityQueueSize;
     OcTree* ocTree;
+    int paddedDepth; // size the voxels of the full resolution textures are padded to
+    int paddedHeight;
+    int paddedWidth;
+    bool powerOfTwo; // the GL contexts only take power of two textures
+    bool resident; // textures are only created for bricks owned by this render node
     int row;
     bool showBricks;
     bool showXSlice;
@@ -138,6 +163,7 @@ private:
     int slab;
     float sliceFactor;
     float slicingScale;
+    StagingCache* stagingCache; // host copies of the textures shared by all GL contexts
     Volume* volume;
     BoundingBox* volumeBox;
     BoundingSphere* volumeSphere;
@@ -151,9 +177,17 @@ private:
     float z;
     int zSlice;
     int zStep;
+    const unsigned char* acquireStaging(int level, int bordersize) const;
     void fill3DTexture (int bordersize, unsigned char *voxels) const;
+    void fillGradient3DTexture(int bordersize, unsigned char* texels) const;
+    void fillInterleaved3DTexture (int bordersize, unsigned char *voxels) const;
     void fillMultiComponent3DTexture (int bordersize, unsigned char *voxels,
                                       int icomp) const;
+    int getComponents(int level) const;
+    int getStep(int step) const;
+    unsigned char* padTexture(int level, int bordersize, unsigned char* voxels) const;
+    void releaseStaging(int level, const unsigned char* voxels) const;
+    unsigned char* stage3DTexture(int level, int bordersize) const;
 };
 
 #endif /*BRICK_H_*/
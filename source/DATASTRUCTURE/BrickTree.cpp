@@ -0,0 +1,422 @@
+/*
+ * BrickTree.cpp - Methods for BrickTree class.
+ *
+ * Author: Patrick O'Leary
+ * Created: October 19, 2026
+ * Copyright 2007. All rights reserved.
+ */
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+#include <DATA/Volume.h>
+#include <DATASTRUCTURE/BrickTree.h>
+
+/*
+ * boxVolume - Number of voxels of the region lo to hi within the cells cellLo to cellHi.
+ *
+ * parameter cellLo - const int*
+ * parameter cellHi - const int*
+ * parameter lo - const int*
+ * parameter hi - const int*
+ * parameter cellSize - int
+ * return - double
+ */
+static double boxVolume(const int* cellLo, const int* cellHi, const int* lo, const int* hi, int cellSize) {
+    double result = 1.0;
+    for (int a = 0; a < 3; a++)
+        result *= double(std::min(hi[a], cellHi[a] * cellSize) - std::max(lo[a], cellLo[a] * cellSize));
+    return result;
+} // end boxVolume()
+
+/*
+ * BrickTree - Constructor for BrickTree class.
+ *
+ * parameter _volume - Volume*
+ * parameter _maximumBrickSize - int (voxels along every side of a brick)
+ * parameter numberOfPartitions - int (slabs along z the bricks are kept apart in)
+ */
+BrickTree::BrickTree(Volume* _volume, int _maximumBrickSize, int numberOfPartitions) :
+    background(0), cellSize(std::min(PARTITION_CELL_SIZE, _maximumBrickSize)), maximumBrickSize(_maximumBrickSize),
+            occupied(NULL), root(-1), volume(_volume) {
+    calculateOccupancy();
+    int lo[3] = { 0, 0, 0 };
+    int hi[3] = { volume->getWidth(), volume->getHeight(), volume->getDepth() };
+    root = buildPartitions(lo, hi, 0, std::max(1, numberOfPartitions));
+} // end BrickTree()
+
+/*
+ * ~BrickTree - Destructor for BrickTree class.
+ */
+BrickTree::~BrickTree(void) {
+    delete[] occupied;
+    volume = NULL;
+} // end ~BrickTree()
+
+/*
+ * getBackground - Get the voxel value of the empty space.
+ *
+ * return - unsigned char
+ */
+unsigned char BrickTree::getBackground(void) const {
+    return background;
+} // end getBackground()
+
+/*
+ * getBrick - Get the column, row, slab, width, height and depth of a brick in voxels.
+ *
+ * parameter which - int
+ * return - const int*
+ */
+const int* BrickTree::getBrick(int which) const {
+    return &boxes[6 * which];
+} // end getBrick()
+
+/*
+ * getNumberOfBricks
+ *
+ * return - int
+ */
+int BrickTree::getNumberOfBricks(void) const {
+    return int(partitions.size());
+} // end getNumberOfBricks()
+
+/*
+ * getPartition - Get the slab along z a brick lies in.
+ *
+ * parameter which - int
+ * return - int
+ */
+int BrickTree::getPartition(int which) const {
+    return partitions[which];
+} // end getPartition()
+
+/*
+ * isSameOrder - Both points lie on the same side of every split plane, so the bricks sort alike for them.
+ *
+ * parameter point - const float*
+ * parameter otherPoint - const float*
+ * return - bool
+ */
+bool BrickTree::isSameOrder(const float* point, const float* otherPoint) const {
+    for (size_t i = 0; i < nodes.size(); i++) {
+        const Node& node = nodes[i];
+        if (node.axis >= 0 && (point[node.axis] < node.plane) != (otherPoint[node.axis] < node.plane))
+            return false;
+    } // end for
+    return true;
+} // end isSameOrder()
+
+/*
+ * sortBricks - Order the bricks back to front for the eye at point.
+ *
+ * The bricks below and above a split plane are separated by it, so the side away from the
+ * eye is drawn first, recursively. The value of a brick is its number of bricks from the front.
+ *
+ * parameter point - const float*
+ * parameter brickList - std::vector<ComparableBrick> &
+ */
+void BrickTree::sortBricks(const float* point, std::vector<ComparableBrick> & brickList) const {
+    int position = 0;
+    if (root >= 0)
+        traverse(root, point, brickList, position);
+} // end sortBricks()
+
+/*
+ * addNode - Add a split node between two subtrees.
+ *
+ * parameter axis - int
+ * parameter split - int (voxel the upper side starts at)
+ * parameter lower - int
+ * parameter upper - int
+ * return - int
+ */
+int BrickTree::addNode(int axis, int split, int lower, int upper) {
+    Node node;
+    node.axis = axis;
+    node.children[0] = lower;
+    node.children[1] = upper;
+    // The same expression as the volume box of a brick, so the plane meets the brick faces exactly
+    node.plane = volume->getOrigin(axis) + (volume->getExtent(axis) - volume->getOrigin(axis)) * (float(split)
+            / float(volume->getSize(axis)));
+    node.which = -1;
+    nodes.push_back(node);
+    return int(nodes.size()) - 1;
+} // end addNode()
+
+/*
+ * build - Partition the occupied cells of the region lo to hi.
+ *
+ * parameter lo - int*
+ * parameter hi - int*
+ * parameter partition - int
+ * return - int (node, -1 when the region is empty)
+ */
+int BrickTree::build(int* lo, int* hi, int partition) {
+    int numberOfOccupiedCells = 0;
+    if (!tighten(lo, hi, numberOfOccupiedCells))
+        return -1;
+    bool fits = true;
+    int longest = 0;
+    double size = 1.0;
+    for (int a = 0; a < 3; a++) {
+        if (hi[a] - lo[a] > maximumBrickSize)
+            fits = false;
+        if (hi[a] - lo[a] > hi[longest] - lo[longest])
+            longest = a;
+        size *= double(hi[a] - lo[a]);
+    } // end for
+    int split = 0;
+    double cost = 0.0;
+    int axis = findSplit(lo, hi, split, cost);
+    if (axis >= 0 && cost > (1.0 - PARTITION_MINIMUM_SAVING) * size) {
+        if (fits) {
+            axis = -1;
+        } else {
+            // Nothing to cut away; cut the longest side evenly into pieces no larger than a brick
+            axis = longest;
+            int extent = hi[axis] - lo[axis];
+            int pieces = (extent + maximumBrickSize - 1) / maximumBrickSize;
+            split = ((lo[axis] + extent / pieces) / cellSize) * cellSize;
+            if (split <= lo[axis])
+                split += cellSize;
+        } // end if
+    } // end if
+    if (axis < 0) {
+        Node node;
+        node.axis = -1;
+        node.children[0] = -1;
+        node.children[1] = -1;
+        node.plane = 0.0f;
+        node.which = int(partitions.size());
+        for (int a = 0; a < 3; a++)
+            boxes.push_back(lo[a]);
+        for (int a = 0; a < 3; a++)
+            boxes.push_back(hi[a] - lo[a]);
+        partitions.push_back(partition);
+        nodes.push_back(node);
+        return int(nodes.size()) - 1;
+    } // end if
+    int lowerLo[3], lowerHi[3], upperLo[3], upperHi[3];
+    for (int a = 0; a < 3; a++) {
+        lowerLo[a] = upperLo[a] = lo[a];
+        lowerHi[a] = upperHi[a] = hi[a];
+    } // end for
+    lowerHi[axis] = split;
+    upperLo[axis] = split;
+    int lower = build(lowerLo, lowerHi, partition);
+    int upper = build(upperLo, upperHi, partition);
+    return addNode(axis, split, lower, upper);
+} // end build()
+
+/*
+ * buildPartitions - Cut the region lo to hi into slabs along z and partition each of them.
+ *
+ * parameter lo - int*
+ * parameter hi - int*
+ * parameter firstPartition - int
+ * parameter numberOfPartitions - int
+ * return - int (node, -1 when the region is empty)
+ */
+int BrickTree::buildPartitions(int* lo, int* hi, int firstPartition, int numberOfPartitions) {
+    if (numberOfPartitions == 1)
+        return build(lo, hi, firstPartition);
+    int half = numberOfPartitions / 2;
+    int split = lo[2] + ((hi[2] - lo[2]) * half) / numberOfPartitions;
+    int lowerLo[3], lowerHi[3], upperLo[3], upperHi[3];
+    for (int a = 0; a < 3; a++) {
+        lowerLo[a] = upperLo[a] = lo[a];
+        lowerHi[a] = upperHi[a] = hi[a];
+    } // end for
+    lowerHi[2] = split;
+    upperLo[2] = split;
+    int lower = buildPartitions(lowerLo, lowerHi, firstPartition, half);
+    int upper = buildPartitions(upperLo, upperHi, firstPartition + half, numberOfPartitions - half);
+    if (lower < 0 && upper < 0)
+        return -1;
+    return addNode(2, split, lower, upper);
+} // end buildPartitions()
+
+/*
+ * calculateOccupancy - Find the background value and flag the cells holding other values.
+ *
+ * The volume is read one layer of cells at a time, whatever its storage.
+ */
+void BrickTree::calculateOccupancy(void) {
+    int w = volume->getWidth();
+    int h = volume->getHeight();
+    int d = volume->getDepth();
+    cells[0] = (w + cellSize - 1) / cellSize;
+    cells[1] = (h + cellSize - 1) / cellSize;
+    cells[2] = (d + cellSize - 1) / cellSize;
+    size_t numberOfCells = size_t(cells[0]) * cells[1] * cells[2];
+    unsigned char* minimum = new unsigned char[numberOfCells];
+    unsigned char* maximum = new unsigned char[numberOfCells];
+    memset(minimum, 255, numberOfCells);
+    memset(maximum, 0, numberOfCells);
+    std::vector<size_t> histogram(256, 0);
+    unsigned char* layer = new unsigned char[size_t(w) * h * cellSize];
+    for (int k = 0; k < cells[2]; k++) {
+        int depth = std::min(cellSize, d - k * cellSize);
+        volume->getVoxelRegion(0, 0, k * cellSize, w, h, depth, layer, w, w * h);
+        for (int z = 0; z < depth; z++) {
+            for (int y = 0; y < h; y++) {
+                const unsigned char* voxel = layer + (size_t(z) * h + y) * w;
+                size_t cell = (size_t(k) * cells[1] + y / cellSize) * cells[0];
+                for (int x = 0; x < w; x++) {
+                    histogram[voxel[x]]++;
+                    size_t c = cell + x / cellSize;
+                    if (voxel[x] < minimum[c])
+                        minimum[c] = voxel[x];
+                    if (voxel[x] > maximum[c])
+                        maximum[c] = voxel[x];
+                } // end for
+            } // end for
+        } // end for
+    } // end for
+    delete[] layer;
+    background = 0;
+    for (int v = 1; v < 256; v++) {
+        if (histogram[v] > histogram[background])
+            background = (unsigned char) v;
+    } // end for
+    occupied = new unsigned char[numberOfCells];
+    for (size_t c = 0; c < numberOfCells; c++)
+        occupied[c] = (int(minimum[c]) < int(background) - PARTITION_EMPTY_TOLERANCE || int(maximum[c]) > int(background)
+                + PARTITION_EMPTY_TOLERANCE) ? 1 : 0;
+    delete[] minimum;
+    delete[] maximum;
+} // end calculateOccupancy()
+
+/*
+ * findSplit - Find the cell boundary leaving the least volume in the shrunken boxes of both sides.
+ *
+ * For each axis the occupied cells are gathered per slice across it, once, so the boxes of
+ * the slices before and after every boundary follow from running unions.
+ *
+ * parameter lo - const int*
+ * parameter hi - const int*
+ * parameter split - int & (voxel the upper side starts at)
+ * parameter cost - double & (voxels in both boxes)
+ * return - int (axis, -1 when the region is a single cell)
+ */
+int BrickTree::findSplit(const int* lo, const int* hi, int & split, double & cost) const {
+    int cellLo[3], cellHi[3];
+    for (int a = 0; a < 3; a++) {
+        cellLo[a] = lo[a] / cellSize;
+        cellHi[a] = (hi[a] + cellSize - 1) / cellSize;
+    } // end for
+    int result = -1;
+    for (int a = 0; a < 3; a++) {
+        int m = cellHi[a] - cellLo[a];
+        if (m < 2)
+            continue;
+        // Box of the occupied cells of every slice across a
+        std::vector<int> sliceLo(3 * m, INT_MAX);
+        std::vector<int> sliceHi(3 * m, INT_MIN);
+        int index[3];
+        for (index[2] = cellLo[2]; index[2] < cellHi[2]; index[2]++) {
+            for (index[1] = cellLo[1]; index[1] < cellHi[1]; index[1]++) {
+                for (index[0] = cellLo[0]; index[0] < cellHi[0]; index[0]++) {
+                    if (occupied[(size_t(index[2]) * cells[1] + index[1]) * cells[0] + index[0]] == 0)
+                        continue;
+                    int s = index[a] - cellLo[a];
+                    for (int b = 0; b < 3; b++) {
+                        sliceLo[3 * s + b] = std::min(sliceLo[3 * s + b], index[b]);
+                        sliceHi[3 * s + b] = std::max(sliceHi[3 * s + b], index[b] + 1);
+                    } // end for
+                } // end for
+            } // end for
+        } // end for
+        // Boxes of the slices from t on
+        std::vector<int> afterLo(3 * (m + 1), INT_MAX);
+        std::vector<int> afterHi(3 * (m + 1), INT_MIN);
+        for (int t = m - 1; t >= 0; t--) {
+            for (int b = 0; b < 3; b++) {
+                afterLo[3 * t + b] = std::min(afterLo[3 * (t + 1) + b], sliceLo[3 * t + b]);
+                afterHi[3 * t + b] = std::max(afterHi[3 * (t + 1) + b], sliceHi[3 * t + b]);
+            } // end for
+        } // end for
+        // Box of the slices before t
+        int beforeLo[3] = { INT_MAX, INT_MAX, INT_MAX };
+        int beforeHi[3] = { INT_MIN, INT_MIN, INT_MIN };
+        for (int t = 1; t < m; t++) {
+            for (int b = 0; b < 3; b++) {
+                beforeLo[b] = std::min(beforeLo[b], sliceLo[3 * (t - 1) + b]);
+                beforeHi[b] = std::max(beforeHi[b], sliceHi[3 * (t - 1) + b]);
+            } // end for
+            if (beforeHi[0] == INT_MIN || afterHi[3 * t] == INT_MIN)
+                continue;
+            double c = boxVolume(beforeLo, beforeHi, lo, hi, cellSize) + boxVolume(&afterLo[3 * t], &afterHi[3 * t], lo, hi,
+                    cellSize);
+            if (result < 0 || c < cost) {
+                result = a;
+                split = (cellLo[a] + t) * cellSize;
+                cost = c;
+            } // end if
+        } // end for
+    } // end for
+    return result;
+} // end findSplit()
+
+/*
+ * tighten - Shrink the region lo to hi to its occupied cells.
+ *
+ * parameter lo - int*
+ * parameter hi - int*
+ * parameter numberOfOccupiedCells - int &
+ * return - bool (the region holds an occupied cell)
+ */
+bool BrickTree::tighten(int* lo, int* hi, int & numberOfOccupiedCells) const {
+    int cellLo[3], cellHi[3], occupiedLo[3], occupiedHi[3];
+    for (int a = 0; a < 3; a++) {
+        cellLo[a] = lo[a] / cellSize;
+        cellHi[a] = (hi[a] + cellSize - 1) / cellSize;
+        occupiedLo[a] = INT_MAX;
+        occupiedHi[a] = INT_MIN;
+    } // end for
+    numberOfOccupiedCells = 0;
+    int index[3];
+    for (index[2] = cellLo[2]; index[2] < cellHi[2]; index[2]++) {
+        for (index[1] = cellLo[1]; index[1] < cellHi[1]; index[1]++) {
+            for (index[0] = cellLo[0]; index[0] < cellHi[0]; index[0]++) {
+                if (occupied[(size_t(index[2]) * cells[1] + index[1]) * cells[0] + index[0]] == 0)
+                    continue;
+                numberOfOccupiedCells++;
+                for (int a = 0; a < 3; a++) {
+                    occupiedLo[a] = std::min(occupiedLo[a], index[a]);
+                    occupiedHi[a] = std::max(occupiedHi[a], index[a] + 1);
+                } // end for
+            } // end for
+        } // end for
+    } // end for
+    if (numberOfOccupiedCells == 0)
+        return false;
+    for (int a = 0; a < 3; a++) {
+        lo[a] = std::max(lo[a], occupiedLo[a] * cellSize);
+        hi[a] = std::min(hi[a], occupiedHi[a] * cellSize);
+    } // end for
+    return true;
+} // end tighten()
+
+/*
+ * traverse - Append the bricks of a subtree back to front for the eye at point.
+ *
+ * parameter node - int
+ * parameter point - const float*
+ * parameter brickList - std::vector<ComparableBrick> &
+ * parameter position - int &
+ */
+void BrickTree::traverse(int node, const float* point, std::vector<ComparableBrick> & brickList, int & position) const {
+    const Node& current = nodes[node];
+    if (current.axis < 0) {
+        brickList[position] = ComparableBrick(current.which, float(getNumberOfBricks() - 1 - position));
+        position++;
+        return;
+    } // end if
+    int nearer = (point[current.axis] < current.plane) ? 0 : 1;
+    if (current.children[1 - nearer] >= 0)
+        traverse(current.children[1 - nearer], point, brickList, position);
+    if (current.children[nearer] >= 0)
+        traverse(current.children[nearer], point, brickList, position);
+} // end traverse()
@@ -0,0 +1,69 @@
+/*
+ * BrickTree.h - Class for partitioning the occupied voxels of a volume into bricks with a kd-tree.
+ *
+ * The volume is divided into cells of PARTITION_CELL_SIZE voxels on a side. The most frequent
+ * voxel value is the background, and a cell is empty when all its voxels lie within
+ * PARTITION_EMPTY_TOLERANCE of it. Every node of the tree first shrinks its box to the
+ * occupied cells, then splits at the cell boundary that leaves the least volume in the
+ * shrunken boxes of both sides. A node becomes a brick once it is no larger than the maximum
+ * brick size and no split saves PARTITION_MINIMUM_SAVING of its volume, so the bricks cover
+ * the occupied voxels tightly and empty regions get no brick at all. The split planes order
+ * the bricks back to front for any eye. With more than one partition, the top of the tree
+ * cuts the volume into that many slabs along z first, and every brick belongs to one of them.
+ *
+ * Author: Patrick O'Leary
+ * Created: October 19, 2026
+ * Copyright 2007. All rights reserved.
+ */
+#ifndef BRICKTREE_H_
+#define BRICKTREE_H_
+
+#include <vector>
+
+#include <DATASTRUCTURE/ComparableBrick.h>
+
+#define PARTITION_CELL_SIZE 16
+#define PARTITION_EMPTY_TOLERANCE 2
+#define PARTITION_MINIMUM_SAVING 0.2
+
+// begin Forward Declarations
+class Volume;
+// end Forward Declarations
+
+class BrickTree {
+public:
+    BrickTree(Volume* _volume, int _maximumBrickSize, int numberOfPartitions);
+    ~BrickTree(void);
+    unsigned char getBackground(void) const;
+    const int* getBrick(int which) const;
+    int getNumberOfBricks(void) const;
+    int getPartition(int which) const;
+    bool isSameOrder(const float* point, const float* otherPoint) const;
+    void sortBricks(const float* point, std::vector<ComparableBrick> & brickList) const;
+private:
+    struct Node {
+        int axis; // split axis, -1 for a brick
+        int children[2]; // below and above the split plane, -1 when empty
+        float plane; // split plane in model coordinates
+        int which; // brick of a leaf
+    };
+    unsigned char background;
+    std::vector<int> boxes; // column, row, slab, width, height and depth of every brick
+    int cellSize;
+    int cells[3];
+    int maximumBrickSize;
+    std::vector<Node> nodes;
+    unsigned char* occupied; // one flag per cell, x fastest
+    std::vector<int> partitions; // partition of every brick
+    int root;
+    Volume* volume;
+    int addNode(int axis, int split, int lower, int upper);
+    int build(int* lo, int* hi, int partition);
+    int buildPartitions(int* lo, int* hi, int firstPartition, int numberOfPartitions);
+    void calculateOccupancy(void);
+    int findSplit(const int* lo, const int* hi, int & split, double & cost) const;
+    bool tighten(int* lo, int* hi, int & numberOfOccupiedCells) const;
+    void traverse(int node, const float* point, std::vector<ComparableBrick> & brickList, int & position) const;
+};
+
+#endif /*BRICKTREE_H_*/
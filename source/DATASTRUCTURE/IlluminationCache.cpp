@@ -0,0 +1,410 @@
+/*
+ * IlluminationCache.cpp - Methods for IlluminationCache class.
+ *
+ * Author: Patrick O'Leary
+ * Created: October 19, 2026
+ * Copyright 2007. All rights reserved.
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+/* Vrui includes */
+#include <Misc/Timer.h>
+#include <Vrui/Vrui.h>
+
+#include <DATA/Volume.h>
+#include <DATASTRUCTURE/Brick.h>
+#include <DATASTRUCTURE/IlluminationCache.h>
+#include <DATASTRUCTURE/StagingCache.h>
+#include <SHADER/ShaderVariants.h>
+
+#define THRESHOLD 0.1f
+
+IlluminationCache::Parameters::Parameters(void) {
+    memset(this, 0, sizeof(Parameters));
+}
+
+/*
+ * IlluminationCache - Constructor for IlluminationCache class.
+ *
+ * parameter _volume - Volume* (keeps its gradient vectors, see Volume::compress())
+ * parameter _bricks - Brick*
+ * parameter _numberOfBricks - int
+ */
+IlluminationCache::IlluminationCache(Volume* _volume, Brick* _bricks, int _numberOfBricks) :
+    baked(NULL), bricks(_bricks), current(false), job(NULL), numberOfBricks(_numberOfBricks), pending(NULL), published(NULL),
+            requestedOnce(false), running(false), version(0), volume(_volume) {
+    pthread_mutex_init(&mutex, NULL);
+    for (int i = 0; i < 3; i++)
+        requestedEyePosition[i] = 0.0f;
+} // end IlluminationCache()
+
+/*
+ * ~IlluminationCache - Destructor for IlluminationCache class.
+ */
+IlluminationCache::~IlluminationCache(void) {
+    if (running)
+        pthread_join(thread, NULL);
+    deleteBake(baked);
+    deleteBake(pending);
+    deleteBake(published);
+    pthread_mutex_destroy(&mutex);
+    bricks = NULL;
+    volume = NULL;
+} // end ~IlluminationCache()
+
+/*
+ * isCurrent - The published bake has the parameters of the last request.
+ *
+ * return - bool
+ */
+bool IlluminationCache::isCurrent(void) const {
+    return current;
+} // end isCurrent()
+
+/*
+ * getSize - Bytes of the published bake; every GL context holds a texture of the same size.
+ *
+ * return - size_t
+ */
+size_t IlluminationCache::getSize(void) const {
+    if (published == NULL)
+        return 0;
+    size_t result = 0;
+    for (int i = 0; i < numberOfBricks; i++) {
+        if (published->texels[i] == NULL)
+            continue;
+        int voxelSize[3];
+        int textureSize[3];
+        bricks[i].getTextureSize(STAGING_TEXTURE, bricks[i].getBorderSize(), voxelSize, textureSize);
+        result += 4 * size_t(textureSize[0]) * textureSize[1] * textureSize[2];
+    } // end for
+    return result;
+} // end getSize()
+
+/*
+ * getTexels - The baked colors of a brick, laid out like its full resolution texture.
+ *
+ * parameter which - int
+ * return - const unsigned char* (NULL before the first bake and for bricks without textures)
+ */
+const unsigned char* IlluminationCache::getTexels(int which) const {
+    if (published == NULL)
+        return NULL;
+    return published->texels[which];
+} // end getTexels()
+
+/*
+ * getVersion - Counts the published bakes.
+ *
+ * return - int
+ */
+int IlluminationCache::getVersion(void) const {
+    return version;
+} // end getVersion()
+
+/*
+ * request - Bake the volume for the lighting, the color map and the eye of this frame unless the published or
+ * running bake already fits them.
+ *
+ * Must be called from the render thread.
+ *
+ * parameter parameters - const Parameters &
+ * parameter eyePosition - const float* (model coordinates)
+ * parameter colormap - const unsigned char* (256 by 256 RGBA)
+ */
+void IlluminationCache::request(const Parameters & parameters, const float* eyePosition, const unsigned char* colormap) {
+    if (requestedOnce && memcmp(&parameters, &requested, sizeof(Parameters)) == 0) {
+        // The baked view dependent terms stay good enough until the eye moves noticeably
+        if (!isViewDependent(parameters))
+            return;
+        float size = 0.0f;
+        float moved = 0.0f;
+        for (int i = 0; i < 3; i++) {
+            float side = volume->getExtent(i) - volume->getOrigin(i);
+            float delta = eyePosition[i] - requestedEyePosition[i];
+            size += side * side;
+            moved += delta * delta;
+        } // end for
+        if (moved <= ILLUMINATION_TOLERANCE * ILLUMINATION_TOLERANCE * size)
+            return;
+    } else
+        current = false;
+    requested = parameters;
+    for (int i = 0; i < 3; i++)
+        requestedEyePosition[i] = eyePosition[i];
+    requestedOnce = true;
+    Bake* bake = new Bake;
+    bake->parameters = parameters;
+    for (int i = 0; i < 3; i++)
+        bake->eyePosition[i] = eyePosition[i];
+    bake->colormap = new unsigned char[256 * 256 * 4];
+    memcpy(bake->colormap, colormap, 256 * 256 * 4);
+    bake->texels.assign(numberOfBricks, (unsigned char*) NULL);
+    bake->nextBrick = 0;
+    pthread_mutex_lock(&mutex);
+    if (running) {
+        // Only the newest request is worth baking next
+        deleteBake(pending);
+        pending = bake;
+        pthread_mutex_unlock(&mutex);
+        return;
+    } // end if
+    running = true;
+    pthread_mutex_unlock(&mutex);
+    startBaking(bake);
+} // end request()
+
+/*
+ * update - Publish a finished bake and start the one requested meanwhile.
+ *
+ * Must be called from the render thread, between frames.
+ */
+void IlluminationCache::update(void) {
+    pthread_mutex_lock(&mutex);
+    Bake* finished = baked;
+    baked = NULL;
+    pthread_mutex_unlock(&mutex);
+    if (finished == NULL)
+        return;
+    pthread_join(thread, NULL);
+    deleteBake(published);
+    published = finished;
+    version++;
+    current = (memcmp(&published->parameters, &requested, sizeof(Parameters)) == 0);
+    pthread_mutex_lock(&mutex);
+    Bake* next = pending;
+    pending = NULL;
+    running = (next != NULL);
+    pthread_mutex_unlock(&mutex);
+    if (next != NULL)
+        startBaking(next);
+} // end update()
+
+/*
+ * bakeBrick - Classify and shade every texel of a brick texture as the lit fragment shaders do.
+ *
+ * parameter bake - Bake*
+ * parameter which - int
+ */
+void IlluminationCache::bakeBrick(Bake* bake, int which) const {
+    Brick & brick = bricks[which];
+    int bordersize = brick.getBorderSize();
+    int voxelSize[3];
+    int textureSize[3];
+    brick.getTextureSize(STAGING_TEXTURE, bordersize, voxelSize, textureSize);
+    int size[3] = { volume->getWidth(), volume->getHeight(), volume->getDepth() };
+    int first[3] = { brick.getColumn() - bordersize, brick.getRow() - bordersize, brick.getSlab() - bordersize };
+    float origin[3];
+    float scale[3];
+    for (int i = 0; i < 3; i++) {
+        origin[i] = volume->getOrigin(i);
+        scale[i] = (volume->getExtent(i) - origin[i]) / float(size[i]);
+    } // end for
+    const Parameters & parameters = bake->parameters;
+    // The voxels of a row are read at once; the border and the padding repeat the nearest of them
+    int firstColumn = std::max(0, first[0]);
+    int lastColumn = std::min(size[0] - 1, first[0] + voxelSize[0] - 1);
+    unsigned char* values = new unsigned char[lastColumn - firstColumn + 1];
+    unsigned char* texels = new unsigned char[4 * textureSize[0] * textureSize[1] * textureSize[2]];
+    unsigned char* texel = texels;
+    for (int k = 0; k < textureSize[2]; k++) {
+        int z = std::max(0, std::min(size[2] - 1, first[2] + std::min(k, voxelSize[2] - 1)));
+        for (int j = 0; j < textureSize[1]; j++) {
+            int y = std::max(0, std::min(size[1] - 1, first[1] + std::min(j, voxelSize[1] - 1)));
+            volume->getVoxelRegion(firstColumn, y, z, lastColumn - firstColumn + 1, 1, 1, values, lastColumn - firstColumn + 1,
+                    lastColumn - firstColumn + 1);
+            for (int i = 0; i < textureSize[0]; i++, texel += 4) {
+                int x = std::max(firstColumn, std::min(lastColumn, first[0] + std::min(i, voxelSize[0] - 1)));
+                int value = values[x - firstColumn];
+                unsigned char gradientTexel[4];
+                volume->getGradientTexel((z * size[1] + y) * size[0] + x, gradientTexel);
+                const unsigned char* entry;
+                if (parameters.dimension == 1)
+                    entry = bake->colormap + 4 * (value * 256 + value);
+                else
+                    entry = bake->colormap + 4 * ((255 - gradientTexel[3]) * 256 + value);
+                float color[4];
+                for (int c = 0; c < 4; c++)
+                    color[c] = float(entry[c]) / 255.0f;
+                if (color[3] > THRESHOLD) {
+                    float N[3];
+                    float L[3];
+                    float V[3];
+                    float position[3] = { origin[0] + scale[0] * (float(x) + 0.5f), origin[1] + scale[1] * (float(y) + 0.5f),
+                            origin[2] + scale[2] * (float(z) + 0.5f) };
+                    float lengthN = 0.0f;
+                    float lengthL = 0.0f;
+                    float lengthV = 0.0f;
+                    for (int c = 0; c < 3; c++) {
+                        N[c] = float(gradientTexel[c]) / 127.5f - 1.0f;
+                        L[c] = parameters.lightPosition[c] - position[c];
+                        V[c] = bake->eyePosition[c] - position[c];
+                        lengthN += N[c] * N[c];
+                        lengthL += L[c] * L[c];
+                        lengthV += V[c] * V[c];
+                    } // end for
+                    lengthN = (lengthN > 0.0f) ? 1.0f / std::sqrt(lengthN) : 0.0f;
+                    lengthL = (lengthL > 0.0f) ? 1.0f / std::sqrt(lengthL) : 0.0f;
+                    lengthV = (lengthV > 0.0f) ? 1.0f / std::sqrt(lengthV) : 0.0f;
+                    float diffuseLight = 0.0f;
+                    float angleVN = 0.0f;
+                    float gradient = 0.0f;
+                    for (int c = 0; c < 3; c++) {
+                        N[c] *= lengthN;
+                        L[c] *= lengthL;
+                        V[c] *= lengthV;
+                        diffuseLight += L[c] * N[c];
+                        angleVN += V[c] * N[c];
+                        gradient += N[c] * N[c];
+                    } // end for
+                    if (parameters.features & NORMAL_SHADING) {
+                        float H[3];
+                        float lengthH = 0.0f;
+                        for (int c = 0; c < 3; c++) {
+                            H[c] = L[c] + V[c];
+                            lengthH += H[c] * H[c];
+                        } // end for
+                        lengthH = (lengthH > 0.0f) ? 1.0f / std::sqrt(lengthH) : 0.0f;
+                        float angleHN = 0.0f;
+                        for (int c = 0; c < 3; c++)
+                            angleHN += H[c] * lengthH * N[c];
+                        float specularLight = std::pow(std::max(angleHN, 0.0f), parameters.shininess);
+                        for (int c = 0; c < 3; c++)
+                            color[c] += parameters.normalContribution * (parameters.kAmbient[c] * parameters.ambientColor[c]
+                                    + parameters.kDiffuse[c] * parameters.diffuseColor[c] * diffuseLight + parameters.kSpecular[c]
+                                    * parameters.specularColor[c] * specularLight);
+                    } // end if
+                    if (parameters.features & TONE_SHADING) {
+                        float warm = (1.0f + diffuseLight) * 0.5f;
+                        for (int c = 0; c < 3; c++)
+                            color[c] += parameters.toneContribution * (warm * parameters.warmColor[c] + (1.0f - warm)
+                                    * parameters.coolColor[c]);
+                    } // end if
+                    if (parameters.features & TOON_SHADING) {
+                        float band = 0.0f;
+                        if (diffuseLight > 0.95f)
+                            band = 0.75f;
+                        else if (diffuseLight > 0.50f)
+                            band = 0.50f;
+                        else if (diffuseLight > 0.25f)
+                            band = 0.25f;
+                        for (int c = 0; c < 3; c++)
+                            color[c] += parameters.toonContribution * (parameters.toonColor[c] - band * (parameters.toonColor[c]
+                                    - 1.0f));
+                    } // end if
+                    if (parameters.features & BOUNDARY_SHADING) {
+                        // The two dimensional shader weighs the boundary by the gradient magnitude
+                        if (parameters.dimension != 1)
+                            gradient = float(gradientTexel[3]) / 255.0f;
+                        color[3] += parameters.boundaryContribution * std::pow(gradient, parameters.boundaryExponent);
+                    } // end if
+                    if (parameters.features & SILHOUETTE_SHADING)
+                        color[3] += parameters.silhouetteContribution * std::pow(1.0f - std::fabs(angleVN),
+                                parameters.silhouetteExponent);
+                    if ((parameters.features & EDGE_SHADING) && parameters.edgeContribution > 0.0f) {
+                        float edgeValue = std::pow(1.0f - std::fabs(angleVN), parameters.edgeExponent);
+                        if (edgeValue > parameters.edgeThreshold) {
+                            float weight = std::pow((edgeValue - parameters.edgeThreshold) / (1.0f - parameters.edgeThreshold), 4.0f);
+                            for (int c = 0; c < 3; c++)
+                                color[c] *= 1.0f - weight;
+                        } // end if
+                    } // end if
+                } // end if
+                for (int c = 0; c < 4; c++)
+                    texel[c] = (unsigned char) (255.0f * std::max(0.0f, std::min(1.0f, color[c])) + 0.5f);
+            } // end for
+        } // end for
+    } // end for
+    delete[] values;
+    bake->texels[which] = texels;
+} // end bakeBrick()
+
+/*
+ * bakeThread - Bake all resident bricks on the decode threads of the volume.
+ *
+ * parameter parameter - void*
+ * return - void*
+ */
+void* IlluminationCache::bakeThread(void* parameter) {
+    IlluminationCache* illuminationCache = static_cast<IlluminationCache*> (parameter);
+    Misc::Timer timer;
+    int numberOfThreads = std::max(1, std::min(illuminationCache->volume->getNumberOfDecodeThreads(),
+            illuminationCache->numberOfBricks));
+    std::vector<pthread_t> threads(numberOfThreads);
+    for (int i = 0; i < numberOfThreads; i++)
+        pthread_create(&threads[i], NULL, workerThread, illuminationCache);
+    for (int i = 0; i < numberOfThreads; i++)
+        pthread_join(threads[i], NULL);
+    Bake* bake = illuminationCache->job;
+    delete[] bake->colormap;
+    bake->colormap = NULL;
+    timer.elapse();
+    if (Vrui::getNodeIndex() == 0)
+        std::cout << "IlluminationCache: " << illuminationCache->numberOfBricks << " bricks baked in " << timer.getTime() * 1000.0
+                << " ms on " << numberOfThreads << " threads" << std::endl;
+    pthread_mutex_lock(&illuminationCache->mutex);
+    illuminationCache->baked = bake;
+    illuminationCache->job = NULL;
+    pthread_mutex_unlock(&illuminationCache->mutex);
+    return NULL;
+} // end bakeThread()
+
+/*
+ * deleteBake
+ *
+ * parameter bake - Bake*
+ */
+void IlluminationCache::deleteBake(Bake* bake) {
+    if (bake == NULL)
+        return;
+    for (unsigned int i = 0; i < bake->texels.size(); i++)
+        delete[] bake->texels[i];
+    delete[] bake->colormap;
+    delete bake;
+} // end deleteBake()
+
+/*
+ * isViewDependent - Some enabled shading term depends on the eye.
+ *
+ * parameter parameters - const Parameters &
+ * return - bool
+ */
+bool IlluminationCache::isViewDependent(const Parameters & parameters) {
+    bool specular = parameters.kSpecular[0] > 0.0f || parameters.kSpecular[1] > 0.0f || parameters.kSpecular[2] > 0.0f;
+    return ((parameters.features & NORMAL_SHADING) && specular) || (parameters.features & (SILHOUETTE_SHADING | EDGE_SHADING));
+} // end isViewDependent()
+
+/*
+ * startBaking
+ *
+ * parameter bake - Bake*
+ */
+void IlluminationCache::startBaking(Bake* bake) {
+    job = bake;
+    pthread_create(&thread, NULL, bakeThread, this);
+} // end startBaking()
+
+/*
+ * workerThread - Bake bricks until none are left.
+ *
+ * parameter parameter - void*
+ * return - void*
+ */
+void* IlluminationCache::workerThread(void* parameter) {
+    IlluminationCache* illuminationCache = static_cast<IlluminationCache*> (parameter);
+    Bake* bake = illuminationCache->job;
+    while (true) {
+        pthread_mutex_lock(&illuminationCache->mutex);
+        int which = bake->nextBrick++;
+        pthread_mutex_unlock(&illuminationCache->mutex);
+        if (which >= illuminationCache->numberOfBricks)
+            break;
+        // Bricks of other render nodes never get textures
+        if (illuminationCache->bricks[which].isResident())
+            illuminationCache->bakeBrick(bake, which);
+    } // end while
+    return NULL;
+} // end workerThread()
@@ -0,0 +1,102 @@
+/*
+ * IlluminationCache.h - Class for baking the lit colors of scalar volumes into brick textures.
+ *
+ * While the lighting and the transfer function stay the same, the lit color of every voxel
+ * does too, so the cache classifies and shades every voxel of the resident bricks once on
+ * worker threads and the bricks are then drawn with a shader that only looks the color up.
+ * Each brick is baked into an RGBA texture laid out like its full resolution texture, border
+ * and power of two padding included, so the octree nodes keep their texture coordinates.
+ * The silhouette, edge and specular terms depend on the eye; they are baked for the head and
+ * baked again once the head has moved by more than ILLUMINATION_TOLERANCE of the size of
+ * the volume. Baking runs on a background thread; the render thread publishes a finished
+ * bake and the bricks upload it once per context, ILLUMINATION_UPLOAD_BUDGET bytes per frame,
+ * drawing with the previous bake until theirs is uploaded.
+ *
+ * Author: Patrick O'Leary
+ * Created: October 19, 2026
+ * Copyright 2007. All rights reserved.
+ */
+#ifndef ILLUMINATIONCACHE_H_
+#define ILLUMINATIONCACHE_H_
+
+#include <cstddef>
+#include <pthread.h>
+#include <vector>
+
+#define ILLUMINATION_TOLERANCE 0.1f
+#define ILLUMINATION_UPLOAD_BUDGET (16 * 1024 * 1024)
+
+// begin Forward Declarations
+class Brick;
+class Volume;
+// end Forward Declarations
+
+class IlluminationCache {
+public:
+    struct Parameters {
+        float ambientColor[3];
+        float diffuseColor[3];
+        float specularColor[3];
+        float kAmbient[3];
+        float kDiffuse[3];
+        float kSpecular[3];
+        float shininess;
+        float normalContribution;
+        float toneContribution;
+        float coolColor[3];
+        float warmColor[3];
+        float toonContribution;
+        float toonColor[3];
+        float boundaryContribution;
+        float boundaryExponent;
+        float silhouetteContribution;
+        float silhouetteExponent;
+        float edgeContribution;
+        float edgeExponent;
+        float edgeThreshold;
+        float lightPosition[3]; // model coordinates
+        int dimension; // of the transfer function
+        unsigned int features; // shading terms, as in ShaderVariants.h
+        unsigned int colorMapVersion;
+        Parameters(void);
+    };
+    IlluminationCache(Volume* _volume, Brick* _bricks, int _numberOfBricks);
+    ~IlluminationCache(void);
+    bool isCurrent(void) const;
+    size_t getSize(void) const;
+    const unsigned char* getTexels(int which) const;
+    int getVersion(void) const;
+    void request(const Parameters & parameters, const float* eyePosition, const unsigned char* colormap);
+    void update(void);
+private:
+    struct Bake {
+        Parameters parameters;
+        float eyePosition[3];
+        unsigned char* colormap; // copy of the two dimensional color map
+        std::vector<unsigned char*> texels; // of every brick, NULL for bricks without textures
+        int nextBrick; // next brick for the worker threads, guarded by mutex
+    };
+    Bake* baked; // finished by the baking thread, not yet published
+    Brick* bricks;
+    bool current; // the published bake has the requested parameters
+    Bake* job; // bake being filled by the baking thread
+    pthread_mutex_t mutex;
+    int numberOfBricks;
+    Bake* pending; // requested while baking, started once the job is published
+    Bake* published; // bake the bricks upload
+    Parameters requested;
+    float requestedEyePosition[3];
+    bool requestedOnce;
+    bool running;
+    pthread_t thread;
+    int version;
+    Volume* volume;
+    void bakeBrick(Bake* bake, int which) const;
+    static void* bakeThread(void* parameter);
+    static void deleteBake(Bake* bake);
+    static bool isViewDependent(const Parameters & parameters);
+    void startBaking(Bake* bake);
+    static void* workerThread(void* parameter);
+};
+
+#endif /*ILLUMINATIONCACHE_H_*/
@@ -7,12 +7,20 @@
  */
 #include <algorithm>
 
+#include <DATA/ComponentKernels.h>
+#include <DATA/CompressedVolume.h>
+#include <DATA/TiledVolume.h>
+#include <DATA/ValueMask.h>
 #include <DATA/Volume.h>
 #include <DATASTRUCTURE/BoundingBox.h>
 #include <DATASTRUCTURE/BoundingSphere.h>
 #include <DATASTRUCTURE/Brick.h>
-#include <DATASTRUCTURE/ComparableOcNode.h>
 #include <DATASTRUCTURE/OcNode.h>
+#include <DATASTRUCTURE/OcNodePool.h>
+#include <DATASTRUCTURE/OctantOrder.h>
+#include <DATASTRUCTURE/TextureAtlas.h>
+#include <DATASTRUCTURE/VisibleValues.h>
+#include <GRAPHIC/Benchmark.h>
 #include <GRAPHIC/CFrustum.h>
 #include <MATH/Matrix4x4.h>
 #include <MATH/Vector4.h>
@@ -23,21 +31,24 @@
  * OcNode - Constructor for OcNode.
  */
 OcNode::OcNode(void) :
-    brick(NULL), child(NULL), cost(0.0), costStructure(0.01), costRender(0.0), delta(0.0), displayed(false), empty(false),
-            emptyChildren(0), leaf(false), level(0), maximumLevel(-1), maximumPriorityQueueTest(false), parent(NULL),
-            percentageOfEmptyVolume(0.0), ratioOfVisibility(0.1), ratioOfVisibilityTest(false), ratioOfVisibilityThreshold(1.0),
-            renderingCostFunctionTest(true), renderingCost(0.2), sliceFactor(1.5), volumeBox(NULL), volumeSphere(NULL), which(-1) {
+    atlasBox(NULL), brick(NULL), child(NULL), cost(0.0), costStructure(0.01), costRender(0.0), delta(0.0), displayed(false), empty(false),
+            emptyChildren(0), leaf(false), level(0), maximum(255), maximumLevel(-1), maximumPriorityQueueTest(false), minimum(0),
+            parent(NULL), percentageOfEmptyVolume(0.0), pool(NULL), ratioOfVisibility(0.1), ratioOfVisibilityTest(false), ratioOfVisibilityThreshold(1.0),
+            renderingCostFunctionTest(true), renderingCost(0.2), sliceFactor(1.5), valueMask(VALUE_MASK_ALL), volumeBox(NULL), volumeSphere(NULL),
+            which(-1) {
 } // end OcNode()
 
 /*
- * OcNode - Constructor for OcNode.
+ * OcNode - Constructor for the root OcNode of a brick; createSubtree() builds the rest of the tree.
  *
  * parameter _brick - Brick*
+ * parameter _pool - OcNodePool*
  */
-OcNode::OcNode(Brick* _brick) :
-    child(NULL), cost(0.0), costStructure(0.01), costRender(0.0), empty(false), emptyChildren(0), level(0), maximumLevel(-1),
-            maximumPriorityQueueTest(false), parent(NULL), percentageOfEmptyVolume(0.0), ratioOfVisibility(0.1),
-            ratioOfVisibilityTest(false), renderingCostFunctionTest(true), renderingCost(0.2), which(-1) {
+OcNode::OcNode(Brick* _brick, OcNodePool* _pool) :
+    atlasBox(NULL), child(NULL), cost(0.0), costStructure(0.01), costRender(0.0), displayed(true), empty(false), emptyChildren(0), leaf(true), level(0), maximum(255),
+            maximumLevel(-1), maximumPriorityQueueTest(false), minimum(0), parent(NULL), percentageOfEmptyVolume(0.0), pool(_pool),
+            ratioOfVisibility(0.1), ratioOfVisibilityTest(false), renderingCostFunctionTest(true), renderingCost(0.2), valueMask(VALUE_MASK_ALL),
+            which(-1) {
     brick = _brick;
     volume = brick->getVolume();
     ratioOfVisibilityThreshold = volume->getRatioOfVisibilityThreshold();
@@ -53,47 +64,65 @@ OcNode::OcNode(Brick* _brick) :
     z = brick->getZ();
     volumeBox = brick->getVolumeBox();
     volumeSphere = brick->getVolumeSphere();
-    textureBox = new BoundingBox(0, 0, 0, 1, 1, 1);
+    textureBox = pool->createBoundingBox(0, 0, 0, 1, 1, 1);
     calculateDelta(getMaximum(volumeBox, volumeBox->getMaximumIndex()), getMinimum(volumeBox, volumeBox->getMinimumIndex()));
-    if ((width / 2 >= volume->getLeafSize() && height / 2 >= volume->getLeafSize() && depth / 2 >= volume->getLeafSize()) && (width
-            / 2 >= 4 && height / 2 >= 4 && depth / 2 >= 4)) {
-        leaf = false;
-        displayed = false;
-        createChildren();
-    } else {
-        leaf = true;
-        displayed = true;
-    }
     renderingCost = 1.0f / pow(2.0, 3.0);
 } // end OcNode()
 
 /*
  * ~OcNode - Destructor for OcNode.
+ *
+ * The children and boxes of a pooled node are released with its OcNodePool; the root's
+ * volume box and sphere belong to its brick.
  */
 OcNode::~OcNode(void) {
-    delete textureBox;
-    delete volumeBox;
-    delete volumeSphere;
-    if (child != 0)
-        delete[] child;
+    delete atlasBox;
+    if (pool == NULL) {
+        delete textureBox;
+        delete volumeBox;
+        delete volumeSphere;
+        if (child != 0)
+            delete[] child;
+    } // end if
 } // end ~OcNode()
 
 /*
- * adjustTextureCoordinatesTraversal
+ * adjustTextureCoordinatesTraversal - Move the texture coordinates in by dx, dy, dz, then scale them by sx, sy, sz.
  *
  * parameter dx - float
  * parameter dy - float
  * parameter dz - float
+ * parameter sx - float
+ * parameter sy - float
+ * parameter sz - float
  */
-void OcNode::adjustTextureCoordinatesTraversal(float dx, float dy, float dz) {
+void OcNode::adjustTextureCoordinatesTraversal(float dx, float dy, float dz, float sx, float sy, float sz) {
     textureBox->adjustCoordinates(dx, dy, dz);
+    textureBox->scaleCoordinates(sx, sy, sz);
     if (!isLeaf()) {
         for (int i = 0; i < 8; i++) {
-            child[i].adjustTextureCoordinatesTraversal(dx, dy, dz);
+            child[i].adjustTextureCoordinatesTraversal(dx, dy, dz, sx, sy, sz);
         } // end for
     } // end if
 } // end adjustTextureCoordinatesTraversal()
 
+/*
+ * atlasBlocksTraversal - Collect the atlas blocks that are visible under the current classification.
+ *
+ * parameter blocks - std::vector<OcNode*> &
+ */
+void OcNode::atlasBlocksTraversal(std::vector<OcNode*> & blocks) {
+    if (ratioOfVisibility == 0.0f)
+        return;
+    if (isAtlasBlock()) {
+        blocks.push_back(this);
+    } else {
+        for (int i = 0; i < 8; i++) {
+            child[i].atlasBlocksTraversal(blocks);
+        } // end for
+    } // end if
+} // end atlasBlocksTraversal()
+
 /*
  * calculateDelta - Calculate the slice step size.
  *
@@ -131,14 +160,22 @@ void OcNode::calculateEmptiness(float* alpha) {
     int w = volume->getWidth();
     int h = volume->getHeight();
     int d = volume->getDepth();
-    for (int k = 0; k < depth; k++) {
-        for (int j = 0; j < height; j++) {
-            for (int i = 0; i < width; i++) {
-                value = alpha[volume->getVoxel(((slab + (k)) * (w * h)) + ((row + (j)) * (w)) + (column + (i)))];
-                ratioOfVisibility += value;
+    if (volume->getCompressedVoxels() != NULL) {
+        float zeros = 0.0f;
+        volume->getCompressedVoxels()->accumulate(column, row, slab, width, height, depth, alpha, ratioOfVisibility, zeros);
+    } else if (volume->getTiledVoxels() != NULL) {
+        float zeros = 0.0f;
+        volume->getTiledVoxels()->accumulate(column, row, slab, width, height, depth, alpha, ratioOfVisibility, zeros);
+    } else {
+        for (int k = 0; k < depth; k++) {
+            for (int j = 0; j < height; j++) {
+                for (int i = 0; i < width; i++) {
+                    value = alpha[volume->getVoxel(((slab + (k)) * (w * h)) + ((row + (j)) * (w)) + (column + (i)))];
+                    ratioOfVisibility += value;
+                } // end for
             } // end for
         } // end for
-    } // end for
+    } // end else
     if (ratioOfVisibility == 0.0f)
         empty = true;
     else
@@ -154,22 +191,9 @@ void OcNode::calculateEmptiness(float* alpha) {
  */
 void OcNode::calculateEmptiness(float* red, float* green, float* blue) {
     emptyChildren = 0;
-    ratioOfVisibility = 0.0f;
-    float value = 0.0f;
-    int w = volume->getWidth();
-    int h = volume->getHeight();
-    int d = volume->getDepth();
-    for (int k = 0; k < depth; k++) {
-        for (int j = 0; j < height; j++) {
-            for (int i = 0; i < width; i++) {
-                value = 0.0f;
-                value += red[volume->getRedVoxel(((slab + (k)) * (w * h)) + ((row + (j)) * (w)) + (column + (i)))];
-                value += green[volume->getGreenVoxel(((slab + (k)) * (w * h)) + ((row + (j)) * (w)) + (column + (i)))];
-                value += blue[volume->getBlueVoxel(((slab + (k)) * (w * h)) + ((row + (j)) * (w)) + (column + (i)))];
-                ratioOfVisibility += value;
-            } // end for
-        } // end for
-    } // end for
+    float transparent = 0.0f;
+    volume->calculateComponentVisibility(column, row, slab, width, height, depth, red, green, blue, ratioOfVisibility,
+            transparent);
     if (ratioOfVisibility == 0.0f)
         empty = true;
     else
@@ -219,16 +243,24 @@ void OcNode::calculatePercentageOfEmptyVolume(float* alpha) {
     int w = volume->getWidth();
     int h = volume->getHeight();
     int d = volume->getDepth();
-    for (int k = 0; k < depth; k++) {
-        for (int j = 0; j < height; j++) {
-            for (int i = 0; i < width; i++) {
-                value = alpha[volume->getVoxel(((slab + (k)) * (w * h)) + ((row + (j)) * (w)) + (column + (i)))];
-                ratioOfVisibility += value;
-                if (value == 0.0f)
-                    percentageOfEmptyVolume += 1.0f;
+    if (volume->getCompressedVoxels() != NULL) {
+        volume->getCompressedVoxels()->accumulate(column, row, slab, width, height, depth, alpha, ratioOfVisibility,
+                percentageOfEmptyVolume);
+    } else if (volume->getTiledVoxels() != NULL) {
+        volume->getTiledVoxels()->accumulate(column, row, slab, width, height, depth, alpha, ratioOfVisibility,
+                percentageOfEmptyVolume);
+    } else {
+        for (int k = 0; k < depth; k++) {
+            for (int j = 0; j < height; j++) {
+                for (int i = 0; i < width; i++) {
+                    value = alpha[volume->getVoxel(((slab + (k)) * (w * h)) + ((row + (j)) * (w)) + (column + (i)))];
+                    ratioOfVisibility += value;
+                    if (value == 0.0f)
+                        percentageOfEmptyVolume += 1.0f;
+                } // end for
             } // end for
         } // end for
-    } // end for
+    } // end else
     percentageOfEmptyVolume *= ((volume->getScale(0)) * (volume->getScale(1)) * (volume->getScale(2)));
     percentageOfEmptyVolume /= ((w * volume->getScale(0)) * (h * volume->getScale(1)) * (d * volume->getScale(2)));
     if (ratioOfVisibility == 0.0f)
@@ -280,100 +312,39 @@ void OcNode::calculatePercentageOfEmptyVolume2_5D(float* alpha) {
  * parameter blue - float*
  */
 void OcNode::calculatePercentageOfEmptyVolume(float* red, float* green, float* blue) {
-    percentageOfEmptyVolume = 0.0f;
-    ratioOfVisibility = 0.0f;
-    float value = 0.0f;
     int w = volume->getWidth();
     int h = volume->getHeight();
     int d = volume->getDepth();
-    int typeOfComponents = volume->getTypeOfComponents();
-    if (typeOfComponents == 7) {
-        for (int k = 0; k < depth; k++) {
-            for (int j = 0; j < height; j++) {
-                for (int i = 0; i < width; i++) {
-                    value = red[volume->getRedVoxel(((slab + (k)) * (w * h)) + ((row + (j)) * (w)) + (column + (i)))];
-                    value += green[volume->getGreenVoxel(((slab + (k)) * (w * h)) + ((row + (j)) * (w)) + (column + (i)))];
-                    value += blue[volume->getBlueVoxel(((slab + (k)) * (w * h)) + ((row + (j)) * (w)) + (column + (i)))];
-                    ratioOfVisibility += value;
-                    if (value == 0.0f)
-                        percentageOfEmptyVolume += 1.0f;
-                } // end for
-            } // end for
-        } // end for
-    } else if (typeOfComponents == 6) {
-        for (int k = 0; k < depth; k++) {
-            for (int j = 0; j < height; j++) {
-                for (int i = 0; i < width; i++) {
-                    value = red[volume->getRedVoxel(((slab + (k)) * (w * h)) + ((row + (j)) * (w)) + (column + (i)))];
-                    value += green[volume->getGreenVoxel(((slab + (k)) * (w * h)) + ((row + (j)) * (w)) + (column + (i)))];
-                    ratioOfVisibility += value;
-                    if (value == 0.0f)
-                        percentageOfEmptyVolume += 1.0f;
-                } // end for
-            } // end for
-        } // end for
-    } else if (typeOfComponents == 5) {
-        for (int k = 0; k < depth; k++) {
-            for (int j = 0; j < height; j++) {
-                for (int i = 0; i < width; i++) {
-                    value = red[volume->getRedVoxel(((slab + (k)) * (w * h)) + ((row + (j)) * (w)) + (column + (i)))];
-                    value += blue[volume->getBlueVoxel(((slab + (k)) * (w * h)) + ((row + (j)) * (w)) + (column + (i)))];
-                    ratioOfVisibility += value;
-                    if (value == 0.0f)
-                        percentageOfEmptyVolume += 1.0f;
-                } // end for
-            } // end for
-        } // end for
-    } else if (typeOfComponents == 4) {
-        for (int k = 0; k < depth; k++) {
-            for (int j = 0; j < height; j++) {
-                for (int i = 0; i < width; i++) {
-                    value = red[volume->getRedVoxel(((slab + (k)) * (w * h)) + ((row + (j)) * (w)) + (column + (i)))];
-                    ratioOfVisibility += value;
-                    if (value == 0.0f)
-                        percentageOfEmptyVolume += 1.0f;
-                } // end for
-            } // end for
-        } // end for
-    } else if (typeOfComponents == 3) {
-        for (int k = 0; k < depth; k++) {
-            for (int j = 0; j < height; j++) {
-                for (int i = 0; i < width; i++) {
-                    value = green[volume->getGreenVoxel(((slab + (k)) * (w * h)) + ((row + (j)) * (w)) + (column + (i)))];
-                    value += blue[volume->getBlueVoxel(((slab + (k)) * (w * h)) + ((row + (j)) * (w)) + (column + (i)))];
-                    ratioOfVisibility += value;
-                    if (value == 0.0f)
-                        percentageOfEmptyVolume += 1.0f;
-                } // end for
-            } // end for
-        } // end for
-    } else if (typeOfComponents == 2) {
-        for (int k = 0; k < depth; k++) {
-            for (int j = 0; j < height; j++) {
-                for (int i = 0; i < width; i++) {
-                    value = green[volume->getGreenVoxel(((slab + (k)) * (w * h)) + ((row + (j)) * (w)) + (column + (i)))];
-                    ratioOfVisibility += value;
-                    if (value == 0.0f)
-                        percentageOfEmptyVolume += 1.0f;
-                } // end for
-            } // end for
-        } // end for
-    } else if (typeOfComponents == 1) {
-        for (int k = 0; k < depth; k++) {
-            for (int j = 0; j < height; j++) {
-                for (int i = 0; i < width; i++) {
-                    value = blue[volume->getBlueVoxel(((slab + (k)) * (w * h)) + ((row + (j)) * (w)) + (column + (i)))];
-                    ratioOfVisibility += value;
-                    if (value == 0.0f)
-                        percentageOfEmptyVolume += 1.0f;
-                } // end for
-            } // end for
-        } // end for
-    }
+    volume->calculateComponentVisibility(column, row, slab, width, height, depth, red, green, blue, ratioOfVisibility,
+            percentageOfEmptyVolume);
     percentageOfEmptyVolume *= ((volume->getScale(0)) * (volume->getScale(1)) * (volume->getScale(2)));
     percentageOfEmptyVolume /= ((w * volume->getScale(0)) * (h * volume->getScale(1)) * (d * volume->getScale(2)));
 } // end calculatePercentageOfEmptyVolume()
 
+/*
+ * calculateRange - Calculate the range of voxel values in the node; leaves scan the volume, others merge their children.
+ */
+void OcNode::calculateRange(void) {
+    if (volume->getNumberOfComponents() != 0) {
+        minimum = 0;
+        maximum = 255;
+        valueMask = VALUE_MASK_ALL;
+    } else if (isLeaf()) {
+        minimum = volume->calculateMinimum(column, row, slab, width, height, depth);
+        maximum = volume->calculateMaximum(column, row, slab, width, height, depth);
+        valueMask = volume->calculateValueMask(column, row, slab, width, height, depth);
+    } else {
+        minimum = child[0].getMinimum();
+        maximum = child[0].getMaximum();
+        valueMask = child[0].getValueMask();
+        for (int i = 1; i < 8; i++) {
+            minimum = std::min(minimum, child[i].getMinimum());
+            maximum = std::max(maximum, child[i].getMaximum());
+            valueMask |= child[i].getValueMask();
+        } // end for
+    } // end if
+} // end calculateRange()
+
 /*
  * calculateRatioOfVisibility - Calculate the ratio of visibility.
  *
@@ -384,13 +355,21 @@ void OcNode::calculateRatioOfVisibility(float* alpha) {
     int w = volume->getWidth();
     int h = volume->getHeight();
     int d = volume->getDepth();
-    for (int k = 0; k < depth; k++) {
-        for (int j = 0; j < height; j++) {
-            for (int i = 0; i < width; i++) {
-                ratioOfVisibility += alpha[volume->getVoxel(((slab + (k)) * (w * h)) + ((row + (j)) * (w)) + (column + (i)))];
+    if (volume->getCompressedVoxels() != NULL) {
+        float zeros = 0.0f;
+        volume->getCompressedVoxels()->accumulate(column, row, slab, width, height, depth, alpha, ratioOfVisibility, zeros);
+    } else if (volume->getTiledVoxels() != NULL) {
+        float zeros = 0.0f;
+        volume->getTiledVoxels()->accumulate(column, row, slab, width, height, depth, alpha, ratioOfVisibility, zeros);
+    } else {
+        for (int k = 0; k < depth; k++) {
+            for (int j = 0; j < height; j++) {
+                for (int i = 0; i < width; i++) {
+                    ratioOfVisibility += alpha[volume->getVoxel(((slab + (k)) * (w * h)) + ((row + (j)) * (w)) + (column + (i)))];
+                } // end for
             } // end for
         } // end for
-    } // end for
+    } // end else
     ratioOfVisibility /= ((width) * (height) * (depth));
 } // end calculateRatioOfVisibility()
 
@@ -428,88 +407,10 @@ void OcNode::calculateRatioOfVisibility2_5D(float* alpha) {
  * parameter blue - float*
  */
 void OcNode::calculateRatioOfVisibility(float* red, float* green, float* blue) {
-    ratioOfVisibility = 0.0f;
-    int w = volume->getWidth();
-    int h = volume->getHeight();
-    int d = volume->getDepth();
-    int typeOfComponents = volume->getTypeOfComponents();
-    if (typeOfComponents == 7) {
-        for (int k = 0; k < depth; k++) {
-            for (int j = 0; j < height; j++) {
-                for (int i = 0; i < width; i++) {
-                    ratioOfVisibility += red[volume->getRedVoxel(((slab + (k)) * (w * h)) + ((row + (j)) * (w)) + (column + (i)))];
-                    ratioOfVisibility += green[volume->getGreenVoxel(((slab + (k)) * (w * h)) + ((row + (j)) * (w))
-                            + (column + (i)))];
-                    ratioOfVisibility
-                            += blue[volume->getBlueVoxel(((slab + (k)) * (w * h)) + ((row + (j)) * (w)) + (column + (i)))];
-                } // end for
-            } // end for
-        } // end for
-        ratioOfVisibility /= (3 * (width) * (height) * (depth));
-    } else if (typeOfComponents == 6) {
-        for (int k = 0; k < depth; k++) {
-            for (int j = 0; j < height; j++) {
-                for (int i = 0; i < width; i++) {
-                    ratioOfVisibility += red[volume->getRedVoxel(((slab + (k)) * (w * h)) + ((row + (j)) * (w)) + (column + (i)))];
-                    ratioOfVisibility += green[volume->getGreenVoxel(((slab + (k)) * (w * h)) + ((row + (j)) * (w))
-                            + (column + (i)))];
-                } // end for
-            } // end for
-        } // end for
-        ratioOfVisibility /= (2 * (width) * (height) * (depth));
-    } else if (typeOfComponents == 5) {
-        for (int k = 0; k < depth; k++) {
-            for (int j = 0; j < height; j++) {
-                for (int i = 0; i < width; i++) {
-                    ratioOfVisibility += red[volume->getRedVoxel(((slab + (k)) * (w * h)) + ((row + (j)) * (w)) + (column + (i)))];
-                    ratioOfVisibility
-                            += blue[volume->getBlueVoxel(((slab + (k)) * (w * h)) + ((row + (j)) * (w)) + (column + (i)))];
-                } // end for
-            } // end for
-        } // end for
-        ratioOfVisibility /= (2 * (width) * (height) * (depth));
-    } else if (typeOfComponents == 4) {
-        for (int k = 0; k < depth; k++) {
-            for (int j = 0; j < height; j++) {
-                for (int i = 0; i < width; i++) {
-                    ratioOfVisibility += red[volume->getRedVoxel(((slab + (k)) * (w * h)) + ((row + (j)) * (w)) + (column + (i)))];
-                } // end for
-            } // end for
-        } // end for
-        ratioOfVisibility /= ((width) * (height) * (depth));
-    } else if (typeOfComponents == 3) {
-        for (int k = 0; k < depth; k++) {
-            for (int j = 0; j < height; j++) {
-                for (int i = 0; i < width; i++) {
-                    ratioOfVisibility += green[volume->getGreenVoxel(((slab + (k)) * (w * h)) + ((row + (j)) * (w))
-                            + (column + (i)))];
-                    ratioOfVisibility
-                            += blue[volume->getBlueVoxel(((slab + (k)) * (w * h)) + ((row + (j)) * (w)) + (column + (i)))];
-                } // end for
-            } // end for
-        } // end for
-        ratioOfVisibility /= (2 * (width) * (height) * (depth));
-    } else if (typeOfComponents == 2) {
-        for (int k = 0; k < depth; k++) {
-            for (int j = 0; j < height; j++) {
-                for (int i = 0; i < width; i++) {
-                    ratioOfVisibility += green[volume->getGreenVoxel(((slab + (k)) * (w * h)) + ((row + (j)) * (w))
-                            + (column + (i)))];
-                } // end for
-            } // end for
-        } // end for
-        ratioOfVisibility /= ((width) * (height) * (depth));
-    } else if (typeOfComponents == 1) {
-        for (int k = 0; k < depth; k++) {
-            for (int j = 0; j < height; j++) {
-                for (int i = 0; i < width; i++) {
-                    ratioOfVisibility
-                            += blue[volume->getBlueVoxel(((slab + (k)) * (w * h)) + ((row + (j)) * (w)) + (column + (i)))];
-                } // end for
-            } // end for
-        } // end for
-        ratioOfVisibility /= ((width) * (height) * (depth));
-    }
+    float transparent = 0.0f;
+    volume->calculateComponentVisibility(column, row, slab, width, height, depth, red, green, blue, ratioOfVisibility,
+            transparent);
+    ratioOfVisibility /= (NUMBER_OF_CHANNELS(volume->getTypeOfComponents()) * (width) * (height) * (depth));
 } // end calculateRatioOfVisibility()
 
 /*
@@ -545,15 +446,77 @@ float OcNode::calculateSampleDistance(const Matrix4x4 * modelviewInverse, float
 } // end calculateSampleDistance()
 
 /*
- * createChildren
+ * createChildren - Set up the eight children from the pool, without their subtrees.
  */
 void OcNode::createChildren(void) {
-    child = new OcNode[8];
+    leaf = false;
+    displayed = false;
+    child = pool->createChildren();
     for (int i = 0; i < 8; i++) {
         child[i].setChild(level + 1, i, this, brick, maximumLevel);
     } // end for
 } // end createChildren()
 
+/*
+ * createSubtree - Subdivide down to the leaves and gather the value range bottom up.
+ *
+ * Touches nothing outside the subtree but the pool, so subtrees with pools of their own
+ * can be built concurrently.
+ */
+void OcNode::createSubtree(void) {
+    if (isSubdivisible()) {
+        createChildren();
+        for (int i = 0; i < 8; i++) {
+            child[i].createSubtree();
+        } // end for
+    } else {
+        leaf = true;
+        displayed = true;
+    }
+    calculateRange();
+} // end createSubtree()
+
+/*
+ * drawAtlasTraversal - Draw the packed atlas blocks in view back to front; the atlas texture must be bound.
+ *
+ * The atlas holds full resolution blocks only, so the traversal skips the invisible and culled
+ * nodes like drawVolumeTraversal() but always descends to the blocks. The nodes selected for
+ * display by the ratio of visibility threshold, the priority queue or the rendering cost are
+ * ignored; the application rejects the tests and the frame governor in atlas mode.
+ *
+ * parameter cFrustum - const CFrustum &
+ * parameter point - float *
+ * parameter shaderObject - ShaderObject*
+ * parameter minimumIndex - int
+ * parameter maximumIndex - int
+ * parameter modelviewInverse - const Matrix4x4 *
+ * parameter testChildren - bool (false once an ancestor is fully inside the frustum)
+ */
+void OcNode::drawAtlasTraversal(const CFrustum & cFrustum, float * point, ShaderObject* shaderObject, int minimumIndex,
+        int maximumIndex, const Matrix4x4 * modelviewInverse, bool testChildren) {
+    if (ratioOfVisibility == 0.0f)
+        return;
+    if (testChildren) {
+        switch (cFrustum.sphereLocation(volumeSphere->getCenter(), volumeSphere->getRadius())) {
+        case FULL_OUTSIDE:
+            return;
+        case FULL_INSIDE:
+            testChildren = false;
+            break;
+        } // end switch
+    } // end if
+    if (isAtlasBlock()) {
+        if (atlasBox != NULL)
+            drawVolume(shaderObject, atlasBox, minimumIndex, maximumIndex, modelviewInverse);
+    } else {
+        const int* order = getBackToFrontOrder(getOctant(point));
+        for (int i = 0; i < 8; i++) {
+            child[order[i]].drawAtlasTraversal(cFrustum, point, shaderObject, minimumIndex, maximumIndex, modelviewInverse,
+                    testChildren);
+        } // end for
+    } // end if
+} // end drawAtlasTraversal()
+
 /*
  * drawGrid
  */
@@ -703,6 +666,7 @@ void OcNode::drawPreIntegratedViewAlignedSlices(const Vector4 & slicePlaneNormal
     float sampleDistance = calculateSampleDistance(modelviewInverse, _minimum, _maximum);
     Vector4* sliceDelta = Vector4::multiply(slicePlaneNormal, delta);
     int samples = (int) ((sampleDistance) / delta);
+    Benchmark::countOcNode(samples + 1);
     // Calculate edge intersections between the plane and the boxes
     Vector4* verts = new Vector4[6]; // for edge intersections
     Vector4* sFront = new Vector4[6]; // for texture intersections
@@ -765,6 +729,7 @@ void OcNode::drawShadowedViewAlignedSlices(const Vector4 & slicePlaneNormal, int
     float sampleDistance = calculateSampleDistance(modelviewInverse, _minimum, _maximum);
     Vector4* sliceDelta = Vector4::multiply(slicePlaneNormal, delta);
     int samples = (int) ((sampleDistance) / delta);
+    Benchmark::countOcNode(samples + 1);
     Vector4* verts = new Vector4[6]; // for edge intersections
     Vector4* sFront = new Vector4[6]; // for texture intersections
     Vector4* sBack = new Vector4[6]; // for texture intersections
@@ -821,6 +786,7 @@ void OcNode::drawViewAlignedSlices(const Vector4 & slicePlaneNormal, int minimum
     float sampleDistance = calculateSampleDistance(modelviewInverse, _minimum, _maximum);
     Vector4* sliceDelta = Vector4::multiply(slicePlaneNormal, delta);
     int samples = (int) ((sampleDistance) / delta);
+    Benchmark::countOcNode(samples + 1);
     // Calculate edge intersections between the plane and the boxes
     Vector4* verts = new Vector4[6]; // for edge intersections
     Vector4* tverts = new Vector4[6]; // for texture intersections
@@ -864,6 +830,7 @@ void OcNode::drawViewAlignedSlicesGPU(int minimumIndex, int maximumIndex, const
     float _maximum = getMaximum(volumeBox, maximumIndex);
     float sampleDistance = calculateSampleDistance(modelviewInverse, _minimum, _maximum);
     int samples = (int) ((sampleDistance) / delta);
+    Benchmark::countOcNode(samples + 1);
     for (int sample = 0; sample <= samples; sample++) {
         glBegin(GL_POLYGON);
         glVertex2i(0, sample);
@@ -898,6 +865,20 @@ void OcNode::drawVolume(int minimumIndex, int maximumIndex, const Vector4 & slic
  * parameter modelviewInverse - const Matrix4x4 *
  */
 void OcNode::drawVolume(ShaderObject* shaderObject, int minimumIndex, int maximumIndex, const Matrix4x4 * modelviewInverse) {
+    drawVolume(shaderObject, textureBox, minimumIndex, maximumIndex, modelviewInverse);
+} // end drawVolume()
+
+/*
+ * drawVolume
+ *
+ * parameter shaderObject - ShaderObject*
+ * parameter _textureBox - BoundingBox* (texture coordinates of the node in the bound texture)
+ * parameter minimumIndex - int
+ * parameter maximumIndex - int
+ * parameter modelviewInverse - const Matrix4x4 *
+ */
+void OcNode::drawVolume(ShaderObject* shaderObject, BoundingBox* _textureBox, int minimumIndex, int maximumIndex,
+        const Matrix4x4 * modelviewInverse) {
     /* GPU Accelerated */
     shaderObject->sendUniform1f("delta", GLfloat(delta));
     float* p;
@@ -909,7 +890,7 @@ void OcNode::drawVolume(ShaderObject* shaderObject, int minimumIndex, int maximu
         vBBox[i * 3 + 1] = GLfloat(p[1]);
         vBBox[i * 3 + 2] = GLfloat(p[2]);
         delete[] p;
-        p = textureBox->getCorner(i);
+        p = _textureBox->getCorner(i);
         tBBox[i * 3 + 0] = GLfloat(p[0]);
         tBBox[i * 3 + 1] = GLfloat(p[1]);
         tBBox[i * 3 + 2] = GLfloat(p[2]);
@@ -941,10 +922,9 @@ void OcNode::drawVolumeTraversal(int _level, const CFrustum & cFrustum, float* p
     if (level == _level) {
         drawVolume(shaderObject, minimumIndex, maximumIndex, modelviewInverse);
     } else {
-        std::vector<ComparableOcNode> ocNodeList(8);
-        sortChildren(point, ocNodeList);
+        const int* order = getBackToFrontOrder(getOctant(point));
         for (int i = 0; i < 8; i++) {
-            child[ocNodeList[i].getWhich()].drawVolumeTraversal(_level, cFrustum, point, shaderObject, minimumIndex, maximumIndex,
+            child[order[i]].drawVolumeTraversal(_level, cFrustum, point, shaderObject, minimumIndex, maximumIndex,
                     modelviewInverse, testChildren);
         } // end for
     } // end if
@@ -994,10 +974,9 @@ void OcNode::drawVolumeTraversal(const CFrustum & cFrustum, float* point, Shader
             if (isLeaf() || (ratioOfVisibility >= ratioOfVisibilityThreshold /* && !testChildren */)) {
                 drawVolume(shaderObject, minimumIndex, maximumIndex, modelviewInverse);
             } else {
-                std::vector<ComparableOcNode> ocNodeList(8);
-                sortChildren(point, ocNodeList);
+                const int* order = getBackToFrontOrder(getOctant(point));
                 for (int i = 0; i < 8; i++) {
-                    child[ocNodeList[i].getWhich()].drawVolumeTraversal(cFrustum, point, shaderObject, minimumIndex, maximumIndex,
+                    child[order[i]].drawVolumeTraversal(cFrustum, point, shaderObject, minimumIndex, maximumIndex,
                             modelviewInverse, testChildren);
                 } // end for
             } // end if
@@ -1005,10 +984,9 @@ void OcNode::drawVolumeTraversal(const CFrustum & cFrustum, float* point, Shader
             if (isLeaf() || displayed) {
                 drawVolume(shaderObject, minimumIndex, maximumIndex, modelviewInverse);
             } else {
-                std::vector<ComparableOcNode> ocNodeList(8);
-                sortChildren(point, ocNodeList);
+                const int* order = getBackToFrontOrder(getOctant(point));
                 for (int i = 0; i < 8; i++) {
-                    child[ocNodeList[i].getWhich()].drawVolumeTraversal(cFrustum, point, shaderObject, minimumIndex, maximumIndex,
+                    child[order[i]].drawVolumeTraversal(cFrustum, point, shaderObject, minimumIndex, maximumIndex,
                             modelviewInverse, testChildren);
                 } // end for
             } // end if
@@ -1016,10 +994,9 @@ void OcNode::drawVolumeTraversal(const CFrustum & cFrustum, float* point, Shader
             if (isLeaf() || (cost < costToRenderChildren)) {
                 drawVolume(shaderObject, minimumIndex, maximumIndex, modelviewInverse);
             } else {
-                std::vector<ComparableOcNode> ocNodeList(8);
-                sortChildren(point, ocNodeList);
+                const int* order = getBackToFrontOrder(getOctant(point));
                 for (int i = 0; i < 8; i++) {
-                    child[ocNodeList[i].getWhich()].drawVolumeTraversal(cFrustum, point, shaderObject, minimumIndex, maximumIndex,
+                    child[order[i]].drawVolumeTraversal(cFrustum, point, shaderObject, minimumIndex, maximumIndex,
                             modelviewInverse, testChildren);
                 } // end for
             } // end if
@@ -1071,10 +1048,9 @@ void OcNode::drawVolumeTraversal(const CFrustum & cFrustum, float * point, int m
             if (isLeaf() || (ratioOfVisibility >= ratioOfVisibilityThreshold /* && !testChildren */)) {
                 drawVolume(minimumIndex, maximumIndex, slicePlaneNormal, modelviewInverse);
             } else {
-                std::vector<ComparableOcNode> ocNodeList(8);
-                sortChildren(point, ocNodeList);
+                const int* order = getBackToFrontOrder(getOctant(point));
                 for (int i = 0; i < 8; i++) {
-                    child[ocNodeList[i].getWhich()].drawVolumeTraversal(cFrustum, point, minimumIndex, maximumIndex,
+                    child[order[i]].drawVolumeTraversal(cFrustum, point, minimumIndex, maximumIndex,
                             slicePlaneNormal, modelviewInverse, testChildren);
                 } // end for
             } // end if
@@ -1082,10 +1058,9 @@ void OcNode::drawVolumeTraversal(const CFrustum & cFrustum, float * point, int m
             if (isLeaf() || displayed) {
                 drawVolume(minimumIndex, maximumIndex, slicePlaneNormal, modelviewInverse);
             } else {
-                std::vector<ComparableOcNode> ocNodeList(8);
-                sortChildren(point, ocNodeList);
+                const int* order = getBackToFrontOrder(getOctant(point));
                 for (int i = 0; i < 8; i++) {
-                    child[ocNodeList[i].getWhich()].drawVolumeTraversal(cFrustum, point, minimumIndex, maximumIndex,
+                    child[order[i]].drawVolumeTraversal(cFrustum, point, minimumIndex, maximumIndex,
                             slicePlaneNormal, modelviewInverse, testChildren);
                 } // end for
             } // end if
@@ -1093,6 +1068,34 @@ void OcNode::drawVolumeTraversal(const CFrustum & cFrustum, float * point, int m
     } // end if
 } // end drawVolumeTraversal()
 
+/*
+ * getAtlasBox
+ *
+ * return - BoundingBox*
+ */
+BoundingBox* OcNode::getAtlasBox(void) {
+    return atlasBox;
+} // end getAtlasBox()
+
+/*
+ * setAtlasBox
+ *
+ * parameter _atlasBox - BoundingBox* (taken over by the node)
+ */
+void OcNode::setAtlasBox(BoundingBox* _atlasBox) {
+    delete atlasBox;
+    atlasBox = _atlasBox;
+} // end setAtlasBox()
+
+/*
+ * isAtlasBlock - A node is packed into the atlas as a whole if it is a leaf or its children are smaller than an atlas block.
+ *
+ * return - bool
+ */
+bool OcNode::isAtlasBlock(void) {
+    return isLeaf() || width / 2 < ATLAS_BLOCK_SIZE || height / 2 < ATLAS_BLOCK_SIZE || depth / 2 < ATLAS_BLOCK_SIZE;
+} // end isAtlasBlock()
+
 /*
  * setCenter
  */
@@ -1126,6 +1129,7 @@ void OcNode::setChild(int _level, int _which, OcNode* _parent, Brick* _brick, in
     parent = _parent;
     brick = _brick;
     maximumLevel = _maximumLevel;
+    pool = parent->pool;
     volume = brick->getVolume();
     ratioOfVisibilityThreshold = volume->getRatioOfVisibilityThreshold();
     sliceFactor = volume->getSliceFactor();
@@ -1139,15 +1143,8 @@ void OcNode::setChild(int _level, int _which, OcNode* _parent, Brick* _brick, in
     setLocations();
     setCenter();
     delta = parent->getDelta();
-    if ((width / 2 >= volume->getLeafSize() && height / 2 >= volume->getLeafSize() && depth / 2 >= volume->getLeafSize()) && (width
-            / 2 >= 4 && height / 2 >= 4 && depth / 2 >= 4)) {
-        leaf = false;
-        displayed = false;
-        createChildren();
-    } else {
-        leaf = true;
-        displayed = true;
-    }
+    leaf = true;
+    displayed = true;
     if (level < 3)
         renderingCost = 1.0f / pow(2.0, (3.0 - double(level)));
     else
@@ -1423,6 +1420,15 @@ void OcNode::setParent(OcNode* _parent) {
     parent = _parent;
 } // end setParent()
 
+/*
+ * setPool - Pool the subtree below this node is built from.
+ *
+ * parameter _pool - OcNodePool*
+ */
+void OcNode::setPool(OcNodePool* _pool) {
+    pool = _pool;
+} // end setPool()
+
 /*
  * getPercentageOfEmptyVolume
  *
@@ -1494,6 +1500,16 @@ void OcNode::setSlab(void) {
     slab += parent->getSlab();
 } // end setSlab()
 
+/*
+ * isSubdivisible - Whether the children would still be at least the leaf size, and 4 voxels, on every side.
+ *
+ * return - bool
+ */
+bool OcNode::isSubdivisible(void) {
+    return (width / 2 >= volume->getLeafSize() && height / 2 >= volume->getLeafSize() && depth / 2 >= volume->getLeafSize())
+            && (width / 2 >= 4 && height / 2 >= 4 && depth / 2 >= 4);
+} // end isSubdivisible()
+
 /*
  * getTextureBox
  *
@@ -1543,11 +1559,30 @@ void OcNode::setTextureBox(void) {
             p1 = parent->textureBox->getCorner(7);
             break;
     } // end switch
-    textureBox = new BoundingBox(p0[0], p0[1], p0[2], p1[0], p1[1], p1[2]);
+    textureBox = pool->createBoundingBox(p0[0], p0[1], p0[2], p1[0], p1[1], p1[2]);
     delete[] p0;
     delete[] p1;
 } // end setTextureBox()
 
+/*
+ * getValueMask
+ *
+ * return - unsigned int
+ */
+unsigned int OcNode::getValueMask(void) {
+    return valueMask;
+} // end getValueMask()
+
+/*
+ * isVisible - Whether the transfer function gives any value of the node a non zero alpha.
+ *
+ * parameter visibleValues - const VisibleValues &
+ * return - bool
+ */
+bool OcNode::isVisible(const VisibleValues & visibleValues) {
+    return visibleValues.isVisible(minimum, maximum, valueMask);
+} // end isVisible()
+
 /*
  * setVolume
  *
@@ -1615,7 +1650,7 @@ void OcNode::setVolumeBox(void) {
             p1 = parent->volumeBox->getCorner(7);
             break;
     } // end switch
-    volumeBox = new BoundingBox(p0[0], p0[1], p0[2], p1[0], p1[1], p1[2]);
+    volumeBox = pool->createBoundingBox(p0[0], p0[1], p0[2], p1[0], p1[1], p1[2]);
     delete[] p0;
     delete[] p1;
 } // end setVolumeBox()
@@ -1634,7 +1669,7 @@ BoundingSphere* OcNode::getVolumeSphere(void) {
  */
 void OcNode::setVolumeSphere(void) {
     float _radius = volumeBox->getRadius();
-    volumeSphere = new BoundingSphere(x, y, z, _radius);
+    volumeSphere = pool->createBoundingSphere(x, y, z, _radius);
 } // end setVolumeSphere()
 
 /*
@@ -1755,11 +1790,21 @@ void OcNode::maximumPriorityQueueTestTraversal(bool _maximumPriorityQueueTest) {
  * percentageOfEmptyVolumeTraversal
  *
  * parameter alpha - float*
- */
-void OcNode::percentageOfEmptyVolumeTraversal(float* alpha) {
+ * parameter minimumChanged - int
+ * parameter maximumChanged - int
+ * parameter visibleValues - const VisibleValues &
+ */
+void OcNode::percentageOfEmptyVolumeTraversal(float* alpha, int minimumChanged, int maximumChanged,
+        const VisibleValues & visibleValues) {
+    if (maximum < minimumChanged || minimum > maximumChanged)
+        return; // no voxel of the node maps through a changed entry, so the last result still holds
+    if (!isVisible(visibleValues)) {
+        transparentTraversal();
+        return;
+    } // end if
     if (!isLeaf()) {
         for (int i = 0; i < 8; i++) {
-            child[i].percentageOfEmptyVolumeTraversal(alpha);
+            child[i].percentageOfEmptyVolumeTraversal(alpha, minimumChanged, maximumChanged, visibleValues);
         } // end for
     } else { // a Leaf
         calculatePercentageOfEmptyVolume(alpha);
@@ -1778,11 +1823,16 @@ void OcNode::percentageOfEmptyVolumeTraversal(float* alpha) {
  * percentageOfEmptyVolumeTraversal2_5D
  *
  * parameter alpha - float*
+ * parameter visibleValues - const VisibleValues &
  */
-void OcNode::percentageOfEmptyVolumeTraversal2_5D(float* alpha) {
+void OcNode::percentageOfEmptyVolumeTraversal2_5D(float* alpha, const VisibleValues & visibleValues) {
+    if (!isVisible(visibleValues)) {
+        transparentTraversal();
+        return;
+    } // end if
     if (!isLeaf()) {
         for (int i = 0; i < 8; i++) {
-            child[i].percentageOfEmptyVolumeTraversal2_5D(alpha);
+            child[i].percentageOfEmptyVolumeTraversal2_5D(alpha, visibleValues);
         } // end for
     } else { // a Leaf
         calculatePercentageOfEmptyVolume2_5D(alpha);
@@ -1826,11 +1876,21 @@ void OcNode::percentageOfEmptyVolumeTraversal(float* red, float* green, float* b
  * ratioOfVisibilityTraversal
  *
  * parameter alpha - float*
- */
-void OcNode::ratioOfVisibilityTraversal(float* alpha) {
+ * parameter minimumChanged - int
+ * parameter maximumChanged - int
+ * parameter visibleValues - const VisibleValues &
+ */
+void OcNode::ratioOfVisibilityTraversal(float* alpha, int minimumChanged, int maximumChanged,
+        const VisibleValues & visibleValues) {
+    if (maximum < minimumChanged || minimum > maximumChanged)
+        return; // no voxel of the node maps through a changed entry, so the last result still holds
+    if (!isVisible(visibleValues)) {
+        transparentTraversal();
+        return;
+    } // end if
     if (!isLeaf()) {
         for (int i = 0; i < 8; i++) {
-            child[i].ratioOfVisibilityTraversal(alpha);
+            child[i].ratioOfVisibilityTraversal(alpha, minimumChanged, maximumChanged, visibleValues);
         } // end for
     } else { // a Leaf
         calculateRatioOfVisibility(alpha);
@@ -1848,11 +1908,16 @@ void OcNode::ratioOfVisibilityTraversal(float* alpha) {
  * ratioOfVisibilityTraversal2_5D
  *
  * parameter alpha - float*
+ * parameter visibleValues - const VisibleValues &
  */
-void OcNode::ratioOfVisibilityTraversal2_5D(float* alpha) {
+void OcNode::ratioOfVisibilityTraversal2_5D(float* alpha, const VisibleValues & visibleValues) {
+    if (!isVisible(visibleValues)) {
+        transparentTraversal();
+        return;
+    } // end if
     if (!isLeaf()) {
         for (int i = 0; i < 8; i++) {
-            child[i].ratioOfVisibilityTraversal2_5D(alpha);
+            child[i].ratioOfVisibilityTraversal2_5D(alpha, visibleValues);
         } // end for
     } else { // a Leaf
         calculateRatioOfVisibility2_5D(alpha);
@@ -1950,11 +2015,21 @@ void OcNode::renderingCostFunctionTestTraversal(bool _renderingCostFunctionTest)
  * rendereringCostFuctionTraversal
  *
  * parameter alpha - float*
- */
-void OcNode::rendereringCostFuctionTraversal(float* alpha) {
+ * parameter minimumChanged - int
+ * parameter maximumChanged - int
+ * parameter visibleValues - const VisibleValues &
+ */
+void OcNode::rendereringCostFuctionTraversal(float* alpha, int minimumChanged, int maximumChanged,
+        const VisibleValues & visibleValues) {
+    if (maximum < minimumChanged || minimum > maximumChanged)
+        return; // no voxel of the node maps through a changed entry, so the last result still holds
+    if (!isVisible(visibleValues)) {
+        transparentTraversal();
+        return;
+    } // end if
     if (!isLeaf()) {
         for (int i = 0; i < 8; i++) {
-            child[i].rendereringCostFuctionTraversal(alpha);
+            child[i].rendereringCostFuctionTraversal(alpha, minimumChanged, maximumChanged, visibleValues);
         } // end for
     } else { // a Leaf
         calculateEmptiness(alpha);
@@ -2034,11 +2109,16 @@ void OcNode::rendereringCostFuctionTraversal(float* red, float* green, float* bl
  * rendereringCostFuctionTraversal2_5D
  *
  * parameter alpha - float *
+ * parameter visibleValues - const VisibleValues &
  */
-void OcNode::rendereringCostFuctionTraversal2_5D(float* alpha) {
+void OcNode::rendereringCostFuctionTraversal2_5D(float* alpha, const VisibleValues & visibleValues) {
+    if (!isVisible(visibleValues)) {
+        transparentTraversal();
+        return;
+    } // end if
     if (!isLeaf()) {
         for (int i = 0; i < 8; i++) {
-            child[i].rendereringCostFuctionTraversal2_5D(alpha);
+            child[i].rendereringCostFuctionTraversal2_5D(alpha, visibleValues);
         } // end for
     } else { // a Leaf
         calculateEmptiness2_5D(alpha);
@@ -2090,36 +2170,23 @@ void OcNode::sliceFactorTraversal(float _sliceFactor) {
 } // end sliceFactorTraversal()
 
 /*
- * sortChildren
+ * getOctant - The octant of point relative to the split point of the node, as in OctantOrder.h.
  *
- * parameter point - float *
- * parameter ocNodeList - std::vector<ComparableOcNode> &
- */
-void OcNode::sortChildren(float * point, std::vector<ComparableOcNode> & ocNodeList) {
-    // Calculate minimum distance from head position to ocNodes feature
-    ComparableOcNode comparableOcNode;
-    comparableOcNode.maximum(); // set static variable greater to perform a maximum sort
-    int i;
-    for (i = 0; i < 8; i++) {
-        ocNodeList[i] = ComparableOcNode(i, child[i].getVolumeBox()->getMinimumDistance(point));
-    }
-    std::sort(ocNodeList.begin(), ocNodeList.end());
-    // Handle ties in smallest keys (drawn last)
-    i = 2;
-    if (8 > 1) {
-        while (i <= 8 & ocNodeList[8 - i].getValue() == ocNodeList[7].getValue()) {
-            if (child[ocNodeList[8 - i].getWhich()].getVolumeBox()->collision(point)) { // if head position inside bounding box
-                float distance = ocNodeList[7].getValue();
-                int which = ocNodeList[7].getWhich();
-                ocNodeList[7].setValue(ocNodeList[8 - i].getValue());
-                ocNodeList[7].setWhich(ocNodeList[8 - i].getWhich());
-                ocNodeList[8 - i].setValue(distance);
-                ocNodeList[8 - i].setWhich(which);
-            }
-            i++;
-        }
-    }
-} // end sortChildren()
+ * parameter point - const float *
+ * return - int
+ */
+int OcNode::getOctant(const float * point) {
+    // The first child spans from the first corner of the node to its split point
+    BoundingBox* box = child[0].volumeBox;
+    int octant = 0;
+    if ((point[0] - box->getX(7)) * (box->getX(7) - box->getX(0)) > 0.0f)
+        octant |= OCTANT_X;
+    if ((point[1] - box->getY(7)) * (box->getY(7) - box->getY(0)) > 0.0f)
+        octant |= OCTANT_Y;
+    if ((point[2] - box->getZ(7)) * (box->getZ(7) - box->getZ(0)) > 0.0f)
+        octant |= OCTANT_Z;
+    return octant;
+} // end getOctant()
 
 /*
  * toString
@@ -2141,6 +2208,29 @@ std::string OcNode::toString(void) {
      */
 } // end toString()
 
+/*
+ * transparentTraversal - Results of a subtree that holds no visible value, without looking at its voxels.
+ */
+void OcNode::transparentTraversal(void) {
+    empty = true;
+    ratioOfVisibility = 0.0f;
+    percentageOfEmptyVolume = (float(width) * float(height) * float(depth)) / (float(volume->getWidth())
+            * float(volume->getHeight()) * float(volume->getDepth()));
+    costRender = 0.0f;
+    if (isLeaf()) {
+        emptyChildren = 0;
+        costToRenderChildren = 8.0f * costStructure + renderingCost * 8.0f;
+    } else {
+        emptyChildren = 255;
+        costToRenderChildren = 0.0f;
+        for (int i = 0; i < 8; i++) {
+            child[i].transparentTraversal();
+            costToRenderChildren += child[i].getLevel() * child[i].getCostStructure();
+        } // end for
+    } // end if
+    cost = std::min(level * costStructure + costRender, costToRenderChildren);
+} // end transparentTraversal()
+
 /*
  * viewAlignedVertex - Find the vertex of the intersection polygon.
  *
@@ -42,19 +42,21 @@ class BoundingSphere;
 class Brick;
 class BoundingBox;
 class CFrustum;
-class ComparableOcNode;
 class Matrix4x4;
+class OcNodePool;
 class ShaderObject;
 class Vector4;
+class VisibleValues;
 class Volume;
 // end Forward Declarations
 
 class OcNode {
 public:
     explicit OcNode(void);
-    OcNode(Brick* _brick);
+    OcNode(Brick* _brick, OcNodePool* _pool);
     ~OcNode(void);
-    void adjustTextureCoordinatesTraversal(float dx, float dy, float dz);
+    void adjustTextureCoordinatesTraversal(float dx, float dy, float dz, float sx, float sy, float sz);
+    void atlasBlocksTraversal(std::vector<OcNode*> & blocks);
     void calculateDelta(float _maximum, float _minimum);
     void calculateEmptiness(float* alpha);
     void calculateEmptiness(float* red, float* green, float* blue);
@@ -62,13 +64,17 @@ public:
     void calculatePercentageOfEmptyVolume(float* alpha);
     void calculatePercentageOfEmptyVolume(float* red, float* green, float* blue);
     void calculatePercentageOfEmptyVolume2_5D(float* alpha);
+    void calculateRange(void);
     void calculateRatioOfVisibility(float* alpha);
     void calculateRatioOfVisibility(float* red, float* green, float* blue);
     void calculateRatioOfVisibility2_5D(float* alpha);
     float calculateSampleDistance(const Matrix4x4 * modelviewInverse, float _minimum, float _maximum);
     void createChildren(void);
+    void createSubtree(void);
     void createChildren(int _minimumOcNodeSize);
     void createChildren(int _maximumTextureSize, int _minimumOcNodeSize);
+    void drawAtlasTraversal(const CFrustum & cFrustum, float * point, ShaderObject* shaderObject, int minimumIndex,
+            int maximumIndex, const Matrix4x4 * modelviewInverse, bool testChildren);
     void drawGrid(void);
     void drawGridTraversal(int _level, const CFrustum & cFrustum, bool testChildren);
     void drawGridTraversal(const CFrustum & cFrustum, bool testChildren);
@@ -81,12 +87,17 @@ public:
     void drawViewAlignedSlicesGPU(int minimumIndex, int maximumIndex, const Matrix4x4 * modelviewInverse);
     void drawVolume(int minimumIndex, int maximumIndex, const Vector4 & slicePlaneNormal, const Matrix4x4 * modelviewInverse);
     void drawVolume(ShaderObject* shaderObject, int minimumIndex, int maximumIndex, const Matrix4x4 * modelviewInverse);
+    void drawVolume(ShaderObject* shaderObject, BoundingBox* _textureBox, int minimumIndex, int maximumIndex,
+            const Matrix4x4 * modelviewInverse);
     void drawVolumeTraversal(int _level, const CFrustum & cFrustum, float* point, ShaderObject* shaderObject, int minimumIndex,
             int maximumIndex, const Matrix4x4 * modelviewInverse, bool testChildren);
     void drawVolumeTraversal(const CFrustum & cFrustum, float * point, ShaderObject* shaderObject, int minimumIndex,
             int maximumIndex, const Matrix4x4 * modelviewInverse, bool testChildren);
     void drawVolumeTraversal(const CFrustum & cFrustum, float * point, int minimumIndex, int maximumIndex,
             const Vector4 & slicePlaneNormal, const Matrix4x4 * modelviewInverse, bool testChildren);
+    BoundingBox* getAtlasBox(void);
+    void setAtlasBox(BoundingBox* _atlasBox);
+    bool isAtlasBlock(void);
     void setCenter(void);
     OcNode* getChildren(void);
     void setChild(int _level, int _which, OcNode* _parent, Brick* _brick, int _maximumLevel);
@@ -121,16 +132,21 @@ public:
     float getMinimum(BoundingBox* boundingBox, int minimumIndex);
     int getMinimum(void);
     void setMinimum(int minimum);
+    int getOctant(const float * point);
     OcNode* getParent(void);
     void setParent(OcNode* parent);
+    void setPool(OcNodePool* _pool);
     float getPercentageOfEmptyVolume(void);
     float getRatioOfVisibility(void);
     int getRow(void);
     void setRow(void);
     int getSlab(void);
     void setSlab(void);
+    bool isSubdivisible(void);
     BoundingBox* getTextureBox(void);
     void setTextureBox(void);
+    unsigned int getValueMask(void);
+    bool isVisible(const VisibleValues & visibleValues);
     Volume* getVolume(void);
     void setVolume(Volume* _volume);
     BoundingBox* getVolumeBox(void);
@@ -148,26 +164,30 @@ public:
     float getZ(void);
     void setZ(float z);
     void maximumPriorityQueueTestTraversal(bool _maximumPriorityQueueTest);
-    void percentageOfEmptyVolumeTraversal(float* alpha);
+    void percentageOfEmptyVolumeTraversal(float* alpha, int minimumChanged, int maximumChanged,
+            const VisibleValues & visibleValues);
     void percentageOfEmptyVolumeTraversal(float* red, float* green, float* blue);
-    void percentageOfEmptyVolumeTraversal2_5D(float* alpha);
-    void ratioOfVisibilityTraversal(float* alpha);
+    void percentageOfEmptyVolumeTraversal2_5D(float* alpha, const VisibleValues & visibleValues);
+    void ratioOfVisibilityTraversal(float* alpha, int minimumChanged, int maximumChanged,
+            const VisibleValues & visibleValues);
     void ratioOfVisibilityTraversal(float* red, float* green, float* blue);
-    void ratioOfVisibilityTraversal2_5D(float* alpha);
+    void ratioOfVisibilityTraversal2_5D(float* alpha, const VisibleValues & visibleValues);
     void ratioOfVisibilityTestTraversal(bool _ratioOfVisibilityTest);
     void ratioOfVisibilityThresholdTraversal(float _ratioOfVisibilityThreshold);
     void renderingCostFunctionTestTraversal(bool _renderingCostFuctionTest);
     void renderingCostTraversal(float _renderingCost);
-    void rendereringCostFuctionTraversal(float* alpha);
+    void rendereringCostFuctionTraversal(float* alpha, int minimumChanged, int maximumChanged,
+            const VisibleValues & visibleValues);
     void rendereringCostFuctionTraversal(float* red, float* green, float* blue);
-    void rendereringCostFuctionTraversal2_5D(float* alpha);
+    void rendereringCostFuctionTraversal2_5D(float* alpha, const VisibleValues & visibleValues);
     void sliceFactorTraversal(float _sliceFactor);
-    void sortChildren(float * point, std::vector<ComparableOcNode> & ocNodeList);
     std::string toString(void);
+    void transparentTraversal(void);
     void viewAlignedVertex(int which, int frontIndex, const Vector4 & sp, const Vector4 & spn, Vector4* tverts, Vector4* verts);
     void viewAlignedVertex(int which, int frontIndex, const Vector4 & spF, const Vector4 & spB, const Vector4 & spn,
             Vector4* sFront, Vector4* sBack, Vector4* verts);
 private:
+    BoundingBox* atlasBox; // slot in the texture atlas, NULL when not packed
     Brick* brick;
     OcNode* child;
     float cost;
@@ -183,12 +203,13 @@ private:
     int height;
     bool leaf;
     int level;
-    int maximum;
+    int maximum; // largest voxel value in the node
     int maximumLevel;
     bool maximumPriorityQueueTest;
-    int minimum;
+    int minimum; // smallest voxel value in the node
     OcNode* parent;
     float percentageOfEmptyVolume;
+    OcNodePool* pool; // storage of the children and boxes, NULL when they are heap allocated
     float ratioOfVisibility;
     bool ratioOfVisibilityTest;
     float ratioOfVisibilityThreshold;
@@ -198,6 +219,7 @@ private:
     int slab;
     float sliceFactor;
     BoundingBox* textureBox;
+    unsigned int valueMask; // value bins the node holds, see ValueMask.h
     Volume* volume;
     BoundingBox* volumeBox;
     BoundingSphere* volumeSphere;
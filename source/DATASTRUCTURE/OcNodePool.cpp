@@ -0,0 +1,114 @@
+/*
+ * OcNodePool.cpp - Methods for OcNodePool class.
+ *
+ * Author: Patrick O'Leary
+ * Created: October 19, 2026
+ * Copyright 2007. All rights reserved.
+ */
+#include <new>
+
+#include <DATASTRUCTURE/BoundingBox.h>
+#include <DATASTRUCTURE/BoundingSphere.h>
+#include <DATASTRUCTURE/OcNode.h>
+#include <DATASTRUCTURE/OcNodePool.h>
+
+/*
+ * OcNodePool - Constructor for OcNodePool class.
+ */
+OcNodePool::OcNodePool(void) :
+    used(OCNODEPOOL_CHUNK_SIZE) {
+} // end OcNodePool()
+
+/*
+ * ~OcNodePool - Destructor for OcNodePool class.
+ *
+ * The boxes keep their corners in the pool as well, so only the nodes need destroying.
+ */
+OcNodePool::~OcNodePool(void) {
+    for (size_t i = 0; i < children.size(); i++) {
+        for (int j = 0; j < 8; j++)
+            children[i][j].~OcNode();
+    } // end for
+    for (size_t i = 0; i < chunks.size(); i++)
+        delete[] chunks[i];
+} // end ~OcNodePool()
+
+/*
+ * allocate - Carve bytes out of the last chunk, starting a new chunk when it is full.
+ *
+ * parameter bytes - size_t
+ * return - void*
+ */
+void* OcNodePool::allocate(size_t bytes) {
+    // Keep every allocation 16 byte aligned
+    bytes = (bytes + 15) & ~size_t(15);
+    if (used + bytes > OCNODEPOOL_CHUNK_SIZE) {
+        chunks.push_back(new char[OCNODEPOOL_CHUNK_SIZE]);
+        used = 0;
+    } // end if
+    void* memory = chunks.back() + used;
+    used += bytes;
+    return memory;
+} // end allocate()
+
+/*
+ * createBoundingBox
+ *
+ * parameter originX - float
+ * parameter originY - float
+ * parameter originZ - float
+ * parameter extentX - float
+ * parameter extentY - float
+ * parameter extentZ - float
+ * return - BoundingBox*
+ */
+BoundingBox* OcNodePool::createBoundingBox(float originX, float originY, float originZ, float extentX, float extentY,
+        float extentZ) {
+    float* data = static_cast<float*> (allocate(24 * sizeof(float)));
+    return new (allocate(sizeof(BoundingBox))) BoundingBox(originX, originY, originZ, extentX, extentY, extentZ, data);
+} // end createBoundingBox()
+
+/*
+ * createBoundingSphere
+ *
+ * parameter x - float
+ * parameter y - float
+ * parameter z - float
+ * parameter _radius - float
+ * return - BoundingSphere*
+ */
+BoundingSphere* OcNodePool::createBoundingSphere(float x, float y, float z, float _radius) {
+    float* center = static_cast<float*> (allocate(3 * sizeof(float)));
+    return new (allocate(sizeof(BoundingSphere))) BoundingSphere(x, y, z, _radius, center);
+} // end createBoundingSphere()
+
+/*
+ * createChildren - Eight default constructed nodes, contiguous like new OcNode[8].
+ *
+ * return - OcNode*
+ */
+OcNode* OcNodePool::createChildren(void) {
+    OcNode* block = static_cast<OcNode*> (allocate(8 * sizeof(OcNode)));
+    for (int i = 0; i < 8; i++)
+        new (block + i) OcNode();
+    children.push_back(block);
+    return block;
+} // end createChildren()
+
+/*
+ * getNumberOfOcNodes
+ *
+ * return - int
+ */
+int OcNodePool::getNumberOfOcNodes(void) const {
+    return 8 * int(children.size());
+} // end getNumberOfOcNodes()
+
+/*
+ * getSize - Bytes reserved by the chunks.
+ *
+ * return - size_t
+ */
+size_t OcNodePool::getSize(void) const {
+    return chunks.size() * OCNODEPOOL_CHUNK_SIZE;
+} // end getSize()
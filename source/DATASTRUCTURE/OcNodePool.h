@@ -0,0 +1,43 @@
+/*
+ * OcNodePool.h - Class for the pooled storage of the nodes and boxes of one octree.
+ *
+ * Children are carved eight at a time, and their volume, texture and sphere bounds next to
+ * them, out of large chunks instead of one heap allocation each. Nothing handed out is freed
+ * on its own; deleting the pool destroys every node and releases all chunks at once. A pool
+ * is not thread safe, so every concurrently built subtree gets a pool of its own.
+ *
+ * Author: Patrick O'Leary
+ * Created: October 19, 2026
+ * Copyright 2007. All rights reserved.
+ */
+#ifndef OCNODEPOOL_H_
+#define OCNODEPOOL_H_
+
+#include <cstddef>
+#include <vector>
+
+#define OCNODEPOOL_CHUNK_SIZE 262144
+
+// begin Forward Declarations
+class BoundingBox;
+class BoundingSphere;
+class OcNode;
+// end Forward Declarations
+
+class OcNodePool {
+public:
+    OcNodePool(void);
+    ~OcNodePool(void);
+    BoundingBox* createBoundingBox(float originX, float originY, float originZ, float extentX, float extentY, float extentZ);
+    BoundingSphere* createBoundingSphere(float x, float y, float z, float _radius);
+    OcNode* createChildren(void);
+    int getNumberOfOcNodes(void) const;
+    size_t getSize(void) const;
+private:
+    void* allocate(size_t bytes);
+    std::vector<OcNode*> children; // blocks of eight nodes, destroyed with the pool
+    std::vector<char*> chunks;
+    size_t used; // bytes used in the last chunk
+};
+
+#endif /*OCNODEPOOL_H_*/
@@ -20,17 +20,19 @@
 #include <DATASTRUCTURE/Brick.h>
 #include <DATASTRUCTURE/ComparableOcNode.h>
 #include <DATASTRUCTURE/OcNode.h>
+#include <DATASTRUCTURE/OcNodePool.h>
 #include <DATASTRUCTURE/OcTree.h>
 #include <MATH/Matrix4x4.h>
 #include <SHADER/ShaderObject.h>
 
 /*
- * OcTree - Constructor for OcTree.
+ * OcTree - Constructor for OcTree; only the root exists until split() and the subtrees are built.
  *
  * parameter _brick - Brick*
  */
 OcTree::OcTree(Brick* _brick) {
-	root = new OcNode(_brick);
+	pools.push_back(new OcNodePool());
+	root = new OcNode(_brick, pools[0]);
 	showOcNodes = false;
 } // end OcTree()
 
@@ -39,8 +41,58 @@ OcTree::OcTree(Brick* _brick) {
  */
 OcTree::~OcTree(void) {
 	delete root;
+	for (size_t i = 0; i < pools.size(); i++)
+		delete pools[i];
 } // end ~OcTree()
 
+/*
+ * calculateRange - Gather the value range of the root once its subtrees are built.
+ */
+void OcTree::calculateRange(void) {
+	root->calculateRange();
+} // end calculateRange()
+
+/*
+ * createSubtrees - Build the subtrees handed out by split(), possibly of many trees, on a number of threads.
+ *
+ * parameter subtrees - std::vector<OcNode*> &
+ * parameter numberOfThreads - int
+ */
+void OcTree::createSubtrees(std::vector<OcNode*> & subtrees, int numberOfThreads) {
+	if (numberOfThreads > int(subtrees.size()))
+		numberOfThreads = int(subtrees.size());
+	if (numberOfThreads <= 1) {
+		for (size_t i = 0; i < subtrees.size(); i++)
+			subtrees[i]->createSubtree();
+		return;
+	}
+	SubtreeQueue queue;
+	pthread_mutex_init(&queue.mutex, NULL);
+	queue.next = 0;
+	queue.subtrees = &subtrees;
+	pthread_t* threads = new pthread_t[numberOfThreads];
+	for (int t = 0; t < numberOfThreads; t++)
+		pthread_create(&threads[t], NULL, subtreeThread, &queue);
+	for (int t = 0; t < numberOfThreads; t++)
+		pthread_join(threads[t], NULL);
+	delete[] threads;
+	pthread_mutex_destroy(&queue.mutex);
+} // end createSubtrees()
+
+/*
+ * drawAtlasVolume
+ *
+ * parameter cFrustum - const CFrustum &
+ * parameter shaderObject - ShaderObject*
+ * parameter point - float *
+ * parameter minimumIndex - int
+ * parameter maximumIndex - int
+ * parameter modelviewInverse - const Matrix4x4 *
+ */
+void OcTree::drawAtlasVolume(const CFrustum & cFrustum, ShaderObject* shaderObject, float * point, int minimumIndex, int maximumIndex, const Matrix4x4 * modelviewInverse) {
+	root->drawAtlasTraversal(cFrustum, point, shaderObject, minimumIndex, maximumIndex, modelviewInverse, true);
+} // end drawAtlasVolume()
+
 /*
  * drawGrid
  *
@@ -85,9 +137,13 @@ void OcTree::setMaximumPriorityQueueTest(bool _maximumPriorityQueueTest) {
  * setPercentageOfEmptyVolume
  *
  * parameter alpha - float*
+ * parameter minimumChanged - int
+ * parameter maximumChanged - int
+ * parameter visibleValues - const VisibleValues &
  */
-void OcTree::setPercentageOfEmptyVolume(float* alpha) {
-	root->percentageOfEmptyVolumeTraversal(alpha);
+void OcTree::setPercentageOfEmptyVolume(float* alpha, int minimumChanged, int maximumChanged,
+        const VisibleValues & visibleValues) {
+	root->percentageOfEmptyVolumeTraversal(alpha, minimumChanged, maximumChanged, visibleValues);
 } // end setPercentageOfEmptyVolume()
 
 /*
@@ -105,18 +161,23 @@ void OcTree::setPercentageOfEmptyVolume(float* red, float* green, float* blue) {
  * setPercentageOfEmptyVolume2_5D
  *
  * parameter alpha - float*
+ * parameter visibleValues - const VisibleValues &
  */
-void OcTree::setPercentageOfEmptyVolume2_5D(float* alpha) {
-    root->percentageOfEmptyVolumeTraversal2_5D(alpha);
+void OcTree::setPercentageOfEmptyVolume2_5D(float* alpha, const VisibleValues & visibleValues) {
+    root->percentageOfEmptyVolumeTraversal2_5D(alpha, visibleValues);
 } // end setPercentageOfEmptyVolume2_5D()
 
 /*
  * setRatioOfVisibility
  *
  * parameter alpha - float*
+ * parameter minimumChanged - int
+ * parameter maximumChanged - int
+ * parameter visibleValues - const VisibleValues &
  */
-void OcTree::setRatioOfVisibility(float* alpha) {
-	root->ratioOfVisibilityTraversal(alpha);
+void OcTree::setRatioOfVisibility(float* alpha, int minimumChanged, int maximumChanged,
+        const VisibleValues & visibleValues) {
+	root->ratioOfVisibilityTraversal(alpha, minimumChanged, maximumChanged, visibleValues);
 } // end setRatioOfVisibility()
 
 /*
@@ -134,9 +195,10 @@ void OcTree::setRatioOfVisibility(float* red, float* green, float* blue) {
  * setRatioOfVisibility2_5D
  *
  * parameter alpha - float*
+ * parameter visibleValues - const VisibleValues &
  */
-void OcTree::setRatioOfVisibility2_5D(float* alpha) {
-    root->ratioOfVisibilityTraversal2_5D(alpha);
+void OcTree::setRatioOfVisibility2_5D(float* alpha, const VisibleValues & visibleValues) {
+    root->ratioOfVisibilityTraversal2_5D(alpha, visibleValues);
 } // end setRatioOfVisibility2_5D()
 
 /*
@@ -170,9 +232,13 @@ void OcTree::setRenderingCost(float _renderingCost) {
  * setRenderingCostFunction
  *
  * parameter alpha - float*
+ * parameter minimumChanged - int
+ * parameter maximumChanged - int
+ * parameter visibleValues - const VisibleValues &
  */
-void OcTree::setRenderingCostFunction(float* alpha) {
-	root->rendereringCostFuctionTraversal(alpha);
+void OcTree::setRenderingCostFunction(float* alpha, int minimumChanged, int maximumChanged,
+        const VisibleValues & visibleValues) {
+	root->rendereringCostFuctionTraversal(alpha, minimumChanged, maximumChanged, visibleValues);
 } // end setRenderingCostFunction()
 
 /*
@@ -190,9 +256,10 @@ void OcTree::setRenderingCostFunction(float * red, float * green, float * blue)
  * setRenderingCostFunction2_5D
  *
  * parameter alpha - float*
+ * parameter visibleValues - const VisibleValues &
  */
-void OcTree::setRenderingCostFunction2_5D(float* alpha) {
-    root->rendereringCostFuctionTraversal2_5D(alpha);
+void OcTree::setRenderingCostFunction2_5D(float* alpha, const VisibleValues & visibleValues) {
+    root->rendereringCostFuctionTraversal2_5D(alpha, visibleValues);
 } // end setRenderingCostFunction2_5D()
 
 /*
@@ -204,6 +271,30 @@ void OcTree::setRenderingCostFunctionTest(bool _renderingCostFunctionTest) {
 	root->renderingCostFunctionTestTraversal(_renderingCostFunctionTest);
 } // end setRenderingCostFunctionTest()
 
+/*
+ * getNumberOfOcNodes
+ *
+ * return - int
+ */
+int OcTree::getNumberOfOcNodes(void) const {
+	int numberOfOcNodes = 1;
+	for (size_t i = 0; i < pools.size(); i++)
+		numberOfOcNodes += pools[i]->getNumberOfOcNodes();
+	return numberOfOcNodes;
+} // end getNumberOfOcNodes()
+
+/*
+ * getPoolSize - Bytes reserved by the pools of the tree.
+ *
+ * return - size_t
+ */
+size_t OcTree::getPoolSize(void) const {
+	size_t poolSize = 0;
+	for (size_t i = 0; i < pools.size(); i++)
+		poolSize += pools[i]->getSize();
+	return poolSize;
+} // end getPoolSize()
+
 /*
  * getRootclass Volume;
  *
@@ -240,6 +331,43 @@ void OcTree::setSliceFactor(float _sliceFactor) {
 	root->sliceFactorTraversal(_sliceFactor);
 } // end setSliceFactor()
 
+/*
+ * split - Create the children of the root, each with a pool of its own, and queue them as subtrees.
+ *
+ * A root too small to subdivide stays a leaf and queues nothing.
+ *
+ * parameter subtrees - std::vector<OcNode*> &
+ */
+void OcTree::split(std::vector<OcNode*> & subtrees) {
+	if (!root->isSubdivisible())
+		return;
+	root->createChildren();
+	for (int i = 0; i < 8; i++) {
+		pools.push_back(new OcNodePool());
+		root->getChildren()[i].setPool(pools.back());
+		subtrees.push_back(&root->getChildren()[i]);
+	} // end for
+} // end split()
+
+/*
+ * subtreeThread - Build queued subtrees until the queue is empty.
+ *
+ * parameter parameter - void* (SubtreeQueue*)
+ * return - void*
+ */
+void* OcTree::subtreeThread(void* parameter) {
+	SubtreeQueue* queue = static_cast<SubtreeQueue*> (parameter);
+	while (true) {
+		pthread_mutex_lock(&queue->mutex);
+		size_t next = queue->next++;
+		pthread_mutex_unlock(&queue->mutex);
+		if (next >= queue->subtrees->size())
+			break;
+		(*queue->subtrees)[next]->createSubtree();
+	} // end while
+	return NULL;
+} // end subtreeThread()
+
 /* toString
  *
  * return - std::string
@@ -8,6 +8,8 @@
 #ifndef OCTREE_H_
 #define OCTREE_H_
 
+#include <cstddef>
+#include <pthread.h>
 #include <vector>
 
 // begin Forward Declarations
@@ -16,38 +18,57 @@ class CFrustum;
 class ComparableOcNode;
 class Matrix4x4;
 class OcNode;
+class OcNodePool;
 class ShaderObject;
+class VisibleValues;
 // end Forward Declarations
 
 class OcTree {
 public:
     OcTree(Brick* _brick);
     ~OcTree(void);
+    void calculateRange(void);
+    static void createSubtrees(std::vector<OcNode*> & subtrees, int numberOfThreads);
+    void drawAtlasVolume(const CFrustum & cFrustum, ShaderObject* shaderObject, float * point, int minimumIndex,
+            int maximumIndex, const Matrix4x4 * modelviewInverse);
     void drawGrid(const CFrustum & cFrustum);
     void drawVolume(const CFrustum & cFrustum, ShaderObject* shaderObject, float * point, int minimumIndex, int maximumIndex,
             const Matrix4x4 * modelviewInverse);
     void setMaximumPriorityQueueTest(bool _maximumPriorityQueueTest);
-    void setPercentageOfEmptyVolume(float* alpha);
+    void setPercentageOfEmptyVolume(float* alpha, int minimumChanged, int maximumChanged,
+            const VisibleValues & visibleValues);
     void setPercentageOfEmptyVolume(float* red, float* green, float* blue);
-    void setPercentageOfEmptyVolume2_5D(float* alpha);
-    void setRatioOfVisibility(float* alpha);
+    void setPercentageOfEmptyVolume2_5D(float* alpha, const VisibleValues & visibleValues);
+    void setRatioOfVisibility(float* alpha, int minimumChanged, int maximumChanged,
+            const VisibleValues & visibleValues);
     void setRatioOfVisibility(float* red, float* green, float* blue);
-    void setRatioOfVisibility2_5D(float* alpha);
+    void setRatioOfVisibility2_5D(float* alpha, const VisibleValues & visibleValues);
     void setRatioOfVisibilityTest(bool _ratioOfVisibilityTest);
     void setRatioOfVisibilityThreshold(float _ratioOfVisibilityThreshold);
     void setRenderingCost(float _renderingCost);
-    void setRenderingCostFunction(float* alpha);
+    void setRenderingCostFunction(float* alpha, int minimumChanged, int maximumChanged,
+            const VisibleValues & visibleValues);
     void setRenderingCostFunction(float* red, float* green, float* blue);
-    void setRenderingCostFunction2_5D(float* alpha);
+    void setRenderingCostFunction2_5D(float* alpha, const VisibleValues & visibleValues);
     void setRenderingCostFunctionTest(bool _renderingCostFunctionTest);
+    int getNumberOfOcNodes(void) const;
+    size_t getPoolSize(void) const;
     OcNode* getRoot(void);
     bool getShowOcNodes(void);
     void setShowOcNodes(bool _showOcNodes);
     void setSliceFactor(float _sliceFactor);
+    void split(std::vector<OcNode*> & subtrees);
     std::string toString(void);
 private:
+    struct SubtreeQueue {
+        pthread_mutex_t mutex;
+        size_t next; // next subtree to hand out
+        std::vector<OcNode*>* subtrees;
+    };
+    std::vector<OcNodePool*> pools; // the root's pool, then one per top level subtree
     OcNode* root;
     bool showOcNodes;
+    static void* subtreeThread(void* parameter);
 };
 
 #endif /*OCTREE_H_*/
@@ -0,0 +1,40 @@
+/*
+ * OctantOrder.h - Back to front order of the children of an octree node from the octant of the eye.
+ *
+ * Child which of a node lies on the far side of the split point in x when bit OCTANT_X of
+ * which is set, in z for OCTANT_Z and in y for OCTANT_Y. With the eye in octant e, a child
+ * further from e in more axes can not be in front of a child further in fewer axes, so the
+ * children ordered by decreasing number of bits that differ from e are back to front. The
+ * table holds that order for each of the eight octants.
+ *
+ * Author: Patrick O'Leary
+ * Created: October 19, 2026
+ * Copyright 2007. All rights reserved.
+ */
+#ifndef OCTANTORDER_H_
+#define OCTANTORDER_H_
+
+#define OCTANT_X 1
+#define OCTANT_Z 2
+#define OCTANT_Y 4
+
+/*
+ * getBackToFrontOrder - The children of a node in drawing order for an eye in octant.
+ *
+ * parameter octant - int
+ * return - const int*
+ */
+inline const int* getBackToFrontOrder(int octant) {
+    static const int backToFrontOrder[8][8] = {
+        { 7, 6, 5, 3, 4, 2, 1, 0 },
+        { 6, 7, 4, 2, 5, 3, 0, 1 },
+        { 5, 4, 7, 1, 6, 0, 3, 2 },
+        { 4, 5, 6, 0, 7, 1, 2, 3 },
+        { 3, 2, 1, 7, 0, 6, 5, 4 },
+        { 2, 3, 0, 6, 1, 7, 4, 5 },
+        { 1, 0, 3, 5, 2, 4, 7, 6 },
+        { 0, 1, 2, 4, 3, 5, 6, 7 } };
+    return backToFrontOrder[octant];
+} // end getBackToFrontOrder()
+
+#endif /*OCTANTORDER_H_*/
@@ -0,0 +1,153 @@
+/*
+ * StagingCache.cpp - Methods for StagingCache class.
+ *
+ * Author: Patrick O'Leary
+ * Created: October 19, 2026
+ * Copyright 2007. All rights reserved.
+ */
+#include <DATASTRUCTURE/StagingCache.h>
+
+/*
+ * StagingCache - Constructor for StagingCache class.
+ */
+StagingCache::StagingCache(void) :
+    numberOfFinishedUses(0), numberOfUses(0), peakSize(0), size(0) {
+    pthread_mutex_init(&mutex, NULL);
+    pthread_cond_init(&built, NULL);
+} // end StagingCache()
+
+/*
+ * ~StagingCache - Destructor for StagingCache class.
+ */
+StagingCache::~StagingCache(void) {
+    for (std::map<Key, Entry>::iterator iterator = entries.begin(); iterator != entries.end(); ++iterator)
+        delete[] iterator->second.voxels;
+    pthread_cond_destroy(&built);
+    pthread_mutex_destroy(&mutex);
+} // end ~StagingCache()
+
+/*
+ * addUse - One more GL context uploads from the cache; call it before the context looks anything up.
+ */
+void StagingCache::addUse(void) {
+    pthread_mutex_lock(&mutex);
+    numberOfUses++;
+    pthread_mutex_unlock(&mutex);
+} // end addUse()
+
+/*
+ * finishUse - One context is done with its first uploads; once every use is, free the entries not in use.
+ *
+ * Those are the entries some context never asked for, which release() would keep forever.
+ */
+void StagingCache::finishUse(void) {
+    pthread_mutex_lock(&mutex);
+    if (++numberOfFinishedUses >= numberOfUses) {
+        std::map<Key, Entry>::iterator iterator = entries.begin();
+        while (iterator != entries.end()) {
+            if (iterator->second.built && iterator->second.acquired == 0) {
+                delete[] iterator->second.voxels;
+                size -= iterator->second.bytes;
+                entries.erase(iterator++);
+            } else
+                ++iterator;
+        } // end while
+    } // end if
+    pthread_mutex_unlock(&mutex);
+} // end finishUse()
+
+/*
+ * insert - Publish the staging array the caller of lookup() was asked to build.
+ *
+ * parameter owner - const void*
+ * parameter level - int
+ * parameter voxels - unsigned char* (taken over by the cache)
+ * parameter bytes - size_t (size of voxels)
+ */
+void StagingCache::insert(const void* owner, int level, unsigned char* voxels, size_t bytes) {
+    pthread_mutex_lock(&mutex);
+    Entry & entry = entries[Key(owner, level)];
+    entry.built = true;
+    entry.bytes = bytes;
+    entry.voxels = voxels;
+    size += bytes;
+    if (peakSize < size)
+        peakSize = size;
+    pthread_cond_broadcast(&built);
+    pthread_mutex_unlock(&mutex);
+} // end insert()
+
+/*
+ * lookup - Find the staging array of owner at level, waiting while another context builds it.
+ *
+ * A NULL result means the caller has to build the array and insert() it.
+ *
+ * parameter owner - const void*
+ * parameter level - int
+ * return - const unsigned char*
+ */
+const unsigned char* StagingCache::lookup(const void* owner, int level) {
+    pthread_mutex_lock(&mutex);
+    std::map<Key, Entry>::iterator iterator = entries.find(Key(owner, level));
+    if (iterator == entries.end()) {
+        Entry entry;
+        entry.acquired = 1;
+        entry.built = false;
+        entry.bytes = 0;
+        entry.releases = 0;
+        entry.voxels = NULL;
+        entries[Key(owner, level)] = entry;
+        pthread_mutex_unlock(&mutex);
+        return NULL;
+    } // end if
+    iterator->second.acquired++;
+    while (!iterator->second.built)
+        pthread_cond_wait(&built, &mutex);
+    const unsigned char* voxels = iterator->second.voxels;
+    pthread_mutex_unlock(&mutex);
+    return voxels;
+} // end lookup()
+
+/*
+ * release - One context is done uploading; the last use frees the staging array.
+ *
+ * parameter owner - const void*
+ * parameter level - int
+ */
+void StagingCache::release(const void* owner, int level) {
+    pthread_mutex_lock(&mutex);
+    std::map<Key, Entry>::iterator iterator = entries.find(Key(owner, level));
+    if (iterator != entries.end()) {
+        iterator->second.acquired--;
+        if (++iterator->second.releases >= numberOfUses && iterator->second.acquired == 0) {
+            delete[] iterator->second.voxels;
+            size -= iterator->second.bytes;
+            entries.erase(iterator);
+        } // end if
+    } // end if
+    pthread_mutex_unlock(&mutex);
+} // end release()
+
+/*
+ * getPeakSize - Most bytes of staging held at once.
+ *
+ * return - size_t
+ */
+size_t StagingCache::getPeakSize(void) {
+    pthread_mutex_lock(&mutex);
+    size_t result = peakSize;
+    pthread_mutex_unlock(&mutex);
+    return result;
+} // end getPeakSize()
+
+/*
+ * getSize - Bytes of staging held now.
+ *
+ * return - size_t
+ */
+size_t StagingCache::getSize(void) {
+    pthread_mutex_lock(&mutex);
+    size_t result = size;
+    pthread_mutex_unlock(&mutex);
+    return result;
+} // end getSize()
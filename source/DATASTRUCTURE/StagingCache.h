@@ -0,0 +1,57 @@
+/*
+ * StagingCache.h - Class for sharing the CPU side texture staging of bricks between GL contexts.
+ *
+ * Every GL context uploads the same voxels for a brick. The first context to ask for a
+ * (brick, level) builds the staging array and inserts it; the others wait for it and reuse
+ * it. Every context that will upload adds itself as a use, and an entry is freed after every
+ * use has released it, so the staging is built once per process however many windows and
+ * shared contexts there are. Entries some context never asked for are freed once every use
+ * has finished its first uploads. The cache keeps the bytes it holds and their peak for the
+ * memory accounting. All methods are thread safe.
+ *
+ * Author: Patrick O'Leary
+ * Created: October 19, 2026
+ * Copyright 2007. All rights reserved.
+ */
+#ifndef STAGINGCACHE_H_
+#define STAGINGCACHE_H_
+
+#include <cstddef>
+#include <map>
+#include <pthread.h>
+#include <utility>
+
+#define STAGING_TEXTURE 0
+#define STAGING_DOWN_SAMPLED_TEXTURE 1
+#define STAGING_GRADIENT_TEXTURE 2
+
+class StagingCache {
+public:
+    StagingCache(void);
+    ~StagingCache(void);
+    void addUse(void);
+    void finishUse(void);
+    void insert(const void* owner, int level, unsigned char* voxels, size_t bytes);
+    const unsigned char* lookup(const void* owner, int level);
+    size_t getPeakSize(void);
+    void release(const void* owner, int level);
+    size_t getSize(void);
+private:
+    typedef std::pair<const void*, int> Key;
+    struct Entry {
+        int acquired; // lookups not released yet
+        bool built;
+        size_t bytes;
+        int releases;
+        unsigned char* voxels;
+    };
+    pthread_cond_t built;
+    std::map<Key, Entry> entries;
+    pthread_mutex_t mutex;
+    int numberOfFinishedUses; // GL contexts done with their first uploads
+    int numberOfUses; // GL contexts uploading every entry
+    size_t peakSize; // most bytes held at once
+    size_t size; // bytes of the built entries
+};
+
+#endif /*STAGINGCACHE_H_*/
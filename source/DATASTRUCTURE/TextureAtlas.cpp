@@ -0,0 +1,325 @@
+/*
+ * TextureAtlas.cpp - Methods for TextureAtlas class.
+ *
+ * Author: Patrick O'Leary
+ * Created: October 19, 2026
+ * Copyright 2007. All rights reserved.
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+/* Vrui includes */
+#include <Vrui/Vrui.h>
+
+#include <DATA/Volume.h>
+#include <DATASTRUCTURE/BoundingBox.h>
+#include <DATASTRUCTURE/Brick.h>
+#include <DATASTRUCTURE/OcNode.h>
+#include <DATASTRUCTURE/OcTree.h>
+#include <DATASTRUCTURE/TextureAtlas.h>
+
+TextureAtlas::DataItem::DataItem(void) :
+    texture3DName(0), version(0) {
+}
+
+TextureAtlas::DataItem::~DataItem(void) {
+    if (texture3DName != 0)
+        glDeleteTextures(1, &texture3DName);
+}
+
+/*
+ * TextureAtlas - Constructor for TextureAtlas class.
+ *
+ * parameter _volume - Volume*
+ */
+TextureAtlas::TextureAtlas(Volume* _volume) :
+    brickTextureSize(0), job(NULL), maximum3DTextureSize(2048), packed(NULL), packing(NULL), pending(NULL), running(false),
+            textureNonPowerOfTwo(true), version(0), volume(_volume) {
+    pthread_mutex_init(&mutex, NULL);
+} // end TextureAtlas()
+
+/*
+ * ~TextureAtlas - Destructor for TextureAtlas class.
+ */
+TextureAtlas::~TextureAtlas(void) {
+    if (running)
+        pthread_join(thread, NULL);
+    delete pending;
+    if (packed != NULL) {
+        delete[] packed->voxels;
+        delete packed;
+    }
+    if (packing != NULL) {
+        delete[] packing->voxels;
+        delete packing;
+    }
+    pthread_mutex_destroy(&mutex);
+    volume = NULL;
+} // end ~TextureAtlas()
+
+/*
+ * bind - Bind the atlas to the current texture unit, uploading it first if this context holds an older packing.
+ *
+ * parameter glContextData - GLContextData &
+ * return - bool (false if the atlas did not fit the texture limits)
+ */
+bool TextureAtlas::bind(GLContextData & glContextData) const {
+    DataItem* dataItem = glContextData.retrieveDataItem<DataItem> (this);
+    if (packing != NULL && packing->voxels == NULL && !packing->blocks.empty())
+        return false;
+    if (dataItem->version != version) {
+        if (dataItem->texture3DName != 0)
+            glDeleteTextures(1, &dataItem->texture3DName);
+        dataItem->texture3DName = 0;
+        if (packing != NULL && packing->voxels != NULL) {
+            glGenTextures(1, &dataItem->texture3DName);
+            glBindTexture(GL_TEXTURE_3D, dataItem->texture3DName);
+            glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glTexImage3D(GL_TEXTURE_3D, 0, GL_LUMINANCE8, packing->size[0], packing->size[1], packing->size[2], 0, GL_LUMINANCE,
+                    GL_UNSIGNED_BYTE, packing->voxels);
+        } // end if
+        dataItem->version = version;
+    } // end if
+    glBindTexture(GL_TEXTURE_3D, dataItem->texture3DName);
+    return true;
+} // end bind()
+
+/*
+ * initContext
+ *
+ * parameter glContextData - GLContextData&
+ */
+void TextureAtlas::initContext(GLContextData& glContextData) const {
+    DataItem* dataItem = new DataItem();
+    glContextData.addDataItem(this, dataItem);
+} // end initContext()
+
+/*
+ * pack - Lay the blocks out in a near cubic grid of equal slots and copy them, with borders, into the atlas.
+ *
+ * parameter _packing - Packing*
+ */
+void TextureAtlas::pack(Packing* _packing) const {
+    int numberOfBlocks = _packing->blocks.size();
+    _packing->voxels = NULL;
+    for (int i = 0; i < 3; i++) {
+        _packing->size[i] = 0;
+        _packing->slots[i] = 0;
+        _packing->slotSize[i] = 0;
+    } // end for
+    if (numberOfBlocks == 0)
+        return;
+    for (int b = 0; b < numberOfBlocks; b++) {
+        _packing->slotSize[0] = std::max(_packing->slotSize[0], _packing->blocks[b].width + 2 * ATLAS_BORDER_SIZE);
+        _packing->slotSize[1] = std::max(_packing->slotSize[1], _packing->blocks[b].height + 2 * ATLAS_BORDER_SIZE);
+        _packing->slotSize[2] = std::max(_packing->slotSize[2], _packing->blocks[b].depth + 2 * ATLAS_BORDER_SIZE);
+    } // end for
+    int side = int(ceil(pow(double(numberOfBlocks), 1.0 / 3.0)));
+    _packing->slots[0] = std::max(1, std::min(side, _packing->maximum3DTextureSize / _packing->slotSize[0]));
+    _packing->slots[1] = std::max(1, std::min((numberOfBlocks + _packing->slots[0] - 1) / _packing->slots[0], std::min(side,
+            _packing->maximum3DTextureSize / _packing->slotSize[1])));
+    _packing->slots[2] = (numberOfBlocks + _packing->slots[0] * _packing->slots[1] - 1) / (_packing->slots[0] * _packing->slots[1]);
+    for (int i = 0; i < 3; i++) {
+        _packing->size[i] = _packing->slots[i] * _packing->slotSize[i];
+        if (!_packing->textureNonPowerOfTwo) {
+            int powerOfTwo = 1;
+            while (powerOfTwo < _packing->size[i])
+                powerOfTwo <<= 1;
+            _packing->size[i] = powerOfTwo;
+        } // end if
+        if (_packing->size[i] > _packing->maximum3DTextureSize)
+            return;
+    } // end for
+    size_t atlasSize = size_t(_packing->size[0]) * size_t(_packing->size[1]) * size_t(_packing->size[2]);
+    _packing->voxels = new unsigned char[atlasSize];
+    memset(_packing->voxels, 0, atlasSize);
+    int w = volume->getWidth();
+    int h = volume->getHeight();
+    int d = volume->getDepth();
+    for (int b = 0; b < numberOfBlocks; b++) {
+        const Block & block = _packing->blocks[b];
+        int x = (b % _packing->slots[0]) * _packing->slotSize[0];
+        int y = ((b / _packing->slots[0]) % _packing->slots[1]) * _packing->slotSize[1];
+        int z = (b / (_packing->slots[0] * _packing->slots[1])) * _packing->slotSize[2];
+        for (int k = -ATLAS_BORDER_SIZE; k < block.depth + ATLAS_BORDER_SIZE; k++) {
+            int slab = std::min(std::max(block.slab + k, 0), d - 1);
+            for (int j = -ATLAS_BORDER_SIZE; j < block.height + ATLAS_BORDER_SIZE; j++) {
+                int row = std::min(std::max(block.row + j, 0), h - 1);
+                unsigned char* destination = _packing->voxels + (size_t(z + ATLAS_BORDER_SIZE + k) * _packing->size[1] + (y
+                        + ATLAS_BORDER_SIZE + j)) * _packing->size[0] + x + ATLAS_BORDER_SIZE;
+                for (int i = -ATLAS_BORDER_SIZE; i < block.width + ATLAS_BORDER_SIZE; i++) {
+                    int column = std::min(std::max(block.column + i, 0), w - 1);
+                    destination[i] = volume->getVoxel((slab * (w * h)) + (row * w) + column);
+                } // end for
+            } // end for
+        } // end for
+    } // end for
+} // end pack()
+
+/*
+ * packThread
+ *
+ * parameter parameter - void*
+ * return - void*
+ */
+void* TextureAtlas::packThread(void* parameter) {
+    TextureAtlas* textureAtlas = static_cast<TextureAtlas*> (parameter);
+    textureAtlas->pack(textureAtlas->job);
+    pthread_mutex_lock(&textureAtlas->mutex);
+    textureAtlas->packed = textureAtlas->job;
+    textureAtlas->job = NULL;
+    pthread_mutex_unlock(&textureAtlas->mutex);
+    return NULL;
+} // end packThread()
+
+/*
+ * repack - Collect the occupied blocks of the resident bricks and pack them in the background.
+ *
+ * Call after the octrees were classified. The request keeps the texture limits of the moment,
+ * so the packing thread never reads the atlas. If a packing is still running the newest
+ * request is kept and started once the running one has been published.
+ *
+ * parameter bricks - Brick*
+ * parameter numberOfBricks - int
+ */
+void TextureAtlas::repack(Brick* bricks, int numberOfBricks) {
+    std::vector<OcNode*> ocNodes;
+    brickTextureSize = 0;
+    for (int i = 0; i < numberOfBricks; i++) {
+        if (bricks[i].isResident()) {
+            bricks[i].getOcTree()->getRoot()->atlasBlocksTraversal(ocNodes);
+            brickTextureSize += size_t(bricks[i].getWidth() + 2) * size_t(bricks[i].getHeight() + 2) * size_t(bricks[i].getDepth()
+                    + 2) * 2;
+        } // end if
+    } // end for
+    std::vector<Block> blocks(ocNodes.size());
+    for (unsigned int i = 0; i < ocNodes.size(); i++) {
+        blocks[i].ocNode = ocNodes[i];
+        blocks[i].column = ocNodes[i]->getColumn();
+        blocks[i].row = ocNodes[i]->getRow();
+        blocks[i].slab = ocNodes[i]->getSlab();
+        blocks[i].width = ocNodes[i]->getWidth();
+        blocks[i].height = ocNodes[i]->getHeight();
+        blocks[i].depth = ocNodes[i]->getDepth();
+    } // end for
+    Packing* request = new Packing;
+    request->blocks.swap(blocks);
+    request->voxels = NULL;
+    pthread_mutex_lock(&mutex);
+    request->maximum3DTextureSize = maximum3DTextureSize;
+    request->textureNonPowerOfTwo = textureNonPowerOfTwo;
+    if (running) {
+        delete pending;
+        pending = request;
+        pthread_mutex_unlock(&mutex);
+        return;
+    } // end if
+    running = true;
+    job = request;
+    pthread_mutex_unlock(&mutex);
+    startPacking();
+} // end repack()
+
+/*
+ * getSize - Bytes of the published packing, held on the host and by every GL context that bound it.
+ *
+ * return - size_t
+ */
+size_t TextureAtlas::getSize(void) const {
+    if (packing == NULL || packing->voxels == NULL)
+        return 0;
+    return size_t(packing->size[0]) * size_t(packing->size[1]) * size_t(packing->size[2]);
+} // end getSize()
+
+/*
+ * getTexelSize - The size of one texel of the published packing in texture coordinates.
+ *
+ * parameter texelSize - float* (three floats)
+ */
+void TextureAtlas::getTexelSize(float* texelSize) const {
+    for (int i = 0; i < 3; i++) {
+        if (packing == NULL || packing->size[i] == 0)
+            texelSize[i] = 1.0f;
+        else
+            texelSize[i] = 1.0f / float(packing->size[i]);
+    } // end for
+} // end getTexelSize()
+
+/*
+ * setTextureLimits - The limits of the packings requested from now on.
+ *
+ * parameter _textureNonPowerOfTwo - bool
+ * parameter _maximum3DTextureSize - int
+ */
+void TextureAtlas::setTextureLimits(bool _textureNonPowerOfTwo, int _maximum3DTextureSize) {
+    pthread_mutex_lock(&mutex);
+    textureNonPowerOfTwo = _textureNonPowerOfTwo;
+    maximum3DTextureSize = _maximum3DTextureSize;
+    pthread_mutex_unlock(&mutex);
+} // end setTextureLimits()
+
+/*
+ * startPacking - Pack the job on the packing thread.
+ */
+void TextureAtlas::startPacking(void) {
+    pthread_create(&thread, NULL, packThread, this);
+} // end startPacking()
+
+/*
+ * update - Publish a finished packing: point the packed octree nodes at their slots.
+ *
+ * Must be called from the render thread, between frames.
+ */
+void TextureAtlas::update(void) {
+    pthread_mutex_lock(&mutex);
+    Packing* finished = packed;
+    packed = NULL;
+    pthread_mutex_unlock(&mutex);
+    if (finished == NULL)
+        return;
+    pthread_join(thread, NULL);
+    if (packing != NULL) {
+        for (unsigned int i = 0; i < packing->blocks.size(); i++)
+            packing->blocks[i].ocNode->setAtlasBox(NULL);
+        delete[] packing->voxels;
+        delete packing;
+    } // end if
+    packing = finished;
+    if (packing->voxels != NULL) {
+        float sizeX = float(packing->size[0]);
+        float sizeY = float(packing->size[1]);
+        float sizeZ = float(packing->size[2]);
+        for (unsigned int b = 0; b < packing->blocks.size(); b++) {
+            const Block & block = packing->blocks[b];
+            int x = (b % packing->slots[0]) * packing->slotSize[0] + ATLAS_BORDER_SIZE;
+            int y = ((b / packing->slots[0]) % packing->slots[1]) * packing->slotSize[1] + ATLAS_BORDER_SIZE;
+            int z = (b / (packing->slots[0] * packing->slots[1])) * packing->slotSize[2] + ATLAS_BORDER_SIZE;
+            block.ocNode->setAtlasBox(new BoundingBox(float(x) / sizeX, float(y) / sizeY, float(z) / sizeZ, float(x + block.width)
+                    / sizeX, float(y + block.height) / sizeY, float(z + block.depth) / sizeZ));
+        } // end for
+    } // end if
+    version++;
+    if (Vrui::getNodeIndex() == 0) {
+        if (packing->voxels == NULL && !packing->blocks.empty())
+            std::cout << "TextureAtlas: " << packing->blocks.size() << " blocks exceed the maximum 3D texture size of "
+                    << packing->maximum3DTextureSize << std::endl;
+        else
+            std::cout << "TextureAtlas: " << packing->blocks.size() << " blocks in " << packing->size[0] << "x" << packing->size[1]
+                    << "x" << packing->size[2] << " (" << float(packing->size[0]) * float(packing->size[1]) * float(packing->size[2])
+                    / 1048576.0f << " MB, bricks " << float(brickTextureSize) / 1048576.0f << " MB)" << std::endl;
+    } // end if
+    pthread_mutex_lock(&mutex);
+    running = (pending != NULL);
+    job = pending;
+    pending = NULL;
+    pthread_mutex_unlock(&mutex);
+    if (running)
+        startPacking();
+} // end update()
@@ -0,0 +1,93 @@
+/*
+ * TextureAtlas.h - Class for a sparse 3D texture atlas of the occupied octree blocks of all bricks.
+ *
+ * Every octree node that is at least ATLAS_BLOCK_SIZE voxels on a side but whose children
+ * are not is an atlas block. The blocks with a non zero visibility under the current
+ * classification are copied, with an ATLAS_BORDER_SIZE voxel border, into equally sized slots
+ * of one shared texture. Each packed node keeps its slot in texture coordinates (its atlas
+ * box), which is all the indirection the slicing shaders need. Packing runs on a background
+ * thread; the render thread publishes a finished packing and uploads it once per context.
+ * The blocks are drawn at full resolution only, whatever level of detail is selected.
+ *
+ * Author: Patrick O'Leary
+ * Created: October 19, 2026
+ * Copyright 2007. All rights reserved.
+ */
+#ifndef TEXTUREATLAS_H_
+#define TEXTUREATLAS_H_
+
+#include <cstddef>
+#include <pthread.h>
+#include <vector>
+
+#include <GL/gl.h>
+
+/* Vrui includes */
+#include <GL/GLContextData.h>
+#include <GL/GLObject.h>
+
+#define ATLAS_BLOCK_SIZE 16
+#define ATLAS_BORDER_SIZE 1
+
+// begin Forward Declarations
+class Brick;
+class OcNode;
+class Volume;
+// end Forward Declarations
+
+class TextureAtlas: public GLObject {
+protected:
+    struct DataItem: public GLObject::DataItem {
+        GLuint texture3DName;
+        int version; // version of the packing held by texture3DName
+        DataItem(void);
+        virtual ~DataItem(void);
+    };
+public:
+    friend class DataItem;
+    TextureAtlas(Volume* _volume);
+    ~TextureAtlas(void);
+    bool bind(GLContextData & glContextData) const;
+    void initContext(GLContextData& glContextData) const;
+    void repack(Brick* bricks, int numberOfBricks);
+    size_t getSize(void) const;
+    void getTexelSize(float* texelSize) const;
+    void setTextureLimits(bool _textureNonPowerOfTwo, int _maximum3DTextureSize);
+    void update(void);
+private:
+    struct Block {
+        OcNode* ocNode;
+        int column;
+        int row;
+        int slab;
+        int width;
+        int height;
+        int depth;
+    };
+    struct Packing {
+        std::vector<Block> blocks;
+        int maximum3DTextureSize; // texture limits when the packing was requested
+        int size[3];
+        int slots[3];
+        int slotSize[3];
+        bool textureNonPowerOfTwo;
+        unsigned char* voxels;
+    };
+    size_t brickTextureSize; // bytes the per brick textures of the packed bricks would take
+    Packing* job; // packing being filled by the packing thread
+    int maximum3DTextureSize;
+    pthread_mutex_t mutex;
+    Packing* packed; // finished by the packing thread, not yet published
+    Packing* packing; // published packing the atlas boxes point into
+    Packing* pending; // newest request, started once the running packing has been published
+    bool running;
+    bool textureNonPowerOfTwo;
+    pthread_t thread;
+    int version;
+    Volume* volume;
+    void pack(Packing* _packing) const;
+    static void* packThread(void* parameter);
+    void startPacking(void);
+};
+
+#endif /*TEXTUREATLAS_H_*/
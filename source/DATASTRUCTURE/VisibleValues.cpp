@@ -0,0 +1,68 @@
+/*
+ * VisibleValues.cpp - Methods for VisibleValues class.
+ *
+ * Author: Patrick O'Leary
+ * Created: October 19, 2026
+ * Copyright 2007. All rights reserved.
+ */
+#include <DATA/ValueMask.h>
+#include <DATASTRUCTURE/VisibleValues.h>
+
+/*
+ * VisibleValues - Constructor for VisibleValues class from a 1D transfer function.
+ *
+ * parameter alpha - const float* (256 entries)
+ */
+VisibleValues::VisibleValues(const float* alpha) {
+    bool _visible[256];
+    for (int v = 0; v < 256; v++)
+        _visible[v] = alpha[v] != 0.0f;
+    setVisible(_visible);
+} // end VisibleValues()
+
+/*
+ * VisibleValues - Constructor for VisibleValues class from a 2D transfer function.
+ *
+ * A value is visible when any gradient row gives it a non zero alpha.
+ *
+ * parameter alpha - const float* (rows x 256 entries, the value along a row)
+ * parameter rows - int
+ */
+VisibleValues::VisibleValues(const float* alpha, int rows) {
+    bool _visible[256];
+    for (int v = 0; v < 256; v++) {
+        _visible[v] = false;
+        for (int y = 0; y < rows && !_visible[v]; y++)
+            _visible[v] = alpha[y * 256 + v] != 0.0f;
+    } // end for
+    setVisible(_visible);
+} // end VisibleValues()
+
+/*
+ * isVisible - Whether a region with values in [minimum, maximum] and bins _valueMask can be visible.
+ *
+ * parameter minimum - int
+ * parameter maximum - int
+ * parameter _valueMask - unsigned int
+ * return - bool
+ */
+bool VisibleValues::isVisible(int minimum, int maximum, unsigned int _valueMask) const {
+    return (valueMask & _valueMask) != 0 && visible[maximum + 1] > visible[minimum];
+} // end isVisible()
+
+/*
+ * setVisible
+ *
+ * parameter _visible - const bool* (256 entries)
+ */
+void VisibleValues::setVisible(const bool* _visible) {
+    valueMask = 0;
+    visible[0] = 0;
+    for (int v = 0; v < 256; v++) {
+        visible[v + 1] = visible[v];
+        if (_visible[v]) {
+            visible[v + 1]++;
+            valueMask |= VALUE_BIT(v);
+        } // end if
+    } // end for
+} // end setVisible()
@@ -0,0 +1,26 @@
+/*
+ * VisibleValues.h - Class for the voxel values a transfer function gives a non zero alpha.
+ *
+ * Built once per transfer function change, it answers in constant time whether an octree
+ * node or brick with a given value range and value mask (see ValueMask.h) can show anything
+ * at all, so invisible bricks and subtrees are skipped without looking at their voxels.
+ *
+ * Author: Patrick O'Leary
+ * Created: October 19, 2026
+ * Copyright 2007. All rights reserved.
+ */
+#ifndef VISIBLEVALUES_H_
+#define VISIBLEVALUES_H_
+
+class VisibleValues {
+public:
+    VisibleValues(const float* alpha);
+    VisibleValues(const float* alpha, int rows);
+    bool isVisible(int minimum, int maximum, unsigned int _valueMask) const;
+private:
+    int visible[257]; // visible[v] - number of visible values below v
+    unsigned int valueMask; // value bins holding a visible value
+    void setVisible(const bool* _visible);
+};
+
+#endif /*VISIBLEVALUES_H_*/
@@ -0,0 +1,173 @@
+/*
+ * Benchmark.cpp - Methods for Benchmark class.
+ *
+ * Author: Patrick O'Leary
+ * Created: October 19, 2026
+ * Copyright 2007. All rights reserved.
+ */
+#include <algorithm>
+#include <fstream>
+
+/* Vrui includes */
+#include <Misc/ThrowStdErr.h>
+
+#include <GRAPHIC/Benchmark.h>
+
+bool Benchmark::counting = false;
+int Benchmark::numberOfOcNodes = 0;
+int Benchmark::numberOfSlices = 0;
+
+/*
+ * Benchmark - Constructor for Benchmark class.
+ *
+ * parameter _reportFileName - const char*
+ * parameter _timeStep - double (seconds of path time per frame)
+ */
+Benchmark::Benchmark(const char* _reportFileName, double _timeStep) :
+    reportFileName(_reportFileName), timeStep(_timeStep) {
+} // end Benchmark()
+
+/*
+ * ~Benchmark - Destructor for Benchmark class.
+ */
+Benchmark::~Benchmark(void) {
+    counting = false;
+} // end ~Benchmark()
+
+/*
+ * addClassificationTime
+ *
+ * parameter time - double
+ */
+void Benchmark::addClassificationTime(double time) {
+    current.classificationTime += time;
+} // end addClassificationTime()
+
+/*
+ * addGPUTime
+ *
+ * parameter time - double
+ */
+void Benchmark::addGPUTime(double time) {
+    current.gpuTime += time;
+} // end addGPUTime()
+
+/*
+ * addSubmissionTime
+ *
+ * parameter time - double
+ */
+void Benchmark::addSubmissionTime(double time) {
+    current.submissionTime += time;
+} // end addSubmissionTime()
+
+/*
+ * addTraversalTime
+ *
+ * parameter time - double
+ */
+void Benchmark::addTraversalTime(double time) {
+    current.traversalTime += time;
+} // end addTraversalTime()
+
+/*
+ * countOcNode - Count an octree node drawn with slices slices, while a frame is being recorded.
+ *
+ * parameter slices - int
+ */
+void Benchmark::countOcNode(int slices) {
+    if (counting) {
+        numberOfOcNodes++;
+        numberOfSlices += slices;
+    }
+} // end countOcNode()
+
+/*
+ * endFrame - Keep the record of the frame being recorded, if any.
+ */
+void Benchmark::endFrame(void) {
+    if (!counting)
+        return;
+    current.numberOfOcNodes = numberOfOcNodes;
+    current.numberOfSlices = numberOfSlices;
+    records.push_back(current);
+    counting = false;
+} // end endFrame()
+
+/*
+ * setMemoryAccount - Set the memory held by each subsystem for the report.
+ *
+ * parameter _memoryAccount - const MemoryAccount&
+ */
+void Benchmark::setMemoryAccount(const MemoryAccount& _memoryAccount) {
+    memoryAccount = _memoryAccount;
+} // end setMemoryAccount()
+
+/*
+ * getPathTime - Get the path time of the next frame.
+ *
+ * return - double
+ */
+double Benchmark::getPathTime(void) const {
+    return double(records.size()) * timeStep;
+} // end getPathTime()
+
+/*
+ * startFrame - Start recording the frame at the next path time.
+ */
+void Benchmark::startFrame(void) {
+    current.classificationTime = 0.0;
+    current.gpuTime = 0.0;
+    current.pathTime = getPathTime();
+    current.submissionTime = 0.0;
+    current.traversalTime = 0.0;
+    numberOfOcNodes = 0;
+    numberOfSlices = 0;
+    counting = true;
+} // end startFrame()
+
+/*
+ * writeReport - Write every frame, the mean, minimum and maximum of each measure and the memory as JSON.
+ *     throws std::runtime_error when the report can not be written
+ */
+void Benchmark::writeReport(void) const {
+    std::ofstream report(reportFileName.c_str(), std::ios::out);
+    if (!report.is_open())
+        Misc::throwStdErr("Benchmark::writeReport: Could not open benchmark report file %s", reportFileName.c_str());
+    static const char* names[6] = { "classification", "traversal", "submission", "gpu", "ocNodes", "slices" };
+    double minimum[6];
+    double maximum[6];
+    double sum[6];
+    for (int j = 0; j < 6; j++) {
+        minimum[j] = 0.0;
+        maximum[j] = 0.0;
+        sum[j] = 0.0;
+    } // end for
+    report << "{\n  \"timeUnit\": \"ms\",\n  \"timeStep\": " << timeStep << ",\n  \"numberOfFrames\": " << records.size()
+            << ",\n  \"frames\": [\n";
+    for (size_t i = 0; i < records.size(); i++) {
+        const Record& record = records[i];
+        double values[6] = { record.classificationTime * 1000.0, record.traversalTime * 1000.0, record.submissionTime
+                * 1000.0, record.gpuTime * 1000.0, double(record.numberOfOcNodes), double(record.numberOfSlices) };
+        report << "    { \"frame\": " << i << ", \"pathTime\": " << record.pathTime;
+        for (int j = 0; j < 6; j++) {
+            report << ", \"" << names[j] << "\": " << values[j];
+            minimum[j] = (i == 0) ? values[j] : std::min(minimum[j], values[j]);
+            maximum[j] = (i == 0) ? values[j] : std::max(maximum[j], values[j]);
+            sum[j] += values[j];
+        } // end for
+        report << " }" << ((i + 1 < records.size()) ? "," : "") << "\n";
+    } // end for
+    report << "  ],\n  \"summary\": {\n";
+    for (int j = 0; j < 6; j++) {
+        double mean = (records.empty()) ? 0.0 : sum[j] / double(records.size());
+        report << "    \"" << names[j] << "\": { \"mean\": " << mean << ", \"minimum\": " << minimum[j] << ", \"maximum\": "
+                << maximum[j] << " }" << ((j < 5) ? "," : "") << "\n";
+    } // end for
+    report << "  },\n  \"memory\": {\n    \"unit\": \"bytes\",\n";
+    for (int j = 0; j < NUMBER_OF_MEMORY_SUBSYSTEMS; j++)
+        report << "    \"" << MemoryAccount::getName(j) << "\": " << memoryAccount.getBytes(j) << ",\n";
+    report << "    \"host\": " << memoryAccount.getHostBytes() << ",\n    \"textures\": " << memoryAccount.getTextureBytes()
+            << "\n  }\n}\n";
+    report.close();
+} // end writeReport()
@@ -0,0 +1,59 @@
+/*
+ * Benchmark.h - Class for recording a deterministic fly-through and reporting it as JSON.
+ *
+ * The fly-through steps a saved keyframe path in fixed increments of path time rather than
+ * wall clock time, so every run draws the same views however long a frame takes. For each
+ * frame the benchmark records the time spent classifying the octrees, selecting the octree
+ * nodes to draw (traversal), submitting the draw calls and waiting for the GPU to finish, as
+ * well as the number of octree nodes and slices drawn. Once the path has been flown the
+ * records, their summary and the memory held by each subsystem are written as one JSON report.
+ *
+ * Author: Patrick O'Leary
+ * Created: October 19, 2026
+ * Copyright 2007. All rights reserved.
+ */
+#ifndef BENCHMARK_H_
+#define BENCHMARK_H_
+
+#include <string>
+#include <vector>
+
+#include <UTILITY/MemoryAccount.h>
+
+#define BENCHMARK_TIME_STEP (1.0 / 30.0)
+
+class Benchmark {
+public:
+    Benchmark(const char* _reportFileName, double _timeStep);
+    ~Benchmark(void);
+    void addClassificationTime(double time);
+    void addGPUTime(double time);
+    void addSubmissionTime(double time);
+    void addTraversalTime(double time);
+    static void countOcNode(int slices);
+    void endFrame(void);
+    void setMemoryAccount(const MemoryAccount& _memoryAccount);
+    double getPathTime(void) const;
+    void startFrame(void);
+    void writeReport(void) const;
+private:
+    struct Record {
+        double classificationTime; // seconds
+        double gpuTime;
+        int numberOfOcNodes;
+        int numberOfSlices;
+        double pathTime;
+        double submissionTime;
+        double traversalTime;
+    };
+    static bool counting; // a frame is being recorded
+    Record current;
+    MemoryAccount memoryAccount; // at the end of the fly-through
+    static int numberOfOcNodes; // drawn since the frame started
+    static int numberOfSlices;
+    std::vector<Record> records;
+    std::string reportFileName;
+    double timeStep;
+};
+
+#endif /*BENCHMARK_H_*/
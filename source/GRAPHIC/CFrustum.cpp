@@ -315,7 +315,7 @@ bool CFrustum::sphereInFrustum(float* fPoint, float fRadius) {
  * parameter fRadius - float
  * return - int
  */
-int CFrustum::sphereLocation(float* fPoint, float fRadius) {
+int CFrustum::sphereLocation(float* fPoint, float fRadius) const {
 	int insideCount = 0;
 	float fDistance;
 
@@ -35,7 +35,7 @@ public:
 	bool rightParallelepipedInFrustum(float* fMinimum, float* fMaximum);
 	int rightParallelepipedLocation(float* fMinimum, float* fMaximum);
 	bool sphereInFrustum(float* fPoint, float fRadius);
-	int sphereLocation(float* fPoint, float fRadius);
+	int sphereLocation(float* fPoint, float fRadius) const;
 	void updateFrustum();
 private:
 	float fFrustum[6][4];
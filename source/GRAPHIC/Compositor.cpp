@@ -0,0 +1,300 @@
+/*
+ * Compositor.cpp - Methods for Compositor class.
+ *
+ * Author: Patrick O'Leary
+ * Created: October 19, 2026
+ * Copyright 2007. All rights reserved.
+ */
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+/* Vrui includes */
+#include <Misc/ThrowStdErr.h>
+
+#include <GRAPHIC/Compositor.h>
+#include <UTILITY/StringTokenizer.h>
+
+/*
+ * Compositor - Constructor for Compositor class.
+ *
+ * parameter _nodeIndex - int
+ * parameter _numberOfNodes - int
+ * parameter _hosts - const char* (comma separated, one per node; missing hosts default to localhost)
+ * parameter _port - int (node i listens on _port + i)
+ */
+Compositor::Compositor(int _nodeIndex, int _numberOfNodes, const char* _hosts, int _port) :
+    connected(false), nodeIndex(_nodeIndex), numberOfNodes(_numberOfNodes), port(_port) {
+    if (_hosts != NULL) {
+        StringTokenizer stringTokenizer(_hosts, ",");
+        while (stringTokenizer.hasMoreTokens())
+            hosts.push_back(stringTokenizer.nextToken());
+    }
+    while (int(hosts.size()) < numberOfNodes)
+        hosts.push_back("localhost");
+    sockets = new int[numberOfNodes];
+    for (int i = 0; i < numberOfNodes; i++)
+        sockets[i] = -1;
+} // end Compositor()
+
+/*
+ * ~Compositor - Destructor for Compositor class.
+ */
+Compositor::~Compositor(void) {
+    for (int i = 0; i < numberOfNodes; i++) {
+        if (sockets[i] >= 0)
+            close(sockets[i]);
+    } // end for
+    delete[] sockets;
+} // end ~Compositor()
+
+/*
+ * composite - Blend premultiplied RGBA images back to front; larger keys are farther away.
+ *
+ * parameter images - unsigned char**
+ * parameter keys - const float*
+ * parameter numberOfImages - int
+ * parameter numberOfPixels - int
+ * parameter image - unsigned char*
+ */
+void Compositor::composite(unsigned char** images, const float* keys, int numberOfImages, int numberOfPixels,
+        unsigned char* image) {
+    std::vector<std::pair<float, int> > order;
+    for (int i = 0; i < numberOfImages; i++)
+        order.push_back(std::pair<float, int>(-keys[i], i));
+    std::sort(order.begin(), order.end());
+    memset(image, 0, 4 * numberOfPixels);
+    for (unsigned int i = 0; i < order.size(); i++) {
+        const unsigned char* source = images[order[i].second];
+        for (int p = 0; p < 4 * numberOfPixels; p += 4) {
+            int transparency = 255 - source[p + 3];
+            for (int c = 0; c < 4; c++) {
+                image[p + c] = (unsigned char) (source[p + c] + (image[p + c] * transparency + 127) / 255);
+            } // end for
+        } // end for
+    } // end for
+} // end composite()
+
+/*
+ * connect - Open one TCP connection to every other node; lower node indices listen, higher ones connect.
+ */
+void Compositor::connect(void) throw (std::runtime_error) {
+    int listeningSocket = socket(AF_INET, SOCK_STREAM, 0);
+    int on = 1;
+    setsockopt(listeningSocket, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port + nodeIndex);
+    if (bind(listeningSocket, (struct sockaddr*) &address, sizeof(address)) < 0 || listen(listeningSocket, numberOfNodes) < 0)
+        Misc::throwStdErr("Compositor::connect: Unable to listen on port %d", port + nodeIndex);
+    for (int i = 0; i < nodeIndex; i++) {
+        struct hostent* host = gethostbyname(hosts[i].c_str());
+        if (host == NULL)
+            Misc::throwStdErr("Compositor::connect: Unable to resolve host %s", hosts[i].c_str());
+        struct sockaddr_in peerAddress;
+        memset(&peerAddress, 0, sizeof(peerAddress));
+        peerAddress.sin_family = AF_INET;
+        memcpy(&peerAddress.sin_addr, host->h_addr, host->h_length);
+        peerAddress.sin_port = htons(port + i);
+        int attempts = 0;
+        sockets[i] = socket(AF_INET, SOCK_STREAM, 0);
+        while (::connect(sockets[i], (struct sockaddr*) &peerAddress, sizeof(peerAddress)) < 0) {
+            close(sockets[i]);
+            if (++attempts == 60)
+                Misc::throwStdErr("Compositor::connect: Unable to connect to node %d at %s:%d", i, hosts[i].c_str(), port + i);
+            sleep(1);
+            sockets[i] = socket(AF_INET, SOCK_STREAM, 0);
+        } // end while
+        writeFully(sockets[i], &nodeIndex, sizeof(int));
+    } // end for
+    for (int i = nodeIndex + 1; i < numberOfNodes; i++) {
+        int peerSocket = accept(listeningSocket, NULL, NULL);
+        if (peerSocket < 0)
+            Misc::throwStdErr("Compositor::connect: Unable to accept a connection");
+        int peerIndex;
+        readFully(peerSocket, &peerIndex, sizeof(int));
+        if (peerIndex <= nodeIndex || peerIndex >= numberOfNodes)
+            Misc::throwStdErr("Compositor::connect: Unexpected node index %d", peerIndex);
+        sockets[peerIndex] = peerSocket;
+    } // end for
+    close(listeningSocket);
+    for (int i = 0; i < numberOfNodes; i++) {
+        if (sockets[i] >= 0)
+            setsockopt(sockets[i], IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    } // end for
+    connected = true;
+    std::cout << "Compositor: node " << nodeIndex << " connected to " << numberOfNodes - 1 << " nodes" << std::endl;
+} // end connect()
+
+/*
+ * disconnect - Shut down every connection so a thread blocked on a peer returns and the peers notice.
+ */
+void Compositor::disconnect(void) {
+    connected = false;
+    for (int i = 0; i < numberOfNodes; i++) {
+        if (sockets[i] >= 0)
+            shutdown(sockets[i], SHUT_RDWR);
+    } // end for
+} // end disconnect()
+
+/*
+ * exchangeImages - Send outgoing[i] (this node's partial for node i's view) to node i and receive every
+ * node's partial for this node's view into incoming[i]. The entries for this node are left untouched.
+ *
+ * In round r every node sends to node + r and receives from node - r, so the transfers pair up
+ * without any node waiting on a peer that is itself blocked. A lost peer disconnects the
+ * compositor; the exception is thrown only after the send thread is done with the buffers.
+ *
+ * parameter outgoing - unsigned char**
+ * parameter outgoingSizes - const int*
+ * parameter outgoingKeys - const float*
+ * parameter incoming - unsigned char**
+ * parameter incomingSize - int
+ * parameter incomingKeys - float*
+ */
+void Compositor::exchangeImages(unsigned char** outgoing, const int* outgoingSizes, const float* outgoingKeys,
+        unsigned char** incoming, int incomingSize, float* incomingKeys) {
+    SendTask sendTask;
+    sendTask.compositor = this;
+    sendTask.outgoing = outgoing;
+    sendTask.outgoingSizes = outgoingSizes;
+    sendTask.outgoingKeys = outgoingKeys;
+    pthread_t thread;
+    pthread_create(&thread, NULL, sendThread, &sendTask);
+    try {
+        for (int round = 1; round < numberOfNodes; round++) {
+            int source = (nodeIndex - round + numberOfNodes) % numberOfNodes;
+            readFully(sockets[source], &incomingKeys[source], sizeof(float));
+            readFully(sockets[source], incoming[source], incomingSize);
+        } // end for
+    } catch (std::runtime_error e) {
+        // The send thread may still be blocked writing from sendTask and outgoing
+        disconnect();
+        pthread_join(thread, NULL);
+        throw;
+    }
+    pthread_join(thread, NULL);
+    if (!sendTask.error.empty()) {
+        disconnect();
+        Misc::throwStdErr("%s", sendTask.error.c_str());
+    }
+} // end exchangeImages()
+
+/*
+ * exchangeViews - Gather the view of every node; views holds VIEW_SIZE floats per node.
+ *
+ * parameter view - const float*
+ * parameter views - float*
+ */
+void Compositor::exchangeViews(const float* view, float* views) {
+    memcpy(views + VIEW_SIZE * nodeIndex, view, VIEW_SIZE * sizeof(float));
+    try {
+        for (int i = 0; i < numberOfNodes; i++) {
+            if (i != nodeIndex)
+                writeFully(sockets[i], view, VIEW_SIZE * sizeof(float));
+        } // end for
+        for (int i = 0; i < numberOfNodes; i++) {
+            if (i != nodeIndex)
+                readFully(sockets[i], views + VIEW_SIZE * i, VIEW_SIZE * sizeof(float));
+        } // end for
+    } catch (std::runtime_error e) {
+        disconnect();
+        throw;
+    }
+} // end exchangeViews()
+
+/*
+ * getNodeIndex
+ *
+ * return - int
+ */
+int Compositor::getNodeIndex(void) const {
+    return nodeIndex;
+} // end getNodeIndex()
+
+/*
+ * getNumberOfNodes
+ *
+ * return - int
+ */
+int Compositor::getNumberOfNodes(void) const {
+    return numberOfNodes;
+} // end getNumberOfNodes()
+
+/*
+ * isConnected
+ *
+ * return - bool
+ */
+bool Compositor::isConnected(void) const {
+    return connected;
+} // end isConnected()
+
+/*
+ * sendThread
+ *
+ * parameter parameter - void*
+ * return - void*
+ */
+void* Compositor::sendThread(void* parameter) {
+    SendTask* sendTask = static_cast<SendTask*> (parameter);
+    Compositor* compositor = sendTask->compositor;
+    // An exception must not leave the thread; exchangeImages() rethrows it on the calling thread
+    try {
+        for (int round = 1; round < compositor->numberOfNodes; round++) {
+            int destination = (compositor->nodeIndex + round) % compositor->numberOfNodes;
+            compositor->writeFully(compositor->sockets[destination], &sendTask->outgoingKeys[destination], sizeof(float));
+            compositor->writeFully(compositor->sockets[destination], sendTask->outgoing[destination],
+                    sendTask->outgoingSizes[destination]);
+        } // end for
+    } catch (std::runtime_error e) {
+        sendTask->error = e.what();
+    }
+    return NULL;
+} // end sendThread()
+
+/*
+ * readFully
+ *
+ * parameter socket - int
+ * parameter buffer - void*
+ * parameter size - int
+ */
+void Compositor::readFully(int socket, void* buffer, int size) {
+    char* bytes = static_cast<char*> (buffer);
+    while (size > 0) {
+        ssize_t count = recv(socket, bytes, size, 0);
+        if (count <= 0)
+            Misc::throwStdErr("Compositor::readFully: Connection to a render node lost");
+        bytes += count;
+        size -= count;
+    } // end while
+} // end readFully()
+
+/*
+ * writeFully
+ *
+ * parameter socket - int
+ * parameter buffer - const void*
+ * parameter size - int
+ */
+void Compositor::writeFully(int socket, const void* buffer, int size) {
+    const char* bytes = static_cast<const char*> (buffer);
+    while (size > 0) {
+        ssize_t count = send(socket, bytes, size, MSG_NOSIGNAL);
+        if (count <= 0)
+            Misc::throwStdErr("Compositor::writeFully: Connection to a render node lost");
+        bytes += count;
+        size -= count;
+    } // end while
+} // end writeFully()
@@ -0,0 +1,57 @@
+/*
+ * Compositor.h - Class for sort-last compositing of partial volume renderings across render nodes.
+ *
+ * Every node owns a contiguous range of brick slabs. Per frame the nodes exchange their views,
+ * render their own slabs for every node's view, and send each partial image straight to the
+ * node that displays it (direct-send). Each node then blends the partials for its own view
+ * back to front. Nodes talk over TCP, one connection per pair, so a cluster of processes on
+ * one machine (all hosts "localhost") works over loopback.
+ *
+ * Author: Patrick O'Leary
+ * Created: October 19, 2026
+ * Copyright 2007. All rights reserved.
+ */
+#ifndef COMPOSITOR_H_
+#define COMPOSITOR_H_
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/* Projection matrix, modelview matrix and viewport of one view */
+#define VIEW_SIZE 36
+
+class Compositor {
+public:
+    Compositor(int _nodeIndex, int _numberOfNodes, const char* _hosts, int _port);
+    ~Compositor(void);
+    static void composite(unsigned char** images, const float* keys, int numberOfImages, int numberOfPixels,
+            unsigned char* image);
+    void connect(void) throw (std::runtime_error);
+    void exchangeImages(unsigned char** outgoing, const int* outgoingSizes, const float* outgoingKeys, unsigned char** incoming,
+            int incomingSize, float* incomingKeys);
+    void exchangeViews(const float* view, float* views);
+    int getNodeIndex(void) const;
+    int getNumberOfNodes(void) const;
+    bool isConnected(void) const;
+private:
+    struct SendTask {
+        Compositor* compositor;
+        unsigned char** outgoing;
+        const int* outgoingSizes;
+        const float* outgoingKeys;
+        std::string error; // of a failed write, rethrown once the thread has been joined
+    };
+    bool connected; // until a peer is lost; the sockets are shut down from then on
+    std::vector<std::string> hosts;
+    int nodeIndex;
+    int numberOfNodes;
+    int port;
+    int* sockets;
+    void disconnect(void);
+    static void* sendThread(void* parameter);
+    void readFully(int socket, void* buffer, int size);
+    void writeFully(int socket, const void* buffer, int size);
+};
+
+#endif /*COMPOSITOR_H_*/
@@ -0,0 +1,122 @@
+/*
+ * FrameGovernor.cpp - Methods for FrameGovernor class.
+ *
+ * Author: Patrick O'Leary
+ * Created: October 19, 2026
+ * Copyright 2007. All rights reserved.
+ */
+#include <algorithm>
+#include <cmath>
+
+/* Vrui includes */
+#include <Misc/ThrowStdErr.h>
+
+#include <GRAPHIC/FrameGovernor.h>
+
+/*
+ * FrameGovernor - Constructor for FrameGovernor class.
+ *
+ * parameter _targetFrameRate - double
+ */
+FrameGovernor::FrameGovernor(double _targetFrameRate) :
+    frame(0), frameTime(0.0), log(NULL), quality(1.0f), settleFrames(GOVERNOR_SETTLE_FRAMES), targetFrameTime(1.0
+            / _targetFrameRate) {
+} // end FrameGovernor()
+
+/*
+ * ~FrameGovernor - Destructor for FrameGovernor class.
+ */
+FrameGovernor::~FrameGovernor(void) {
+    if (log != NULL) {
+        log->close();
+        delete log;
+    }
+} // end ~FrameGovernor()
+
+/*
+ * getQuality - Get the quality level, GOVERNOR_MINIMUM_QUALITY to 1.
+ *
+ * return - float
+ */
+float FrameGovernor::getQuality(void) const {
+    return quality;
+} // end getQuality()
+
+/*
+ * isStill - Compare the navigation transformation and the head with the last frame.
+ *
+ * Navigation only changes on purpose and is compared exactly; a tracked head jitters, so it
+ * is still within a twentieth of an inch and a fraction of a degree.
+ *
+ * return - bool
+ */
+bool FrameGovernor::isStill(void) {
+    const Vrui::NavTransform& currentNavigation = Vrui::getNavigationTransformation();
+    const Vrui::NavTrackerState& currentHead = Vrui::getHeadTransformation();
+    bool still = currentNavigation.getTranslation() == navigation.getTranslation() && currentNavigation.getRotation()
+            == navigation.getRotation() && currentNavigation.getScaling() == navigation.getScaling();
+    Vrui::Scalar tolerance = Vrui::Scalar(0.05) * Vrui::getInchFactor();
+    if ((currentHead.getTranslation() - head.getTranslation()).sqr() > tolerance * tolerance)
+        still = false;
+    const Vrui::Scalar* a = currentHead.getRotation().getQuaternion();
+    const Vrui::Scalar* b = head.getRotation().getQuaternion();
+    if (std::fabs(a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3]) < Vrui::Scalar(0.99999))
+        still = false;
+    navigation = currentNavigation;
+    head = currentHead;
+    return still;
+} // end isStill()
+
+/*
+ * setLogFile - Log every decision to a comma separated file.
+ *     throws std::runtime_error when the file can not be opened
+ *
+ * parameter fileName - const char*
+ */
+void FrameGovernor::setLogFile(const char* fileName) {
+    log = new std::ofstream(fileName, std::ios::out);
+    if (!log->is_open()) {
+        delete log;
+        log = NULL;
+        Misc::throwStdErr("FrameGovernor::setLogFile: Could not open governor log file %s", fileName);
+    }
+    *log << "frame,frameTime,smoothedFrameTime,targetFrameTime,still,quality,decision" << std::endl;
+} // end setLogFile()
+
+/*
+ * update - Measure the last frame and decide the quality level of the next one.
+ *
+ * return - bool (the quality level changed)
+ */
+bool FrameGovernor::update(void) {
+    double currentFrameTime = Vrui::getCurrentFrameTime();
+    if (frameTime == 0.0)
+        frameTime = currentFrameTime;
+    else
+        frameTime += GOVERNOR_SMOOTHING * (currentFrameTime - frameTime);
+    bool still = isStill();
+    float previousQuality = quality;
+    const char* decision = "hold";
+    if (settleFrames > 0) {
+        settleFrames--;
+        decision = "settle";
+    } else if (!still && frameTime > targetFrameTime * 1.05) {
+        // Coarsen in proportion to the overrun, at least one step
+        quality = std::floor(quality * float(targetFrameTime / frameTime) / GOVERNOR_QUALITY_STEP) * GOVERNOR_QUALITY_STEP;
+        quality = std::max(GOVERNOR_MINIMUM_QUALITY, std::min(quality, previousQuality - GOVERNOR_QUALITY_STEP));
+        decision = "coarsen";
+    } else if (quality < 1.0f && (still || frameTime < targetFrameTime * 0.8)) {
+        quality = std::min(1.0f, quality + GOVERNOR_QUALITY_STEP);
+        decision = (still) ? "refine still" : "refine";
+    }
+    if (log != NULL)
+        *log << frame << "," << currentFrameTime * 1000.0 << "," << frameTime * 1000.0 << "," << targetFrameTime * 1000.0
+                << "," << still << "," << quality << "," << decision << std::endl;
+    frame++;
+    if (quality == previousQuality)
+        return false;
+    // Measure the new quality level afresh once the change has settled
+    frameTime = 0.0;
+    settleFrames = GOVERNOR_SETTLE_FRAMES;
+    return true;
+} // end update()
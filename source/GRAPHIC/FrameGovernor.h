@@ -0,0 +1,47 @@
+/*
+ * FrameGovernor.h - Class for holding a target frame rate by trading level of detail for frame time.
+ *
+ * The governor smooths the measured frame time and steers a quality level in
+ * [GOVERNOR_MINIMUM_QUALITY, 1] in steps of GOVERNOR_QUALITY_STEP: down in proportion to the
+ * overrun when the frame is too slow, one step up when there is head room. While neither the
+ * navigation transformation nor the head moves, it steps the quality back up to full each
+ * GOVERNOR_SETTLE_FRAMES frames. The caller maps the quality onto the octree node budget and
+ * the sample spacing. Every decision may be logged as one comma separated line per frame.
+ *
+ * Author: Patrick O'Leary
+ * Created: October 19, 2026
+ * Copyright 2007. All rights reserved.
+ */
+#ifndef FRAMEGOVERNOR_H_
+#define FRAMEGOVERNOR_H_
+
+#include <fstream>
+
+/* Vrui includes to use the Vrui interface */
+#include <Vrui/Vrui.h>
+
+#define GOVERNOR_MINIMUM_QUALITY 0.25f
+#define GOVERNOR_QUALITY_STEP 0.0625f
+#define GOVERNOR_SETTLE_FRAMES 4
+#define GOVERNOR_SMOOTHING 0.2
+
+class FrameGovernor {
+public:
+    FrameGovernor(double _targetFrameRate);
+    ~FrameGovernor(void);
+    float getQuality(void) const;
+    void setLogFile(const char* fileName);
+    bool update(void);
+private:
+    int frame;
+    double frameTime; // smoothed frame time in seconds
+    Vrui::NavTrackerState head;
+    std::ofstream* log;
+    Vrui::NavTransform navigation;
+    float quality;
+    int settleFrames; // frames left before the next decision
+    double targetFrameTime;
+    bool isStill(void);
+};
+
+#endif /*FRAMEGOVERNOR_H_*/
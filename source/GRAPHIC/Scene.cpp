@@ -8,6 +8,10 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <queue>
+#include <stdexcept>
 
 /* Vrui includes */
 #include <Geometry/OrthogonalTransformation.h>
@@ -22,23 +26,46 @@
 
 #include <DATA/Volume.h>
 #include <DATASTRUCTURE/BoundingBox.h>
+#include <DATASTRUCTURE/BoundingSphere.h>
 #include <DATASTRUCTURE/Brick.h>
+#include <DATASTRUCTURE/BrickTree.h>
 #include <DATASTRUCTURE/ComparableBrick.h>
 #include <DATASTRUCTURE/ComparableOcNode.h>
+#include <DATASTRUCTURE/IlluminationCache.h>
 #include <DATASTRUCTURE/OcNode.h>
 #include <DATASTRUCTURE/OcTree.h>
+#include <DATASTRUCTURE/StagingCache.h>
+#include <DATASTRUCTURE/TextureAtlas.h>
+#include <DATASTRUCTURE/VisibleValues.h>
+#include <GRAPHIC/Benchmark.h>
+#include <GRAPHIC/Compositor.h>
 #include <GRAPHIC/Scene.h>
 #include <MATH/Matrix4x4.h>
 #include <MATH/Point4.h>
 #include <MATH/Vector4.h>
 #include <SHADER/ShaderManager.h>
 #include <SHADER/ShaderObject.h>
+#include <SHADER/ShaderVariants.h>
+#include <UTILITY/MemoryAccount.h>
 #include <UTILITY/Stringify.h>
 
-Scene::DataItem::DataItem(void) {
+Scene::DataItem::DataItem(void) :
+    illuminatedVolumeShaderObject(0), volumeShaderVariants2DWithLighting(0), volumeShaderVariantsWithLighting(0), preIntegratedVolumeShaderVariantsWithLighting(0),
+            framebufferName(0), colorbufferName(0), depthbufferName(0), framebufferWidth(0), framebufferHeight(0), offscreen(false),
+            colorMapVersion(0), sliceColorMapVersion(0), minimumIndex(-1), stagingFinished(false), illuminationBudget(0), illuminationFrame(0), illuminationUploaded(false) {
+    for (int i = 0; i < 9; i++)
+        rotation[i] = 0.0f;
 }
 
 Scene::DataItem::~DataItem(void) {
+    if (framebufferName != 0) {
+        glDeleteFramebuffersEXTProc(1, &framebufferName);
+        glDeleteRenderbuffersEXTProc(1, &colorbufferName);
+        glDeleteRenderbuffersEXTProc(1, &depthbufferName);
+    }
+    delete volumeShaderVariants2DWithLighting;
+    delete volumeShaderVariantsWithLighting;
+    delete preIntegratedVolumeShaderVariantsWithLighting;
     delete shaderManager;
 }
 
@@ -55,14 +82,18 @@ Scene::DataItem::~DataItem(void) {
  */
 Scene::Scene(Volume* _volume, unsigned char* _colormap, float* _alpha, float * _alpha2_5D, float* _red, float* _green,
         float* _blue, unsigned char* _sliceColormap) :
-    alpha(_alpha), alpha2_5D(_alpha2_5D), animating(false), blue(_blue), blueScale(1.0), boundaryContribution(0.0),
-            boundaryExponent(1.0), bricks(NULL),
-            colormap(_colormap), colorMapChanged(true), dimension(1), edgeContribution(0.0), edgeExponent(1.0), edgeThreshold(0.1),
-            focusAndContext(false), green(_green), greenScale(1.0), interactive(false), lighting(false), maximumPriorityQueueSizeChanged(false),
-            maximumPriorityQueueTest(false), normalContribution(1.0), numberOfBricks(0), preintegrated(false),
+    alpha(_alpha), alpha2_5D(_alpha2_5D), animating(false), atlas(NULL), benchmark(NULL), blue(_blue), blueScale(1.0), boundaryContribution(0.0),
+            boundaryExponent(1.0), bricks(NULL), brickTree(NULL),
+            colormap(_colormap), colorMapChanged(true), colorMapVersion(0), compositor(NULL), dimension(1), edgeContribution(0.0), edgeExponent(1.0), edgeThreshold(0.1),
+            focusAndContext(false), frameNumber(0), green(_green), greenScale(1.0), illuminated(false), illuminationCache(NULL),
+            illuminationRequested(false), interactive(false), lighting(false), maximum3DTextureSize(0), maximumPriorityQueueSize(
+                    _volume->getMaximumPriorityQueueSize()), maximumPriorityQueueSizeChanged(false),
+            maximumPriorityQueueTest(false), normalContribution(1.0), numberOfBrickColumns(0), numberOfBrickRows(0), numberOfBrickSlabs(0), numberOfBricks(0), partitionMaximumZ(0.0), partitionMinimumZ(0.0),
+            preintegrated(false),
             ratioOfVisibilityTest(false), red(_red), redScale(1.0), renderingCostFunctionTest(true), showDisplay(false),
             showOutline(true), showVolume(false), silhouetteContribution(0.0), silhouetteExponent(1.0), sliceColormap(
-                    _sliceColormap), sliceColorMapChanged(true), toneContribution(0.0), toonContribution(0.0), volume(_volume) {
+                    _sliceColormap), sliceColorMapChanged(true), sliceColorMapVersion(0), stagingCache(new StagingCache()), textureNonPowerOfTwo(true), toneContribution(0.0), toonContribution(0.0), volume(_volume) {
+    pthread_mutex_init(&textureLimitsMutex, NULL);
     if (volume->getNumberOfComponents() != 0) {
         rgbChanged = true;
         alphaChanged = false;
@@ -72,6 +103,14 @@ Scene::Scene(Volume* _volume, unsigned char* _colormap, float* _alpha, float * _
     }
     Brick* bricks;
     int numberOfBricks;
+    classifiedAlpha = new float[256];
+    invalidateClassification();
+    colormap1D = new unsigned char[256 * 4];
+    sliceColormap1D = new unsigned char[256 * 4];
+    for (int i = 0; i < 3; i++) {
+        framePoint[i] = 0.0f;
+        refinementPoint[i] = 0.0f;
+    }
     setCoolColor(0.0f, 0.0f, 1.0f);
     setWarmColor(1.0f, 0.0f, 0.0f);
     setToonColor(0.0f, 1.0f, 0.0f);
@@ -96,10 +135,48 @@ Scene::~Scene(void) {
     red = NULL;
     sliceColormap = NULL;
     volume = NULL;
+    delete atlas;
+    delete illuminationCache;
     if (bricks != NULL)
         delete[] bricks;
+    delete brickTree;
+    delete stagingCache;
+    pthread_mutex_destroy(&textureLimitsMutex);
+    delete[] classifiedAlpha;
+    delete[] colormap1D;
+    delete[] sliceColormap1D;
 } // end ~Scene()
 
+/*
+ * accountMemory - Add the bytes held by the volume, the bricks and the textures of every window.
+ *
+ * The GL textures are estimated from the resident bricks, whether or not the contexts have
+ * uploaded them yet; the staging is the most held at once.
+ *
+ * parameter memoryAccount - MemoryAccount&
+ */
+void Scene::accountMemory(MemoryAccount& memoryAccount) const {
+    volume->accountMemory(memoryAccount);
+    size_t numberOfWindows = size_t(std::max(1, Vrui::getNumWindows()));
+    for (int i = 0; i < numberOfBricks; i++) {
+        memoryAccount.add(MEMORY_OCTREES, bricks[i].getOcTree()->getPoolSize());
+        size_t textureMemory = bricks[i].getTextureMemory(STAGING_TEXTURE) + bricks[i].getTextureMemory(
+                STAGING_DOWN_SAMPLED_TEXTURE) + bricks[i].getTextureMemory(STAGING_GRADIENT_TEXTURE);
+        memoryAccount.add(MEMORY_BRICK_TEXTURES, numberOfWindows * textureMemory);
+    } // end for
+    if (stagingCache != NULL)
+        memoryAccount.add(MEMORY_STAGING, stagingCache->getPeakSize());
+    if (illuminationCache != NULL) {
+        // The baked colors stay on the host and are uploaded as one more texture per brick
+        memoryAccount.add(MEMORY_ILLUMINATION, illuminationCache->getSize());
+        memoryAccount.add(MEMORY_BRICK_TEXTURES, numberOfWindows * illuminationCache->getSize());
+    } // end if
+    if (atlas != NULL) {
+        memoryAccount.add(MEMORY_STAGING, atlas->getSize());
+        memoryAccount.add(MEMORY_ATLAS_TEXTURE, numberOfWindows * atlas->getSize());
+    } // end if
+} // end accountMemory()
+
 /*
  * calculateSlicePlaneNormal
  *
@@ -126,6 +203,26 @@ Vector4* Scene::calculateSlicePlaneNormal(Matrix4x4* modelviewInverse) const {
     return slicePlaneNormal;
 } // end calculateSlicePlaneNormal()
 
+/*
+ * calculateAlphaChanged - Find the interval of data values whose alpha changed since the last classification.
+ *
+ * The interval is empty (minimumChanged > maximumChanged) when nothing changed.
+ *
+ * parameter minimumChanged - int &
+ * parameter maximumChanged - int &
+ */
+void Scene::calculateAlphaChanged(int & minimumChanged, int & maximumChanged) const {
+    minimumChanged = 256;
+    maximumChanged = -1;
+    for (int i = 0; i < 256; i++) {
+        if (alpha[i] != classifiedAlpha[i]) {
+            minimumChanged = std::min(minimumChanged, i);
+            maximumChanged = i;
+        } // end if
+        classifiedAlpha[i] = alpha[i];
+    } // end for
+} // end calculateAlphaChanged()
+
 /*
  * clearSpheres
  */
@@ -134,60 +231,150 @@ void Scene::clearSpheres(void) {
 } // end clearSpheres()
 
 /*
- * createBricks
+ * createBricks - Create the bricks of the partitioned brick boxes.
+ *
+ * The bricks are GL objects, so they and the texture atlas are created on
+ * the render thread, between frames; every context uploads the brick textures from the next
+ * frame on. Their octrees only hold their roots until createOcTrees().
  */
 void Scene::createBricks(void) {
-    int numberOfColumns = volume->getWidth() / volume->getTextureSize();
-    if (volume->getWidth() % volume->getTextureSize() != 0)
-        numberOfColumns++;
-    int width = volume->getWidth() / numberOfColumns;
-    int numberOfRows = volume->getHeight() / volume->getTextureSize();
-    if (volume->getHeight() % volume->getTextureSize() != 0)
-        numberOfRows++;
-    int height = volume->getHeight() / numberOfRows;
-    int numberOfSlabs = volume->getDepth() / volume->getTextureSize();
-    if (volume->getDepth() % volume->getTextureSize() != 0)
-        numberOfSlabs++;
-    int depth = volume->getDepth() / numberOfSlabs;
-    numberOfBricks = numberOfColumns * numberOfRows * numberOfSlabs;
     bricks = new Brick[numberOfBricks];
-    int which = 0;
-    int slabRemainder = volume->getDepth() % numberOfSlabs;
-    int _slab = 0;
-    for (int k = 0; k < numberOfSlabs; k++) {
-        int rowRemainder = volume->getHeight() % numberOfRows;
-        int _depth = depth;
-        if (slabRemainder > 0) {
-            _depth++;
-            slabRemainder--;
-        }
-        int _row = 0;
-        for (int j = 0; j < numberOfRows; j++) {
-            int columnRemainder = volume->getWidth() % numberOfColumns;
-            int _height = height;
-            if (rowRemainder > 0) {
-                _height++;
-                rowRemainder--;
-            }
-            int _column = 0;
-            for (int i = 0; i < numberOfColumns; i++) {
-                int _width = width;
-                if (columnRemainder > 0) {
-                    _width++;
-                    columnRemainder--;
-                }
-                bricks[which].setBrick(_column, _row, _slab, _width, _height, _depth, volume);
-                _column += _width;
-                which++;
-            }
-            _row += _height;
-        }
-        _slab += _depth;
-    }
+    for (int i = 0; i < numberOfBricks; i++) {
+        const int* box = &brickBoxes[6 * i];
+        bricks[i].setBrick(box[0], box[1], box[2], box[3], box[4], box[5], volume);
+    } // end for
+    // Every context uploads the bricks from one shared staging copy
     for (int i = 0; i < numberOfBricks; i++)
-        bricks[i].adjustTextureCoordinates();
+        bricks[i].setStagingCache(stagingCache);
+    // Contexts without non power of two textures get padded brick textures, not a padded volume
+    bool nonPowerOfTwo;
+    int maximumSize;
+    getTextureLimits(nonPowerOfTwo, maximumSize);
+    for (int i = 0; i < numberOfBricks; i++)
+        bricks[i].setPowerOfTwo(!nonPowerOfTwo);
+    if (volume->isTextureAtlas() && volume->getNumberOfComponents() == 0)
+        atlas = new TextureAtlas(volume);
+    if (volume->isIlluminationCache())
+        illuminationCache = new IlluminationCache(volume, bricks, numberOfBricks);
+    partitionMinimumZ = volume->getVolumeBox()->getZ(0);
+    partitionMaximumZ = volume->getVolumeBox()->getZ(7);
+    if (compositor != NULL) {
+        // Every render node owns a contiguous range of slabs; the other bricks never get textures
+        int nodeIndex = compositor->getNodeIndex();
+        int numberOfNodes = compositor->getNumberOfNodes();
+        int firstSlab = (nodeIndex * numberOfBrickSlabs) / numberOfNodes;
+        int lastSlab = ((nodeIndex + 1) * numberOfBrickSlabs) / numberOfNodes;
+        int bricksPerSlab = numberOfBrickColumns * numberOfBrickRows;
+        bool owner = false;
+        for (int i = 0; i < numberOfBricks; i++) {
+            if (brickTree != NULL) {
+                bricks[i].setResident(brickTree->getPartition(i) == nodeIndex);
+            } else {
+                int k = i / bricksPerSlab;
+                bricks[i].setResident(k >= firstSlab && k < lastSlab);
+            } // end if
+            if (bricks[i].isResident()) {
+                if (!owner || bricks[i].getVolumeBox()->getZ(0) < partitionMinimumZ)
+                    partitionMinimumZ = bricks[i].getVolumeBox()->getZ(0);
+                if (!owner || bricks[i].getVolumeBox()->getZ(7) > partitionMaximumZ)
+                    partitionMaximumZ = bricks[i].getVolumeBox()->getZ(7);
+                owner = true;
+            } // end if
+        } // end for
+        if (Vrui::getNodeIndex() == 0)
+            std::cout << "Compositor: " << ((brickTree != NULL) ? numberOfNodes : numberOfBrickSlabs) << " slabs over "
+                    << numberOfNodes << " render nodes" << std::endl;
+    } // end if
 } // end createBricks()
 
+/*
+ * createOcTrees - Build the octrees of all bricks at once, one top level subtree per task.
+ *
+ * Only touches the octrees, so it may run on a background thread while the bricks upload
+ * their textures, as long as the scene is not drawn before it has finished.
+ */
+void Scene::createOcTrees(void) {
+    Misc::Timer timer;
+    std::vector<OcNode*> subtrees;
+    for (int i = 0; i < numberOfBricks; i++)
+        bricks[i].getOcTree()->split(subtrees);
+    OcTree::createSubtrees(subtrees, volume->getNumberOfDecodeThreads());
+    int numberOfOcNodes = 0;
+    size_t poolSize = 0;
+    for (int i = 0; i < numberOfBricks; i++) {
+        bricks[i].getOcTree()->calculateRange();
+        numberOfOcNodes += bricks[i].getOcTree()->getNumberOfOcNodes();
+        poolSize += bricks[i].getOcTree()->getPoolSize();
+    } // end for
+    for (int i = 0; i < numberOfBricks; i++)
+        bricks[i].adjustTextureCoordinates();
+    timer.elapse();
+    if (Vrui::getNodeIndex() == 0) {
+        std::cout << "Brick setup: " << numberOfBricks << " bricks, " << numberOfOcNodes << " octree nodes in " << poolSize
+                << " pooled bytes, " << timer.getTime() * 1000.0 << " ms on " << volume->getNumberOfDecodeThreads() << " threads"
+                << std::endl;
+        MemoryAccount memoryAccount;
+        accountMemory(memoryAccount);
+        std::cout << memoryAccount.toString() << std::endl;
+        if (volume->getMemoryBudget() != 0 && memoryAccount.getHostBytes() > volume->getMemoryBudget())
+            std::cout << "Memory budget: " << memoryAccount.getHostBytes() << " host bytes exceed the budget of "
+                    << volume->getMemoryBudget() << " bytes" << std::endl;
+    } // end if
+} // end createOcTrees()
+
+/*
+ * determineOcNodesToDisplay - Refine the octrees of all bricks from one queue within the node budget.
+ *
+ * The frontier of displayed nodes starts at the roots of the visible bricks. The frontier node
+ * of highest importance is replaced by its visible children until maximumPriorityQueueSize
+ * nodes are displayed, so a dense or distant brick gets fewer nodes than a close one that is
+ * partly empty. The importance of a node is its projected size, the squared ratio of its
+ * bounding sphere radius to its distance from the eye at point, times its mean visibility
+ * times its fraction of empty voxels.
+ *
+ * parameter point - const float*
+ */
+void Scene::determineOcNodesToDisplay(const float* point) {
+    ComparableOcNode comparableOcNode;
+    comparableOcNode.minimum(); // use the standard less operator<
+    std::priority_queue<ComparableOcNode> maximumPriorityQueue;
+    float numberOfVoxels = float(volume->getWidth()) * float(volume->getHeight()) * float(volume->getDepth());
+    int numberOfOcNodes = 0;
+    for (int i = 0; i < numberOfBricks; i++) {
+        OcNode * ocNode = bricks[i].getOcTree()->getRoot();
+        if (ocNode->getRatioOfVisibility() != 0.0f) {
+            bricks[i].setEmpty(false);
+            ocNode->setDisplayed(true);
+            numberOfOcNodes++;
+            if (!ocNode->isLeaf())
+                maximumPriorityQueue.push(ComparableOcNode(i, getImportance(ocNode, point, numberOfVoxels), ocNode));
+        } else {
+            bricks[i].setEmpty(true);
+            ocNode->setDisplayed(false);
+        }
+    } // end for
+    while (numberOfOcNodes < maximumPriorityQueueSize && !maximumPriorityQueue.empty()) {
+        OcNode * ocNode = maximumPriorityQueue.top().getOcNode();
+        int which = maximumPriorityQueue.top().getWhich();
+        maximumPriorityQueue.pop();
+        ocNode->setDisplayed(false);
+        numberOfOcNodes--;
+        OcNode * child = ocNode->getChildren();
+        for (int i = 0; i < 8; i++) {
+            if (child[i].getRatioOfVisibility() != 0.0f) {
+                child[i].setDisplayed(true);
+                numberOfOcNodes++;
+                if (!child[i].isLeaf())
+                    maximumPriorityQueue.push(ComparableOcNode(which, getImportance(&child[i], point, numberOfVoxels),
+                            &child[i]));
+            } else
+                child[i].setDisplayed(false);
+        } // end for
+    } // end while
+    for (int i = 0; i < 3; i++)
+        refinementPoint[i] = point[i];
+} // end determineOcNodesToDisplay()
+
 /*
  * displayScene
  *
@@ -195,80 +382,54 @@ void Scene::createBricks(void) {
  */
 void Scene::display(GLContextData& glContextData) const {
     DataItem* dataItem = glContextData.retrieveDataItem<DataItem> (this);
+    // The bricks of this context were initialized before its first display with them
+    if (!dataItem->stagingFinished && bricks != NULL) {
+        dataItem->stagingFinished = true;
+        stagingCache->finishUse();
+    }
     pushGLState(glContextData);
     dataItem->cFrustum.updateFrustum();
     if (showDisplay) {
-        // Get head position in physical coordinates (Cheaper than transforming every bounding box)
-        Geometry::Point<double, 3> p = Vrui::getHeadPosition();
-        Vrui::getNavigationTransformation().inverseTransform(p);
-        float* point = new float[3];
-        point[0] = p[0];
-        point[1] = p[1];
-        point[2] = p[2];
-        // sort bricks and ocnodes
-        std::vector<ComparableBrick> brickList(numberOfBricks);
-        sortBricks(point, brickList);
-
-        if (alphaChanged) {
-            if (ratioOfVisibilityTest) {
-                if (dimension == 1) {
-                    for (int i = 0; i < numberOfBricks; i++)
-                        bricks[i].setRatioOfVisibility(alpha);
-                } else {
-                    for (int i = 0; i < numberOfBricks; i++)
-                        bricks[i].setRatioOfVisibility2_5D(alpha2_5D);
-                }
-            } else if (maximumPriorityQueueTest) {
-                if (dimension == 1) {
-                    for (int i = 0; i < numberOfBricks; i++)
-                        bricks[i].setPercentageOfEmptyVolume(alpha);
-                } else {
-                    for (int i = 0; i < numberOfBricks; i++)
-                        bricks[i].setPercentageOfEmptyVolume2_5D(alpha2_5D);
-                }
-                for (int i = 0; i < numberOfBricks; i++)
-                    bricks[i].determineOcNodesToDisplay();
-            } else if (renderingCostFunctionTest) {
-                if (dimension == 1) {
-                    for (int i = 0; i < numberOfBricks; i++)
-                        bricks[i].setRenderingCostFunction(alpha);
-                } else {
-                    for (int i = 0; i < numberOfBricks; i++)
-                        bricks[i].setRenderingCostFunction2_5D(alpha2_5D);
-                }
-            }
-        }
-        if (maximumPriorityQueueSizeChanged) {
-            for (int i = 0; i < numberOfBricks; i++)
-                bricks[i].determineOcNodesToDisplay();
-
-        }
-
-        if (rgbChanged) {
-            if (ratioOfVisibilityTest) {
-                for (int i = 0; i < numberOfBricks; i++)
-                    bricks[i].setRatioOfVisibility(red, green, blue);
-            } else if (maximumPriorityQueueTest) {
-                for (int i = 0; i < numberOfBricks; i++) {
-                    bricks[i].setPercentageOfEmptyVolume(red, green, blue);
-                    bricks[i].determineOcNodesToDisplay();
-                }
-            } else if (renderingCostFunctionTest) {
-                for (int i = 0; i < numberOfBricks; i++)
-                    bricks[i].setRenderingCostFunction(red, green, blue);
-            }
+        Misc::Timer timer;
+        // The eye of this view in model coordinates
+        float* data = new float[16];
+        glGetFloatv(GL_MODELVIEW_MATRIX, data);
+        Matrix4x4 modelview(data);
+        delete[] data;
+        Matrix4x4* modelviewInverse = modelview.inverse();
+        float point[3];
+        for (int i = 0; i < 3; i++)
+            point[i] = modelviewInverse->get(3, i) / modelviewInverse->get(3, 3);
+        delete modelviewInverse;
+        // An eye in the same brick as the head shares the order sorted by frame()
+        std::vector<ComparableBrick> eyeBrickList;
+        bool sameBrick = isInSameBrick(point, framePoint);
+        if (!sameBrick) {
+            eyeBrickList.resize(numberOfBricks);
+            sortBricks(point, eyeBrickList);
         }
+        const std::vector<ComparableBrick> & brickList = (sameBrick) ? frameBrickList : eyeBrickList;
 
-        if (colorMapChanged) {
+        // Upload the color maps frame() prepared once per context, not once per eye
+        if (dataItem->colorMapVersion != colorMapVersion) {
             if (!preintegrated && dimension == 1)
                 update1DColorMap(dataItem);
             else {
                 update2DColorMap(dataItem);
             }
+            dataItem->colorMapVersion = colorMapVersion;
         }
 
-        if (sliceColorMapChanged) {
+        if (dataItem->sliceColorMapVersion != sliceColorMapVersion) {
             update1DSliceColorMap(dataItem);
+            dataItem->sliceColorMapVersion = sliceColorMapVersion;
+        }
+
+        // The baked colors are of no use once the illumination cache no longer applies, e.g. without lighting
+        if (dataItem->illuminationUploaded && !illuminationRequested) {
+            for (int i = 0; i < numberOfBricks; i++)
+                bricks[i].releaseIlluminatedTexture(glContextData);
+            dataItem->illuminationUploaded = false;
         }
 
         glDisable(GL_CULL_FACE);
@@ -296,7 +457,9 @@ void Scene::display(GLContextData& glContextData) const {
 
         //Misc::Timer timer;
         if (showVolume) {
-            drawVolume(glContextData, dataItem, brickList, point);
+            // Once a render node is lost every node draws only its own slabs
+            if (compositor == NULL || !compositor->isConnected() || !drawCompositedVolume(glContextData, dataItem))
+                drawVolume(glContextData, dataItem, brickList, point);
         }
         //timer.elapse();
         //if(Vrui::getNodeIndex()==0) std::cout<<timer.getTime()*1000.0<<std::endl;
@@ -304,6 +467,14 @@ void Scene::display(GLContextData& glContextData) const {
         glLightModeli(GL_LIGHT_MODEL_TWO_SIDE, GL_FALSE);
         glDepthMask(GL_TRUE);
         glDisable(GL_BLEND);
+        if (benchmark != NULL) {
+            // Submitting returns before the GPU is done; wait for it to split the two
+            timer.elapse();
+            benchmark->addSubmissionTime(timer.getTime());
+            glFinish();
+            timer.elapse();
+            benchmark->addGPUTime(timer.getTime());
+        }
     }
     popGLState(glContextData);
 
@@ -320,14 +491,205 @@ void Scene::display(GLContextData& glContextData) const {
  */
 void Scene::drawBricks(GLContextData & glContextData, const CFrustum & cFrustum, ShaderObject* shaderObject, const std::vector<
         ComparableBrick> & brickList, float * point, int maximumIndex, int minimumIndex, Matrix4x4 * modelviewInverse) const {
+    if (atlas != NULL && !interactive) {
+        // One texture bind for all bricks
+        glActiveTexture(GL_TEXTURE0);
+        if (atlas->bind(glContextData)) {
+            shaderObject->sendUniform1i("volume", 0);
+            // A block has a one texel border in the atlas, so the central differences must step no further
+            if (shaderObject->hasUniform("texelSize")) {
+                float texelSize[3];
+                atlas->getTexelSize(texelSize);
+                shaderObject->sendUniform3f("texelSize", GLfloat(texelSize[0]), GLfloat(texelSize[1]), GLfloat(texelSize[2]));
+            } // end if
+            for (int i = 0; i < numberOfBricks; i++) {
+                if (!bricks[brickList[i].getWhich()].isEmpty() && bricks[brickList[i].getWhich()].isResident())
+                    bricks[brickList[i].getWhich()].drawAtlasVolume(cFrustum, shaderObject, point, minimumIndex, maximumIndex,
+                            modelviewInverse);
+            }
+            glBindTexture(GL_TEXTURE_3D, 0);
+            return;
+        }
+    }
     for (int i = 0; i < numberOfBricks; i++) {
-        if (!bricks[brickList[i].getWhich()].isEmpty())
+        if (!bricks[brickList[i].getWhich()].isEmpty() && bricks[brickList[i].getWhich()].isResident())
             bricks[brickList[i].getWhich()].drawVolume(glContextData, cFrustum, shaderObject, point, minimumIndex, maximumIndex,
                     modelviewInverse);
 
     }
 } // end drawBricks()
 
+/*
+ * drawCompositedVolume - Sort-last rendering of the volume across the render nodes.
+ *
+ * This node renders its own slabs once for every node's view into an off screen buffer and
+ * sends each partial image to the node that displays it. The partials for this node's view
+ * are blended back to front by their distance along z and drawn over the frame buffer.
+ * Nothing is drawn if a render node is lost.
+ *
+ * parameter glContextData - GLContextData &
+ * parameter dataItem - DataItem*
+ * return - bool (false if the compositor lost a render node)
+ */
+bool Scene::drawCompositedVolume(GLContextData & glContextData, DataItem* dataItem) const {
+    int nodeIndex = compositor->getNodeIndex();
+    int numberOfNodes = compositor->getNumberOfNodes();
+    float* view = new float[VIEW_SIZE];
+    GLint viewport[4];
+    glGetFloatv(GL_PROJECTION_MATRIX, view);
+    glGetFloatv(GL_MODELVIEW_MATRIX, view + 16);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    for (int i = 0; i < 4; i++)
+        view[32 + i] = float(viewport[i]);
+    float* views = new float[VIEW_SIZE * numberOfNodes];
+    try {
+        compositor->exchangeViews(view, views);
+    } catch (std::runtime_error e) {
+        std::cerr << "Error: Exception " << e.what() << "!" << std::endl;
+        delete[] view;
+        delete[] views;
+        return false;
+    }
+    delete[] view;
+    int width = 0;
+    int height = 0;
+    for (int n = 0; n < numberOfNodes; n++) {
+        width = std::max(width, int(views[VIEW_SIZE * n + 34]));
+        height = std::max(height, int(views[VIEW_SIZE * n + 35]));
+    } // end for
+    if (width > dataItem->framebufferWidth || height > dataItem->framebufferHeight) {
+        dataItem->framebufferWidth = std::max(width, dataItem->framebufferWidth);
+        dataItem->framebufferHeight = std::max(height, dataItem->framebufferHeight);
+        dataItem->glBindRenderbufferEXTProc(GL_RENDERBUFFER_EXT, dataItem->colorbufferName);
+        dataItem->glRenderbufferStorageEXTProc(GL_RENDERBUFFER_EXT, GL_RGBA8, dataItem->framebufferWidth, dataItem->framebufferHeight);
+        dataItem->glBindRenderbufferEXTProc(GL_RENDERBUFFER_EXT, dataItem->depthbufferName);
+        dataItem->glRenderbufferStorageEXTProc(GL_RENDERBUFFER_EXT, GL_DEPTH_COMPONENT24, dataItem->framebufferWidth,
+                dataItem->framebufferHeight);
+        dataItem->glBindRenderbufferEXTProc(GL_RENDERBUFFER_EXT, 0);
+        dataItem->glBindFramebufferEXTProc(GL_FRAMEBUFFER_EXT, dataItem->framebufferName);
+        dataItem->glFramebufferRenderbufferEXTProc(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_RENDERBUFFER_EXT,
+                dataItem->colorbufferName);
+        dataItem->glFramebufferRenderbufferEXTProc(GL_FRAMEBUFFER_EXT, GL_DEPTH_ATTACHMENT_EXT, GL_RENDERBUFFER_EXT,
+                dataItem->depthbufferName);
+        dataItem->glBindFramebufferEXTProc(GL_FRAMEBUFFER_EXT, 0);
+    } // end if
+    unsigned char** outgoing = new unsigned char*[numberOfNodes];
+    int* outgoingSizes = new int[numberOfNodes];
+    float* outgoingKeys = new float[numberOfNodes];
+    std::vector<ComparableBrick> brickList(numberOfBricks);
+    float* point = new float[3];
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    dataItem->glBindFramebufferEXTProc(GL_FRAMEBUFFER_EXT, dataItem->framebufferName);
+    dataItem->offscreen = true;
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    for (int n = 0; n < numberOfNodes; n++) {
+        float* nodeView = views + VIEW_SIZE * n;
+        int nodeWidth = int(nodeView[34]);
+        int nodeHeight = int(nodeView[35]);
+        glViewport(0, 0, nodeWidth, nodeHeight);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glMatrixMode(GL_PROJECTION);
+        glLoadMatrixf(nodeView);
+        glMatrixMode(GL_MODELVIEW);
+        glLoadMatrixf(nodeView + 16);
+        dataItem->cFrustum.updateFrustum();
+        // Eye position in model coordinates
+        Matrix4x4 modelview(nodeView + 16);
+        Matrix4x4* modelviewInverse = modelview.inverse();
+        point[0] = modelviewInverse->get(3, 0);
+        point[1] = modelviewInverse->get(3, 1);
+        point[2] = modelviewInverse->get(3, 2);
+        delete modelviewInverse;
+        sortBricks(point, brickList);
+        drawVolume(glContextData, dataItem, brickList, point);
+        outgoingSizes[n] = 4 * nodeWidth * nodeHeight;
+        outgoing[n] = new unsigned char[outgoingSizes[n]];
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, nodeWidth, nodeHeight, GL_RGBA, GL_UNSIGNED_BYTE, outgoing[n]);
+        // Slabs are disjoint in z, so the distance along z from the eye orders the partial images
+        outgoingKeys[n] = std::max(0.0f, std::max(partitionMinimumZ - point[2], point[2] - partitionMaximumZ));
+    } // end for
+    dataItem->offscreen = false;
+    dataItem->glBindFramebufferEXTProc(GL_FRAMEBUFFER_EXT, 0);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPopMatrix();
+    dataItem->cFrustum.updateFrustum();
+    delete[] point;
+    delete[] views;
+
+    int numberOfPixels = viewport[2] * viewport[3];
+    unsigned char** incoming = new unsigned char*[numberOfNodes];
+    float* incomingKeys = new float[numberOfNodes];
+    for (int n = 0; n < numberOfNodes; n++) {
+        if (n == nodeIndex)
+            incoming[n] = outgoing[n];
+        else
+            incoming[n] = new unsigned char[4 * numberOfPixels];
+    } // end for
+    incomingKeys[nodeIndex] = outgoingKeys[nodeIndex];
+    bool exchanged = true;
+    try {
+        compositor->exchangeImages(outgoing, outgoingSizes, outgoingKeys, incoming, 4 * numberOfPixels, incomingKeys);
+    } catch (std::runtime_error e) {
+        std::cerr << "Error: Exception " << e.what() << "!" << std::endl;
+        exchanged = false;
+    }
+    unsigned char* image = NULL;
+    if (exchanged) {
+        image = new unsigned char[4 * numberOfPixels];
+        Compositor::composite(incoming, incomingKeys, numberOfNodes, numberOfPixels, image);
+        drawCompositedImage(viewport, image);
+    }
+
+    for (int n = 0; n < numberOfNodes; n++) {
+        if (n != nodeIndex)
+            delete[] incoming[n];
+        delete[] outgoing[n];
+    } // end for
+    delete[] image;
+    delete[] incoming;
+    delete[] incomingKeys;
+    delete[] outgoing;
+    delete[] outgoingKeys;
+    delete[] outgoingSizes;
+    return exchanged;
+} // end drawCompositedVolume()
+
+/*
+ * drawCompositedImage - Blend the composited premultiplied image over the frame buffer.
+ *
+ * parameter viewport - const GLint*
+ * parameter image - const unsigned char*
+ */
+void Scene::drawCompositedImage(const GLint* viewport, const unsigned char* image) const {
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glOrtho(0.0, viewport[2], 0.0, viewport[3], -1.0, 1.0);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_LIGHTING);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glRasterPos2i(0, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glDrawPixels(viewport[2], viewport[3], GL_RGBA, GL_UNSIGNED_BYTE, image);
+    glDisable(GL_BLEND);
+    glEnable(GL_LIGHTING);
+    glPopMatrix();
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+} // end drawCompositedImage()
+
 /*
  * drawGrid
  *
@@ -336,7 +698,7 @@ void Scene::drawBricks(GLContextData & glContextData, const CFrustum & cFrustum,
  */
 void Scene::drawGrid(DataItem* dataItem, const std::vector<ComparableBrick> & brickList) const {
     for (int i = 0; i < numberOfBricks; i++) {
-        if (!bricks[brickList[i].getWhich()].isEmpty())
+        if (!bricks[brickList[i].getWhich()].isEmpty() && bricks[brickList[i].getWhich()].isResident())
             bricks[brickList[i].getWhich()].drawGrid(dataItem->cFrustum);
     }
     if (showOutline) {
@@ -415,8 +777,9 @@ void Scene::drawSlices(GLContextData & glContextData, DataItem * dataItem, const
         dataItem->sliceShaderObject->sendUniform1f("greenScale", GLfloat(greenScale));
         dataItem->sliceShaderObject->sendUniform1f("blueScale", GLfloat(blueScale));
     }
+    // Slices have a color map of their own, so bricks the volume transfer function empties still show them
     for (int i = 0; i < numberOfBricks; i++) {
-        if (!bricks[brickList[i].getWhich()].isEmpty())
+        if (bricks[brickList[i].getWhich()].isResident())
             bricks[brickList[i].getWhich()].drawSlices(glContextData, dataItem->cFrustum, dataItem->sliceShaderObject);
     }
     dataItem->sliceShaderObject->end();
@@ -479,15 +842,33 @@ void Scene::drawVolume(GLContextData & glContextData, DataItem* dataItem, const
     Matrix4x4 modelview(data);
     delete[] data;
     modelviewInverse = modelview.inverse();
-    BoundingBox* rotatedBox = new BoundingBox(bricks[0].getOcTree()->getRoot()->getVolumeBox()->getCorners());
-    rotatedBox->transform(modelview);
-    rotatedBox->findExtrema();
-    int minimumIndex = rotatedBox->getMinimumIndex();
-    delete rotatedBox;
+    // The nearest corner only depends on the rotation, which the eyes of a stereo view share
+    bool sameRotation = (dataItem->minimumIndex >= 0);
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            if (dataItem->rotation[3 * i + j] != modelview.get(i, j)) {
+                dataItem->rotation[3 * i + j] = modelview.get(i, j);
+                sameRotation = false;
+            }
+        }
+    }
+    if (!sameRotation) {
+        BoundingBox* rotatedBox = new BoundingBox(bricks[0].getOcTree()->getRoot()->getVolumeBox()->getCorners());
+        rotatedBox->transform(modelview);
+        rotatedBox->findExtrema();
+        dataItem->minimumIndex = rotatedBox->getMinimumIndex();
+        delete rotatedBox;
+    }
+    int minimumIndex = dataItem->minimumIndex;
     int maximumIndex = oppositeCorner[minimumIndex];
     Vector4* slicePlaneNormal = calculateSlicePlaneNormal(modelviewInverse);
     glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    if (dataItem->offscreen) {
+        // Keep the partial image premultiplied so the compositor can blend it with the other nodes' partials
+        dataItem->glBlendFuncSeparateProc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    } else {
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    }
     // glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
     glEnable(GL_DEPTH_TEST);
     glDepthMask(false);
@@ -518,7 +899,10 @@ void Scene::drawVolume(GLContextData & glContextData, DataItem* dataItem, const
             glEnable(GL_TEXTURE_1D);
             glActiveTexture(GL_TEXTURE1);
             glBindTexture(GL_TEXTURE_1D, dataItem->colormap1DName);
-            if (lighting) {
+            if (illuminated && dataItem->illuminatedVolumeShaderObject != 0 && uploadIlluminatedTextures(glContextData, brickList)) {
+                volumeShaderIlluminated(glContextData, dataItem, brickList, point, maximumIndex, minimumIndex, slicePlaneNormal,
+                        modelviewInverse);
+            } else if (lighting) {
                 volumeShaderWithLighting(glContextData, dataItem, brickList, point, maximumIndex, minimumIndex, slicePlaneNormal,
                         modelviewInverse);
             } else {
@@ -532,7 +916,10 @@ void Scene::drawVolume(GLContextData & glContextData, DataItem* dataItem, const
         glEnable(GL_TEXTURE_2D);
         glActiveTexture(GL_TEXTURE1);
         glBindTexture(GL_TEXTURE_2D, dataItem->colormap2DName);
-        if (lighting) {
+        if (illuminated && dataItem->illuminatedVolumeShaderObject != 0 && uploadIlluminatedTextures(glContextData, brickList)) {
+            volumeShaderIlluminated(glContextData, dataItem, brickList, point, maximumIndex, minimumIndex, slicePlaneNormal,
+                    modelviewInverse);
+        } else if (lighting) {
             volumeShader2DWithLighting(glContextData, dataItem, brickList, point, maximumIndex, minimumIndex, slicePlaneNormal,
                     modelviewInverse);
         } else {
@@ -552,6 +939,157 @@ void Scene::drawVolume(GLContextData & glContextData, DataItem* dataItem, const
     delete modelviewInverse;
 } // end drawVolume()
 
+/*
+ * frame - Do the view independent work of a frame once, before any eye of any window is drawn.
+ *
+ * Classifies the octrees after a transfer function change, chooses the octree nodes of the
+ * priority queue test, publishes a finished atlas packing, prepares the one dimensional color
+ * map texels and sorts the bricks for the head. display() then only uploads and draws.
+ */
+void Scene::frame(void) {
+    // Get head position in model coordinates (Cheaper than transforming every bounding box)
+    Geometry::Point<double, 3> p = Vrui::getNavigationTransformation().inverseTransform(Vrui::getHeadPosition());
+    for (int i = 0; i < 3; i++)
+        framePoint[i] = p[i];
+    frameNumber++;
+    Misc::Timer timer;
+    frameBrickList.resize(numberOfBricks);
+    sortBricks(framePoint, frameBrickList);
+    if (benchmark != NULL) {
+        timer.elapse();
+        benchmark->addTraversalTime(timer.getTime());
+    }
+
+    if (alphaChanged) {
+        // Only octree nodes holding data values whose alpha changed are reclassified
+        int minimumChanged = 0;
+        int maximumChanged = 255;
+        if (dimension == 1)
+            calculateAlphaChanged(minimumChanged, maximumChanged);
+        // Bricks and nodes whose value range the transfer function leaves transparent are marked empty unscanned
+        VisibleValues visibleValues = (dimension == 1) ? VisibleValues(alpha) : VisibleValues(alpha2_5D, 256);
+        if (ratioOfVisibilityTest) {
+            if (dimension == 1) {
+                for (int i = 0; i < numberOfBricks; i++)
+                    bricks[i].setRatioOfVisibility(alpha, minimumChanged, maximumChanged, visibleValues);
+            } else {
+                for (int i = 0; i < numberOfBricks; i++)
+                    bricks[i].setRatioOfVisibility2_5D(alpha2_5D, visibleValues);
+            }
+        } else if (maximumPriorityQueueTest) {
+            if (dimension == 1) {
+                for (int i = 0; i < numberOfBricks; i++)
+                    bricks[i].setPercentageOfEmptyVolume(alpha, minimumChanged, maximumChanged, visibleValues);
+            } else {
+                for (int i = 0; i < numberOfBricks; i++)
+                    bricks[i].setPercentageOfEmptyVolume2_5D(alpha2_5D, visibleValues);
+            }
+        } else if (renderingCostFunctionTest) {
+            if (dimension == 1) {
+                for (int i = 0; i < numberOfBricks; i++)
+                    bricks[i].setRenderingCostFunction(alpha, minimumChanged, maximumChanged, visibleValues);
+            } else {
+                for (int i = 0; i < numberOfBricks; i++)
+                    bricks[i].setRenderingCostFunction2_5D(alpha2_5D, visibleValues);
+            }
+        }
+        if (atlas != NULL && minimumChanged <= maximumChanged) {
+            bool nonPowerOfTwo;
+            int maximumSize;
+            getTextureLimits(nonPowerOfTwo, maximumSize);
+            atlas->setTextureLimits(nonPowerOfTwo, maximumSize);
+            atlas->repack(bricks, numberOfBricks);
+        }
+    }
+    if (atlas != NULL)
+        atlas->update();
+
+    if (rgbChanged) {
+        if (ratioOfVisibilityTest) {
+            for (int i = 0; i < numberOfBricks; i++)
+                bricks[i].setRatioOfVisibility(red, green, blue);
+        } else if (maximumPriorityQueueTest) {
+            for (int i = 0; i < numberOfBricks; i++)
+                bricks[i].setPercentageOfEmptyVolume(red, green, blue);
+        } else if (renderingCostFunctionTest) {
+            for (int i = 0; i < numberOfBricks; i++)
+                bricks[i].setRenderingCostFunction(red, green, blue);
+        }
+    }
+
+    if (colorMapChanged) {
+        for (int i = 0; i < 256; i++) {
+            colormap1D[4 * i + RED] = colormap[4 * (i * 256 + i) + RED];
+            colormap1D[4 * i + GREEN] = colormap[4 * (i * 256 + i) + GREEN];
+            colormap1D[4 * i + BLUE] = colormap[4 * (i * 256 + i) + BLUE];
+            colormap1D[4 * i + ALPHA] = colormap[4 * (i * 256 + i) + ALPHA];
+        }
+        colorMapVersion++;
+    }
+
+    if (sliceColorMapChanged) {
+        for (int i = 0; i < 256; i++) {
+            sliceColormap1D[4 * i + RED] = sliceColormap[4 * (i * 256 + i) + RED];
+            sliceColormap1D[4 * i + GREEN] = sliceColormap[4 * (i * 256 + i) + GREEN];
+            sliceColormap1D[4 * i + BLUE] = sliceColormap[4 * (i * 256 + i) + BLUE];
+            sliceColormap1D[4 * i + ALPHA] = sliceColormap[4 * (i * 256 + i) + ALPHA];
+        }
+        sliceColorMapVersion++;
+    }
+
+    // Bake the lit colors while the lighting and the transfer function stay the same
+    illuminated = false;
+    unsigned int features = getShadingFeatures() & ~GRADIENT_TEXTURE;
+    illuminationRequested = illuminationCache != NULL && lighting && !preintegrated && !focusAndContext && features != 0;
+    if (illuminationRequested) {
+        IlluminationCache::Parameters parameters;
+        for (int i = 0; i < 3; i++) {
+            parameters.ambientColor[i] = ambientColor[i];
+            parameters.diffuseColor[i] = diffuseColor[i];
+            parameters.specularColor[i] = specularColor[i];
+            parameters.kAmbient[i] = kAmbient[i];
+            parameters.kDiffuse[i] = kDiffuse[i];
+            parameters.kSpecular[i] = kSpecular[i];
+            parameters.coolColor[i] = coolColor[i];
+            parameters.warmColor[i] = warmColor[i];
+            parameters.toonColor[i] = toonColor[i];
+            parameters.lightPosition[i] = lightPosition[i];
+        } // end for
+        parameters.shininess = shininess;
+        parameters.normalContribution = normalContribution;
+        parameters.toneContribution = toneContribution;
+        parameters.toonContribution = toonContribution;
+        parameters.boundaryContribution = boundaryContribution;
+        parameters.boundaryExponent = boundaryExponent;
+        parameters.silhouetteContribution = silhouetteContribution;
+        parameters.silhouetteExponent = silhouetteExponent;
+        parameters.edgeContribution = edgeContribution;
+        parameters.edgeExponent = edgeExponent;
+        parameters.edgeThreshold = edgeThreshold;
+        parameters.dimension = dimension;
+        parameters.features = features;
+        parameters.colorMapVersion = colorMapVersion;
+        illuminationCache->request(parameters, framePoint, colormap);
+        illuminationCache->update();
+        // Interactive frames keep drawing the down sampled bricks with the lit shaders
+        illuminated = !interactive && illuminationCache->isCurrent();
+    }
+    if (benchmark != NULL) {
+        timer.elapse();
+        benchmark->addClassificationTime(timer.getTime());
+    }
+
+    // Refine once after every reclassification of this frame
+    if (maximumPriorityQueueSizeChanged || (maximumPriorityQueueTest && (alphaChanged || rgbChanged || isRefinementStale(
+            framePoint)))) {
+        determineOcNodesToDisplay(framePoint);
+        if (benchmark != NULL) {
+            timer.elapse();
+            benchmark->addTraversalTime(timer.getTime());
+        }
+    }
+} // end frame()
+
 /*
  * setAmbientColor
  *
@@ -585,6 +1123,15 @@ void Scene::setAlphaChanged(bool _alphaChanged) {
     alphaChanged = _alphaChanged;
 } // end setAlphaChanged()
 
+/*
+ * setBenchmark - Record the frame timings and counts of a fly-through.
+ *
+ * parameter _benchmark - Benchmark*
+ */
+void Scene::setBenchmark(Benchmark* _benchmark) {
+    benchmark = _benchmark;
+} // end setBenchmark()
+
 /*
  * setBlueScale
  *
@@ -621,6 +1168,15 @@ void Scene::setColorMapChanged(bool _colorMapChanged) {
     colorMapChanged = _colorMapChanged;
 } // end setColorMapChanged()
 
+/*
+ * setCompositor - Composite this node's slabs with the other render nodes; call before initialize()
+ *
+ * parameter _compositor - Compositor*
+ */
+void Scene::setCompositor(Compositor* _compositor) {
+    compositor = _compositor;
+} // end setCompositor()
+
 /*
  * setCoolColor
  *
@@ -665,6 +1221,7 @@ int Scene::getDimension(void) const {
  */
 void Scene::setDimension(int dimension) {
     this->dimension = dimension;
+    invalidateClassification();
 } // end setDimension()
 
 /*
@@ -713,6 +1270,27 @@ void Scene::setGreenScale(float _greenScale) {
     greenScale = _greenScale;
 } // end setGreenScale()
 
+/*
+ * getImportance - Get the importance of refining an octree node for the eye at point.
+ *
+ * parameter ocNode - OcNode*
+ * parameter point - const float*
+ * parameter numberOfVoxels - float (in the whole volume)
+ * return - float
+ */
+float Scene::getImportance(OcNode* ocNode, const float* point, float numberOfVoxels) const {
+    float* center = ocNode->getVolumeSphere()->getCenter();
+    float radius = ocNode->getVolumeSphere()->getRadius();
+    float distance = 0.0f;
+    for (int i = 0; i < 3; i++)
+        distance += (point[i] - center[i]) * (point[i] - center[i]);
+    float projectedSize = (distance > radius * radius) ? (radius * radius) / distance : 1.0f;
+    float numberOfOcNodeVoxels = float(ocNode->getWidth()) * float(ocNode->getHeight()) * float(ocNode->getDepth());
+    float visibility = ocNode->getRatioOfVisibility() / numberOfOcNodeVoxels;
+    float emptiness = ocNode->getPercentageOfEmptyVolume() * numberOfVoxels / numberOfOcNodeVoxels;
+    return projectedSize * visibility * emptiness;
+} // end getImportance()
+
 /*
  * getInteractive
  *
@@ -809,8 +1387,7 @@ void Scene::setLightPosition(float xLightPosition, float yLightPosition, float z
  * parameter _maximumPriorityQueueSize - int
  */
 void Scene::setMaximumPriorityQueueSize(int _maximumPriorityQueueSize) {
-    for (int i = 0; i < numberOfBricks; i++)
-        bricks[i].setMaximumPriorityQueueSize(_maximumPriorityQueueSize);
+    maximumPriorityQueueSize = _maximumPriorityQueueSize;
 } // end setMaximumPriorityQueueSize()
 
 /*
@@ -829,6 +1406,7 @@ void Scene::setMaximumPriorityQueueSizeChanged(bool _maximumPriorityQueueSizeCha
  */
 void Scene::setMaximumPriorityQueueTest(bool _maximumPriorityQueueTest) {
     maximumPriorityQueueTest = _maximumPriorityQueueTest;
+    invalidateClassification();
     for (int i = 0; i < numberOfBricks; i++)
         bricks[i].setMaximumPriorityQueueTest(_maximumPriorityQueueTest);
 } // end setMaximumPriorityQueueTest()
@@ -842,6 +1420,15 @@ void Scene::setNormalContribution(float normalContribution) {
     this->normalContribution = normalContribution;
 } // end setNormalContribution()
 
+/*
+ * getNumberOfBricks - The bricks of the partition, 0 before the volume is partitioned.
+ *
+ * return - int
+ */
+int Scene::getNumberOfBricks(void) const {
+    return numberOfBricks;
+} // end getNumberOfBricks()
+
 /*
  * setPerspective
  *
@@ -896,6 +1483,7 @@ void Scene::setPlaneOffset(float planeOffset) {
  */
 void Scene::setRatioOfVisibilityTest(bool _ratioOfVisibilityTest) {
     ratioOfVisibilityTest = _ratioOfVisibilityTest;
+    invalidateClassification();
     for (int i = 0; i < numberOfBricks; i++)
         bricks[i].setRatioOfVisibilityTest(_ratioOfVisibilityTest);
 } // end setRatioOfVisibilityTest()
@@ -925,6 +1513,7 @@ void Scene::setRedScale(float _redScale) {
  * parameter _renderingCost - float
  */
 void Scene::setRenderingCost(float _renderingCost) {
+    invalidateClassification();
     for (int i = 0; i < numberOfBricks; i++)
         bricks[i].setRenderingCost(_renderingCost);
 } // end setRenderingCost()
@@ -936,6 +1525,7 @@ void Scene::setRenderingCost(float _renderingCost) {
  */
 void Scene::setRenderingCostFunctionTest(bool _renderingCostFunctionTest) {
     renderingCostFunctionTest = _renderingCostFunctionTest;
+    invalidateClassification();
     for (int i = 0; i < numberOfBricks; i++)
         bricks[i].setRenderingCostFunctionTest(_renderingCostFunctionTest);
 } // end setRenderingCostFunctionTest()
@@ -1210,6 +1800,45 @@ void Scene::setZStep(int zStep) {
         bricks[i].setZStep(zStep);
 } // end setZStep()
 
+/*
+ * getShadingFeatures - The shading terms that contribute, one bit each as in ShaderVariants.h.
+ *
+ * Lit variants also read the gradient texture when the bricks carry one.
+ *
+ * return - unsigned int
+ */
+unsigned int Scene::getShadingFeatures(void) const {
+    unsigned int features = 0;
+    if (normalContribution > 0.0)
+        features |= NORMAL_SHADING;
+    if (toneContribution > 0.0)
+        features |= TONE_SHADING;
+    if (toonContribution > 0.0)
+        features |= TOON_SHADING;
+    if (boundaryContribution > 0.0)
+        features |= BOUNDARY_SHADING;
+    if (silhouetteContribution > 0.0)
+        features |= SILHOUETTE_SHADING;
+    if (edgeContribution > 0.0)
+        features |= EDGE_SHADING;
+    if (features != 0 && volume->isGradientTexture())
+        features |= GRADIENT_TEXTURE;
+    return features;
+} // end getShadingFeatures()
+
+/*
+ * getTextureLimits - The texture limits met by every GL context initialized so far.
+ *
+ * parameter _textureNonPowerOfTwo - bool &
+ * parameter _maximum3DTextureSize - int & (0 before the first context)
+ */
+void Scene::getTextureLimits(bool & _textureNonPowerOfTwo, int & _maximum3DTextureSize) const {
+    pthread_mutex_lock(&textureLimitsMutex);
+    _textureNonPowerOfTwo = textureNonPowerOfTwo;
+    _maximum3DTextureSize = maximum3DTextureSize;
+    pthread_mutex_unlock(&textureLimitsMutex);
+} // end getTextureLimits()
+
 /*
  * initContext
  *
@@ -1218,13 +1847,41 @@ void Scene::setZStep(int zStep) {
 void Scene::initContext(GLContextData& glContextData) const {
     DataItem* dataItem = new DataItem();
     glContextData.addDataItem(this, dataItem);
+    // Counted here, as windows sharing a context upload the bricks only once
+    stagingCache->addUse();
     dataItem->textureNonPowerOfTwo = GLARBTextureNonPowerOfTwo::isSupported();
-    if (dataItem->textureNonPowerOfTwo) {
+    if (dataItem->textureNonPowerOfTwo)
         GLARBTextureNonPowerOfTwo::initExtension();
-    } else {
-        volume->resize();
-    }
     glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &dataItem->maximum3DTextureSize);
+    pthread_mutex_lock(&textureLimitsMutex);
+    // The bricks pad their textures to power of two sizes; see createBricks()
+    if (!dataItem->textureNonPowerOfTwo)
+        textureNonPowerOfTwo = false;
+    if (maximum3DTextureSize == 0 || dataItem->maximum3DTextureSize < maximum3DTextureSize)
+        maximum3DTextureSize = dataItem->maximum3DTextureSize;
+    pthread_mutex_unlock(&textureLimitsMutex);
+    if (compositor != NULL) {
+        if (!GLExtensionManager::isExtensionSupported("GL_EXT_framebuffer_object")) {
+            std::cout << "Error: GL_EXT_framebuffer_object is required for compositing" << std::endl;
+            exit(-1);
+        }
+        dataItem->glBindFramebufferEXTProc = GLExtensionManager::getFunction<PFNGLBINDFRAMEBUFFEREXTPROC> ("glBindFramebufferEXT");
+        dataItem->glBindRenderbufferEXTProc = GLExtensionManager::getFunction<PFNGLBINDRENDERBUFFEREXTPROC> ("glBindRenderbufferEXT");
+        dataItem->glBlendFuncSeparateProc = GLExtensionManager::getFunction<PFNGLBLENDFUNCSEPARATEPROC> ("glBlendFuncSeparate");
+        dataItem->glDeleteFramebuffersEXTProc = GLExtensionManager::getFunction<PFNGLDELETEFRAMEBUFFERSEXTPROC> (
+                "glDeleteFramebuffersEXT");
+        dataItem->glDeleteRenderbuffersEXTProc = GLExtensionManager::getFunction<PFNGLDELETERENDERBUFFERSEXTPROC> (
+                "glDeleteRenderbuffersEXT");
+        dataItem->glFramebufferRenderbufferEXTProc = GLExtensionManager::getFunction<PFNGLFRAMEBUFFERRENDERBUFFEREXTPROC> (
+                "glFramebufferRenderbufferEXT");
+        dataItem->glGenFramebuffersEXTProc = GLExtensionManager::getFunction<PFNGLGENFRAMEBUFFERSEXTPROC> ("glGenFramebuffersEXT");
+        dataItem->glGenRenderbuffersEXTProc = GLExtensionManager::getFunction<PFNGLGENRENDERBUFFERSEXTPROC> ("glGenRenderbuffersEXT");
+        dataItem->glRenderbufferStorageEXTProc = GLExtensionManager::getFunction<PFNGLRENDERBUFFERSTORAGEEXTPROC> (
+                "glRenderbufferStorageEXT");
+        dataItem->glGenFramebuffersEXTProc(1, &dataItem->framebufferName);
+        dataItem->glGenRenderbuffersEXTProc(1, &dataItem->colorbufferName);
+        dataItem->glGenRenderbuffersEXTProc(1, &dataItem->depthbufferName);
+    }
     dataItem->shaderManager = new ShaderManager();
     if (!dataItem->shaderManager->initializeGLSL()) {
         std::cout << "Error: Can't initialize GLSL" << std::endl;
@@ -1234,21 +1891,28 @@ void Scene::initContext(GLContextData& glContextData) const {
         dataItem->volumeShaderObject2D = dataItem->shaderManager->loadFromMemory(GPUVertexShader, multiComponentFragmentShader);
         dataItem->preIntegratedVolumeShaderObject = dataItem->shaderManager->loadFromMemory(preIntegratedGPUVertexShader,
                 preIntegratedMultiComponentFragmentShader);
-        dataItem->volumeShaderObjectWithLighting = dataItem->shaderManager->loadFromMemory(GPUVertexShaderWithLighting,
+        dataItem->volumeShaderVariantsWithLighting = new ShaderVariants(dataItem->shaderManager, GPUVertexShaderWithLighting,
                 multiComponentFragmentShaderWithLighting);
-        dataItem->preIntegratedVolumeShaderObjectWithLighting = dataItem->shaderManager->loadFromMemory(
+        dataItem->preIntegratedVolumeShaderVariantsWithLighting = new ShaderVariants(dataItem->shaderManager,
                 preIntegratedGPUVertexShaderWithLighting, preIntegratedMultiComponentFragmentShaderWithLighting);
     } else {
         dataItem->volumeShaderObjectFocusAndContext = dataItem->shaderManager->loadFromMemory(GPUVertexShaderWithLighting, focusAndContextFragmentShader);
         dataItem->volumeShaderObject = dataItem->shaderManager->loadFromMemory(GPUVertexShader, fragmentShader);
-        dataItem->volumeShaderObject2D = dataItem->shaderManager->loadFromMemory(GPUVertexShader, fragmentShader2D);
-        dataItem->volumeShaderObject2DWithLighting = dataItem->shaderManager->loadFromMemory(GPUVertexShaderWithLighting,
+        if (volume->isIlluminationCache())
+            dataItem->illuminatedVolumeShaderObject = dataItem->shaderManager->loadFromMemory(GPUVertexShader,
+                    illuminatedFragmentShader);
+        if (volume->isGradientTexture()) {
+            std::string fragmentShader2DSource = ShaderVariants::getDefines(GRADIENT_TEXTURE) + fragmentShader2D;
+            dataItem->volumeShaderObject2D = dataItem->shaderManager->loadFromMemory(GPUVertexShader, fragmentShader2DSource.c_str());
+        } else
+            dataItem->volumeShaderObject2D = dataItem->shaderManager->loadFromMemory(GPUVertexShader, fragmentShader2D);
+        dataItem->volumeShaderVariants2DWithLighting = new ShaderVariants(dataItem->shaderManager, GPUVertexShaderWithLighting,
                 fragmentShader2DWithLighting);
-        dataItem->volumeShaderObjectWithLighting = dataItem->shaderManager->loadFromMemory(GPUVertexShaderWithLighting,
+        dataItem->volumeShaderVariantsWithLighting = new ShaderVariants(dataItem->shaderManager, GPUVertexShaderWithLighting,
                 fragmentShaderWithLighting);
         dataItem->preIntegratedVolumeShaderObject = dataItem->shaderManager->loadFromMemory(preIntegratedGPUVertexShader,
                 preIntegratedFragmentShader);
-        dataItem->preIntegratedVolumeShaderObjectWithLighting = dataItem->shaderManager->loadFromMemory(
+        dataItem->preIntegratedVolumeShaderVariantsWithLighting = new ShaderVariants(dataItem->shaderManager,
                 preIntegratedGPUVertexShaderWithLighting, preIntegratedFragmentShaderWithLighting);
     }
     if (volume->getNumberOfComponents() != 0) {
@@ -1274,10 +1938,12 @@ void Scene::initContext(GLContextData& glContextData) const {
 } // end initContext()
 
 /*
- * initialize
+ * initialize - Partition the volume, create the bricks and build their octrees.
  */
 void Scene::initialize(void) {
+    partitionBricks();
     createBricks();
+    createOcTrees();
 } // end initialize()
 
 /*
@@ -1351,6 +2017,180 @@ void Scene::initialize1DSliceColorMap(DataItem* dataItem) const {
     delete[] texels;
 } // end initialize1DSliceColorMap()
 
+/*
+ * invalidateClassification - Reclassify every octree node on the next alpha change.
+ */
+void Scene::invalidateClassification(void) {
+    for (int i = 0; i < 256; i++)
+        classifiedAlpha[i] = -1.0f;
+} // end invalidateClassification()
+
+/*
+ * isInSameBrick - Both points lie in the same brick of the grid, clamped to the grid, so the bricks sort alike for them.
+ *
+ * Adaptive bricks sort alike for points on the same side of every split plane of their tree.
+ *
+ * parameter point - const float*
+ * parameter otherPoint - const float*
+ * return - bool
+ */
+bool Scene::isInSameBrick(const float* point, const float* otherPoint) const {
+    if (brickTree != NULL)
+        return brickTree->isSameOrder(point, otherPoint);
+    int index[3];
+    int otherIndex[3];
+    locateBrick(point, index);
+    locateBrick(otherPoint, otherIndex);
+    return index[0] == otherIndex[0] && index[1] == otherIndex[1] && index[2] == otherIndex[2];
+} // end isInSameBrick()
+
+/*
+ * isRefinementStale - The eye moved by more than REFINEMENT_TOLERANCE of its distance to the volume since the last refinement.
+ *
+ * parameter point - const float*
+ * return - bool
+ */
+bool Scene::isRefinementStale(const float* point) const {
+    float moved = 0.0f;
+    float distance = 0.0f;
+    for (int i = 0; i < 3; i++) {
+        moved += (point[i] - refinementPoint[i]) * (point[i] - refinementPoint[i]);
+        distance += (point[i] - volume->getCenter(i)) * (point[i] - volume->getCenter(i));
+    } // end for
+    return moved > REFINEMENT_TOLERANCE * REFINEMENT_TOLERANCE * distance;
+} // end isRefinementStale()
+
+/*
+ * locateBrick - Find the column, row and slab of the brick holding point, clamped to the brick grid.
+ *
+ * parameter point - const float*
+ * parameter index - int*
+ */
+void Scene::locateBrick(const float* point, int* index) const {
+    int bricksPerSlab = numberOfBrickColumns * numberOfBrickRows;
+    index[0] = 0;
+    for (int i = 1; i < numberOfBrickColumns; i++) {
+        if (point[0] >= bricks[i].getVolumeBox()->getX(0))
+            index[0] = i;
+    }
+    index[1] = 0;
+    for (int j = 1; j < numberOfBrickRows; j++) {
+        if (point[1] >= bricks[j * numberOfBrickColumns].getVolumeBox()->getY(0))
+            index[1] = j;
+    }
+    index[2] = 0;
+    for (int k = 1; k < numberOfBrickSlabs; k++) {
+        if (point[2] >= bricks[k * bricksPerSlab].getVolumeBox()->getZ(0))
+            index[2] = k;
+    }
+} // end locateBrick()
+
+/*
+ * partitionAdaptiveBricks - Partition the occupied voxels into brick boxes with a kd-tree.
+ *
+ * Every brick fits into a texture of the texture size and, with its border, into the
+ * GL_MAX_3D_TEXTURE_SIZE of every context. When compositing, the bricks are kept apart in one
+ * slab along z per render node.
+ */
+void Scene::partitionAdaptiveBricks(void) {
+    bool nonPowerOfTwo;
+    int maximumSize;
+    getTextureLimits(nonPowerOfTwo, maximumSize);
+    int maximumBrickSize = volume->getTextureSize();
+    if (maximumSize > 2 && maximumSize - 2 < maximumBrickSize)
+        maximumBrickSize = maximumSize - 2;
+    int numberOfPartitions = (compositor != NULL) ? compositor->getNumberOfNodes() : 1;
+    brickTree = new BrickTree(volume, maximumBrickSize, numberOfPartitions);
+    numberOfBricks = brickTree->getNumberOfBricks();
+    numberOfBrickColumns = 0;
+    numberOfBrickRows = 0;
+    numberOfBrickSlabs = 0;
+    brickBoxes.clear();
+    double numberOfBrickVoxels = 0.0;
+    for (int i = 0; i < numberOfBricks; i++) {
+        const int* box = brickTree->getBrick(i);
+        brickBoxes.insert(brickBoxes.end(), box, box + 6);
+        numberOfBrickVoxels += double(box[3]) * double(box[4]) * double(box[5]);
+    } // end for
+    if (Vrui::getNodeIndex() == 0)
+        std::cout << "Adaptive bricks: " << numberOfBricks << " bricks of at most " << maximumBrickSize << " voxels cover "
+                << 100.0 * numberOfBrickVoxels / (double(volume->getWidth()) * double(volume->getHeight())
+                        * double(volume->getDepth())) << "% of the volume around background value "
+                << int(brickTree->getBackground()) << std::endl;
+} // end partitionAdaptiveBricks()
+
+/*
+ * partitionBricks - Partition the volume into brick boxes.
+ *
+ * Touches neither GL nor the bricks, so it may run on a background thread.
+ */
+void Scene::partitionBricks(void) {
+    // Scalar volumes may skip their empty space; the other volumes get a regular grid
+    if (volume->isAdaptiveBricks() && volume->getNumberOfComponents() == 0)
+        partitionAdaptiveBricks();
+    // A volume of nothing but background leaves the kd-tree without bricks; the scene needs at least one
+    if (numberOfBricks == 0) {
+        delete brickTree;
+        brickTree = NULL;
+        partitionRegularBricks();
+    } // end if
+} // end partitionBricks()
+
+/*
+ * partitionRegularBricks - Slice the volume into a regular grid of brick boxes of about the texture size.
+ */
+void Scene::partitionRegularBricks(void) {
+    int numberOfColumns = volume->getWidth() / volume->getTextureSize();
+    if (volume->getWidth() % volume->getTextureSize() != 0)
+        numberOfColumns++;
+    int width = volume->getWidth() / numberOfColumns;
+    int numberOfRows = volume->getHeight() / volume->getTextureSize();
+    if (volume->getHeight() % volume->getTextureSize() != 0)
+        numberOfRows++;
+    int height = volume->getHeight() / numberOfRows;
+    int numberOfSlabs = volume->getDepth() / volume->getTextureSize();
+    if (volume->getDepth() % volume->getTextureSize() != 0)
+        numberOfSlabs++;
+    int depth = volume->getDepth() / numberOfSlabs;
+    numberOfBricks = numberOfColumns * numberOfRows * numberOfSlabs;
+    numberOfBrickColumns = numberOfColumns;
+    numberOfBrickRows = numberOfRows;
+    numberOfBrickSlabs = numberOfSlabs;
+    brickBoxes.clear();
+    int slabRemainder = volume->getDepth() % numberOfSlabs;
+    int _slab = 0;
+    for (int k = 0; k < numberOfSlabs; k++) {
+        int rowRemainder = volume->getHeight() % numberOfRows;
+        int _depth = depth;
+        if (slabRemainder > 0) {
+            _depth++;
+            slabRemainder--;
+        }
+        int _row = 0;
+        for (int j = 0; j < numberOfRows; j++) {
+            int columnRemainder = volume->getWidth() % numberOfColumns;
+            int _height = height;
+            if (rowRemainder > 0) {
+                _height++;
+                rowRemainder--;
+            }
+            int _column = 0;
+            for (int i = 0; i < numberOfColumns; i++) {
+                int _width = width;
+                if (columnRemainder > 0) {
+                    _width++;
+                    columnRemainder--;
+                }
+                int box[6] = { _column, _row, _slab, _width, _height, _depth };
+                brickBoxes.insert(brickBoxes.end(), box, box + 6);
+                _column += _width;
+            }
+            _row += _height;
+        }
+        _slab += _depth;
+    }
+} // end partitionRegularBricks()
+
 /*
  * popGLState - Restore GL State
  *
@@ -1370,34 +2210,93 @@ void Scene::pushGLState(GLContextData& glContextData) const {
 } // end pushGLState()
 
 /*
- * sortBricks
+ * sendLightingUniforms - Send the lighting uniforms of the shading terms compiled into a variant.
+ *
+ * The shaders light in model coordinates, like the illumination cache bakes.
+ *
+ * parameter shaderObject - ShaderObject*
+ * parameter features - unsigned int
+ * parameter point - float * (eye in model coordinates)
+ */
+void Scene::sendLightingUniforms(ShaderObject* shaderObject, unsigned int features, float * point) const {
+    if (features & GRADIENT_TEXTURE)
+        shaderObject->sendUniform1i("gradientVolume", 2);
+    // The compiler drops the positions from variants whose terms do not read them
+    if (features & VIEW_SHADING)
+        shaderObject->sendUniform4f("eyePosition", GLfloat(point[0]), GLfloat(point[1]), GLfloat(point[2]), GLfloat(1.0f));
+    if (features & LIGHT_SHADING)
+        shaderObject->sendUniform4f("lightPosition", GLfloat(lightPosition[0]), GLfloat(lightPosition[1]),
+                GLfloat(lightPosition[2]), GLfloat(1.0f));
+    if (features & NORMAL_SHADING) {
+        shaderObject->sendUniform3f("ambientColor", GLfloat(ambientColor[0]), GLfloat(ambientColor[1]), GLfloat(ambientColor[2]));
+        shaderObject->sendUniform3f("diffuseColor", GLfloat(diffuseColor[0]), GLfloat(diffuseColor[1]), GLfloat(diffuseColor[2]));
+        shaderObject->sendUniform3f("specularColor", GLfloat(specularColor[0]), GLfloat(specularColor[1]), GLfloat(specularColor[2]));
+        shaderObject->sendUniform3f("kAmbient", GLfloat(kAmbient[0]), GLfloat(kAmbient[1]), GLfloat(kAmbient[2]));
+        shaderObject->sendUniform3f("kDiffuse", GLfloat(kDiffuse[0]), GLfloat(kDiffuse[1]), GLfloat(kDiffuse[2]));
+        shaderObject->sendUniform3f("kSpecular", GLfloat(kSpecular[0]), GLfloat(kSpecular[1]), GLfloat(kSpecular[2]));
+        shaderObject->sendUniform1f("shininess", GLfloat(shininess));
+        shaderObject->sendUniform1f("normalContribution", GLfloat(normalContribution));
+    }
+    if (features & TONE_SHADING) {
+        shaderObject->sendUniform1f("toneContribution", GLfloat(toneContribution));
+        shaderObject->sendUniform3f("coolColor", GLfloat(coolColor[0]), GLfloat(coolColor[1]), GLfloat(coolColor[2]));
+        shaderObject->sendUniform3f("warmColor", GLfloat(warmColor[0]), GLfloat(warmColor[1]), GLfloat(warmColor[2]));
+    }
+    if (features & TOON_SHADING) {
+        shaderObject->sendUniform1f("toonContribution", GLfloat(toonContribution));
+        shaderObject->sendUniform3f("toonColor", GLfloat(toonColor[0]), GLfloat(toonColor[1]), GLfloat(toonColor[2]));
+    }
+    if (features & BOUNDARY_SHADING) {
+        shaderObject->sendUniform1f("boundaryContribution", GLfloat(boundaryContribution));
+        shaderObject->sendUniform1f("boundaryExponent", GLfloat(boundaryExponent));
+    }
+    if (features & SILHOUETTE_SHADING) {
+        shaderObject->sendUniform1f("silhouetteContribution", GLfloat(silhouetteContribution));
+        shaderObject->sendUniform1f("silhouetteExponent", GLfloat(silhouetteExponent));
+    }
+    if (features & EDGE_SHADING) {
+        shaderObject->sendUniform1f("edgeContribution", GLfloat(edgeContribution));
+        shaderObject->sendUniform1f("edgeExponent", GLfloat(edgeExponent));
+        shaderObject->sendUniform1f("edgeThreshold", GLfloat(edgeThreshold));
+    }
+} // end sendLightingUniforms()
+
+/*
+ * sortBricks - Order the bricks back to front for the eye at point.
+ *
+ * The bricks form a regular grid. A ray from the eye moves one brick further from the column,
+ * row and slab of the eye brick at every brick face it crosses, so the bricks ordered by
+ * decreasing grid distance to the eye brick (clamped to the grid) are back to front. A
+ * counting sort on that distance replaces sorting by box distances. Adaptive bricks are
+ * ordered by their kd-tree instead.
  *
  * parameter point - float *
  * parameter brickList - std::vector<ComparableBrick> &
  */
 void Scene::sortBricks(float * point, std::vector<ComparableBrick> & brickList) const {
-    // Calculate minimum distance from head position to brick feature
-    ComparableBrick comparableBrick;
-    comparableBrick.maximum(); // set static variable greater to perform a maximum sort
-    int i;
-    for (i = 0; i < numberOfBricks; i++) {
-        brickList[i] = ComparableBrick(i, bricks[i].getVolumeBox()->getMinimumDistance(point));
+    if (brickTree != NULL) {
+        brickTree->sortBricks(point, brickList);
+        return;
+    } // end if
+    int bricksPerSlab = numberOfBrickColumns * numberOfBrickRows;
+    int index[3];
+    locateBrick(point, index);
+    int eyeColumn = index[0];
+    int eyeRow = index[1];
+    int eyeSlab = index[2];
+    int maximumDistance = numberOfBrickColumns + numberOfBrickRows + numberOfBrickSlabs - 3;
+    std::vector<int> first(maximumDistance + 2, 0);
+    for (int which = 0; which < numberOfBricks; which++) {
+        int distance = abs(which % numberOfBrickColumns - eyeColumn) + abs((which % bricksPerSlab) / numberOfBrickColumns
+                - eyeRow) + abs(which / bricksPerSlab - eyeSlab);
+        first[maximumDistance - distance + 1]++;
     }
-    std::sort(brickList.begin(), brickList.end());
-    // Handle ties in smallest keys (drawn last)
-    i = 2;
-    if (numberOfBricks > 1) {
-        while (i <= numberOfBricks & brickList[numberOfBricks - i].getValue() == brickList[numberOfBricks - 1].getValue()) {
-            if (bricks[brickList[numberOfBricks - i].getWhich()].getVolumeBox()->collision(point)) { // if head position inside bounding box
-                float distance = brickList[numberOfBricks - 1].getValue();
-                int which = brickList[numberOfBricks - 1].getWhich();
-                brickList[numberOfBricks - 1].setValue(brickList[numberOfBricks - i].getValue());
-                brickList[numberOfBricks - 1].setWhich(brickList[numberOfBricks - i].getWhich());
-                brickList[numberOfBricks - i].setValue(distance);
-                brickList[numberOfBricks - i].setWhich(which);
-            }
-            i++;
-        }
+    for (int i = 1; i <= maximumDistance + 1; i++)
+        first[i] += first[i - 1];
+    for (int which = 0; which < numberOfBricks; which++) {
+        int distance = abs(which % numberOfBrickColumns - eyeColumn) + abs((which % bricksPerSlab) / numberOfBrickColumns
+                - eyeRow) + abs(which / bricksPerSlab - eyeSlab);
+        brickList[first[maximumDistance - distance]++] = ComparableBrick(which, float(distance));
     }
 } // end sortBricks()
 
@@ -1416,21 +2315,11 @@ std::string Scene::toString(void) {
  * parameter dataItem - DataItem*
  */
 void Scene::update1DColorMap(DataItem* dataItem) const {
-    if (colorMapChanged) {
-        unsigned char * texels = new unsigned char[256 * 4];
-        for (int i = 0; i < 256; i++) {
-            texels[4 * i + RED] = colormap[4 * (i * 256 + i) + RED];
-            texels[4 * i + GREEN] = colormap[4 * (i * 256 + i) + GREEN];
-            texels[4 * i + BLUE] = colormap[4 * (i * 256 + i) + BLUE];
-            texels[4 * i + ALPHA] = colormap[4 * (i * 256 + i) + ALPHA];
-        }
-        glEnable(GL_TEXTURE_1D);
-        glBindTexture(GL_TEXTURE_1D, dataItem->colormap1DName);
-        glTexSubImage1D(GL_TEXTURE_1D, 0, 0, 256, GL_RGBA, GL_UNSIGNED_BYTE, texels);
-        glBindTexture(GL_TEXTURE_1D, 0);
-        glDisable(GL_TEXTURE_1D);
-        delete[] texels;
-    }
+    glEnable(GL_TEXTURE_1D);
+    glBindTexture(GL_TEXTURE_1D, dataItem->colormap1DName);
+    glTexSubImage1D(GL_TEXTURE_1D, 0, 0, 256, GL_RGBA, GL_UNSIGNED_BYTE, colormap1D);
+    glBindTexture(GL_TEXTURE_1D, 0);
+    glDisable(GL_TEXTURE_1D);
 } // end update1DColorMap()
 
 /*
@@ -1439,13 +2328,11 @@ void Scene::update1DColorMap(DataItem* dataItem) const {
  * parameter dataItem - DataItem*
  */
 void Scene::update2DColorMap(DataItem* dataItem) const {
-    if (colorMapChanged) {
-        glEnable(GL_TEXTURE_2D);
-        glBindTexture(GL_TEXTURE_2D, dataItem->colormap2DName);
-        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 256, 256, GL_RGBA, GL_UNSIGNED_BYTE, colormap);
-        glBindTexture(GL_TEXTURE_2D, 0);
-        glDisable(GL_TEXTURE_2D);
-    }
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, dataItem->colormap2DName);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 256, 256, GL_RGBA, GL_UNSIGNED_BYTE, colormap);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDisable(GL_TEXTURE_2D);
 } // end update2DColorMap()
 
 /*
@@ -1454,23 +2341,47 @@ void Scene::update2DColorMap(DataItem* dataItem) const {
  * parameter dataItem - DataItem*
  */
 void Scene::update1DSliceColorMap(DataItem* dataItem) const {
-    if (sliceColorMapChanged) {
-        unsigned char * texels = new unsigned char[256 * 4];
-        for (int i = 0; i < 256; i++) {
-            texels[4 * i + RED] = sliceColormap[4 * (i * 256 + i) + RED];
-            texels[4 * i + GREEN] = sliceColormap[4 * (i * 256 + i) + GREEN];
-            texels[4 * i + BLUE] = sliceColormap[4 * (i * 256 + i) + BLUE];
-            texels[4 * i + ALPHA] = sliceColormap[4 * (i * 256 + i) + ALPHA];
-        }
-        glEnable(GL_TEXTURE_1D);
-        glBindTexture(GL_TEXTURE_1D, dataItem->sliceColormap1DName);
-        glTexSubImage1D(GL_TEXTURE_1D, 0, 0, 256, GL_RGBA, GL_UNSIGNED_BYTE, texels);
-        glBindTexture(GL_TEXTURE_1D, 0);
-        glDisable(GL_TEXTURE_1D);
-        delete[] texels;
-    }
+    glEnable(GL_TEXTURE_1D);
+    glBindTexture(GL_TEXTURE_1D, dataItem->sliceColormap1DName);
+    glTexSubImage1D(GL_TEXTURE_1D, 0, 0, 256, GL_RGBA, GL_UNSIGNED_BYTE, sliceColormap1D);
+    glBindTexture(GL_TEXTURE_1D, 0);
+    glDisable(GL_TEXTURE_1D);
 } // end update1DSliceColorMap()
 
+/*
+ * uploadIlluminatedTextures - Upload the published bake into this context, ILLUMINATION_UPLOAD_BUDGET bytes per frame.
+ *
+ * The bricks nearest the eye go first. A brick not uploaded yet keeps drawing the previous bake.
+ * The budget is shared by every view this context draws in a frame, such as the two eyes of a
+ * stereo window or the views of the other render nodes when compositing.
+ *
+ * parameter glContextData - GLContextData &
+ * parameter brickList - const std::vector<ComparableBrick> & (back to front)
+ * return - bool (false until this context holds a bake of every brick to draw)
+ */
+bool Scene::uploadIlluminatedTextures(GLContextData & glContextData, const std::vector<ComparableBrick> & brickList) const {
+    DataItem* dataItem = glContextData.retrieveDataItem<DataItem> (this);
+    if (dataItem->illuminationFrame != frameNumber) {
+        dataItem->illuminationFrame = frameNumber;
+        dataItem->illuminationBudget = ILLUMINATION_UPLOAD_BUDGET;
+    }
+    int version = illuminationCache->getVersion();
+    bool complete = true;
+    for (int i = numberOfBricks - 1; i >= 0; i--) {
+        int which = brickList[i].getWhich();
+        if (bricks[which].isEmpty() || !bricks[which].isResident() || illuminationCache->getTexels(which) == NULL)
+            continue;
+        if (dataItem->illuminationBudget > 0) {
+            dataItem->illuminationBudget -= long(bricks[which].uploadIlluminatedTexture(glContextData,
+                    illuminationCache->getTexels(which), version));
+            dataItem->illuminationUploaded = true;
+        }
+        if (bricks[which].getIlluminationVersion(glContextData) == 0)
+            complete = false;
+    } // end for
+    return complete;
+} // end uploadIlluminatedTextures()
+
 /*
  * updateAlpha
  *
@@ -1597,7 +2508,10 @@ void Scene::volumeShader2D(GLContextData & glContextData, DataItem * dataItem, c
     dataItem->volumeShaderObject2D->sendUniform1iv("seq", 64, sequenceIndices);
     dataItem->volumeShaderObject2D->sendUniform1iv("edge", 48, edgeIndices);
     dataItem->volumeShaderObject2D->sendUniform1i("front", GLint(maximumIndex));
-    dataItem->volumeShaderObject2D->sendUniform1f("maximumGradient", GLfloat(volume->getMaximumGradient()));
+    if (volume->isGradientTexture())
+        dataItem->volumeShaderObject2D->sendUniform1i("gradientVolume", 2);
+    else
+        dataItem->volumeShaderObject2D->sendUniform1f("maximumGradient", GLfloat(volume->getMaximumGradient()));
     dataItem->volumeShaderObject2D->sendUniform3f("slicePlaneNormal", GLfloat(slicePlaneNormal->getX()), GLfloat(
             slicePlaneNormal->getY()), GLfloat(slicePlaneNormal->getZ()));
     if (volume->getNumberOfComponents() != 0) {
@@ -1610,6 +2524,36 @@ void Scene::volumeShader2D(GLContextData & glContextData, DataItem * dataItem, c
     dataItem->volumeShaderObject2D->end();
 } // end volumeShader2D()
 
+/*
+ * volumeShaderIlluminated - Draw the colors the illumination cache baked for the lit shaders.
+ *
+ * parameter glContextData - GLContextData &
+ * parameter dataItem - DataItem *
+ * parameter brickList - const std::vector<ComparableBrick> &
+ * parameter point - float *
+ * parameter maximumIndex - int
+ * parameter minimumIndex - int
+ * parameter slicePlaneNormal - Vector4 *
+ * parameter modelviewInverse - Matrix4x4 *
+ */
+void Scene::volumeShaderIlluminated(GLContextData & glContextData, DataItem * dataItem,
+        const std::vector<ComparableBrick> & brickList, float * point, int maximumIndex, int minimumIndex,
+        Vector4 * slicePlaneNormal, Matrix4x4 * modelviewInverse) const {
+    dataItem->illuminatedVolumeShaderObject->begin();
+    dataItem->illuminatedVolumeShaderObject->sendUniform1iv("seq", 64, sequenceIndices);
+    dataItem->illuminatedVolumeShaderObject->sendUniform1iv("edge", 48, edgeIndices);
+    dataItem->illuminatedVolumeShaderObject->sendUniform1i("front", GLint(maximumIndex));
+    dataItem->illuminatedVolumeShaderObject->sendUniform3f("slicePlaneNormal", GLfloat(slicePlaneNormal->getX()), GLfloat(
+            slicePlaneNormal->getY()), GLfloat(slicePlaneNormal->getZ()));
+    for (int i = 0; i < numberOfBricks; i++) {
+        int which = brickList[i].getWhich();
+        if (!bricks[which].isEmpty() && bricks[which].isResident() && illuminationCache->getTexels(which) != NULL)
+            bricks[which].drawIlluminatedVolume(glContextData, dataItem->cFrustum, dataItem->illuminatedVolumeShaderObject,
+                    point, minimumIndex, maximumIndex, modelviewInverse);
+    }
+    dataItem->illuminatedVolumeShaderObject->end();
+} // end volumeShaderIlluminated()
+
 /*
  * volumeShaderFocusAndContext
  *
@@ -1635,7 +2579,7 @@ void Scene::volumeShaderFocusAndContext(GLContextData & glContextData, DataItem
     dataItem->volumeShaderObjectFocusAndContext->sendUniform3f("planeNormal", GLfloat(planeNormal[0]), GLfloat(planeNormal[1]), GLfloat(
             planeNormal[2]));
     dataItem->volumeShaderObjectFocusAndContext->sendUniform1f("planeOffset", GLfloat(planeOffset));
-    drawBricks(glContextData, dataItem->cFrustum, dataItem->volumeShaderObjectWithLighting, brickList, point, maximumIndex,
+    drawBricks(glContextData, dataItem->cFrustum, dataItem->volumeShaderObjectFocusAndContext, brickList, point, maximumIndex,
             minimumIndex, modelviewInverse);
     dataItem->volumeShaderObjectFocusAndContext->end();
 } // end volumeShaderFocusAndContext()
@@ -1655,54 +2599,29 @@ void Scene::volumeShaderFocusAndContext(GLContextData & glContextData, DataItem
 void Scene::volumeShaderWithLighting(GLContextData & glContextData, DataItem * dataItem,
         const std::vector<ComparableBrick> & brickList, float * point, int maximumIndex, int minimumIndex,
         Vector4 * slicePlaneNormal, Matrix4x4 * modelviewInverse) const {
-    dataItem->volumeShaderObjectWithLighting->begin();
-    dataItem->volumeShaderObjectWithLighting->sendUniform1i("colormap1D", 1);
-    dataItem->volumeShaderObjectWithLighting->sendUniform1iv("seq", 64, sequenceIndices);
-    dataItem->volumeShaderObjectWithLighting->sendUniform1iv("edge", 48, edgeIndices);
-    dataItem->volumeShaderObjectWithLighting->sendUniform1i("front", GLint(maximumIndex));
-    dataItem->volumeShaderObjectWithLighting->sendUniform3f("slicePlaneNormal", GLfloat(slicePlaneNormal->getX()), GLfloat(
-            slicePlaneNormal->getY()), GLfloat(slicePlaneNormal->getZ()));
+    unsigned int features = getShadingFeatures();
+    ShaderObject* shaderObject = 0;
+    if (features != 0 && dataItem->volumeShaderVariantsWithLighting != 0)
+        shaderObject = dataItem->volumeShaderVariantsWithLighting->getShaderObject(features);
+    if (shaderObject == 0) {
+        volumeShader(glContextData, dataItem, brickList, point, maximumIndex, minimumIndex, slicePlaneNormal, modelviewInverse);
+        return;
+    }
+    shaderObject->begin();
+    shaderObject->sendUniform1i("colormap1D", 1);
+    shaderObject->sendUniform1iv("seq", 64, sequenceIndices);
+    shaderObject->sendUniform1iv("edge", 48, edgeIndices);
+    shaderObject->sendUniform1i("front", GLint(maximumIndex));
+    shaderObject->sendUniform3f("slicePlaneNormal", GLfloat(slicePlaneNormal->getX()), GLfloat(slicePlaneNormal->getY()),
+            GLfloat(slicePlaneNormal->getZ()));
     if (volume->getNumberOfComponents() != 0) {
-        dataItem->volumeShaderObjectWithLighting->sendUniform1f("redScale", GLfloat(redScale));
-        dataItem->volumeShaderObjectWithLighting->sendUniform1f("greenScale", GLfloat(greenScale));
-        dataItem->volumeShaderObjectWithLighting->sendUniform1f("blueScale", GLfloat(blueScale));
+        shaderObject->sendUniform1f("redScale", GLfloat(redScale));
+        shaderObject->sendUniform1f("greenScale", GLfloat(greenScale));
+        shaderObject->sendUniform1f("blueScale", GLfloat(blueScale));
     }
-    dataItem->volumeShaderObjectWithLighting->sendUniform4f("eyePosition", GLfloat(point[0]), GLfloat(point[1]), GLfloat(point[2]),
-            GLfloat(1.0f));
-    dataItem->volumeShaderObjectWithLighting->sendUniform4f("lightPosition", GLfloat(lightPosition[0]), GLfloat(lightPosition[1]),
-            GLfloat(lightPosition[2]), GLfloat(1.0f));
-    dataItem->volumeShaderObjectWithLighting->sendUniform3f("ambientColor", GLfloat(ambientColor[0]), GLfloat(ambientColor[1]),
-            GLfloat(ambientColor[2]));
-    dataItem->volumeShaderObjectWithLighting->sendUniform3f("diffuseColor", GLfloat(diffuseColor[0]), GLfloat(diffuseColor[1]),
-            GLfloat(diffuseColor[2]));
-    dataItem->volumeShaderObjectWithLighting->sendUniform3f("specularColor", GLfloat(specularColor[0]), GLfloat(specularColor[1]),
-            GLfloat(specularColor[2]));
-    dataItem->volumeShaderObjectWithLighting->sendUniform3f("kAmbient", GLfloat(kAmbient[0]), GLfloat(kAmbient[1]), GLfloat(
-            kAmbient[2]));
-    dataItem->volumeShaderObjectWithLighting->sendUniform3f("kDiffuse", GLfloat(kDiffuse[0]), GLfloat(kDiffuse[1]), GLfloat(
-            kDiffuse[2]));
-    dataItem->volumeShaderObjectWithLighting->sendUniform3f("kSpecular", GLfloat(kSpecular[0]), GLfloat(kSpecular[1]), GLfloat(
-            kSpecular[2]));
-    dataItem->volumeShaderObjectWithLighting->sendUniform1f("shininess", GLfloat(shininess));
-    dataItem->volumeShaderObjectWithLighting->sendUniform1f("normalContribution", GLfloat(normalContribution));
-    dataItem->volumeShaderObjectWithLighting->sendUniform1f("toneContribution", GLfloat(toneContribution));
-    dataItem->volumeShaderObjectWithLighting->sendUniform3f("coolColor", GLfloat(coolColor[0]), GLfloat(coolColor[1]), GLfloat(
-            coolColor[2]));
-    dataItem->volumeShaderObjectWithLighting->sendUniform3f("warmColor", GLfloat(warmColor[0]), GLfloat(warmColor[1]), GLfloat(
-            warmColor[2]));
-    dataItem->volumeShaderObjectWithLighting->sendUniform1f("toonContribution", GLfloat(toonContribution));
-    dataItem->volumeShaderObjectWithLighting->sendUniform3f("toonColor", GLfloat(toonColor[0]), GLfloat(toonColor[1]), GLfloat(
-            toonColor[2]));
-    dataItem->volumeShaderObjectWithLighting->sendUniform1f("boundaryContribution", GLfloat(boundaryContribution));
-    dataItem->volumeShaderObjectWithLighting->sendUniform1f("boundaryExponent", GLfloat(boundaryExponent));
-    dataItem->volumeShaderObjectWithLighting->sendUniform1f("silhouetteContribution", GLfloat(silhouetteContribution));
-    dataItem->volumeShaderObjectWithLighting->sendUniform1f("silhouetteExponent", GLfloat(silhouetteExponent));
-    dataItem->volumeShaderObjectWithLighting->sendUniform1f("edgeContribution", GLfloat(edgeContribution));
-    dataItem->volumeShaderObjectWithLighting->sendUniform1f("edgeExponent", GLfloat(edgeExponent));
-    dataItem->volumeShaderObjectWithLighting->sendUniform1f("edgeThreshold", GLfloat(edgeThreshold));
-    drawBricks(glContextData, dataItem->cFrustum, dataItem->volumeShaderObjectWithLighting, brickList, point, maximumIndex,
-            minimumIndex, modelviewInverse);
-    dataItem->volumeShaderObjectWithLighting->end();
+    sendLightingUniforms(shaderObject, features, point);
+    drawBricks(glContextData, dataItem->cFrustum, shaderObject, brickList, point, maximumIndex, minimumIndex, modelviewInverse);
+    shaderObject->end();
 } // end volumeShaderWithLighting()
 
 /*
@@ -1720,50 +2639,31 @@ void Scene::volumeShaderWithLighting(GLContextData & glContextData, DataItem * d
 void Scene::volumeShader2DWithLighting(GLContextData & glContextData, DataItem * dataItem,
         const std::vector<ComparableBrick> & brickList, float * point, int maximumIndex, int minimumIndex,
         Vector4 * slicePlaneNormal, Matrix4x4 * modelviewInverse) const {
-    dataItem->volumeShaderObject2DWithLighting->begin();
-    dataItem->volumeShaderObject2DWithLighting->sendUniform1i("colormap2D", 1);
-    dataItem->volumeShaderObject2DWithLighting->sendUniform1iv("seq", 64, sequenceIndices);
-    dataItem->volumeShaderObject2DWithLighting->sendUniform1iv("edge", 48, edgeIndices);
-    dataItem->volumeShaderObject2DWithLighting->sendUniform1i("front", GLint(maximumIndex));
-    dataItem->volumeShaderObject2DWithLighting->sendUniform1f("maximumGradient", GLfloat(volume->getMaximumGradient()));
-    dataItem->volumeShaderObject2DWithLighting->sendUniform3f("slicePlaneNormal", GLfloat(slicePlaneNormal->getX()), GLfloat(
-            slicePlaneNormal->getY()), GLfloat(slicePlaneNormal->getZ()));
-    dataItem->volumeShaderObject2DWithLighting->sendUniform4f("eyePosition", GLfloat(point[0]), GLfloat(point[1]),
-            GLfloat(point[2]), GLfloat(1.0f));
-    dataItem->volumeShaderObject2DWithLighting->sendUniform4f("lightPosition", GLfloat(lightPosition[0]),
-            GLfloat(lightPosition[1]), GLfloat(lightPosition[2]), GLfloat(1.0f));
-    dataItem->volumeShaderObject2DWithLighting->sendUniform3f("ambientColor", GLfloat(ambientColor[0]), GLfloat(ambientColor[1]),
-            GLfloat(ambientColor[2]));
-    dataItem->volumeShaderObject2DWithLighting->sendUniform3f("diffuseColor", GLfloat(diffuseColor[0]), GLfloat(diffuseColor[1]),
-            GLfloat(diffuseColor[2]));
-    dataItem->volumeShaderObject2DWithLighting->sendUniform3f("specularColor", GLfloat(specularColor[0]),
-            GLfloat(specularColor[1]), GLfloat(specularColor[2]));
-    dataItem->volumeShaderObject2DWithLighting->sendUniform3f("kAmbient", GLfloat(kAmbient[0]), GLfloat(kAmbient[1]), GLfloat(
-            kAmbient[2]));
-    dataItem->volumeShaderObject2DWithLighting->sendUniform3f("kDiffuse", GLfloat(kDiffuse[0]), GLfloat(kDiffuse[1]), GLfloat(
-            kDiffuse[2]));
-    dataItem->volumeShaderObject2DWithLighting->sendUniform3f("kSpecular", GLfloat(kSpecular[0]), GLfloat(kSpecular[1]), GLfloat(
-            kSpecular[2]));
-    dataItem->volumeShaderObject2DWithLighting->sendUniform1f("shininess", GLfloat(shininess));
-    dataItem->volumeShaderObject2DWithLighting->sendUniform1f("normalContribution", GLfloat(normalContribution));
-    dataItem->volumeShaderObject2DWithLighting->sendUniform1f("toneContribution", GLfloat(toneContribution));
-    dataItem->volumeShaderObject2DWithLighting->sendUniform3f("coolColor", GLfloat(coolColor[0]), GLfloat(coolColor[1]), GLfloat(
-            coolColor[2]));
-    dataItem->volumeShaderObject2DWithLighting->sendUniform3f("warmColor", GLfloat(warmColor[0]), GLfloat(warmColor[1]), GLfloat(
-            warmColor[2]));
-    dataItem->volumeShaderObject2DWithLighting->sendUniform1f("toonContribution", GLfloat(toonContribution));
-    dataItem->volumeShaderObject2DWithLighting->sendUniform3f("toonColor", GLfloat(toonColor[0]), GLfloat(toonColor[1]), GLfloat(
-            toonColor[2]));
-    dataItem->volumeShaderObject2DWithLighting->sendUniform1f("boundaryContribution", GLfloat(boundaryContribution));
-    dataItem->volumeShaderObject2DWithLighting->sendUniform1f("boundaryExponent", GLfloat(boundaryExponent));
-    dataItem->volumeShaderObject2DWithLighting->sendUniform1f("silhouetteContribution", GLfloat(silhouetteContribution));
-    dataItem->volumeShaderObject2DWithLighting->sendUniform1f("silhouetteExponent", GLfloat(silhouetteExponent));
-    dataItem->volumeShaderObject2DWithLighting->sendUniform1f("edgeContribution", GLfloat(edgeContribution));
-    dataItem->volumeShaderObject2DWithLighting->sendUniform1f("edgeExponent", GLfloat(edgeExponent));
-    dataItem->volumeShaderObject2DWithLighting->sendUniform1f("edgeThreshold", GLfloat(edgeThreshold));
-    drawBricks(glContextData, dataItem->cFrustum, dataItem->volumeShaderObject2DWithLighting, brickList, point, maximumIndex,
-            minimumIndex, modelviewInverse);
-    dataItem->volumeShaderObject2DWithLighting->end();
+    unsigned int features = getShadingFeatures();
+    ShaderObject* shaderObject = 0;
+    if (features != 0 && dataItem->volumeShaderVariants2DWithLighting != 0)
+        shaderObject = dataItem->volumeShaderVariants2DWithLighting->getShaderObject(features);
+    if (shaderObject == 0) {
+        volumeShader2D(glContextData, dataItem, brickList, point, maximumIndex, minimumIndex, slicePlaneNormal, modelviewInverse);
+        return;
+    }
+    shaderObject->begin();
+    shaderObject->sendUniform1i("colormap2D", 1);
+    shaderObject->sendUniform1iv("seq", 64, sequenceIndices);
+    shaderObject->sendUniform1iv("edge", 48, edgeIndices);
+    shaderObject->sendUniform1i("front", GLint(maximumIndex));
+    if (!(features & GRADIENT_TEXTURE))
+        shaderObject->sendUniform1f("maximumGradient", GLfloat(volume->getMaximumGradient()));
+    shaderObject->sendUniform3f("slicePlaneNormal", GLfloat(slicePlaneNormal->getX()), GLfloat(slicePlaneNormal->getY()),
+            GLfloat(slicePlaneNormal->getZ()));
+    if (volume->getNumberOfComponents() != 0) {
+        shaderObject->sendUniform1f("redScale", GLfloat(redScale));
+        shaderObject->sendUniform1f("greenScale", GLfloat(greenScale));
+        shaderObject->sendUniform1f("blueScale", GLfloat(blueScale));
+    }
+    sendLightingUniforms(shaderObject, features, point);
+    drawBricks(glContextData, dataItem->cFrustum, shaderObject, brickList, point, maximumIndex, minimumIndex, modelviewInverse);
+    shaderObject->end();
 } // end volumeShader2DWithLighting()
 
 /*
@@ -1810,55 +2710,30 @@ void Scene::volumeShaderPreIntegrated(GLContextData & glContextData, DataItem *
  * parameter slicePlaneNormal - Vector4 *
  * parameter modelviewInverse - Matrix4x4 *
  */
-void Scene::volumeShaderPreIntegratedWithLighting(GLContextData & glContextData, DataItem * dataItem, const std::vector<
-        ComparableBrick> & brickList, float * point, int maximumIndex, int minimumIndex, Vector4 * slicePlaneNormal,
-        Matrix4x4 * modelviewInverse) const {
-    dataItem->preIntegratedVolumeShaderObjectWithLighting->begin();
-    dataItem->preIntegratedVolumeShaderObjectWithLighting->sendUniform1i("colormap2D", 1);
-    dataItem->preIntegratedVolumeShaderObjectWithLighting->sendUniform1iv("seq", 64, sequenceIndices);
-    dataItem->preIntegratedVolumeShaderObjectWithLighting->sendUniform1iv("edge", 48, edgeIndices);
-    dataItem->preIntegratedVolumeShaderObjectWithLighting->sendUniform1i("front", GLint(maximumIndex));
-    dataItem->preIntegratedVolumeShaderObjectWithLighting->sendUniform3f("slicePlaneNormal", GLfloat(slicePlaneNormal->getX()),
-            GLfloat(slicePlaneNormal->getY()), GLfloat(slicePlaneNormal->getZ()));
+void Scene::volumeShaderPreIntegratedWithLighting(GLContextData & glContextData, DataItem * dataItem,
+        const std::vector<ComparableBrick> & brickList, float * point, int maximumIndex, int minimumIndex,
+        Vector4 * slicePlaneNormal, Matrix4x4 * modelviewInverse) const {
+    unsigned int features = getShadingFeatures();
+    ShaderObject* shaderObject = 0;
+    if (features != 0 && dataItem->preIntegratedVolumeShaderVariantsWithLighting != 0)
+        shaderObject = dataItem->preIntegratedVolumeShaderVariantsWithLighting->getShaderObject(features);
+    if (shaderObject == 0) {
+        volumeShaderPreIntegrated(glContextData, dataItem, brickList, point, maximumIndex, minimumIndex, slicePlaneNormal, modelviewInverse);
+        return;
+    }
+    shaderObject->begin();
+    shaderObject->sendUniform1i("colormap2D", 1);
+    shaderObject->sendUniform1iv("seq", 64, sequenceIndices);
+    shaderObject->sendUniform1iv("edge", 48, edgeIndices);
+    shaderObject->sendUniform1i("front", GLint(maximumIndex));
+    shaderObject->sendUniform3f("slicePlaneNormal", GLfloat(slicePlaneNormal->getX()), GLfloat(slicePlaneNormal->getY()),
+            GLfloat(slicePlaneNormal->getZ()));
     if (volume->getNumberOfComponents() != 0) {
-        dataItem->preIntegratedVolumeShaderObjectWithLighting->sendUniform1f("redScale", GLfloat(redScale));
-        dataItem->preIntegratedVolumeShaderObjectWithLighting->sendUniform1f("greenScale", GLfloat(greenScale));
-        dataItem->preIntegratedVolumeShaderObjectWithLighting->sendUniform1f("blueScale", GLfloat(blueScale));
+        shaderObject->sendUniform1f("redScale", GLfloat(redScale));
+        shaderObject->sendUniform1f("greenScale", GLfloat(greenScale));
+        shaderObject->sendUniform1f("blueScale", GLfloat(blueScale));
     }
-    dataItem->preIntegratedVolumeShaderObjectWithLighting->sendUniform4f("eyePosition", GLfloat(point[0]), GLfloat(point[1]),
-            GLfloat(point[2]), GLfloat(1.0f));
-    dataItem->preIntegratedVolumeShaderObjectWithLighting->sendUniform4f("lightPosition", GLfloat(lightPosition[0]), GLfloat(
-            lightPosition[1]), GLfloat(lightPosition[2]), GLfloat(1.0f));
-    dataItem->preIntegratedVolumeShaderObjectWithLighting->sendUniform3f("ambientColor", GLfloat(ambientColor[0]), GLfloat(
-            ambientColor[1]), GLfloat(ambientColor[2]));
-    dataItem->preIntegratedVolumeShaderObjectWithLighting->sendUniform3f("diffuseColor", GLfloat(diffuseColor[0]), GLfloat(
-            diffuseColor[1]), GLfloat(diffuseColor[2]));
-    dataItem->preIntegratedVolumeShaderObjectWithLighting->sendUniform3f("specularColor", GLfloat(specularColor[0]), GLfloat(
-            specularColor[1]), GLfloat(specularColor[2]));
-    dataItem->preIntegratedVolumeShaderObjectWithLighting->sendUniform3f("kAmbient", GLfloat(kAmbient[0]), GLfloat(kAmbient[1]),
-            GLfloat(kAmbient[2]));
-    dataItem->preIntegratedVolumeShaderObjectWithLighting->sendUniform3f("kDiffuse", GLfloat(kDiffuse[0]), GLfloat(kDiffuse[1]),
-            GLfloat(kDiffuse[2]));
-    dataItem->preIntegratedVolumeShaderObjectWithLighting->sendUniform3f("kSpecular", GLfloat(kSpecular[0]), GLfloat(kSpecular[1]),
-            GLfloat(kSpecular[2]));
-    dataItem->preIntegratedVolumeShaderObjectWithLighting->sendUniform1f("shininess", GLfloat(shininess));
-    dataItem->preIntegratedVolumeShaderObjectWithLighting->sendUniform1f("normalContribution", GLfloat(normalContribution));
-    dataItem->preIntegratedVolumeShaderObjectWithLighting->sendUniform1f("toneContribution", GLfloat(toneContribution));
-    dataItem->preIntegratedVolumeShaderObjectWithLighting->sendUniform3f("coolColor", GLfloat(coolColor[0]), GLfloat(coolColor[1]),
-            GLfloat(coolColor[2]));
-    dataItem->preIntegratedVolumeShaderObjectWithLighting->sendUniform3f("warmColor", GLfloat(warmColor[0]), GLfloat(warmColor[1]),
-            GLfloat(warmColor[2]));
-    dataItem->preIntegratedVolumeShaderObjectWithLighting->sendUniform1f("toonContribution", GLfloat(toonContribution));
-    dataItem->preIntegratedVolumeShaderObjectWithLighting->sendUniform3f("toonColor", GLfloat(toonColor[0]), GLfloat(toonColor[1]),
-            GLfloat(toonColor[2]));
-    dataItem->preIntegratedVolumeShaderObjectWithLighting->sendUniform1f("boundaryContribution", GLfloat(boundaryContribution));
-    dataItem->preIntegratedVolumeShaderObjectWithLighting->sendUniform1f("boundaryExponent", GLfloat(boundaryExponent));
-    dataItem->preIntegratedVolumeShaderObjectWithLighting->sendUniform1f("silhouetteContribution", GLfloat(silhouetteContribution));
-    dataItem->preIntegratedVolumeShaderObjectWithLighting->sendUniform1f("silhouetteExponent", GLfloat(silhouetteExponent));
-    dataItem->preIntegratedVolumeShaderObjectWithLighting->sendUniform1f("edgeContribution", GLfloat(edgeContribution));
-    dataItem->preIntegratedVolumeShaderObjectWithLighting->sendUniform1f("edgeExponent", GLfloat(edgeExponent));
-    dataItem->preIntegratedVolumeShaderObjectWithLighting->sendUniform1f("edgeThreshold", GLfloat(edgeThreshold));
-    drawBricks(glContextData, dataItem->cFrustum, dataItem->preIntegratedVolumeShaderObjectWithLighting, brickList, point,
-            maximumIndex, minimumIndex, modelviewInverse);
-    dataItem->preIntegratedVolumeShaderObjectWithLighting->end();
+    sendLightingUniforms(shaderObject, features, point);
+    drawBricks(glContextData, dataItem->cFrustum, shaderObject, brickList, point, maximumIndex, minimumIndex, modelviewInverse);
+    shaderObject->end();
 } // end volumeShaderPreIntegratedWithLighting()
@@ -9,11 +9,13 @@
 #define SCENE_H_
 
 #include <deque>
+#include <pthread.h>
 #include <string>
 #include <vector>
 
 #include <GL/gl.h>
 #include <GL/glu.h>
+#include <GL/glext.h>
 
 /* Vrui includes */
 #include <Geometry/Point.h>
@@ -21,6 +23,7 @@
 #include <GL/GLObject.h>
 #include <GL/GLPolylineTube.h>
 
+#include <DATASTRUCTURE/ComparableBrick.h>
 #include <GRAPHIC/CFrustum.h>
 
 #define RED 0
@@ -28,6 +31,9 @@
 #define BLUE 2
 #define ALPHA 3
 
+/* Fraction of its distance to the volume the eye moves before the global octree refinement is redone */
+#define REFINEMENT_TOLERANCE 0.05f
+
 /* GPUVertexShader */
 static const char* GPUVertexShader = "uniform vec3 vBBox[8];    // updated per brick                           \n"
     "uniform vec3 tBBox[8];                                                   \n"
@@ -102,7 +108,7 @@ static const char* GPUVertexShaderWithLighting = "uniform vec3 vBBox[8];    // u
     "    gl_ClipVertex = gl_ModelViewMatrix * pos;                            \n"
     "	 vec4 tex0 = vec4(TexCoord0.x, TexCoord0.y, TexCoord0.z, 1.0);        \n"
     "    gl_TexCoord[0] = tex0;                                               \n"
-    "	 gl_TexCoord[1] = gl_Position;                                        \n"
+    "	 gl_TexCoord[1] = pos;                                                \n"
     "}                                                                      \n\0";
 
 /* preIntegratedGPUVertexShader */
@@ -204,7 +210,7 @@ static const char* preIntegratedGPUVertexShaderWithLighting =
             "    gl_TexCoord[0] = tex0;                                               \n"
             "	 vec4 tex1 = vec4(TexCoord1.x, TexCoord1.y, TexCoord1.z, 1.0);        \n"
             "    gl_TexCoord[1] = tex1;                                               \n"
-            "	 gl_TexCoord[2] = gl_Position;                                        \n"
+            "	 gl_TexCoord[2] = pos;                                                \n"
             "}                                                                      \n\0";
 
 /* vertexShader */
@@ -221,7 +227,7 @@ static const char* vertexShaderWithLighting = "void main(void)
     "	gl_TexCoord[0] = gl_MultiTexCoord0;                      \n"
     "	gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;  \n"
     "   gl_ClipVertex = gl_ModelViewMatrix * gl_Vertex;          \n"
-    "	gl_TexCoord[1] = gl_Position;                            \n"
+    "	gl_TexCoord[1] = gl_Vertex;                              \n"
     "}                                                         \n\0";
 
 /* fragmentShaderWithLighting */
@@ -250,24 +256,40 @@ static const char* fragmentShader = "uniform sampler3D volume;
     "	gl_FragColor = y;                                          \n"
     "}                                                           \n\0";
 
+/* illuminatedFragmentShader */
+static const char* illuminatedFragmentShader = "uniform sampler3D volume;                         \n"
+    "                                                              \n"
+    "void main (void)                                              \n"
+    "{                                                             \n"
+    "	gl_FragColor = texture3D(volume, gl_TexCoord[0].xyz);      \n"
+    "}                                                           \n\0";
+
 /* fragmentShader2D */
-static const char* fragmentShader2D = "#define DELTA 0.01                                            \n"
+static const char* fragmentShader2D = "uniform vec3 texelSize;                                       \n"
     "uniform sampler3D volume;                                     \n"
     "uniform sampler2D colormap2D;                                 \n"
-    "uniform float maximumGradient;                                        \n"
+    "#ifdef GRADIENT_TEXTURE                                       \n"
+    "uniform sampler3D gradientVolume;                             \n"
+    "#else                                                         \n"
+    "uniform float maximumGradient;                                \n"
+    "#endif                                                        \n"
     "                                                              \n"
     "void main (void)                                              \n"
     "{                                                             \n"
     "   float x = texture3D(volume, gl_TexCoord[0].xyz).x;         \n"
+    "#ifdef GRADIENT_TEXTURE                                       \n"
+    "   float c = texture3D(gradientVolume, gl_TexCoord[0].xyz).a; \n"
+    "#else                                                         \n"
     "   vec3 a, b;                                                 \n"
-    "   a.x  = texture3D(volume, gl_TexCoord[0].xyz - vec3(DELTA,0.0,0.0)).x;\n"
-    "   b.x  = texture3D(volume, gl_TexCoord[0].xyz + vec3(DELTA,0.0,0.0)).x;\n"
-    "   a.y  = texture3D(volume, gl_TexCoord[0].xyz - vec3(0.0,DELTA,0.0)).x;\n"
-    "   b.y  = texture3D(volume, gl_TexCoord[0].xyz + vec3(0.0,DELTA,0.0)).x;\n"
-    "   a.z  = texture3D(volume, gl_TexCoord[0].xyz - vec3(0.0,0.0,DELTA)).x;\n"
-    "   b.z  = texture3D(volume, gl_TexCoord[0].xyz + vec3(0.0,0.0,DELTA)).x;\n"
+    "   a.x  = texture3D(volume, gl_TexCoord[0].xyz - vec3(texelSize.x,0.0,0.0)).x;\n"
+    "   b.x  = texture3D(volume, gl_TexCoord[0].xyz + vec3(texelSize.x,0.0,0.0)).x;\n"
+    "   a.y  = texture3D(volume, gl_TexCoord[0].xyz - vec3(0.0,texelSize.y,0.0)).x;\n"
+    "   b.y  = texture3D(volume, gl_TexCoord[0].xyz + vec3(0.0,texelSize.y,0.0)).x;\n"
+    "   a.z  = texture3D(volume, gl_TexCoord[0].xyz - vec3(0.0,0.0,texelSize.z)).x;\n"
+    "   b.z  = texture3D(volume, gl_TexCoord[0].xyz + vec3(0.0,0.0,texelSize.z)).x;\n"
     "   vec3 gradient = b * 255.0 - a * 255.0;                     \n"
     "   float c = log2(dot(gradient, gradient))/log2(maximumGradient);     \n"
+    "#endif                                                        \n"
     "   c = 1.0 - c;                                               \n"
     "   vec2 coordinate = vec2(x,c);                               \n"
     "   vec4 color = texture2D(colormap2D, coordinate);            \n"
@@ -275,13 +297,18 @@ static const char* fragmentShader2D = "#define DELTA 0.01
     "}                                                           \n\0";
 
 /* fragmentShader2DWithLighting */
-static const char* fragmentShader2DWithLighting = "#define DELTA 0.01                                            \n"
+static const char* fragmentShader2DWithLighting = "uniform vec3 texelSize;                                       \n"
     "#define THRESHOLD 0.1                                         \n"
     "uniform sampler3D volume;                                     \n"
     "uniform sampler2D colormap2D;                                 \n"
+    "#ifdef GRADIENT_TEXTURE                                       \n"
+    "uniform sampler3D gradientVolume;                             \n"
+    "#else                                                         \n"
     "uniform float maximumGradient;                                \n"
+    "#endif                                                        \n"
     "uniform vec4 lightPosition;                                   \n"
     "uniform vec4 eyePosition;                                     \n"
+    "#ifdef NORMAL_SHADING                                         \n"
     "uniform vec3 ambientColor;                                    \n"
     "uniform vec3 diffuseColor;                                    \n"
     "uniform vec3 specularColor;                                   \n"
@@ -290,19 +317,31 @@ static const char* fragmentShader2DWithLighting = "#define DELTA 0.01
     "uniform vec3 kSpecular;                                       \n"
     "uniform float shininess;                                      \n"
     "uniform float normalContribution;                             \n"
+    "#endif                                                        \n"
+    "#ifdef TONE_SHADING                                           \n"
     "uniform float toneContribution;                               \n"
     "uniform vec3 coolColor;                                       \n"
     "uniform vec3 warmColor;                                       \n"
+    "#endif                                                        \n"
+    "#ifdef TOON_SHADING                                           \n"
     "uniform float toonContribution;                               \n"
     "uniform vec3 toonColor;                                       \n"
+    "#endif                                                        \n"
+    "#ifdef BOUNDARY_SHADING                                       \n"
     "uniform float boundaryContribution;                           \n"
     "uniform float boundaryExponent;                               \n"
+    "#endif                                                        \n"
+    "#ifdef SILHOUETTE_SHADING                                     \n"
     "uniform float silhouetteContribution;                         \n"
     "uniform float silhouetteExponent;                             \n"
+    "#endif                                                        \n"
+    "#ifdef EDGE_SHADING                                           \n"
     "uniform float edgeContribution;                               \n"
     "uniform float edgeExponent;                                   \n"
     "uniform float edgeThreshold;                                  \n"
+    "#endif                                                        \n"
     "                                                              \n"
+    "#ifdef NORMAL_SHADING                                         \n"
     "vec3 normalShading(vec3 N, vec3 V, vec3 L, float diffuseLight)\n"
     "{                                                             \n"
     "// calculate halfway vector                                   \n"
@@ -317,13 +356,17 @@ static const char* fragmentShader2DWithLighting = "#define DELTA 0.01
     "    vec3 specular = kSpecular * specularColor * specularLight;\n"
     "    return ambient + diffuse + specular;                      \n"
     "}                                                             \n"
+    "#endif                                                        \n"
     "                                                              \n"
+    "#ifdef TONE_SHADING                                           \n"
     "vec3 toneShading(float diffuseLight)                          \n"
     "{                                                             \n"
     "    vec3 tone = (((1.0+diffuseLight)*0.5)*warmColor + (1.0-((1.0+diffuseLight)*0.5))*coolColor);\n"
     "    return tone;                                              \n"
     "}                                                             \n"
+    "#endif                                                        \n"
     "                                                              \n"
+    "#ifdef TOON_SHADING                                           \n"
     "vec3 toonShading(float diffuseLight)                          \n"
     "{                                                             \n"
     "    vec3 color = toonColor - vec3(1.0, 1.0, 1.0);             \n"
@@ -335,17 +378,23 @@ static const char* fragmentShader2DWithLighting = "#define DELTA 0.01
     "    else if (diffuseLight > 0.25) return color3;              \n"
     "    else return toonColor;                                    \n"
     "}                                                             \n"
+    "#endif                                                        \n"
     "                                                              \n"
+    "#ifdef BOUNDARY_SHADING                                       \n"
     "float boundaryShading(float gradient)                         \n"
     "{                                                             \n"
     "    return pow(gradient,boundaryExponent);  \n"
     "}                                                             \n"
+    "#endif                                                        \n"
     "                                                              \n"
+    "#ifdef SILHOUETTE_SHADING                                     \n"
     "float silhouetteShading(float angleVN)                        \n"
     "{                                                             \n"
     "    return pow(1.0-abs(angleVN),silhouetteExponent);          \n"
     "}                                                             \n"
+    "#endif                                                        \n"
     "                                                              \n"
+    "#ifdef EDGE_SHADING                                           \n"
     "vec3 edgeShading(vec3 color, float angleVN)                   \n"
     "{                                                             \n"
     "    float edgeValue = pow(1.0-abs(angleVN),edgeExponent);     \n"
@@ -355,47 +404,70 @@ static const char* fragmentShader2DWithLighting = "#define DELTA 0.01
     "    }                                                         \n"
     "    return color;                                             \n"
     "}                                                             \n"
+    "#endif                                                        \n"
     "                                                              \n"
     "void main (void)                                              \n"
     "{                                                             \n"
     "   float x = texture3D(volume, gl_TexCoord[0].xyz).x;         \n"
+    "#ifdef GRADIENT_TEXTURE                                       \n"
+    "   vec4 g = texture3D(gradientVolume, gl_TexCoord[0].xyz);    \n"
+    "   vec3 gradient = g.rgb * 2.0 - 1.0;                         \n"
+    "   float gradientMagnitude = g.a;                             \n"
+    "#else                                                         \n"
     "   vec3 a, b;                                                 \n"
-    "   a.x  = texture3D(volume, gl_TexCoord[0].xyz - vec3(DELTA,0.0,0.0)).x;\n"
-    "   b.x  = texture3D(volume, gl_TexCoord[0].xyz + vec3(DELTA,0.0,0.0)).x;\n"
-    "   a.y  = texture3D(volume, gl_TexCoord[0].xyz - vec3(0.0,DELTA,0.0)).x;\n"
-    "   b.y  = texture3D(volume, gl_TexCoord[0].xyz + vec3(0.0,DELTA,0.0)).x;\n"
-    "   a.z  = texture3D(volume, gl_TexCoord[0].xyz - vec3(0.0,0.0,DELTA)).x;\n"
-    "   b.z  = texture3D(volume, gl_TexCoord[0].xyz + vec3(0.0,0.0,DELTA)).x;\n"
+    "   a.x  = texture3D(volume, gl_TexCoord[0].xyz - vec3(texelSize.x,0.0,0.0)).x;\n"
+    "   b.x  = texture3D(volume, gl_TexCoord[0].xyz + vec3(texelSize.x,0.0,0.0)).x;\n"
+    "   a.y  = texture3D(volume, gl_TexCoord[0].xyz - vec3(0.0,texelSize.y,0.0)).x;\n"
+    "   b.y  = texture3D(volume, gl_TexCoord[0].xyz + vec3(0.0,texelSize.y,0.0)).x;\n"
+    "   a.z  = texture3D(volume, gl_TexCoord[0].xyz - vec3(0.0,0.0,texelSize.z)).x;\n"
+    "   b.z  = texture3D(volume, gl_TexCoord[0].xyz + vec3(0.0,0.0,texelSize.z)).x;\n"
     "   vec3 gradient = b * 255.0 - a * 255.0;                     \n"
     "   float gradientMagnitude = log2(dot(gradient, gradient))/log2(maximumGradient);     \n"
+    "#endif                                                        \n"
     "   gradientMagnitude = 1.0 - gradientMagnitude;                                               \n"
     "   vec2 coordinate = vec2(x,gradientMagnitude);                               \n"
     "   vec4 color = texture2D(colormap2D, coordinate);            \n"
     "   if (color.a > THRESHOLD) {                                 \n"
     "     vec3 N = normalize(gradient);                              \n"
-    "     vec3 L = normalize((gl_ModelViewProjectionMatrix * lightPosition).xyz - gl_TexCoord[1].xyz); \n"
-    "     vec3 V = normalize((gl_ModelViewProjectionMatrix * eyePosition).xyz - gl_TexCoord[1].xyz);   \n"
+    "     vec3 L = normalize(lightPosition.xyz - gl_TexCoord[1].xyz); \n"
+    "     vec3 V = normalize(eyePosition.xyz - gl_TexCoord[1].xyz);   \n"
     "     float diffuseLight = dot(L, N);                          \n"
+    "#ifdef NORMAL_SHADING                                         \n"
     "     color.rgb += normalContribution * normalShading(N, V, L, diffuseLight);   \n"
+    "#endif                                                        \n"
+    "#ifdef TONE_SHADING                                           \n"
     "     color.rgb += toneContribution * toneShading(diffuseLight);  \n"
+    "#endif                                                        \n"
+    "#ifdef TOON_SHADING                                           \n"
     "     color.rgb += toonContribution * toonShading(diffuseLight);  \n"
+    "#endif                                                        \n"
+    "#ifdef BOUNDARY_SHADING                                       \n"
     "     color.a += boundaryContribution * boundaryShading(1.0 - gradientMagnitude);\n"
+    "#endif                                                        \n"
     "     float angleVN = dot(V, N);                              \n"
+    "#ifdef SILHOUETTE_SHADING                                     \n"
     "     color.a += silhouetteContribution * silhouetteShading(angleVN);\n"
+    "#endif                                                        \n"
+    "#ifdef EDGE_SHADING                                           \n"
     "      if (edgeContribution > 0.0) {                           \n"
     "         color.rgb = edgeShading(color.rgb, angleVN);         \n"
     "      }                                                       \n"
+    "#endif                                                        \n"
     "   }                                                          \n"
     "   gl_FragColor = color;                                      \n"
     "}                                                           \n\0";
 
 /* fragmentShaderWithLighting */
-static const char* fragmentShaderWithLighting = "#define DELTA 0.01                                            \n"
+static const char* fragmentShaderWithLighting = "uniform vec3 texelSize;                                       \n"
     "#define THRESHOLD 0.1                                         \n"
     "uniform sampler3D volume;                                     \n"
+    "#ifdef GRADIENT_TEXTURE                                       \n"
+    "uniform sampler3D gradientVolume;                             \n"
+    "#endif                                                        \n"
     "uniform sampler1D colormap1D;                                 \n"
     "uniform vec4 lightPosition;                                   \n"
     "uniform vec4 eyePosition;                                     \n"
+    "#ifdef NORMAL_SHADING                                         \n"
     "uniform vec3 ambientColor;                                    \n"
     "uniform vec3 diffuseColor;                                    \n"
     "uniform vec3 specularColor;                                   \n"
@@ -404,19 +476,31 @@ static const char* fragmentShaderWithLighting = "#define DELTA 0.01
     "uniform vec3 kSpecular;                                       \n"
     "uniform float shininess;                                      \n"
     "uniform float normalContribution;                             \n"
+    "#endif                                                        \n"
+    "#ifdef TONE_SHADING                                           \n"
     "uniform float toneContribution;                               \n"
     "uniform vec3 coolColor;                                       \n"
     "uniform vec3 warmColor;                                       \n"
+    "#endif                                                        \n"
+    "#ifdef TOON_SHADING                                           \n"
     "uniform float toonContribution;                               \n"
     "uniform vec3 toonColor;                                       \n"
+    "#endif                                                        \n"
+    "#ifdef BOUNDARY_SHADING                                       \n"
     "uniform float boundaryContribution;                           \n"
     "uniform float boundaryExponent;                               \n"
+    "#endif                                                        \n"
+    "#ifdef SILHOUETTE_SHADING                                     \n"
     "uniform float silhouetteContribution;                         \n"
     "uniform float silhouetteExponent;                             \n"
+    "#endif                                                        \n"
+    "#ifdef EDGE_SHADING                                           \n"
     "uniform float edgeContribution;                               \n"
     "uniform float edgeExponent;                                   \n"
     "uniform float edgeThreshold;                                  \n"
+    "#endif                                                        \n"
     "                                                              \n"
+    "#ifdef NORMAL_SHADING                                         \n"
     "vec3 normalShading(vec3 N, vec3 V, vec3 L, float diffuseLight)\n"
     "{                                                             \n"
     "// calculate halfway vector                                   \n"
@@ -431,13 +515,17 @@ static const char* fragmentShaderWithLighting = "#define DELTA 0.01
     "    vec3 specular = kSpecular * specularColor * specularLight;\n"
     "    return ambient + diffuse + specular;                      \n"
     "}                                                             \n"
+    "#endif                                                        \n"
     "                                                              \n"
+    "#ifdef TONE_SHADING                                           \n"
     "vec3 toneShading(float diffuseLight)                          \n"
     "{                                                             \n"
     "    vec3 tone = (((1.0+diffuseLight)*0.5)*warmColor + (1.0-((1.0+diffuseLight)*0.5))*coolColor);\n"
     "    return tone;                                              \n"
     "}                                                             \n"
+    "#endif                                                        \n"
     "                                                              \n"
+    "#ifdef TOON_SHADING                                           \n"
     "vec3 toonShading(float diffuseLight)                          \n"
     "{                                                             \n"
     "    vec3 color = toonColor - vec3(1.0, 1.0, 1.0);             \n"
@@ -449,17 +537,23 @@ static const char* fragmentShaderWithLighting = "#define DELTA 0.01
     "    else if (diffuseLight > 0.25) return color3;              \n"
     "    else return toonColor;                                    \n"
     "}                                                             \n"
+    "#endif                                                        \n"
     "                                                              \n"
+    "#ifdef BOUNDARY_SHADING                                       \n"
     "float boundaryShading(float gradient)                         \n"
     "{                                                             \n"
     "    return pow(gradient,boundaryExponent);                    \n"
     "}                                                             \n"
+    "#endif                                                        \n"
     "                                                              \n"
+    "#ifdef SILHOUETTE_SHADING                                     \n"
     "float silhouetteShading(float angleVN)                        \n"
     "{                                                             \n"
     "    return pow(1.0-abs(angleVN),silhouetteExponent);          \n"
     "}                                                             \n"
+    "#endif                                                        \n"
     "                                                              \n"
+    "#ifdef EDGE_SHADING                                           \n"
     "vec3 edgeShading(vec3 color, float angleVN)                   \n"
     "{                                                             \n"
     "    float edgeValue = pow(1.0-abs(angleVN),edgeExponent);     \n"
@@ -469,33 +563,50 @@ static const char* fragmentShaderWithLighting = "#define DELTA 0.01
     "    }                                                         \n"
     "    return color;                                             \n"
     "}                                                             \n"
+    "#endif                                                        \n"
     "                                                              \n"
     "void main (void)                                              \n"
     "{                                                             \n"
     "   float x = texture3D(volume, gl_TexCoord[0].xyz).x;         \n"
     "   vec4 c = texture1D(colormap1D, x);                         \n"
     "   if (c.a > THRESHOLD) {                                     \n"
+    "#ifdef GRADIENT_TEXTURE                                       \n"
+    "      vec3 N = normalize(texture3D(gradientVolume, gl_TexCoord[0].xyz).rgb * 2.0 - 1.0);\n"
+    "#else                                                         \n"
     "      vec3 sample1, sample2;                                  \n"
-    "      sample1.x  = texture3D(volume, gl_TexCoord[0].xyz - vec3(DELTA,0.0,0.0)).x;\n"
-    "      sample2.x  = texture3D(volume, gl_TexCoord[0].xyz + vec3(DELTA,0.0,0.0)).x;\n"
-    "      sample1.y  = texture3D(volume, gl_TexCoord[0].xyz - vec3(0.0,DELTA,0.0)).y;\n"
-    "      sample2.y  = texture3D(volume, gl_TexCoord[0].xyz + vec3(0.0,DELTA,0.0)).y;\n"
-    "      sample1.z  = texture3D(volume, gl_TexCoord[0].xyz - vec3(0.0,0.0,DELTA)).z;\n"
-    "      sample2.z  = texture3D(volume, gl_TexCoord[0].xyz + vec3(0.0,0.0,DELTA)).z;\n"
+    "      sample1.x  = texture3D(volume, gl_TexCoord[0].xyz - vec3(texelSize.x,0.0,0.0)).x;\n"
+    "      sample2.x  = texture3D(volume, gl_TexCoord[0].xyz + vec3(texelSize.x,0.0,0.0)).x;\n"
+    "      sample1.y  = texture3D(volume, gl_TexCoord[0].xyz - vec3(0.0,texelSize.y,0.0)).y;\n"
+    "      sample2.y  = texture3D(volume, gl_TexCoord[0].xyz + vec3(0.0,texelSize.y,0.0)).y;\n"
+    "      sample1.z  = texture3D(volume, gl_TexCoord[0].xyz - vec3(0.0,0.0,texelSize.z)).z;\n"
+    "      sample2.z  = texture3D(volume, gl_TexCoord[0].xyz + vec3(0.0,0.0,texelSize.z)).z;\n"
     "      vec3 N = normalize(sample2 - sample1);                  \n"
-    "      vec3 L = normalize((gl_ModelViewProjectionMatrix * lightPosition).xyz - gl_TexCoord[1].xyz); \n"
-    "      vec3 V = normalize((gl_ModelViewProjectionMatrix * eyePosition).xyz - gl_TexCoord[1].xyz);   \n"
+    "#endif                                                        \n"
+    "      vec3 L = normalize(lightPosition.xyz - gl_TexCoord[1].xyz); \n"
+    "      vec3 V = normalize(eyePosition.xyz - gl_TexCoord[1].xyz);   \n"
     "      float diffuseLight = dot(L, N);                         \n"
+    "#ifdef NORMAL_SHADING                                         \n"
     "      c.rgb += normalContribution * normalShading(N, V, L, diffuseLight);   \n"
+    "#endif                                                        \n"
+    "#ifdef TONE_SHADING                                           \n"
     "      c.rgb += toneContribution * toneShading(diffuseLight);  \n"
+    "#endif                                                        \n"
+    "#ifdef TOON_SHADING                                           \n"
     "      c.rgb += toonContribution * toonShading(diffuseLight);  \n"
+    "#endif                                                        \n"
     "      float gradient = dot(N, N);                             \n"
+    "#ifdef BOUNDARY_SHADING                                       \n"
     "      c.a += boundaryContribution * boundaryShading(gradient);\n"
+    "#endif                                                        \n"
     "      float angleVN = dot(V, N);                              \n"
+    "#ifdef SILHOUETTE_SHADING                                     \n"
     "      c.a += silhouetteContribution * silhouetteShading(angleVN);\n"
+    "#endif                                                        \n"
+    "#ifdef EDGE_SHADING                                           \n"
     "      if (edgeContribution > 0.0) {                           \n"
     "         c.rgb = edgeShading(c.rgb, angleVN);                 \n"
     "      }                                                       \n"
+    "#endif                                                        \n"
     "   }                                                          \n"
     "   gl_FragColor = c;                                          \n"
     "}                                                           \n\0";
@@ -518,7 +629,7 @@ static const char* multiComponentFragmentShader = "uniform sampler3D volume;
     "}                                                           \n\0";
 
 /* fragmentShaderWithLighting */
-static const char* multiComponentFragmentShaderWithLighting = "#define DELTA 0.01                                            \n"
+static const char* multiComponentFragmentShaderWithLighting = "uniform vec3 texelSize;                                       \n"
     "#define THRESHOLD 0.1                                         \n"
     "uniform sampler3D volume;                                     \n"
     "uniform sampler1D colormap1D;                                 \n"
@@ -527,6 +638,7 @@ static const char* multiComponentFragmentShaderWithLighting = "#define DELTA 0.0
     "uniform float blueScale;                                      \n"
     "uniform vec4 lightPosition;                                   \n"
     "uniform vec4 eyePosition;                                     \n"
+    "#ifdef NORMAL_SHADING                                         \n"
     "uniform vec3 ambientColor;                                    \n"
     "uniform vec3 diffuseColor;                                    \n"
     "uniform vec3 specularColor;                                   \n"
@@ -535,19 +647,31 @@ static const char* multiComponentFragmentShaderWithLighting = "#define DELTA 0.0
     "uniform vec3 kSpecular;                                       \n"
     "uniform float shininess;                                      \n"
     "uniform float normalContribution;                             \n"
+    "#endif                                                        \n"
+    "#ifdef TONE_SHADING                                           \n"
     "uniform float toneContribution;                               \n"
     "uniform vec3 coolColor;                                       \n"
     "uniform vec3 warmColor;                                       \n"
+    "#endif                                                        \n"
+    "#ifdef TOON_SHADING                                           \n"
     "uniform float toonContribution;                               \n"
     "uniform vec3 toonColor;                                       \n"
+    "#endif                                                        \n"
+    "#ifdef BOUNDARY_SHADING                                       \n"
     "uniform float boundaryContribution;                           \n"
     "uniform float boundaryExponent;                               \n"
+    "#endif                                                        \n"
+    "#ifdef SILHOUETTE_SHADING                                     \n"
     "uniform float silhouetteContribution;                         \n"
     "uniform float silhouetteExponent;                             \n"
+    "#endif                                                        \n"
+    "#ifdef EDGE_SHADING                                           \n"
     "uniform float edgeContribution;                               \n"
     "uniform float edgeExponent;                                   \n"
     "uniform float edgeThreshold;                                  \n"
+    "#endif                                                        \n"
     "                                                              \n"
+    "#ifdef NORMAL_SHADING                                         \n"
     "vec3 normalShading(vec3 N, vec3 V, vec3 L, float diffuseLight)\n"
     "{                                                             \n"
     "// calculate halfway vector                                   \n"
@@ -562,13 +686,17 @@ static const char* multiComponentFragmentShaderWithLighting = "#define DELTA 0.0
     "    vec3 specular = kSpecular * specularColor * specularLight;\n"
     "    return ambient + diffuse + specular;                      \n"
     "}                                                             \n"
+    "#endif                                                        \n"
     "                                                              \n"
+    "#ifdef TONE_SHADING                                           \n"
     "vec3 toneShading(float diffuseLight)                          \n"
     "{                                                             \n"
     "    vec3 tone = (((1.0+diffuseLight)*0.5)*warmColor + (1.0-((1.0+diffuseLight)*0.5))*coolColor);\n"
     "    return tone;                                              \n"
     "}                                                             \n"
+    "#endif                                                        \n"
     "                                                              \n"
+    "#ifdef TOON_SHADING                                           \n"
     "vec3 toonShading(float diffuseLight)                          \n"
     "{                                                             \n"
     "    vec3 color = toonColor - vec3(1.0, 1.0, 1.0);             \n"
@@ -580,17 +708,23 @@ static const char* multiComponentFragmentShaderWithLighting = "#define DELTA 0.0
     "    else if (diffuseLight > 0.25) return color3;              \n"
     "    else return toonColor;                                    \n"
     "}                                                             \n"
+    "#endif                                                        \n"
     "                                                              \n"
+    "#ifdef BOUNDARY_SHADING                                       \n"
     "float boundaryShading(float gradient)                         \n"
     "{                                                             \n"
     "    return pow(gradient,boundaryExponent);                    \n"
     "}                                                             \n"
+    "#endif                                                        \n"
     "                                                              \n"
+    "#ifdef SILHOUETTE_SHADING                                     \n"
     "float silhouetteShading(float angleVN)                        \n"
     "{                                                             \n"
     "    return pow(1.0-abs(angleVN),silhouetteExponent);          \n"
     "}                                                             \n"
+    "#endif                                                        \n"
     "                                                              \n"
+    "#ifdef EDGE_SHADING                                           \n"
     "vec3 edgeShading(vec3 color, float angleVN)                   \n"
     "{                                                             \n"
     "    float edgeValue = pow(1.0-abs(angleVN),edgeExponent);     \n"
@@ -600,6 +734,7 @@ static const char* multiComponentFragmentShaderWithLighting = "#define DELTA 0.0
     "    }                                                         \n"
     "    return color;                                             \n"
     "}                                                             \n"
+    "#endif                                                        \n"
     "                                                              \n"
     "void main (void)                                              \n"
     "{                                                             \n"
@@ -610,26 +745,38 @@ static const char* multiComponentFragmentShaderWithLighting = "#define DELTA 0.0
     "   vec4 color = vec4(r, g, b, r+g+b);                         \n"
     "   if (color.a > THRESHOLD) {                                 \n"
     "      vec3 sample1, sample2;                                  \n"
-    "      sample1.x  = texture3D(volume, gl_TexCoord[0].xyz - vec3(DELTA,0.0,0.0)).x;\n"
-    "      sample2.x  = texture3D(volume, gl_TexCoord[0].xyz + vec3(DELTA,0.0,0.0)).x;\n"
-    "      sample1.y  = texture3D(volume, gl_TexCoord[0].xyz - vec3(0.0,DELTA,0.0)).y;\n"
-    "      sample2.y  = texture3D(volume, gl_TexCoord[0].xyz + vec3(0.0,DELTA,0.0)).y;\n"
-    "      sample1.z  = texture3D(volume, gl_TexCoord[0].xyz - vec3(0.0,0.0,DELTA)).z;\n"
-    "      sample2.z  = texture3D(volume, gl_TexCoord[0].xyz + vec3(0.0,0.0,DELTA)).z;\n"
+    "      sample1.x  = texture3D(volume, gl_TexCoord[0].xyz - vec3(texelSize.x,0.0,0.0)).x;\n"
+    "      sample2.x  = texture3D(volume, gl_TexCoord[0].xyz + vec3(texelSize.x,0.0,0.0)).x;\n"
+    "      sample1.y  = texture3D(volume, gl_TexCoord[0].xyz - vec3(0.0,texelSize.y,0.0)).y;\n"
+    "      sample2.y  = texture3D(volume, gl_TexCoord[0].xyz + vec3(0.0,texelSize.y,0.0)).y;\n"
+    "      sample1.z  = texture3D(volume, gl_TexCoord[0].xyz - vec3(0.0,0.0,texelSize.z)).z;\n"
+    "      sample2.z  = texture3D(volume, gl_TexCoord[0].xyz + vec3(0.0,0.0,texelSize.z)).z;\n"
     "      vec3 N = normalize(sample2 - sample1);                  \n"
-    "      vec3 L = normalize((gl_ModelViewProjectionMatrix * lightPosition).xyz - gl_TexCoord[1].xyz); \n"
-    "      vec3 V = normalize((gl_ModelViewProjectionMatrix * eyePosition).xyz - gl_TexCoord[1].xyz);   \n"
+    "      vec3 L = normalize(lightPosition.xyz - gl_TexCoord[1].xyz); \n"
+    "      vec3 V = normalize(eyePosition.xyz - gl_TexCoord[1].xyz);   \n"
     "      float diffuseLight = dot(L, N);                         \n"
+    "#ifdef NORMAL_SHADING                                         \n"
     "      color.rgb += normalContribution * normalShading(N, V, L, diffuseLight);   \n"
+    "#endif                                                        \n"
+    "#ifdef TONE_SHADING                                           \n"
     "      color.rgb += toneContribution * toneShading(diffuseLight);  \n"
+    "#endif                                                        \n"
+    "#ifdef TOON_SHADING                                           \n"
     "      color.rgb += toonContribution * toonShading(diffuseLight);  \n"
+    "#endif                                                        \n"
     "      float gradient = dot(N, N);                             \n"
+    "#ifdef BOUNDARY_SHADING                                       \n"
     "      color.a += boundaryContribution * boundaryShading(gradient);\n"
+    "#endif                                                        \n"
     "      float angleVN = dot(V, N);                              \n"
+    "#ifdef SILHOUETTE_SHADING                                     \n"
     "      color.a += silhouetteContribution * silhouetteShading(angleVN);\n"
+    "#endif                                                        \n"
+    "#ifdef EDGE_SHADING                                           \n"
     "      if (edgeContribution > 0.0) {                           \n"
     "         color.rgb = edgeShading(color.rgb, angleVN);         \n"
     "      }                                                       \n"
+    "#endif                                                        \n"
     "   }                                                          \n"
     "   gl_FragColor = color;                                      \n"
     "}                                                           \n\0";
@@ -648,12 +795,16 @@ static const char* preIntegratedFragmentShader = "uniform sampler3D volume;
     "}                                                           \n\0";
 
 /* preIntegratedFragmentShaderWithLighting */
-static const char* preIntegratedFragmentShaderWithLighting = "#define DELTA 0.01                                            \n"
+static const char* preIntegratedFragmentShaderWithLighting = "uniform vec3 texelSize;                                       \n"
     "#define THRESHOLD 0.1                                         \n"
     "uniform sampler3D volume;                                     \n"
+    "#ifdef GRADIENT_TEXTURE                                       \n"
+    "uniform sampler3D gradientVolume;                             \n"
+    "#endif                                                        \n"
     "uniform sampler2D colormap2D;                                 \n"
     "uniform vec4 lightPosition;                                   \n"
     "uniform vec4 eyePosition;                                     \n"
+    "#ifdef NORMAL_SHADING                                         \n"
     "uniform vec3 ambientColor;                                    \n"
     "uniform vec3 diffuseColor;                                    \n"
     "uniform vec3 specularColor;                                   \n"
@@ -662,19 +813,31 @@ static const char* preIntegratedFragmentShaderWithLighting = "#define DELTA 0.01
     "uniform vec3 kSpecular;                                       \n"
     "uniform float shininess;                                      \n"
     "uniform float normalContribution;                             \n"
+    "#endif                                                        \n"
+    "#ifdef TONE_SHADING                                           \n"
     "uniform float toneContribution;                               \n"
     "uniform vec3 coolColor;                                       \n"
     "uniform vec3 warmColor;                                       \n"
+    "#endif                                                        \n"
+    "#ifdef TOON_SHADING                                           \n"
     "uniform float toonContribution;                               \n"
     "uniform vec3 toonColor;                                       \n"
+    "#endif                                                        \n"
+    "#ifdef BOUNDARY_SHADING                                       \n"
     "uniform float boundaryContribution;                           \n"
     "uniform float boundaryExponent;                               \n"
+    "#endif                                                        \n"
+    "#ifdef SILHOUETTE_SHADING                                     \n"
     "uniform float silhouetteContribution;                         \n"
     "uniform float silhouetteExponent;                             \n"
+    "#endif                                                        \n"
+    "#ifdef EDGE_SHADING                                           \n"
     "uniform float edgeContribution;                               \n"
     "uniform float edgeExponent;                                   \n"
     "uniform float edgeThreshold;                                  \n"
+    "#endif                                                        \n"
     "                                                              \n"
+    "#ifdef NORMAL_SHADING                                         \n"
     "vec3 normalShading(vec3 N, vec3 V, vec3 L, float diffuseLight)\n"
     "{                                                             \n"
     "// calculate halfway vector                                   \n"
@@ -689,13 +852,17 @@ static const char* preIntegratedFragmentShaderWithLighting = "#define DELTA 0.01
     "    vec3 specular = kSpecular * specularColor * specularLight;\n"
     "    return ambient + diffuse + specular;                      \n"
     "}                                                             \n"
+    "#endif                                                        \n"
     "                                                              \n"
+    "#ifdef TONE_SHADING                                           \n"
     "vec3 toneShading(float diffuseLight)                          \n"
     "{                                                             \n"
     "    vec3 tone = (((1.0+diffuseLight)*0.5)*warmColor + (1.0-((1.0+diffuseLight)*0.5))*coolColor);\n"
     "    return tone;                                              \n"
     "}                                                             \n"
+    "#endif                                                        \n"
     "                                                              \n"
+    "#ifdef TOON_SHADING                                           \n"
     "vec3 toonShading(float diffuseLight)                          \n"
     "{                                                             \n"
     "    vec3 color = toonColor - vec3(1.0, 1.0, 1.0);             \n"
@@ -707,17 +874,23 @@ static const char* preIntegratedFragmentShaderWithLighting = "#define DELTA 0.01
     "    else if (diffuseLight > 0.25) return color3;              \n"
     "    else return toonColor;                                    \n"
     "}                                                             \n"
+    "#endif                                                        \n"
     "                                                              \n"
+    "#ifdef BOUNDARY_SHADING                                       \n"
     "float boundaryShading(float gradient)                         \n"
     "{                                                             \n"
     "    return pow(gradient,boundaryExponent);  \n"
     "}                                                             \n"
+    "#endif                                                        \n"
     "                                                              \n"
+    "#ifdef SILHOUETTE_SHADING                                     \n"
     "float silhouetteShading(float angleVN)                        \n"
     "{                                                             \n"
     "    return pow(1.0-abs(angleVN),silhouetteExponent);          \n"
     "}                                                             \n"
+    "#endif                                                        \n"
     "                                                              \n"
+    "#ifdef EDGE_SHADING                                           \n"
     "vec3 edgeShading(vec3 color, float angleVN)                   \n"
     "{                                                             \n"
     "    float edgeValue = pow(1.0-abs(angleVN),edgeExponent);     \n"
@@ -727,6 +900,7 @@ static const char* preIntegratedFragmentShaderWithLighting = "#define DELTA 0.01
     "    }                                                         \n"
     "    return color;                                             \n"
     "}                                                             \n"
+    "#endif                                                        \n"
     "                                                              \n"
     "void main (void)                                              \n"
     "{                                                             \n"
@@ -735,27 +909,43 @@ static const char* preIntegratedFragmentShaderWithLighting = "#define DELTA 0.01
     "	vec2 coord = vec2(x, y);                                   \n"
     "	vec4 c = texture2D(colormap2D, coord);                     \n"
     "   if (c.a > THRESHOLD) {                                     \n"
+    "#ifdef GRADIENT_TEXTURE                                       \n"
+    "      vec3 N = normalize(texture3D(gradientVolume, gl_TexCoord[0].xyz).rgb * 2.0 - 1.0);\n"
+    "#else                                                         \n"
     "      vec3 sample1, sample2;                                  \n"
-    "      sample1.x  = texture3D(volume, gl_TexCoord[0].xyz - vec3(DELTA,0.0,0.0)).x;\n"
-    "      sample2.x  = texture3D(volume, gl_TexCoord[0].xyz + vec3(DELTA,0.0,0.0)).x;\n"
-    "      sample1.y  = texture3D(volume, gl_TexCoord[0].xyz - vec3(0.0,DELTA,0.0)).x;\n"
-    "      sample2.y  = texture3D(volume, gl_TexCoord[0].xyz + vec3(0.0,DELTA,0.0)).x;\n"
-    "      sample1.z  = texture3D(volume, gl_TexCoord[0].xyz - vec3(0.0,0.0,DELTA)).x;\n"
-    "      sample2.z  = texture3D(volume, gl_TexCoord[0].xyz + vec3(0.0,0.0,DELTA)).x;\n"
+    "      sample1.x  = texture3D(volume, gl_TexCoord[0].xyz - vec3(texelSize.x,0.0,0.0)).x;\n"
+    "      sample2.x  = texture3D(volume, gl_TexCoord[0].xyz + vec3(texelSize.x,0.0,0.0)).x;\n"
+    "      sample1.y  = texture3D(volume, gl_TexCoord[0].xyz - vec3(0.0,texelSize.y,0.0)).x;\n"
+    "      sample2.y  = texture3D(volume, gl_TexCoord[0].xyz + vec3(0.0,texelSize.y,0.0)).x;\n"
+    "      sample1.z  = texture3D(volume, gl_TexCoord[0].xyz - vec3(0.0,0.0,texelSize.z)).x;\n"
+    "      sample2.z  = texture3D(volume, gl_TexCoord[0].xyz + vec3(0.0,0.0,texelSize.z)).x;\n"
     "      vec3 N = normalize(sample2 - sample1);                  \n"
-    "      vec3 L = normalize((gl_ModelViewProjectionMatrix * lightPosition).xyz - gl_TexCoord[1].xyz); \n"
-    "      vec3 V = normalize((gl_ModelViewProjectionMatrix * eyePosition).xyz - gl_TexCoord[1].xyz);   \n"
+    "#endif                                                        \n"
+    "      vec3 L = normalize(lightPosition.xyz - gl_TexCoord[2].xyz); \n"
+    "      vec3 V = normalize(eyePosition.xyz - gl_TexCoord[2].xyz);   \n"
     "      float diffuseLight = dot(L, N);                         \n"
+    "#ifdef NORMAL_SHADING                                         \n"
     "      c.rgb += normalContribution * normalShading(N, V, L, diffuseLight);   \n"
+    "#endif                                                        \n"
+    "#ifdef TONE_SHADING                                           \n"
     "      c.rgb += toneContribution * toneShading(diffuseLight);  \n"
+    "#endif                                                        \n"
+    "#ifdef TOON_SHADING                                           \n"
     "      c.rgb += toonContribution * toonShading(diffuseLight);  \n"
+    "#endif                                                        \n"
     "      float gradient = dot(N, N);                             \n"
+    "#ifdef BOUNDARY_SHADING                                       \n"
     "      c.a += boundaryContribution * boundaryShading(gradient);\n"
+    "#endif                                                        \n"
     "      float angleVN = dot(V, N);                              \n"
+    "#ifdef SILHOUETTE_SHADING                                     \n"
     "      c.a += silhouetteContribution * silhouetteShading(angleVN);\n"
+    "#endif                                                        \n"
+    "#ifdef EDGE_SHADING                                           \n"
     "      if (edgeContribution > 0.0) {                           \n"
     "         c.rgb = edgeShading(c.rgb, angleVN);                 \n"
     "      }                                                       \n"
+    "#endif                                                        \n"
     "   }                                                          \n"
     "	gl_FragColor = c;                                          \n"
     "}                                                           \n\0";
@@ -782,7 +972,7 @@ static const char* preIntegratedMultiComponentFragmentShader = "uniform sampler3
     "}                                                           \n\0";
 
 /* preIntegratedFragmentShaderWithLighting */
-static const char* preIntegratedMultiComponentFragmentShaderWithLighting = "#define DELTA 0.01                                            \n"
+static const char* preIntegratedMultiComponentFragmentShaderWithLighting = "uniform vec3 texelSize;                                       \n"
     "#define THRESHOLD 0.1                                         \n"
     "uniform sampler3D volume;                                     \n"
     "uniform sampler2D colormap2D;                                 \n"
@@ -791,6 +981,7 @@ static const char* preIntegratedMultiComponentFragmentShaderWithLighting = "#def
     "uniform float blueScale;                                      \n"
     "uniform vec4 lightPosition;                                   \n"
     "uniform vec4 eyePosition;                                     \n"
+    "#ifdef NORMAL_SHADING                                         \n"
     "uniform vec3 ambientColor;                                    \n"
     "uniform vec3 diffuseColor;                                    \n"
     "uniform vec3 specularColor;                                   \n"
@@ -799,19 +990,31 @@ static const char* preIntegratedMultiComponentFragmentShaderWithLighting = "#def
     "uniform vec3 kSpecular;                                       \n"
     "uniform float shininess;                                      \n"
     "uniform float normalContribution;                             \n"
+    "#endif                                                        \n"
+    "#ifdef TONE_SHADING                                           \n"
     "uniform float toneContribution;                               \n"
     "uniform vec3 coolColor;                                       \n"
     "uniform vec3 warmColor;                                       \n"
+    "#endif                                                        \n"
+    "#ifdef TOON_SHADING                                           \n"
     "uniform float toonContribution;                               \n"
     "uniform vec3 toonColor;                                       \n"
+    "#endif                                                        \n"
+    "#ifdef BOUNDARY_SHADING                                       \n"
     "uniform float boundaryContribution;                           \n"
     "uniform float boundaryExponent;                               \n"
+    "#endif                                                        \n"
+    "#ifdef SILHOUETTE_SHADING                                     \n"
     "uniform float silhouetteContribution;                         \n"
     "uniform float silhouetteExponent;                             \n"
+    "#endif                                                        \n"
+    "#ifdef EDGE_SHADING                                           \n"
     "uniform float edgeContribution;                               \n"
     "uniform float edgeExponent;                                   \n"
     "uniform float edgeThreshold;                                  \n"
+    "#endif                                                        \n"
     "                                                              \n"
+    "#ifdef NORMAL_SHADING                                         \n"
     "vec3 normalShading(vec3 N, vec3 V, vec3 L, float diffuseLight)\n"
     "{                                                             \n"
     "// calculate halfway vector                                   \n"
@@ -826,13 +1029,17 @@ static const char* preIntegratedMultiComponentFragmentShaderWithLighting = "#def
     "    vec3 specular = kSpecular * specularColor * specularLight;\n"
     "    return ambient + diffuse + specular;                      \n"
     "}                                                             \n"
+    "#endif                                                        \n"
     "                                                              \n"
+    "#ifdef TONE_SHADING                                           \n"
     "vec3 toneShading(float diffuseLight)                          \n"
     "{                                                             \n"
     "    vec3 tone = (((1.0+diffuseLight)*0.5)*warmColor + (1.0-((1.0+diffuseLight)*0.5))*coolColor);\n"
     "    return tone;                                              \n"
     "}                                                             \n"
+    "#endif                                                        \n"
     "                                                              \n"
+    "#ifdef TOON_SHADING                                           \n"
     "vec3 toonShading(float diffuseLight)                          \n"
     "{                                                             \n"
     "    vec3 color = toonColor - vec3(1.0, 1.0, 1.0);             \n"
@@ -844,17 +1051,23 @@ static const char* preIntegratedMultiComponentFragmentShaderWithLighting = "#def
     "    else if (diffuseLight > 0.25) return color3;              \n"
     "    else return toonColor;                                    \n"
     "}                                                             \n"
+    "#endif                                                        \n"
     "                                                              \n"
+    "#ifdef BOUNDARY_SHADING                                       \n"
     "float boundaryShading(float gradient)                         \n"
     "{                                                             \n"
     "    return pow(gradient,boundaryExponent);  \n"
     "}                                                             \n"
+    "#endif                                                        \n"
     "                                                              \n"
+    "#ifdef SILHOUETTE_SHADING                                     \n"
     "float silhouetteShading(float angleVN)                        \n"
     "{                                                             \n"
     "    return pow(1.0-abs(angleVN),silhouetteExponent);          \n"
     "}                                                             \n"
+    "#endif                                                        \n"
     "                                                              \n"
+    "#ifdef EDGE_SHADING                                           \n"
     "vec3 edgeShading(vec3 color, float angleVN)                   \n"
     "{                                                             \n"
     "    float edgeValue = pow(1.0-abs(angleVN),edgeExponent);     \n"
@@ -864,6 +1077,7 @@ static const char* preIntegratedMultiComponentFragmentShaderWithLighting = "#def
     "    }                                                         \n"
     "    return color;                                             \n"
     "}                                                             \n"
+    "#endif                                                        \n"
     "                                                              \n"
     "void main (void)                                              \n"
     "{                                                             \n"
@@ -878,26 +1092,38 @@ static const char* preIntegratedMultiComponentFragmentShaderWithLighting = "#def
     "   vec4 c = vec4(r, g, b, r+g+b);                             \n"
     "   if (c.a > THRESHOLD) {                                     \n"
     "      vec3 sample1, sample2;                                  \n"
-    "      sample1.x  = texture3D(volume, gl_TexCoord[0].xyz - vec3(DELTA,0.0,0.0)).x;\n"
-    "      sample2.x  = texture3D(volume, gl_TexCoord[0].xyz + vec3(DELTA,0.0,0.0)).x;\n"
-    "      sample1.y  = texture3D(volume, gl_TexCoord[0].xyz - vec3(0.0,DELTA,0.0)).x;\n"
-    "      sample2.y  = texture3D(volume, gl_TexCoord[0].xyz + vec3(0.0,DELTA,0.0)).x;\n"
-    "      sample1.z  = texture3D(volume, gl_TexCoord[0].xyz - vec3(0.0,0.0,DELTA)).x;\n"
-    "      sample2.z  = texture3D(volume, gl_TexCoord[0].xyz + vec3(0.0,0.0,DELTA)).x;\n"
+    "      sample1.x  = texture3D(volume, gl_TexCoord[0].xyz - vec3(texelSize.x,0.0,0.0)).x;\n"
+    "      sample2.x  = texture3D(volume, gl_TexCoord[0].xyz + vec3(texelSize.x,0.0,0.0)).x;\n"
+    "      sample1.y  = texture3D(volume, gl_TexCoord[0].xyz - vec3(0.0,texelSize.y,0.0)).x;\n"
+    "      sample2.y  = texture3D(volume, gl_TexCoord[0].xyz + vec3(0.0,texelSize.y,0.0)).x;\n"
+    "      sample1.z  = texture3D(volume, gl_TexCoord[0].xyz - vec3(0.0,0.0,texelSize.z)).x;\n"
+    "      sample2.z  = texture3D(volume, gl_TexCoord[0].xyz + vec3(0.0,0.0,texelSize.z)).x;\n"
     "      vec3 N = normalize(sample2 - sample1);                  \n"
-    "      vec3 L = normalize((gl_ModelViewProjectionMatrix * lightPosition).xyz - gl_TexCoord[1].xyz); \n"
-    "      vec3 V = normalize((gl_ModelViewProjectionMatrix * eyePosition).xyz - gl_TexCoord[1].xyz);   \n"
+    "      vec3 L = normalize(lightPosition.xyz - gl_TexCoord[2].xyz); \n"
+    "      vec3 V = normalize(eyePosition.xyz - gl_TexCoord[2].xyz);   \n"
     "      float diffuseLight = dot(L, N);                         \n"
+    "#ifdef NORMAL_SHADING                                         \n"
     "      c.rgb += normalContribution * normalShading(N, V, L, diffuseLight);   \n"
+    "#endif                                                        \n"
+    "#ifdef TONE_SHADING                                           \n"
     "      c.rgb += toneContribution * toneShading(diffuseLight);  \n"
+    "#endif                                                        \n"
+    "#ifdef TOON_SHADING                                           \n"
     "      c.rgb += toonContribution * toonShading(diffuseLight);  \n"
+    "#endif                                                        \n"
     "      float gradient = dot(N, N);                             \n"
+    "#ifdef BOUNDARY_SHADING                                       \n"
     "      c.a += boundaryContribution * boundaryShading(gradient);\n"
+    "#endif                                                        \n"
     "      float angleVN = dot(V, N);                              \n"
+    "#ifdef SILHOUETTE_SHADING                                     \n"
     "      c.a += silhouetteContribution * silhouetteShading(angleVN);\n"
+    "#endif                                                        \n"
+    "#ifdef EDGE_SHADING                                           \n"
     "      if (edgeContribution > 0.0) {                           \n"
     "         c.rgb = edgeShading(c.rgb, angleVN);                 \n"
     "      }                                                       \n"
+    "#endif                                                        \n"
     "   }                                                          \n"
     "   gl_FragColor = c;                                          \n"
     "}                                                           \n\0";
@@ -942,13 +1168,21 @@ static GLint sequenceIndices[64] = { 0, 1, 2, 4, 5, 3, 6, 7, 1, 3, 0, 5, 7, 2, 4
         4, 4, 5, 0, 6, 7, 1, 2, 3, 5, 7, 1, 4, 6, 3, 0, 2, 6, 4, 2, 7, 5, 0, 3, 1, 7, 6, 3, 5, 4, 2, 1, 0 };
 
 // begin Forward Declarations
+class Benchmark;
 class Brick;
-class ComparableBrick;
+class BrickTree;
 class ComparableOcNode;
+class Compositor;
+class IlluminationCache;
 class Matrix4x4;
+class MemoryAccount;
+class OcNode;
 class Point4;
 class ShaderManager;
 class ShaderObject;
+class ShaderVariants;
+class StagingCache;
+class TextureAtlas;
 class Vector4;
 class Volume;
 // end Forward Declarations
@@ -963,14 +1197,38 @@ protected:
         ShaderObject* volumeShaderObjectFocusAndContext;
         ShaderObject* volumeShaderObject;
         ShaderObject* volumeShaderObject2D;
-        ShaderObject* volumeShaderObject2DWithLighting;
-        ShaderObject* volumeShaderObjectWithLighting;
+        ShaderObject* illuminatedVolumeShaderObject; // colors baked by the illumination cache, 0 for multi-component volumes
+        ShaderVariants* volumeShaderVariants2DWithLighting; // compiled on demand for the enabled shading terms
+        ShaderVariants* volumeShaderVariantsWithLighting;
         ShaderObject* preIntegratedVolumeShaderObject;
-        ShaderObject* preIntegratedVolumeShaderObjectWithLighting;
+        ShaderVariants* preIntegratedVolumeShaderVariantsWithLighting;
         ShaderObject* sliceShaderObject;
         CFrustum cFrustum;
         bool textureNonPowerOfTwo;
         GLint maximum3DTextureSize;
+        PFNGLBINDFRAMEBUFFEREXTPROC glBindFramebufferEXTProc;
+        PFNGLBINDRENDERBUFFEREXTPROC glBindRenderbufferEXTProc;
+        PFNGLBLENDFUNCSEPARATEPROC glBlendFuncSeparateProc;
+        PFNGLDELETEFRAMEBUFFERSEXTPROC glDeleteFramebuffersEXTProc;
+        PFNGLDELETERENDERBUFFERSEXTPROC glDeleteRenderbuffersEXTProc;
+        PFNGLFRAMEBUFFERRENDERBUFFEREXTPROC glFramebufferRenderbufferEXTProc;
+        PFNGLGENFRAMEBUFFERSEXTPROC glGenFramebuffersEXTProc;
+        PFNGLGENRENDERBUFFERSEXTPROC glGenRenderbuffersEXTProc;
+        PFNGLRENDERBUFFERSTORAGEEXTPROC glRenderbufferStorageEXTProc;
+        GLuint framebufferName; // off screen target for partial images
+        GLuint colorbufferName;
+        GLuint depthbufferName;
+        int framebufferWidth;
+        int framebufferHeight;
+        bool offscreen; // drawing a partial image to be composited
+        unsigned int colorMapVersion; // versions of the color maps last uploaded into this context
+        unsigned int sliceColorMapVersion;
+        float rotation[9]; // rotation of the last view drawn and the volume corner nearest to it
+        int minimumIndex;
+        bool stagingFinished; // this context has uploaded the textures of the bricks
+        long illuminationBudget; // bytes of baked colors this context may still upload in illuminationFrame
+        unsigned int illuminationFrame;
+        bool illuminationUploaded; // the bricks hold baked colors in this context
         DataItem(void);
         ~DataItem(void);
     };
@@ -979,12 +1237,20 @@ public:
     Scene(Volume* _volume, unsigned char* _colormap, float* _alpha, float * _alpha2_5D, float* _red, float* _green, float* _blue,
             unsigned char* _sliceColormap);
     ~Scene(void);
+    void accountMemory(MemoryAccount& memoryAccount) const;
     Vector4* calculateSlicePlaneNormal(Matrix4x4* modelviewInverse) const;
     void clearSpheres(void);
+    void invalidateClassification(void);
+    void calculateAlphaChanged(int & minimumChanged, int & maximumChanged) const;
     void createBricks(void);
+    void createOcTrees(void);
     void display(GLContextData& glContextData) const;
+    void frame(void);
+    void setCompositor(Compositor* _compositor);
     void drawBricks(GLContextData & glContextData, const CFrustum & cFrustum, ShaderObject * shaderObject, const std::vector<ComparableBrick> & brickList,
             float * point, int maximumIndex, int minimumIndex, Matrix4x4 * modelviewInverse) const;
+    void drawCompositedImage(const GLint* viewport, const unsigned char* image) const;
+    bool drawCompositedVolume(GLContextData & glContextData, DataItem* dataItem) const;
     void drawGrid(DataItem* dataItem, const std::vector<ComparableBrick> & brickList) const;
     void drawOutline(void) const;
     void drawSlices(GLContextData & glContextData, DataItem* dataItem, const std::vector<ComparableBrick> & brickList) const;
@@ -993,6 +1259,7 @@ public:
     void setAlphaChanged(bool _alphaChanged);
     void setAmbientColor(float r, float g, float b, float a);
     void setAnimating(bool _animating);
+    void setBenchmark(Benchmark* _benchmark);
     void setBlueScale(float _blueScale);
     void setBoundaryContribution(float boundaryContribution);
     void setBoundaryExponent(float boundaryExponent);
@@ -1018,6 +1285,7 @@ public:
     void setMaximumPriorityQueueSizeChanged(bool _maximumPriorityQueueSizeChanged);
     void setMaximumPriorityQueueTest(bool _maximumPriorityQueueTest);
     void setNormalContribution(float normalContribution);
+    int getNumberOfBricks(void) const;
     void setPerspective(bool _perspective);
     bool getPreintegrated(void) const;
     void setPreintegrated(bool preintegrated);
@@ -1055,18 +1323,30 @@ public:
     void setYStep(int yStep);
     void setZSlice(int _zSlice);
     void setZStep(int zStep);
+    unsigned int getShadingFeatures(void) const;
+    void getTextureLimits(bool & _textureNonPowerOfTwo, int & _maximum3DTextureSize) const;
+    void determineOcNodesToDisplay(const float* point);
+    float getImportance(OcNode* ocNode, const float* point, float numberOfVoxels) const;
     void initContext(GLContextData& glContextData) const;
     void initialize(void);
     void initialize1DColorMap(DataItem* dataItem) const;
     void initialize2DColorMap(DataItem* dataItem) const;
     void initialize1DSliceColorMap(DataItem* dataItem) const;
+    bool isInSameBrick(const float* point, const float* otherPoint) const;
+    bool isRefinementStale(const float* point) const;
+    void locateBrick(const float* point, int* index) const;
+    void partitionAdaptiveBricks(void);
+    void partitionBricks(void);
+    void partitionRegularBricks(void);
     void popGLState(GLContextData& glContextData) const;
     void pushGLState(GLContextData& glContextData) const;
+    void sendLightingUniforms(ShaderObject* shaderObject, unsigned int features, float * point) const;
     void sortBricks(float * point, std::vector<ComparableBrick> & brickList) const;
     std::string toString(void);
     void update1DColorMap(DataItem* dataItem) const;
     void update2DColorMap(DataItem* dataItem) const;
     void update1DSliceColorMap(DataItem* dataItem) const;
+    bool uploadIlluminatedTextures(GLContextData & glContextData, const std::vector<ComparableBrick> & brickList) const;
     void updateAlpha(float* _alpha);
     void updateAlpha2_5D(float * _alpha2_5D);
     void updateBlue(float* _blue);
@@ -1081,31 +1361,52 @@ private:
     float * alpha;
     float * alpha2_5D;
     bool alphaChanged;
+    TextureAtlas* atlas; // occupied octree blocks of scalar volumes in one texture, NULL unless in texture atlas mode
+    Benchmark* benchmark; // records the frame timings of a fly-through, NULL unless benchmarking
     float* blue;
     float blueScale;
     float boundaryContribution;
     float boundaryExponent;
     Brick* bricks;
+    std::vector<int> brickBoxes; // column, row, slab, width, height and depth of every brick, filled by partitionBricks()
+    BrickTree* brickTree; // kd-tree of the adaptive bricks, NULL for a regular brick grid
+    float* classifiedAlpha; // alpha the octrees were last classified with; negative entries force a reclassification
     unsigned char* colormap;
+    unsigned char* colormap1D; // diagonal of colormap, prepared by frame() for the one dimensional texture
     bool colorMapChanged;
+    unsigned int colorMapVersion; // counts the color map changes frame() prepared
+    Compositor* compositor; // sort-last compositing across render nodes
     float diffuseColor[4];
     int dimension; // one or two dimension transfer function
     float edgeContribution;
     float edgeExponent;
     float edgeThreshold;
     bool focusAndContext; // lighting
+    std::vector<ComparableBrick> frameBrickList; // bricks back to front for the head, sorted once per frame
+    float framePoint[3]; // head in model coordinates this frame
+    unsigned int frameNumber; // counts the calls of frame(), so the contexts can pace their work per frame
     float* green;
     float greenScale;
+    bool illuminated; // draw the colors baked by the illumination cache this frame
+    IlluminationCache* illuminationCache; // lit colors of scalar volumes, NULL unless the volume asks for it
+    bool illuminationRequested; // the illumination cache bakes for the current shading
     bool interactive; // down sampled and not traversing octree
     float kAmbient[3];
     float kDiffuse[3];
     float kSpecular[3];
     bool lighting; // lighting
     float lightPosition[3];
+    mutable int maximum3DTextureSize; // smallest of all GL contexts; set by initContext, guarded by textureLimitsMutex
+    int maximumPriorityQueueSize; // octree nodes displayed over all bricks
     bool maximumPriorityQueueSizeChanged;
     bool maximumPriorityQueueTest;
     float normalContribution;
+    int numberOfBrickColumns; // dimensions of the regular brick grid, columns fastest; 0 for adaptive bricks
+    int numberOfBrickRows;
+    int numberOfBrickSlabs;
     int numberOfBricks;
+    float partitionMaximumZ; // z range of the slabs owned by this render node
+    float partitionMinimumZ;
     bool perspective;
     bool preintegrated;
     float planeNormal[3];
@@ -1113,19 +1414,25 @@ private:
     bool ratioOfVisibilityTest;
     float* red;
     float redScale;
+    float refinementPoint[3]; // eye the displayed octree nodes were last chosen for
     bool renderingCostFunctionTest;
     bool rgbChanged;
     bool showDisplay;
     bool showOutline;
     bool showVolume;
     unsigned char* sliceColormap;
+    unsigned char* sliceColormap1D;
     bool sliceColorMapChanged;
+    unsigned int sliceColorMapVersion;
     typedef Geometry::Point<double,3> Point;
     float shininess;
     float silhouetteContribution;
     float silhouetteExponent;
+    StagingCache* stagingCache; // brick texture staging built once for all GL contexts
     float specularColor[4];
     std::deque<Point> spheres;
+    mutable pthread_mutex_t textureLimitsMutex; // threaded windows initialize their contexts concurrently
+    mutable bool textureNonPowerOfTwo; // every GL context supports non power of two textures; set by initContext, guarded by textureLimitsMutex
     float toneContribution;
     float coolColor[3];
     float warmColor[3];
@@ -1136,6 +1443,8 @@ private:
             int minimumIndex, Vector4 * slicePlaneNormal, Matrix4x4 * modelviewInverse) const;
     void volumeShader2D(GLContextData & glContextData, DataItem * dataItem, const std::vector<ComparableBrick> & brickList, float * point, int maximumIndex,
             int minimumIndex, Vector4 * slicePlaneNormal, Matrix4x4 * modelviewInverse) const;
+    void volumeShaderIlluminated(GLContextData & glContextData, DataItem * dataItem, const std::vector<ComparableBrick> & brickList, float * point,
+            int maximumIndex, int minimumIndex, Vector4 * slicePlaneNormal, Matrix4x4 * modelviewInverse) const;
     void volumeShaderFocusAndContext(GLContextData & glContextData, DataItem * dataItem, const std::vector<ComparableBrick> & brickList, float * point,
                 int maximumIndex, int minimumIndex, Vector4 * slicePlaneNormal, Matrix4x4 * modelviewInverse) const;
     void volumeShaderWithLighting(GLContextData & glContextData, DataItem * dataItem, const std::vector<ComparableBrick> & brickList, float * point,
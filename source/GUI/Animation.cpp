@@ -7,12 +7,16 @@
  */
 
 #include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
 
 /* Vrui includes */
 #include <GLMotif/Blind.h>
 #include <GLMotif/StyleSheet.h>
 #include <GLMotif/SubMenu.h>
 #include <GLMotif/WidgetManager.h>
+#include <Misc/ThrowStdErr.h>
 
 #include <GRAPHIC/Scene.h>
 #include <GUI/Animation.h>
@@ -50,6 +54,10 @@ void Animation::createCaptureAndResetAndAnimatingRowColumn(GLMotif::RowColumn *
     keyFrameButton->getSelectCallbacks().add(this, &Animation::keyframeCallback);
     GLMotif::Button * resetButton = new GLMotif::Button("ResetButton", captureAndResetAndAnimatingRowColumn, "Reset");
     resetButton->getSelectCallbacks().add(this, &Animation::resetCallback);
+    GLMotif::Button * saveButton = new GLMotif::Button("SaveButton", captureAndResetAndAnimatingRowColumn, "Save");
+    saveButton->getSelectCallbacks().add(this, &Animation::saveCallback);
+    GLMotif::Button * loadButton = new GLMotif::Button("LoadButton", captureAndResetAndAnimatingRowColumn, "Load");
+    loadButton->getSelectCallbacks().add(this, &Animation::loadCallback);
     animatingToggle = new GLMotif::ToggleButton("AnimatingToggle", captureAndResetAndAnimatingRowColumn, "Animating");
     animatingToggle->setToggle(false);
     animatingToggle->getValueChangedCallbacks().add(this, &Animation::toggleSelectCallback);
@@ -286,6 +294,39 @@ void Animation::initialize(void) {
     animationRowColumn->manageChild();
 } // end initialize()
 
+/*
+ * interpolate - Navigate to the point a fraction t of the way from keyframe to the next keyframe.
+ *
+ * parameter keyframe - int
+ * parameter t - double
+ */
+void Animation::interpolate(int keyframe, double t) {
+    const Vrui::NavTransform & a = keyframes[keyframe];
+    const Vrui::NavTransform & b = keyframes[keyframe + 1];
+    Vrui::Vector translationA = a.getTranslation();
+    Vrui::Vector translationB = b.getTranslation();
+    Vrui::Rotation rotationA = a.getRotation();
+    Vrui::Rotation rotationB = b.getRotation();
+    Vrui::Vector translation = translationA;
+    if (translationA != translationB) {
+        for (int i = 0; i < 3; i++)
+            translation[i] = (1.0 - t) * translationA[i] + t * translationB[i];
+    }
+    Vrui::Scalar scaling = a.getScaling();
+    if (a.getScaling() != b.getScaling())
+        scaling = (1.0 - t) * a.getScaling() + t * b.getScaling();
+    Vrui::Rotation rotation = rotationA;
+    if (rotationA != rotationB) {
+        Vector4 quaternionA(rotationA.getQuaternion()[0], rotationA.getQuaternion()[1], rotationA.getQuaternion()[2],
+                rotationA.getQuaternion()[3]);
+        Vector4 quaternionB(rotationB.getQuaternion()[0], rotationB.getQuaternion()[1], rotationB.getQuaternion()[2],
+                rotationB.getQuaternion()[3]);
+        Vector4 result = slerp(quaternionA, quaternionB, t);
+        rotation = rotation.fromQuaternion(result.getX(), result.getY(), result.getZ(), result.getW());
+    }
+    Vrui::setNavigationTransformation(Vrui::NavTransform(translation, rotation, scaling));
+} // end interpolate()
+
 /*
  * keyframeButtonsCallback
  *
@@ -315,6 +356,57 @@ void Animation::keyframeCallback(Misc::CallbackData * callbackData) {
     frameStatisticsUpdate();
 } // end keyframeCallback()
 
+/*
+ * loadCallback
+ *
+ * parameter callbackData - Misc::CallbackData *
+ */
+void Animation::loadCallback(Misc::CallbackData * callbackData) {
+    try {
+        loadKeyframes(KEYFRAMES_FILE);
+    } catch (std::runtime_error e) {
+        std::cerr << "Error: Exception " << e.what() << "!" << std::endl;
+    }
+} // end loadCallback()
+
+/*
+ * loadKeyframes - Replace the keyframes with a path saved by saveKeyframes().
+ *     throws std::runtime_error when the file can not be read or holds fewer than two keyframes
+ *
+ * parameter fileName - const char*
+ */
+void Animation::loadKeyframes(const char* fileName) {
+    std::ifstream file(fileName, std::ios::in);
+    if (!file.is_open())
+        Misc::throwStdErr("Animation::loadKeyframes: Could not open keyframes file %s", fileName);
+    std::deque<Vrui::NavTransform> _keyframes;
+    std::vector<float> _animationTime;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+        std::istringstream values(line);
+        Vrui::Scalar translation[3];
+        Vrui::Scalar quaternion[4];
+        Vrui::Scalar scaling;
+        float time;
+        if (!(values >> translation[0] >> translation[1] >> translation[2] >> quaternion[0] >> quaternion[1] >> quaternion[2]
+                >> quaternion[3] >> scaling >> time) || time <= 0.0f)
+            Misc::throwStdErr("Animation::loadKeyframes: Malformed keyframe in keyframes file %s", fileName);
+        _keyframes.push_back(Vrui::NavTransform(Vrui::Vector(translation), Vrui::Rotation::fromQuaternion(quaternion[0],
+                quaternion[1], quaternion[2], quaternion[3]), scaling));
+        _animationTime.push_back(time);
+    } // end while
+    if (_keyframes.size() < 2)
+        Misc::throwStdErr("Animation::loadKeyframes: Keyframes file %s holds fewer than two keyframes", fileName);
+    reset();
+    keyframes = _keyframes;
+    animationTime = _animationTime;
+    currentKeyFrame = 0;
+    keyframesCascadeButton->setPopup(createKeyFramesSubMenu());
+    frameStatisticsUpdate();
+} // end loadKeyframes()
+
 /*
  * navigateToCallback
  *
@@ -360,56 +452,82 @@ void Animation::resetCallback(Misc::CallbackData * callbackData) {
 } // end resetCallback()
 
 /*
- * setCurrentNavigationTransformation
+ * saveCallback
+ *
+ * parameter callbackData - Misc::CallbackData *
+ */
+void Animation::saveCallback(Misc::CallbackData * callbackData) {
+    try {
+        saveKeyframes(KEYFRAMES_FILE);
+    } catch (std::runtime_error e) {
+        std::cerr << "Error: Exception " << e.what() << "!" << std::endl;
+    }
+} // end saveCallback()
+
+/*
+ * saveKeyframes - Save the keyframes one per line, with the seconds to the next keyframe.
+ *     throws std::runtime_error when the file can not be opened
+ *
+ * parameter fileName - const char*
+ */
+void Animation::saveKeyframes(const char* fileName) const {
+    std::ofstream file(fileName, std::ios::out);
+    if (!file.is_open())
+        Misc::throwStdErr("Animation::saveKeyframes: Could not open keyframes file %s", fileName);
+    file << "# translation x y z, rotation quaternion x y z w, scaling, seconds to the next keyframe" << std::endl;
+    file.precision(17);
+    for (int i = 0; i < (int) keyframes.size(); i++) {
+        Vrui::Vector translation = keyframes[i].getTranslation();
+        const Vrui::Scalar * quaternion = keyframes[i].getRotation().getQuaternion();
+        file << translation[0] << " " << translation[1] << " " << translation[2] << " " << quaternion[0] << " "
+                << quaternion[1] << " " << quaternion[2] << " " << quaternion[3] << " " << keyframes[i].getScaling() << " "
+                << animationTime[i] << std::endl;
+    } // end for
+    file.close();
+} // end saveKeyframes()
+
+/*
+ * setCurrentNavigationTransformation - Advance the animation by the wall clock time since the last step.
  */
 void Animation::setCurrentNavigationTransformation(void) {
-    float currentAnimationTime = animationTime[keyframesIterator];
-    if (currentTime > currentAnimationTime) {
+    if (keyframes.size() < 2)
+        return;
+    if (currentTime > animationTime[keyframesIterator]) {
         currentTime = 0;
         keyframesIterator += 1;
     }
     if (keyframesIterator > (int) keyframes.size() - 2)
         keyframesIterator = 0;
-    Vrui::NavTransform a = keyframes[keyframesIterator];
-    Vrui::NavTransform b = keyframes[keyframesIterator + 1];
-    Vrui::Vector translationA = a.getTranslation();
-    Vrui::Vector translationB = b.getTranslation();
-    Vrui::Rotation rotationA = a.getRotation();
-    Vrui::Rotation rotationB = b.getRotation();
-    Vector4 quaternionA(rotationA.getQuaternion()[0], rotationA.getQuaternion()[1], rotationA.getQuaternion()[2],
-            rotationA.getQuaternion()[3]);
-    Vector4 quaternionB(rotationB.getQuaternion()[0], rotationB.getQuaternion()[1], rotationB.getQuaternion()[2],
-            rotationB.getQuaternion()[3]);
-    float scalingA = a.getScaling();
-    float scalingB = b.getScaling();
     if (slerpTimer->peekTime() > 0.033) {
         currentTime += slerpTimer->peekTime();
-        Vrui::Vector translation = a.getTranslation();
-        if (translationA != translationB) {
-            translation[0] = (currentAnimationTime - currentTime) / currentAnimationTime * translationA[0] + currentTime
-                    / currentAnimationTime * translationB[0];
-            translation[1] = (currentAnimationTime - currentTime) / currentAnimationTime * translationA[1] + currentTime
-                    / currentAnimationTime * translationB[1];
-            translation[2] = (currentAnimationTime - currentTime) / currentAnimationTime * translationA[2] + currentTime
-                    / currentAnimationTime * translationB[2];
-        }
-        float scaling = a.getScaling();
-        if (scalingA != scalingB) {
-            scaling = ((currentAnimationTime - currentTime) / currentAnimationTime * scalingA + currentTime / currentAnimationTime
-                    * scalingB);
-        }
-        Vrui::Rotation rotation = a.getRotation();
-        if (rotationA != rotationB) {
-            Vector4 result = slerp(quaternionA, quaternionB, currentTime / currentAnimationTime);
-            rotation = rotation.fromQuaternion(result.getX(), result.getY(), result.getZ(), result.getW());
-        }
-        Vrui::NavTransform currentNavigationTransformation =
-                Vrui::NavTransform((const Vrui::Vector) translation, rotation, scaling);
-        Vrui::setNavigationTransformation(currentNavigationTransformation);
+        interpolate(keyframesIterator, currentTime / animationTime[keyframesIterator]);
         slerpTimer->elapse();
     }
 } // end setCurrentNavigationTransformation()
 
+/*
+ * setPathTime - Navigate to the point pathTime seconds along the keyframe path.
+ *
+ * Unlike the animation the path is not looped, and the point only depends on pathTime, so a
+ * path stepped in fixed increments shows the same views on every run.
+ *
+ * parameter pathTime - double
+ * return - bool (pathTime lies on the path)
+ */
+bool Animation::setPathTime(double pathTime) {
+    if (keyframes.size() < 2 || pathTime < 0.0)
+        return false;
+    int keyframe = 0;
+    while (keyframe < (int) keyframes.size() - 2 && pathTime > animationTime[keyframe]) {
+        pathTime -= animationTime[keyframe];
+        keyframe++;
+    } // end while
+    if (pathTime > animationTime[keyframe])
+        return false;
+    interpolate(keyframe, pathTime / animationTime[keyframe]);
+    return true;
+} // end setPathTime()
+
 /*
  * slerp
  *
@@ -26,6 +26,8 @@
 /* Vrui includes to use the Vrui interface */
 #include <Vrui/Vrui.h>
 
+#define KEYFRAMES_FILE "Keyframes.path"
+
 // begin Forward Declarations
 class Scene;
 class Toirt_Samhlaigh;
@@ -39,10 +41,15 @@ public:
     void frameStatisticsUpdate(void);
     void keyframeButtonsCallback(GLMotif::ToggleButton::ValueChangedCallbackData * callBackData);
     void keyframeCallback(Misc::CallbackData * callbackData);
+    void loadCallback(Misc::CallbackData * callbackData);
+    void loadKeyframes(const char* fileName);
     void navigateToCallback(Misc::CallbackData * callbackData);
     void reset(void);
     void resetCallback(Misc::CallbackData * callbackData);
+    void saveCallback(Misc::CallbackData * callbackData);
+    void saveKeyframes(const char* fileName) const;
     void setCurrentNavigationTransformation(void);
+    bool setPathTime(double pathTime);
     Vector4 slerp(Vector4 a, Vector4 b, double t);
     void sliderCallback(GLMotif::Slider::ValueChangedCallbackData * callBackData);
     void toggleSelectCallback(GLMotif::ToggleButton::ValueChangedCallbackData * callBackData);
@@ -81,6 +88,7 @@ private:
     void createXYZLabelsRowColumn(GLMotif::RowColumn * animationRowColumn);
     void createXYZWidgetsRowColumn(GLMotif::RowColumn * animationRowColumn);
     void initialize(void);
+    void interpolate(int keyframe, double t);
 };
 
 #endif /* ANIMATION_H_ */
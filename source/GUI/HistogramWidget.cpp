@@ -6,6 +6,7 @@
  * Copyright: 2008. All rights reserved.
  */
 
+#include <algorithm>
 #include <cfloat>
 #include <cmath>
 
@@ -838,31 +839,36 @@ void HistogramWidget::updateHistogram(int _sliceDirection, int _which) {
     for (int i = 0; i < 256 * 256; i++) {
         histogram[i] = 0;
     }
+    unsigned char* slice = new unsigned char[std::max(width * height, depth * std::max(width, height))];
     if (sliceDirection == XY) {
+        volume->getVoxelRegion(0, 0, which, width, height, 1, slice, width, width * height);
         for (int j = 0; j < height; j++) {
             for (int i = 0; i < width; i++) {
-                int x = volume->getVoxel(i + j * width + which * (width * height));
+                int x = slice[j * width + i];
                 int y = int((log2(volume->getGradient(i + j * width + which * (width * height))) / log2(maximum)) * 255.0);
                 histogram[y * 256 + x] = (unsigned char) (255);
             }
         }
     } else if (sliceDirection == XZ) {
+        volume->getVoxelRegion(0, which, 0, width, 1, depth, slice, width, width);
         for (int j = 0; j < depth; j++) {
             for (int i = 0; i < width; i++) {
-                int x = volume->getVoxel(i + which * width + j * (width * height));
+                int x = slice[j * width + i];
                 int y = int((log2(volume->getGradient(i + which * width + j * (width * height))) / log2(maximum)) * 255.0);
                 histogram[y * 256 + x] = (unsigned char) (255);
             }
         }
     } else {
+        volume->getVoxelRegion(which, 0, 0, 1, height, depth, slice, 1, height);
         for (int j = 0; j < depth; j++) {
             for (int i = 0; i < height; i++) {
-                int x = volume->getVoxel(which + i * width + j * (width * height));
+                int x = slice[j * height + i];
                 int y = int((log2(volume->getGradient(which + i * width + j * (width * height))) / log2(maximum)) * 255.0);
                 histogram[y * 256 + x] = (unsigned char) (255);
             }
         }
     }
+    delete[] slice;
 } // end updateHistogram()
 
 /*
@@ -338,23 +338,11 @@ void SliceWidget::updateSlice(int _sliceDirection, int _which) {
     int height = volume->getHeight();
     int depth = volume->getDepth();
     if (sliceDirection == XY) {
-        for (int j = 0; j < height; j++) {
-            for (int i = 0; i < width; i++) {
-                xySlice[j * width + i] = volume->getVoxel(i + j * width + which * (width * height));
-            }
-        }
+        volume->getVoxelRegion(0, 0, which, width, height, 1, xySlice, width, width * height);
     } else if (sliceDirection == XZ) {
-        for (int j = 0; j < depth; j++) {
-            for (int i = 0; i < width; i++) {
-                xzSlice[j * width + i] = volume->getVoxel(i + which * width + j * (width * height));
-            }
-        }
+        volume->getVoxelRegion(0, which, 0, width, 1, depth, xzSlice, width, width);
     } else {
-        for (int j = 0; j < depth; j++) {
-            for (int i = 0; i < height; i++) {
-                yzSlice[j * height + i] = volume->getVoxel(which + i * width + j * (width * height));
-            }
-        }
+        volume->getVoxelRegion(which, 0, 0, 1, height, depth, yzSlice, 1, height);
     }
 } // end updateSlice()
 
@@ -5,6 +5,7 @@
  * Created: October 19, 2007
  * Copyright: 2007
  */
+#include <algorithm>
 #include <iostream>
 
 /* Vrui includes */
@@ -69,3 +70,69 @@ void ByteVolume::readByteVolume(const char* filename, Volume* volume) {
 	volume->setIncrements(increments);
 	volume->setVoxels(voxels);
 }
+
+/*
+ * readByteVolume - Read every stride-th voxel of a byte volume data set (.vol), at most maximumSize voxels on a side.
+ *
+ * The voxels are addressed as readByteVolume(filename, volume) lays them out. Only the rows
+ * holding a kept voxel are read, so the preview costs a fraction of the whole file.
+ *
+ * parameter filename - const char*
+ * parameter volume - Volume
+ * parameter maximumSize - int
+ */
+void ByteVolume::readByteVolume(const char* filename, Volume* volume, int maximumSize) {
+	/* Open the volume file: */
+	Misc::File byteVolumeFile(filename, "rb", Misc::File::BigEndian);
+	/* Read the volume file header: */
+	int fileSize[3];
+	byteVolumeFile.read(fileSize, 3);
+	int borderSize=byteVolumeFile.read<int>();
+	/* The preview covers the same block as the whole volume: */
+	Point origin=Point::origin;
+	Size extent;
+	Point center;
+	for (int i=0; i<3; ++i) {
+		extent[i]=Scalar(byteVolumeFile.read<float>());
+		center[i]=origin[i]+extent[i]*Scalar(0.5);
+	}
+	Misc::File::Offset voxelsOffset=byteVolumeFile.tell();
+	/* One stride along every axis keeps the aspect of the voxels: */
+	int stride=1;
+	for (int i=0; i<3; ++i)
+		stride=std::max(stride, (fileSize[i]+maximumSize-1)/maximumSize);
+	int size[3];
+	for (int i=0; i<3; ++i)
+		size[i]=(fileSize[i]+stride-1)/stride;
+	volume->setSize(size);
+	volume->setBorderSize(0);
+	volume->setOrigin(origin);
+	volume->setExtent(extent);
+	volume->setVolumeBox();
+	volume->setCenter(center);
+	int numberOfVoxels=size[0]*size[1]*size[2];
+	volume->setNumberOfVoxels(numberOfVoxels);
+	Voxel* voxels=new Voxel[numberOfVoxels];
+	Voxel* row=new Voxel[fileSize[0]];
+	/* Skip the border in front of the voxel block: */
+	Misc::File::Offset rowPitch=fileSize[0]+2*borderSize;
+	Misc::File::Offset slicePitch=rowPitch*(fileSize[1]+2*borderSize);
+	voxelsOffset+=Misc::File::Offset(borderSize)*(1+rowPitch+slicePitch);
+	for (int k=0; k<size[2]; ++k) {
+		for (int j=0; j<size[1]; ++j) {
+			byteVolumeFile.seekSet(voxelsOffset+Misc::File::Offset(k*stride)*slicePitch+Misc::File::Offset(j*stride)*rowPitch);
+			byteVolumeFile.read(row, fileSize[0]);
+			Voxel* destination=voxels+(size_t(k)*size[1]+j)*size[0];
+			for (int i=0; i<size[0]; ++i)
+				destination[i]=row[i*stride];
+		}
+	}
+	delete[] row;
+	volume->setByteVoxelsBase(voxels);
+	int increments[3];
+	increments[2]=1;
+	increments[1]=size[2];
+	increments[0]=size[1]*size[2];
+	volume->setIncrements(increments);
+	volume->setVoxels(voxels);
+}
@@ -25,6 +25,7 @@ public:
 	ByteVolume();
 	~ByteVolume();
 	void readByteVolume(const char* filename, Volume* volume);
+	void readByteVolume(const char* filename, Volume* volume, int maximumSize);
 };
 
 #endif /*BYTEVOLUME_H_*/
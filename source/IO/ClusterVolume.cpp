@@ -0,0 +1,266 @@
+/*
+ * ClusterVolume.cpp - Methods for ClusterVolume class.
+ *
+ * Author: Patrick O'Leary
+ * Created: October 19, 2026
+ * Copyright 2007. All rights reserved.
+ */
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+/* Vrui includes */
+#include <Comm/MulticastPipe.h>
+#include <Misc/ThrowStdErr.h>
+#include <Misc/Timer.h>
+#include <Vrui/Vrui.h>
+
+#include <DATA/Volume.h>
+#include <IO/ClusterVolume.h>
+
+/*
+ * ClusterVolume - Constructor for ClusterVolume class.
+ *
+ * parameter _pipe - Comm::MulticastPipe*
+ */
+ClusterVolume::ClusterVolume(Comm::MulticastPipe* _pipe) :
+    cancelled(false), gradient(false), pipe(_pipe), receivedSlabs(0), volume(NULL) {
+    pthread_mutex_init(&mutex, NULL);
+    pthread_cond_init(&received, NULL);
+} // end ClusterVolume()
+
+/*
+ * ~ClusterVolume - Destructor for ClusterVolume class.
+ */
+ClusterVolume::~ClusterVolume() {
+    pthread_cond_destroy(&received);
+    pthread_mutex_destroy(&mutex);
+} // end ~ClusterVolume()
+
+/*
+ * gradientThread - Calculate the gradients of every slab whose neighbours have arrived.
+ *
+ * parameter parameter - void*
+ * return - void*
+ */
+void* ClusterVolume::gradientThread(void* parameter) {
+    ClusterVolume* clusterVolume = static_cast<ClusterVolume*> (parameter);
+    int depth = clusterVolume->volume->getDepth();
+    int calculated = 1;
+    while (calculated < depth - 1) {
+        pthread_mutex_lock(&clusterVolume->mutex);
+        while (!clusterVolume->cancelled && clusterVolume->receivedSlabs < std::min(calculated + 2, depth))
+            pthread_cond_wait(&clusterVolume->received, &clusterVolume->mutex);
+        if (clusterVolume->cancelled) {
+            pthread_mutex_unlock(&clusterVolume->mutex);
+            break;
+        } // end if
+        int lastSlab = std::min(clusterVolume->receivedSlabs - 1, depth - 1);
+        pthread_mutex_unlock(&clusterVolume->mutex);
+        clusterVolume->volume->calculateGradient(calculated, lastSlab);
+        calculated = lastSlab;
+    } // end while
+    return 0;
+} // end gradientThread()
+
+/*
+ * receiveArray - Receive one voxel array in chunks.
+ *
+ * parameter base - unsigned char*
+ * parameter numberOfVoxels - size_t
+ * parameter voxels - bool (the array holds the byte voxels the gradients are calculated from)
+ */
+void ClusterVolume::receiveArray(unsigned char* base, size_t numberOfVoxels, bool voxels) {
+    size_t slabSize = size_t(volume->getWidth()) * volume->getHeight();
+    for (size_t offset = 0; offset < numberOfVoxels; offset += CLUSTER_CHUNK_SIZE) {
+        size_t length = std::min(size_t(CLUSTER_CHUNK_SIZE), numberOfVoxels - offset);
+        pipe->read<unsigned char> (base + offset, length);
+        if (voxels && gradient) {
+            pthread_mutex_lock(&mutex);
+            receivedSlabs = int((offset + length) / slabSize);
+            pthread_cond_signal(&received);
+            pthread_mutex_unlock(&mutex);
+        } // end if
+    } // end for
+} // end receiveArray()
+
+/*
+ * receiveVolume - Receive the volume the master node loaded, on a slave node.
+ *
+ * The gradients of a single component volume are calculated while its voxels arrive,
+ * which makes the later Volume::calculateGradient() call return at once. The memory budget
+ * is fitted before anything arrives; when it asks for quantized gradients the float
+ * gradients are not streamed, and Volume::calculateGradient() quantizes once all voxels are in.
+ *     throws std::runtime_error when the master could not load the data set or the transfer fails
+ *
+ * parameter _volume - Volume*
+ */
+void ClusterVolume::receiveVolume(Volume* _volume) {
+    volume = _volume;
+    if (pipe->read<int> () == 0)
+        Misc::throwStdErr("ClusterVolume::receiveVolume: Master node could not load the data set");
+    int size[3];
+    float scale[3];
+    float components[9];
+    int increments[3];
+    pipe->read<int> (size, 3);
+    pipe->read<float> (scale, 3);
+    pipe->read<float> (components, 9);
+    pipe->read<int> (increments, 3);
+    int borderSize = pipe->read<int> ();
+    int numberOfVoxels = pipe->read<int> ();
+    int numberOfComponents = pipe->read<int> ();
+    int typeOfComponents = pipe->read<int> ();
+    int arrays = pipe->read<int> ();
+    int offset = pipe->read<int> ();
+    int voxelsArray = pipe->read<int> ();
+    Volume::Point origin;
+    Volume::Size extent;
+    Volume::Point center;
+    for (int i = 0; i < 3; i++) {
+        origin[i] = components[i];
+        extent[i] = components[3 + i];
+        center[i] = components[6 + i];
+    } // end for
+    volume->setSize(size);
+    volume->setScale(scale);
+    volume->setOrigin(origin);
+    volume->setExtent(extent);
+    volume->setVolumeBox();
+    volume->setCenter(center);
+    volume->setIncrements(increments);
+    volume->setBorderSize(borderSize);
+    volume->setNumberOfVoxels(numberOfVoxels);
+    volume->setNumberOfComponents(numberOfComponents);
+    volume->setTypeOfComponents(typeOfComponents);
+    unsigned char* bases[4] = { NULL, NULL, NULL, NULL };
+    for (int i = 0; i < 4; i++) {
+        if (arrays & (1 << i))
+            bases[i] = new unsigned char[numberOfVoxels];
+    } // end for
+    if (bases[0] != NULL) {
+        volume->setByteVoxelsBase(bases[0]);
+    }
+    if (bases[1] != NULL) {
+        volume->setRedByteVoxelsBase(bases[1]);
+        volume->setRedVoxels(bases[1] + offset);
+    }
+    if (bases[2] != NULL) {
+        volume->setGreenByteVoxelsBase(bases[2]);
+        volume->setGreenVoxels(bases[2] + offset);
+    }
+    if (bases[3] != NULL) {
+        volume->setBlueByteVoxelsBase(bases[3]);
+        volume->setBlueVoxels(bases[3] + offset);
+    }
+    if (voxelsArray >= 0)
+        volume->setVoxels(bases[voxelsArray] + offset);
+    volume->fitMemoryBudget();
+    gradient = numberOfComponents == 0 && voxelsArray == 0 && borderSize == 0 && size[2] > 2 && !volume->isQuantizedGradient();
+    pthread_t thread;
+    if (gradient) {
+        volume->allocateGradient();
+        pthread_create(&thread, NULL, gradientThread, this);
+    } // end if
+    try {
+        for (int i = 0; i < 4; i++) {
+            if (bases[i] != NULL)
+                receiveArray(bases[i], numberOfVoxels, i == voxelsArray);
+        } // end for
+    } catch (std::runtime_error e) {
+        // The gradient thread must not outlive this object waiting for slabs that never arrive
+        if (gradient) {
+            pthread_mutex_lock(&mutex);
+            cancelled = true;
+            pthread_cond_signal(&received);
+            pthread_mutex_unlock(&mutex);
+            pthread_join(thread, NULL);
+        } // end if
+        throw;
+    }
+    if (gradient) {
+        pthread_mutex_lock(&mutex);
+        receivedSlabs = size[2];
+        pthread_cond_signal(&received);
+        pthread_mutex_unlock(&mutex);
+        pthread_join(thread, NULL);
+    } // end if
+} // end receiveVolume()
+
+/*
+ * sendArray - Send one voxel array in chunks.
+ *
+ * parameter base - const unsigned char*
+ * parameter numberOfVoxels - size_t
+ */
+void ClusterVolume::sendArray(const unsigned char* base, size_t numberOfVoxels) {
+    for (size_t offset = 0; offset < numberOfVoxels; offset += CLUSTER_CHUNK_SIZE) {
+        size_t length = std::min(size_t(CLUSTER_CHUNK_SIZE), numberOfVoxels - offset);
+        pipe->write<unsigned char> (base + offset, length);
+    } // end for
+} // end sendArray()
+
+/*
+ * sendFailure - Tell the slave nodes the master could not load the data set.
+ */
+void ClusterVolume::sendFailure(void) {
+    pipe->write<int> (0);
+    pipe->finishMessage();
+} // end sendFailure()
+
+/*
+ * sendVolume - Send the volume the master node loaded to the slave nodes.
+ *
+ * parameter _volume - Volume*
+ */
+void ClusterVolume::sendVolume(Volume* _volume) {
+    volume = _volume;
+    Misc::Timer timer;
+    const unsigned char* bases[4] = { volume->getByteVoxelsBase(), volume->getRedByteVoxelsBase(),
+            volume->getGreenByteVoxelsBase(), volume->getBlueByteVoxelsBase() };
+    const unsigned char* voxels[4] = { volume->getVoxels(), volume->getRedVoxels(), volume->getGreenVoxels(),
+            volume->getBlueVoxels() };
+    int arrays = 0;
+    int offset = 0;
+    int voxelsArray = -1;
+    for (int i = 0; i < 4; i++) {
+        if (bases[i] == NULL)
+            continue;
+        arrays |= 1 << i;
+        if (voxels[i] != NULL)
+            offset = int(voxels[i] - bases[i]);
+        if (voxelsArray < 0 && volume->getVoxels() == voxels[i] && voxels[i] != NULL)
+            voxelsArray = i;
+    } // end for
+    int numberOfVoxels = volume->getNumberOfVoxels();
+    float components[9];
+    for (int i = 0; i < 3; i++) {
+        components[i] = volume->getOrigin(i);
+        components[3 + i] = volume->getExtent(i);
+        components[6 + i] = volume->getCenter(i);
+    } // end for
+    pipe->write<int> (1);
+    pipe->write<int> (volume->getSize(), 3);
+    pipe->write<float> (volume->getScale(), 3);
+    pipe->write<float> (components, 9);
+    pipe->write<int> (volume->getIncrements(), 3);
+    pipe->write<int> (volume->getBorderSize());
+    pipe->write<int> (numberOfVoxels);
+    pipe->write<int> (volume->getNumberOfComponents());
+    pipe->write<int> (volume->getTypeOfComponents());
+    pipe->write<int> (arrays);
+    pipe->write<int> (offset);
+    pipe->write<int> (voxelsArray);
+    size_t bytes = 0;
+    for (int i = 0; i < 4; i++) {
+        if (bases[i] != NULL) {
+            sendArray(bases[i], numberOfVoxels);
+            bytes += numberOfVoxels;
+        } // end if
+    } // end for
+    pipe->finishMessage();
+    timer.elapse();
+    if (Vrui::getNodeIndex() == 0)
+        std::cout << "Time to distribute data set: " << bytes << " bytes to " << Vrui::getNumNodes() - 1 << " nodes in "
+                << timer.getTime() * 1000.0 << " ms" << std::endl;
+} // end sendVolume()
@@ -0,0 +1,48 @@
+/*
+ * ClusterVolume.h - Class for distributing a loaded volume from the master node to the slaves of a Vrui cluster.
+ *
+ * Only the master node reads the data set; it then streams the description and the voxel
+ * arrays to the slave nodes in CLUSTER_CHUNK_SIZE chunks over a dedicated multicast pipe.
+ * While the chunks arrive a slave computes the gradients of the slabs it already has, so the
+ * gradient pass overlaps the transfer instead of following a full read.
+ *
+ * Author: Patrick O'Leary
+ * Created: October 19, 2026
+ * Copyright 2007. All rights reserved.
+ */
+#ifndef CLUSTERVOLUME_H_
+#define CLUSTERVOLUME_H_
+
+#include <cstddef>
+#include <pthread.h>
+
+#define CLUSTER_CHUNK_SIZE 1048576
+
+// begin Forward Declarations
+namespace Comm {
+class MulticastPipe;
+}
+class Volume;
+// end Forward Declarations
+
+class ClusterVolume {
+public:
+    ClusterVolume(Comm::MulticastPipe* _pipe);
+    ~ClusterVolume();
+    void receiveVolume(Volume* volume);
+    void sendFailure(void);
+    void sendVolume(Volume* volume);
+private:
+    bool cancelled; // the transfer failed, the gradient thread stops waiting for slabs
+    bool gradient; // compute the gradients while the voxels arrive
+    Comm::MulticastPipe* pipe;
+    pthread_cond_t received;
+    pthread_mutex_t mutex;
+    int receivedSlabs; // slabs of the byte voxels that have arrived
+    Volume* volume;
+    static void* gradientThread(void* parameter);
+    void receiveArray(unsigned char* base, size_t numberOfVoxels, bool voxels);
+    void sendArray(const unsigned char* base, size_t numberOfVoxels);
+};
+
+#endif /*CLUSTERVOLUME_H_*/
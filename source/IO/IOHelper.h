@@ -169,7 +169,10 @@ public:
             try {
                 SegyVolume segyVolume;
                 Misc::Timer timer;
-                segyVolume.readSegySlice(filename, volume);
+                if (volume->hasRegionOfInterest())
+                    segyVolume.readSegyRegion(filename, volume);
+                else
+                    segyVolume.readSegySlice(filename, volume);
                 timer.elapse();
                 if(Vrui::getNodeIndex()==0) std::cout<<"Time to load data set: "<<timer.getTime()*1000.0<<" ms"<<std::endl;
             }
@@ -278,11 +278,11 @@ void MultiComponentByteRaw::readMultiComponentByteRaw(const char* redFilename,
 		Voxel* blueVoxelsBase=new Voxel[numberOfVoxels];
 		blueByteRawFile.read(blueVoxelsBase, numberOfVoxels);
 		volume->setBlueByteVoxelsBase(blueVoxelsBase);
-		Voxel* blueVoxels=greenVoxelsBase+borderSize;
+		Voxel* blueVoxels=blueVoxelsBase+borderSize;
 		for (int i=2; i>0; --i) {
 			blueVoxels+=borderSize*increments[i-1];
 		}
-		volume->setBlueVoxels(blueVoxelsBase);
+		volume->setBlueVoxels(blueVoxels);
 		volume->setIncrements(increments);
 		volume->setVoxels(blueVoxels); // remove when fully operational
 	} else {
@@ -0,0 +1,249 @@
+/*
+ * ProgressiveLoader.cpp - Methods for ProgressiveLoader class.
+ *
+ * Author: Patrick O'Leary
+ * Created: October 19, 2026
+ * Copyright 2007. All rights reserved.
+ */
+#include <algorithm>
+#include <stdexcept>
+
+#include <DATA/Volume.h>
+#include <GRAPHIC/Scene.h>
+#include <IO/ByteVolume.h>
+#include <IO/IOHelper.h>
+#include <IO/ProgressiveLoader.h>
+
+/*
+ * ProgressiveLoader - Constructor for ProgressiveLoader class.
+ *
+ * parameter _volumeFile - const char*
+ * parameter _volume - Volume* (configured by the command-line, loaded in the background)
+ * parameter _compressVolume - bool
+ * parameter _tileVolume - bool
+ */
+ProgressiveLoader::ProgressiveLoader(const char* _volumeFile, Volume* _volume, bool _compressVolume, bool _tileVolume) :
+    bricked(false), compressVolume(_compressVolume), partitioned(false), running(false), scene(NULL), started(false), tileVolume(_tileVolume),
+            volume(_volume), volumeFile(_volumeFile), volumeRead(false) {
+    pthread_mutex_init(&mutex, NULL);
+} // end ProgressiveLoader()
+
+/*
+ * ~ProgressiveLoader - Destructor for ProgressiveLoader class.
+ */
+ProgressiveLoader::~ProgressiveLoader(void) {
+    if (started)
+        pthread_join(thread, NULL);
+    pthread_mutex_destroy(&mutex);
+    scene = NULL;
+    volume = NULL;
+    volumeFile = NULL;
+} // end ~ProgressiveLoader()
+
+/*
+ * isBricked - The octrees of the scene have been built in the background.
+ *
+ * return - bool
+ */
+bool ProgressiveLoader::isBricked(void) const {
+    return bricked;
+} // end isBricked()
+
+/*
+ * isPartitioned - The volume of the scene has been partitioned in the background.
+ *
+ * return - bool
+ */
+bool ProgressiveLoader::isPartitioned(void) const {
+    return partitioned;
+} // end isPartitioned()
+
+/*
+ * getError - Get the message of the failed task.
+ *
+ * return - const std::string&
+ */
+const std::string& ProgressiveLoader::getError(void) const {
+    return error;
+} // end getError()
+
+/*
+ * hasFailed - A background task threw.
+ *
+ * return - bool
+ */
+bool ProgressiveLoader::hasFailed(void) const {
+    return !error.empty();
+} // end hasFailed()
+
+/*
+ * readPreview - Read the preview volume.
+ *     throws std::runtime_error for I/O problems
+ *
+ * return - Volume* (owned by the caller)
+ */
+Volume* ProgressiveLoader::readPreview(void) {
+    Volume* preview = new Volume;
+    try {
+        if (IOHelper::getFileExtension(volumeFile) == BYTE_VOLUME_FILE) {
+            ByteVolume byteVolume;
+            byteVolume.readByteVolume(volumeFile, preview, PREVIEW_SIZE);
+        } else {
+            // No strided reader for this format; read it whole now and stride it in memory
+            IOHelper::readVolume(volumeFile, volume);
+            volumeRead = true;
+            int stride = 1;
+            for (int i = 0; i < 3; i++)
+                stride = std::max(stride, (volume->getSize(i) + PREVIEW_SIZE - 1) / PREVIEW_SIZE);
+            int size[3];
+            for (int i = 0; i < 3; i++)
+                size[i] = (volume->getSize(i) + stride - 1) / stride;
+            preview->setSize(size);
+            preview->setBorderSize(0);
+            preview->setOrigin(volume->getOrigin());
+            preview->setExtent(volume->getExtent());
+            preview->setVolumeBox();
+            preview->setCenter(volume->getCenter());
+            preview->setNumberOfVoxels(size[0] * size[1] * size[2]);
+            unsigned char* voxels = new unsigned char[size_t(size[0]) * size[1] * size[2]];
+            unsigned char* row = new unsigned char[volume->getWidth()];
+            for (int k = 0; k < size[2]; k++) {
+                for (int j = 0; j < size[1]; j++) {
+                    volume->getVoxelRegion(0, j * stride, k * stride, volume->getWidth(), 1, 1, row, volume->getWidth(),
+                            volume->getWidth());
+                    unsigned char* destination = voxels + (size_t(k) * size[1] + j) * size[0];
+                    for (int i = 0; i < size[0]; i++)
+                        destination[i] = row[i * stride];
+                } // end for
+            } // end for
+            delete[] row;
+            preview->setByteVoxelsBase(voxels);
+            int increments[3] = { size[1] * size[2], size[2], 1 };
+            preview->setIncrements(increments);
+            preview->setVoxels(voxels);
+        } // end if
+    } catch (std::runtime_error e) {
+        delete preview;
+        throw;
+    }
+    // The options of the volume, with all of the preview in one brick
+    preview->setLeafSize(volume->getLeafSize());
+    preview->setMaximumPriorityQueueSize(volume->getMaximumPriorityQueueSize());
+    preview->setNumberOfDecodeThreads(volume->getNumberOfDecodeThreads());
+    preview->setRatioOfVisibilityThreshold(volume->getRatioOfVisibilityThreshold());
+    preview->setSliceFactor(volume->getSliceFactor());
+    preview->setTextureSize(std::max(preview->getWidth(), std::max(preview->getHeight(), preview->getDepth())));
+    return preview;
+} // end readPreview()
+
+/*
+ * isRunning - A background task is still running; joins the thread once it has finished.
+ *
+ * return - bool
+ */
+bool ProgressiveLoader::isRunning(void) {
+    pthread_mutex_lock(&mutex);
+    bool result = running;
+    pthread_mutex_unlock(&mutex);
+    if (!result && started) {
+        pthread_join(thread, NULL);
+        started = false;
+    }
+    return result;
+} // end isRunning()
+
+/*
+ * startOcTrees - Build the octrees of the bricks of the scene in the background.
+ *
+ * Call once the render thread has created the bricks of the partitioned scene.
+ */
+void ProgressiveLoader::startOcTrees(void) {
+    running = true;
+    started = true;
+    pthread_create(&thread, NULL, ocTreesThread, this);
+} // end startOcTrees()
+
+/*
+ * startPartition - Partition the volume of the scene built around the loaded volume in the background.
+ *
+ * Call once the GL contexts of the scene have been initialized.
+ *
+ * parameter _scene - Scene*
+ */
+void ProgressiveLoader::startPartition(Scene* _scene) {
+    scene = _scene;
+    running = true;
+    started = true;
+    pthread_create(&thread, NULL, partitionThread, this);
+} // end startPartition()
+
+/*
+ * startVolume - Read the volume at full resolution and prepare it in the background.
+ */
+void ProgressiveLoader::startVolume(void) {
+    running = true;
+    started = true;
+    pthread_create(&thread, NULL, volumeThread, this);
+} // end startVolume()
+
+/*
+ * finish - Let the render thread know the task has finished.
+ */
+void ProgressiveLoader::finish(void) {
+    pthread_mutex_lock(&mutex);
+    running = false;
+    pthread_mutex_unlock(&mutex);
+} // end finish()
+
+/*
+ * ocTreesThread
+ *
+ * parameter parameter - void*
+ * return - void*
+ */
+void* ProgressiveLoader::ocTreesThread(void* parameter) {
+    ProgressiveLoader* progressiveLoader = static_cast<ProgressiveLoader*> (parameter);
+    progressiveLoader->scene->createOcTrees();
+    progressiveLoader->bricked = true;
+    progressiveLoader->finish();
+    return NULL;
+} // end ocTreesThread()
+
+/*
+ * partitionThread
+ *
+ * parameter parameter - void*
+ * return - void*
+ */
+void* ProgressiveLoader::partitionThread(void* parameter) {
+    ProgressiveLoader* progressiveLoader = static_cast<ProgressiveLoader*> (parameter);
+    progressiveLoader->scene->partitionBricks();
+    progressiveLoader->partitioned = true;
+    progressiveLoader->finish();
+    return NULL;
+} // end partitionThread()
+
+/*
+ * volumeThread
+ *
+ * parameter parameter - void*
+ * return - void*
+ */
+void* ProgressiveLoader::volumeThread(void* parameter) {
+    ProgressiveLoader* progressiveLoader = static_cast<ProgressiveLoader*> (parameter);
+    Volume* volume = progressiveLoader->volume;
+    try {
+        if (!progressiveLoader->volumeRead)
+            IOHelper::readVolume(progressiveLoader->volumeFile, volume);
+        volume->fitMemoryBudget();
+        volume->calculateGradient();
+        if (progressiveLoader->compressVolume)
+            volume->compress();
+        if (progressiveLoader->tileVolume)
+            volume->tile();
+    } catch (std::runtime_error e) {
+        progressiveLoader->error = e.what();
+    }
+    progressiveLoader->finish();
+    return NULL;
+} // end volumeThread()
@@ -0,0 +1,64 @@
+/*
+ * ProgressiveLoader.h - Class for loading a volume in the background behind a coarse preview.
+ *
+ * The preview keeps every stride-th voxel of the volume, at most PREVIEW_SIZE voxels on a
+ * side, so it fits one brick and loads in seconds. Byte volumes (.vol) are read strided
+ * straight from the file; other formats have no strided reader, so they are read whole first
+ * and strided in memory. The full resolution reading, the gradients, compression and tiling
+ * then run on one background thread, followed by the bricking of the scene built around the
+ * loaded volume. Only the CPU work of the bricking runs in the background: the volume is
+ * partitioned into brick boxes, the render thread creates the bricks, which are GL objects,
+ * and their octrees are built in the background again. The render thread polls isRunning()
+ * between frames and never waits.
+ *
+ * Author: Patrick O'Leary
+ * Created: October 19, 2026
+ * Copyright 2007. All rights reserved.
+ */
+#ifndef PROGRESSIVELOADER_H_
+#define PROGRESSIVELOADER_H_
+
+#include <pthread.h>
+#include <string>
+
+#define PREVIEW_SIZE 128
+
+// begin Forward Declarations
+class Scene;
+class Volume;
+// end Forward Declarations
+
+class ProgressiveLoader {
+public:
+    ProgressiveLoader(const char* _volumeFile, Volume* _volume, bool _compressVolume, bool _tileVolume);
+    ~ProgressiveLoader(void);
+    bool isBricked(void) const;
+    bool isPartitioned(void) const;
+    const std::string& getError(void) const;
+    bool hasFailed(void) const;
+    Volume* readPreview(void);
+    bool isRunning(void);
+    void startOcTrees(void);
+    void startPartition(Scene* _scene);
+    void startVolume(void);
+private:
+    bool bricked; // the octrees of the bricks of the scene have been built
+    bool compressVolume;
+    std::string error; // of the failed task, empty otherwise
+    pthread_mutex_t mutex;
+    bool partitioned; // the volume of the scene has been partitioned into brick boxes
+    bool running; // a task is running on the thread, guarded by mutex
+    Scene* scene;
+    bool started; // the thread has been started and not joined yet
+    pthread_t thread;
+    bool tileVolume;
+    Volume* volume;
+    const char* volumeFile;
+    bool volumeRead; // the whole volume was read for the preview
+    void finish(void);
+    static void* ocTreesThread(void* parameter);
+    static void* partitionThread(void* parameter);
+    static void* volumeThread(void* parameter);
+};
+
+#endif /*PROGRESSIVELOADER_H_*/
@@ -5,12 +5,18 @@
  * Created: April 13, 2009
  * Copyright: 2009
  */
+#include <cfloat>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <libgen.h>
+#include <pthread.h>
 
 /* Vrui includes */
 #include <Math/Math.h>
 #include <Misc/File.h>
+#include <Misc/ThrowStdErr.h>
+#include <Misc/Timer.h>
 
 #include <DATA/Volume.h>
 #include <IO/SegyVolume.h>
@@ -34,7 +40,49 @@ SegyVolume::~SegyVolume() {
 }
 
 
-float asp_ratioSegyData (SegyData *segy_data)
+/* What the first pass learns about one slice file */
+typedef struct
+{
+    int         ntraces;
+    int         nsamps;      /* shortest trace                           */
+    SegyTrcHdr  hdr[2];      /* first two trace headers, for the spacing */
+} SegySliceScan;
+
+/* The slices shared by all reader threads; each takes the next file */
+typedef struct
+{
+    int             nslices;
+    char            **filenames;
+    SegySliceScan   *scans;
+    int             next;
+    pthread_mutex_t mutex;
+
+    /* Second pass */
+    int             size[3];
+    int             iz_clip;
+    float           *fac;
+    unsigned char   *voxels;
+
+    /* Region of a single indexed file */
+    int             inline_beg;
+    int             crline_beg;
+    int             thin;        /* one inline, stored twice */
+} SegyAssembly;
+
+/* Per thread state; the depth statistics are merged after the first pass */
+typedef struct
+{
+    SegyAssembly    *assembly;
+    int             iy;
+    int             ix;
+    int             nsamps;
+    float           *min;
+    float           *max;
+    double          nbytes;
+} SegyReader;
+
+
+float asp_ratioSegyData (int ntraces, SegyTrcHdr *hdr)
 {
     float       vel_mpns;    /* signal velocity through material -- m/ns */
     float       samp_int_ns; /* sample interval -- ns                    */
@@ -45,18 +93,18 @@ float asp_ratioSegyData (SegyData *segy_data)
     float       dx_m;        /* trace interval -- meters                 */
     float       asp_ratio;   /* dz/dx aspect ratio                       */
 
-    if (segy_data->n_traces <= 1) return 1.0;
+    if (ntraces <= 1) return 1.0;
 
     vel_mpns    = 0.15; /* assuming dry sand */
-    samp_int_ns = segy_data->traces[0]->hdr.samp_int; /* GPR is ns */
+    samp_int_ns = hdr[0].samp_int; /* GPR is ns */
     dz_m        = vel_mpns * samp_int_ns;
     std::cout << "asp_rat: Z: " << vel_mpns << " "
               << samp_int_ns << " " << dz_m << std::endl;
     if (dz_m <= 0.0) return 1.0;
 
-    coord_fac = segy_data->traces[0]->hdr.coord_scalar;
-    x1_m      = segy_data->traces[0]->hdr.src_x;
-    x2_m      = segy_data->traces[1]->hdr.src_x;
+    coord_fac = hdr[0].coord_scalar;
+    x1_m      = hdr[0].src_x;
+    x2_m      = hdr[1].src_x;
     dx_m      = x2_m - x1_m;
     dx_m      = (coord_fac > 0) ? dx_m *= coord_fac : dx_m / -coord_fac;
     if (dx_m < 0) dx_m = -dx_m;
@@ -72,44 +120,173 @@ float asp_ratioSegyData (SegyData *segy_data)
 }
 
 
-int adjustSegyData (int nslices, SegyData **segy_slices, int mode)
+/*
+ * scanTrace - First pass: note the trace dimensions and fold the samples
+ * into the reader's per-depth minimum and maximum.
+ */
+void scanTrace (SegyTrcHdr *trc_hdr, float *data, void *client)
 {
-    /* Standardize the effective dimensions of the slices */
-    int        ntraces, nsamps;
-    ntraces = segy_slices[0]->n_traces;
-    nsamps  = segy_slices[0]->traces[0]->hdr.n_samp;
-    for (int iy = 0; iy < nslices; iy++)
+    SegyReader      *reader = (SegyReader *) client;
+    SegySliceScan   *scan   = &reader->assembly->scans[reader->iy];
+    int             nsamps  = trc_hdr->n_samp;
+
+    if (scan->ntraces < 2) scan->hdr[scan->ntraces] = *trc_hdr;
+    if ((scan->ntraces == 0) || (nsamps < scan->nsamps)) scan->nsamps = nsamps;
+    scan->ntraces++;
+
+    if (nsamps > reader->nsamps)
     {
-        if (segy_slices[iy]->n_traces < ntraces)
+        float   *min = new float[nsamps];
+        float   *max = new float[nsamps];
+        for (int iz = 0; iz < nsamps; iz++)
         {
-            ntraces = segy_slices[iy]->n_traces;
+            min[iz] = (iz < reader->nsamps) ? reader->min[iz] :  FLT_MAX;
+            max[iz] = (iz < reader->nsamps) ? reader->max[iz] : -FLT_MAX;
         }
-        for (int ix = 0; ix < segy_slices[iy]->n_traces; ix++)
+        delete[] reader->min;
+        delete[] reader->max;
+        reader->min    = min;
+        reader->max    = max;
+        reader->nsamps = nsamps;
+    }
+
+    for (int iz = 0; iz < nsamps; iz++)
+    {
+        if (data[iz] < reader->min[iz]) reader->min[iz] = data[iz];
+        if (data[iz] > reader->max[iz]) reader->max[iz] = data[iz];
+    }
+    reader->nbytes += sizeof (SegyTrcHdr) + nsamps * sizeof (float);
+}
+
+
+/*
+ * fillTrace - Second pass: normalize one trace and store it straight into
+ * the byte volume, top of the trace in the last Z plane.
+ */
+void fillTrace (SegyTrcHdr *trc_hdr, float *data, void *client)
+{
+    SegyReader      *reader   = (SegyReader *) client;
+    SegyAssembly    *assembly = reader->assembly;
+    int             *size     = assembly->size;
+    unsigned char   *voxel;
+    int             jz;
+
+    voxel = assembly->voxels + ((size[2] - 1) * size[1] + reader->iy) * size[0]
+          + reader->ix;
+    for (int iz = 0; iz < size[2]; iz++)
+    {
+        jz     = iz + assembly->iz_clip;
+        *voxel = (unsigned char) Math::floor(
+                 ((data[jz] / assembly->fac[jz] + 1.0) * 127.5) + 0.5);
+        voxel -= size[1] * size[0];
+    }
+    reader->ix++;
+    reader->nbytes += sizeof (SegyTrcHdr) + trc_hdr->n_samp * sizeof (float);
+}
+
+
+/*
+ * fillRegionTrace - Second pass of a region: place the trace by its index keys.
+ */
+void fillRegionTrace (SegyTrcHdr *trc_hdr, float *data, void *client)
+{
+    SegyReader      *reader   = (SegyReader *) client;
+    SegyAssembly    *assembly = reader->assembly;
+
+    reader->iy = trc_hdr->pstk_inline_num - assembly->inline_beg;
+    reader->ix = trc_hdr->pstk_crline_num - assembly->crline_beg;
+    fillTrace (trc_hdr, data, client);
+    if (assembly->thin)
+    {
+        reader->iy = 1;
+        reader->ix--;
+        fillTrace (trc_hdr, data, client);
+    }
+}
+
+
+/*
+ * scanThread, fillThread - Stream slice files until none are left.
+ */
+void *scanThread (void *parameter)
+{
+    SegyReader      *reader   = (SegyReader *) parameter;
+    SegyAssembly    *assembly = reader->assembly;
+
+    while (1)
+    {
+        pthread_mutex_lock (&assembly->mutex);
+        reader->iy = assembly->next++;
+        pthread_mutex_unlock (&assembly->mutex);
+        if (reader->iy >= assembly->nslices) break;
+
+        if (segy_file_stream (assembly->filenames[reader->iy], -1,
+                              scanTrace, reader) == SEGY_ERROR)
         {
-            if (segy_slices[iy]->traces[ix]->hdr.n_samp < nsamps)
-            {
-                nsamps = segy_slices[iy]->traces[ix]->hdr.n_samp;
-            }
+            std::cout << "Error: couldn't read SEG-Y file "
+                      << assembly->filenames[reader->iy] << std::endl;
         }
     }
-    segy_slices[0]->n_traces              = ntraces;
-    segy_slices[0]->traces[0]->hdr.n_samp = nsamps;
 
-    /* Normalize appropriately and try to detect the ground wave */
+    return NULL;
+}
+
+void *fillThread (void *parameter)
+{
+    SegyReader      *reader   = (SegyReader *) parameter;
+    SegyAssembly    *assembly = reader->assembly;
+
+    while (1)
+    {
+        pthread_mutex_lock (&assembly->mutex);
+        reader->iy = assembly->next++;
+        pthread_mutex_unlock (&assembly->mutex);
+        if (reader->iy >= assembly->nslices) break;
+
+        reader->ix = 0;
+        segy_file_stream (assembly->filenames[reader->iy], assembly->size[0],
+                          fillTrace, reader);
+    }
+
+    return NULL;
+}
+
+
+/*
+ * runReaders - Run one pass of nthreads reader threads over all slices.
+ */
+void runReaders (SegyAssembly *assembly, SegyReader *readers, int nthreads,
+                 void *(*thread) (void *))
+{
+    pthread_t   *threads = new pthread_t[nthreads];
+
+    assembly->next = 0;
+    for (int i = 0; i < nthreads; i++)
+        pthread_create (&threads[i], NULL, thread, &readers[i]);
+    for (int i = 0; i < nthreads; i++)
+        pthread_join (threads[i], NULL);
+    delete[] threads;
+}
+
+
+/*
+ * normalizeSegyDepths - Merge the readers' per-depth statistics into the
+ * normalization factors, and try to detect the ground wave.
+ */
+int normalizeSegyDepths (SegyReader *readers, int nreaders, int nsamps,
+                         int mode, float *fac)
+{
     int         iz_clip = -1;
-    float       min, max, fac;
+    float       min, max;
     for (int iz = 0; iz < nsamps; iz++)
     {
-        min = max = segy_slices[0]->traces[0]->data[iz];
-        for (int iy = 0; iy < nslices; iy++)
+        min = FLT_MAX;
+        max = -FLT_MAX;
+        for (int i = 0; i < nreaders; i++)
         {
-            for (int ix = 0; ix < ntraces; ix++)
-            {
-                if (segy_slices[iy]->traces[ix]->data[iz] < min)
-                    min = segy_slices[iy]->traces[ix]->data[iz];
-                else if (segy_slices[iy]->traces[ix]->data[iz] > max)
-                    max = segy_slices[iy]->traces[ix]->data[iz];
-            }
+            if (iz >= readers[i].nsamps) continue;
+            if (readers[i].min[iz] < min) min = readers[i].min[iz];
+            if (readers[i].max[iz] > max) max = readers[i].max[iz];
         }
 
         if ((max == 32767.0) || (min == -32768.0))
@@ -124,37 +301,15 @@ int adjustSegyData (int nslices, SegyData **segy_slices, int mode)
             }
         }
 
-        fac = 32768.0;
+        fac[iz] = 32768.0;
         if (mode & SEGY_MODE_NORM_BY_DEPTH)
         {
-            fac = (abs (min) > abs (max)) ? abs(min) : abs (max);
-        }
-        fprintf (stderr, "%d %f %f   %f %f\n",
-                 iz, min, max, (min/fac), (max/fac));
-        for (int iy = 0; iy < nslices; iy++)
-        {
-            for (int ix = 0; ix < ntraces; ix++)
-            {
-                segy_slices[iy]->traces[ix]->data[iz] /= fac;
-            }
+            fac[iz] = (Math::abs (min) > Math::abs (max)) ?
+                      Math::abs (min) : Math::abs (max);
+            if (fac[iz] == 0.0) fac[iz] = 1.0;
         }
     }
-
     fprintf (stderr, "iz_clip = %d   %d\n", iz_clip, mode);
-    /* Clip appropriately around the probable ground wave */
-    if (iz_clip >= 99999)
-    {
-        iz_clip++;
-        for (int iy = 0; iy < nslices; iy++)
-        {
-            for (int ix = 0; ix < ntraces; ix++)
-            {
-               segy_slices[iy]->traces[ix]->data += iz_clip;
-            }
-         }
-         segy_slices[0]->traces[0]->hdr.n_samp -= iz_clip;
-    }
-
     if (iz_clip < 0) iz_clip = 0;
 
     return iz_clip;
@@ -162,19 +317,10 @@ int adjustSegyData (int nslices, SegyData **segy_slices, int mode)
 
 
 /*
- * finishSegyVolume - create a volume from SEG-Y data
- * (.segy, .sgy, .segy3D, .sgy3D).
- *
+ * setupSegyVolume - Set the geometry of a volume of the given size.
  */
-void SegyVolume::finishSegyVolume (int nslices, SegyData **segy_slices,
-                                   Volume* volume, int iz_clip)
+void SegyVolume::setupSegyVolume (int size[3], float asp_ratio, Volume* volume)
 {
-    /* Determine the dimensions of the volume */
-    int        size[3];
-    size[0] = segy_slices[0]->n_traces;
-    size[1] = nslices;
-    size[2] = segy_slices[0]->traces[0]->hdr.n_samp - iz_clip;
-    if (size[2] > 250) size[2] = 250;
     volume->setSize (size);
     std::cout << "finSeg: sizes: "
               << size[0] << " " << size[1] << " " << size[2] << std::endl;
@@ -188,7 +334,7 @@ void SegyVolume::finishSegyVolume (int nslices, SegyData **segy_slices,
     {
         origin[i] = 1;
         extent[i] = size[i];
-        if (i == 2) extent[i] *= asp_ratioSegyData (segy_slices[0]);
+        if (i == 2) extent[i] *= asp_ratio;
         center[i] = (origin[i] + extent[i]) / 2.0;
     }
     volume->setExtent    (extent);
@@ -209,33 +355,215 @@ void SegyVolume::finishSegyVolume (int nslices, SegyData **segy_slices,
     int         numberOfVoxels = size[0] * size[1] * size[2];
     volume->setNumberOfVoxels(numberOfVoxels);
 
-    /* Copy the data, which has already been normalized */
-    FloatVoxel  *floatVoxelsBase=new FloatVoxel[numberOfVoxels];
-    int         jz;
-    int         iv = 0;
-    for (int iz = size[2]-1; iz >= 0; iz--)
+    return;
+}
+
+
+/*
+ * reportReadRate - Log the throughput of the readers.
+ */
+void reportReadRate (SegyReader *readers, int nreaders, double seconds)
+{
+    double      mbytes = 0.0;
+    for (int i = 0; i < nreaders; i++) mbytes += readers[i].nbytes;
+    mbytes /= 1024.0 * 1024.0;
+    std::cout << "SegyVol: read: " << mbytes << " MB in " << seconds
+              << " s (" << ((seconds > 0.0) ? mbytes / seconds : 0.0)
+              << " MB/s) with " << nreaders << " threads" << std::endl;
+}
+
+
+/*
+ * assembleSegyVolume - create a volume from a list of SEG-Y slice files
+ * (.segy, .sgy, .segy3D, .sgy3D).
+ *
+ * The files are streamed twice by a pool of reader threads, one file per
+ * thread at a time: the first pass gathers the dimensions and the per-depth
+ * statistics, the second writes normalized bytes straight into the volume.
+ * Only a run of traces per thread is ever resident besides the volume.
+ */
+void SegyVolume::assembleSegyVolume (int nslices, char **filenames,
+                                     Volume* volume, int mode)
+{
+    SegyAssembly    assembly;
+    assembly.nslices   = nslices;
+    assembly.filenames = filenames;
+    assembly.scans     = new SegySliceScan[nslices];
+    assembly.fac       = NULL;
+    assembly.voxels    = NULL;
+    pthread_mutex_init (&assembly.mutex, NULL);
+    for (int iy = 0; iy < nslices; iy++)
+    {
+        assembly.scans[iy].ntraces = 0;
+        assembly.scans[iy].nsamps  = 0;
+    }
+
+    int         nthreads = volume->getNumberOfDecodeThreads();
+    if (nthreads > nslices) nthreads = nslices;
+    if (nthreads < 1) nthreads = 1;
+    SegyReader  *readers = new SegyReader[nthreads];
+    for (int i = 0; i < nthreads; i++)
+    {
+        readers[i].assembly = &assembly;
+        readers[i].nsamps   = 0;
+        readers[i].min      = NULL;
+        readers[i].max      = NULL;
+        readers[i].nbytes   = 0.0;
+    }
+
+    /* First pass: standardize the effective dimensions of the slices */
+    Misc::Timer timer;
+    runReaders (&assembly, readers, nthreads, scanThread);
+
+    int         ntraces, nsamps;
+    ntraces = assembly.scans[0].ntraces;
+    nsamps  = assembly.scans[0].nsamps;
+    for (int iy = 0; iy < nslices; iy++)
+    {
+        if (assembly.scans[iy].ntraces < ntraces)
+            ntraces = assembly.scans[iy].ntraces;
+        if (assembly.scans[iy].nsamps < nsamps)
+            nsamps = assembly.scans[iy].nsamps;
+    }
+    if ((ntraces == 0) || (nsamps == 0))
     {
-        jz = iz + iz_clip;
-        for (int iy = 0; iy < size[1]; iy++)
+        for (int i = 0; i < nthreads; i++)
         {
-            for (int ix = 0; ix < size[0]; ix++)
-            {
-                floatVoxelsBase[iv++] = segy_slices[iy]->traces[ix]->data[jz];
-            }
+            delete[] readers[i].min;
+            delete[] readers[i].max;
         }
+        delete[] readers;
+        delete[] assembly.scans;
+        pthread_mutex_destroy (&assembly.mutex);
+        Misc::throwStdErr ("SegyVolume::assembleSegyVolume: No SEG-Y traces found");
     }
-    volume->setFloatVoxelsBase(floatVoxelsBase);
 
-    /* Convert the float data to unsigned char: */
+    /* Normalize appropriately and try to detect the ground wave */
+    assembly.fac     = new float[nsamps];
+    assembly.iz_clip = normalizeSegyDepths (readers, nthreads, nsamps, mode,
+                                            assembly.fac);
+
+    /* Determine the dimensions of the volume */
+    int        *size = assembly.size;
+    size[0] = ntraces;
+    size[1] = nslices;
+    size[2] = nsamps - assembly.iz_clip;
+    setupSegyVolume (size, asp_ratioSegyData (assembly.scans[0].ntraces,
+                                              assembly.scans[0].hdr), volume);
+    int         numberOfVoxels = size[0] * size[1] * size[2];
+
+    /* Second pass: convert the normalized data to unsigned char in place */
     Voxel      *voxelsBase = new Voxel[numberOfVoxels];
-    for (int i = 0; i < numberOfVoxels; ++i)
+    assembly.voxels = voxelsBase;
+    runReaders (&assembly, readers, nthreads, fillThread);
+    volume->setByteVoxelsBase(voxelsBase);
+    volume->setVoxels(voxelsBase);
+
+    timer.elapse();
+    reportReadRate (readers, nthreads, timer.getTime());
+    for (int i = 0; i < nthreads; i++)
+    {
+        delete[] readers[i].min;
+        delete[] readers[i].max;
+    }
+
+    delete[] readers;
+    delete[] assembly.fac;
+    delete[] assembly.scans;
+    pthread_mutex_destroy (&assembly.mutex);
+
+    return;
+}
+
+/*
+ * readSegyRegion - Read the region of interest of the volume out of a single
+ * SEG-Y survey (.segy, .sgy).
+ *
+ * The file is memory mapped and indexed by inline and crossline (the index is
+ * cached on disk next to it), so only the traces inside the region are
+ * decoded; traces missing from the survey are left at zero amplitude.
+ *
+ * parameter filename - const char*
+ * parameter volume - Volume
+ */
+void SegyVolume::readSegyRegion(const char* filename, Volume* volume)
+{
+    Misc::Timer timer;
+    SegyIndex   *segy_index = segy_index_open (filename);
+    if (segy_index == NULL)
+        Misc::throwStdErr ("SegyVolume::readSegyRegion: Couldn't index SEG-Y file %s", filename);
+    timer.elapse();
+    std::cout << "SegyVol: index: " << segy_index->n_traces << " traces, inlines "
+              << segy_index->inline_min << "-" << segy_index->inline_max
+              << ", crosslines " << segy_index->crline_min << "-"
+              << segy_index->crline_max << " in " << timer.getTime()
+              << " s" << std::endl;
+
+    /* Clamp the region to the survey */
+    const int   *region = volume->getRegionOfInterest();
+    int         box[6];
+    box[0] = Math::max (region[0], segy_index->inline_min);
+    box[1] = Math::min (region[1], segy_index->inline_max);
+    box[2] = Math::max (region[2], segy_index->crline_min);
+    box[3] = Math::min (region[3], segy_index->crline_max);
+    box[4] = Math::max (region[4], 0);
+    box[5] = Math::min (region[5], segy_index->n_samp_max - 1);
+
+    SegyAssembly    assembly;
+    SegySliceScan   scan;
+    SegyReader      reader;
+    assembly.nslices    = 1;
+    assembly.scans      = &scan;
+    assembly.inline_beg = box[0];
+    assembly.crline_beg = box[2];
+    assembly.thin       = (box[0] == box[1]);
+    scan.ntraces        = 0;
+    scan.nsamps         = 0;
+    reader.assembly     = &assembly;
+    reader.iy           = 0;
+    reader.nsamps       = 0;
+    reader.min          = NULL;
+    reader.max          = NULL;
+    reader.nbytes       = 0.0;
+
+    /* First pass: dimensions and per-depth statistics of the region */
+    if ((box[0] > box[1]) || (box[2] > box[3]) || (box[4] > box[5]) ||
+        (segy_index_read_box (segy_index, box[0], box[1], box[2], box[3],
+                              box[4], box[5], scanTrace, &reader) == 0))
     {
-        voxelsBase[i] = (unsigned char)Math::floor(
-                        ((floatVoxelsBase[i] + 1.0) * 127.5) + 0.5);
+        segy_index_close (segy_index);
+        Misc::throwStdErr ("SegyVolume::readSegyRegion: No SEG-Y traces in the region of interest");
     }
+
+    assembly.fac     = new float[scan.nsamps];
+    assembly.iz_clip = normalizeSegyDepths (&reader, 1, scan.nsamps,
+                                            SEGY_MODE_NORM_BY_DEPTH, assembly.fac);
+
+    int         *size = assembly.size;
+    size[0] = box[3] - box[2] + 1;
+    size[1] = assembly.thin ? 2 : box[1] - box[0] + 1;
+    size[2] = scan.nsamps;
+    setupSegyVolume (size, asp_ratioSegyData (scan.ntraces, scan.hdr), volume);
+    int         numberOfVoxels = size[0] * size[1] * size[2];
+
+    /* Second pass: decode the region straight into the volume */
+    Voxel      *voxelsBase = new Voxel[numberOfVoxels];
+    memset (voxelsBase, 128, numberOfVoxels);
+    assembly.voxels = voxelsBase;
+    segy_index_read_box (segy_index, box[0], box[1], box[2], box[3],
+                         box[4], box[5],
+                         fillRegionTrace, &reader);
     volume->setByteVoxelsBase(voxelsBase);
     volume->setVoxels(voxelsBase);
 
+    timer.elapse();
+    reportReadRate (&reader, 1, timer.getTime());
+
+    delete[] reader.min;
+    delete[] reader.max;
+    delete[] assembly.fac;
+    segy_index_close (segy_index);
+
     return;
 }
 
@@ -247,32 +575,15 @@ void SegyVolume::finishSegyVolume (int nslices, SegyData **segy_slices,
  */
 void SegyVolume::readSegySlice(const char* filename, Volume* volume)
 {
-    /* Read a single SEG-Y file */
-    SegyData    *segy_data = segy_file_read (filename);
-    if (segy_data == NULL)
-    {
-        std::cout << "Error: couldn't read SEG-Y file "
-                  << filename << std::endl;
-        return;
-    }
-
     /* Create a thin volume by duplicating the slice */
-    SegyData    **segy_slices;
+    char        *filenames[2];
     int         nslices = 2;
-    segy_slices = (SegyData **) malloc (nslices * sizeof (SegyData *));
-    for (int i = 0; i < nslices; i++) segy_slices[i] = segy_data;
+    for (int i = 0; i < nslices; i++) filenames[i] = (char *) filename;
 
     /* Standardize the slices and finish the volume */
-    int         mode, iz_clip, old_ntraces;
-    old_ntraces = segy_data->n_traces;
-
-    mode    = SEGY_MODE_CLIP_GND_WAVE_TOP | SEGY_MODE_NORM_BY_DEPTH;
-    iz_clip = adjustSegyData (1, &segy_data, mode);
-    finishSegyVolume (nslices, segy_slices, volume, iz_clip);
-
-    segy_data->n_traces = old_ntraces;
-    segy_data_destroy (segy_data);
-    free (segy_slices);
+    int         mode;
+    mode = SEGY_MODE_CLIP_GND_WAVE_TOP | SEGY_MODE_NORM_BY_DEPTH;
+    assembleSegyVolume (nslices, filenames, volume, mode);
 
     return;
 }
@@ -290,8 +601,8 @@ void SegyVolume::readSegyVolume(const char* listfile, Volume* volume)
     int         i, nslices;
     char        filename[256], dir[256], str[256], *p_str;
     FILE        *file;
-    void        *data_beg[2], **data_prv, **data_nxt;
-    SegyData    *segy_data, **segy_slices;
+    void        *name_beg[2], **name_prv, **name_nxt;
+    char        **filenames;
 
     std::cout << "SegyVol: file: " << listfile << std::endl;
     if ((file = fopen (listfile, "r")) == NULL)
@@ -303,21 +614,22 @@ void SegyVolume::readSegyVolume(const char* listfile, Volume* volume)
     strcpy (dir, dirname ((char *) listfile));
     strcat (dir, "/");
 
-    /* Read the data from each file and save it in a chain */
+    /* Save the name of each file in a chain */
     nslices     = 0;
-    data_beg[0] = NULL;
-    data_prv    = data_beg;
+    name_beg[0] = NULL;
+    name_prv    = name_beg;
     while (fgets (str, sizeof (str), file) != NULL)
     {
         if ((p_str = strrchr (str, '\n')) != NULL) *p_str = '\0';
+        if (str[0] == '\0') continue;
         if (str[0] != '/') strcpy (filename, dir);
+        else filename[0] = '\0';
         strcat (filename, str);
-        segy_data = segy_file_read (filename);
 
-        data_nxt    = (void **) calloc (2, sizeof (void *));
-        data_nxt[1] = segy_data;
-        data_prv[0] = data_nxt;
-        data_prv    = data_nxt;
+        name_nxt    = (void **) calloc (2, sizeof (void *));
+        name_nxt[1] = strdup (filename);
+        name_prv[0] = name_nxt;
+        name_prv    = name_nxt;
 
         nslices++;
     }
@@ -329,29 +641,25 @@ void SegyVolume::readSegyVolume(const char* listfile, Volume* volume)
         return;
     }
 
-    /* Move the data from the chain into an array */
-    segy_slices = (SegyData **) malloc (nslices * sizeof (SegyData *));
+    /* Move the names from the chain into an array */
+    filenames = (char **) malloc (nslices * sizeof (char *));
     i        = 0;
-    data_nxt = (void **) data_beg[0];
-    while (data_nxt != NULL)
+    name_nxt = (void **) name_beg[0];
+    while (name_nxt != NULL)
     {
-        segy_slices[i++] = (SegyData *) data_nxt[1];
-        data_prv = data_nxt;
-        data_nxt = (void **) data_nxt[0];
-        free (data_prv);
+        filenames[i++] = (char *) name_nxt[1];
+        name_prv = name_nxt;
+        name_nxt = (void **) name_nxt[0];
+        free (name_prv);
     }
 
-    /* Standardize the slices and finish the volume */
-    int         mode, iz_clip, old_ntraces;
-    old_ntraces = segy_slices[0]->n_traces;
-
-    mode    = SEGY_MODE_CLIP_GND_WAVE_TOP | SEGY_MODE_NORM_BY_DEPTH;
-    iz_clip = adjustSegyData (nslices, segy_slices, mode);
-    finishSegyVolume (nslices, segy_slices, volume, iz_clip);
+    /* Stream the slices into the volume */
+    int         mode;
+    mode = SEGY_MODE_CLIP_GND_WAVE_TOP | SEGY_MODE_NORM_BY_DEPTH;
+    assembleSegyVolume (nslices, filenames, volume, mode);
 
-    segy_slices[0]->n_traces = old_ntraces;
-    for (i = 0; i < nslices; i++) segy_data_destroy (segy_slices[i]);
-    free (segy_slices);
+    for (i = 0; i < nslices; i++) free (filenames[i]);
+    free (filenames);
 
     return;
 }
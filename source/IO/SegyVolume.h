@@ -29,11 +29,13 @@ public:
     typedef float FloatVoxel;
     SegyVolume();
     ~SegyVolume();
+    void readSegyRegion (const char *filename, Volume *volume);
     void readSegyVolume (const char *filename, Volume *volume);
     void readSegySlice (const char *filename, Volume *volume);
 private:
-    void finishSegyVolume (int nslices, SegyData **segy_slices, Volume *volume,
-                           int iz_clip);
+    void assembleSegyVolume (int nslices, char **filenames, Volume *volume,
+                             int mode);
+    void setupSegyVolume (int size[3], float asp_ratio, Volume *volume);
 };
 
 #endif /*SEGYVOLUME_H_*/
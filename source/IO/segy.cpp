@@ -1,9 +1,16 @@
 
 
 
+#include <float.h>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
 
 #include "segy.h"
 
@@ -108,6 +115,190 @@ static void segy_swap_bytes (void *data, int nmember, int member_size[])
 
 
 
+/* Decoding of trace samples.  The kernels convert a whole trace at a time   */
+/* with straight loops over the raw bytes, which the compiler vectorizes;    */
+/* big-endian values are assembled from their bytes, so the same loop works  */
+/* on any host.                                                              */
+
+#define SEGY_BULK_TRACES             256
+
+
+
+/* IBM single precision:  sign, 7-bit base 16 exponent biased by 64, and a   */
+/* 24-bit fraction.  value = fraction * 2^-24 * 16^(exponent - 64).          */
+/* Exponents outside the IEEE range saturate so 0 * scale stays 0.           */
+
+static float segy_ibm_scale[128];
+
+
+
+static int segy_ibm_scale_init (void)
+{
+    int         i;
+    double      scale;
+
+
+
+    for (i = 0; i < 128; i++)
+    {
+        scale = ldexp (1.0, 4 * (i - 64) - 24);
+        segy_ibm_scale[i] = (scale > FLT_MAX) ? FLT_MAX : (float) scale;
+    }
+
+
+    return 1;
+}
+
+
+
+static int segy_ibm_scale_ready = segy_ibm_scale_init ();
+
+
+
+static unsigned int segy_get4 (const unsigned char *p_byte, int swap_bytes)
+{
+    unsigned int   u4;
+
+
+
+    if (swap_bytes)
+    {
+        u4 = ((unsigned int) p_byte[0] << 24) | ((unsigned int) p_byte[1] << 16) |
+             ((unsigned int) p_byte[2] << 8)  |  (unsigned int) p_byte[3];
+    }
+    else
+    {
+        memcpy (&u4, p_byte, sizeof (u4));
+    }
+
+
+    return u4;
+}
+
+
+
+static void segy_decode_ibm (const unsigned char *raw, int n_samp,
+                             int swap_bytes, float *data)
+{
+    int            i;
+    unsigned int   u4;
+    float          x4;
+
+
+
+    for (i = 0; i < n_samp; i++)
+    {
+        u4 = segy_get4 (raw + 4*i, swap_bytes);
+        x4 = (float) (int) (u4 & 0x00ffffff) * segy_ibm_scale[(u4 >> 24) & 0x7f];
+        data[i] = x4 * (float) (1 - (int) ((u4 >> 30) & 2));
+    }
+
+
+    return;
+}
+
+
+
+static void segy_decode_int4 (const unsigned char *raw, int n_samp,
+                              int swap_bytes, float *data)
+{
+    int            i;
+
+
+
+    for (i = 0; i < n_samp; i++)
+    {
+        data[i] = (float) (int) segy_get4 (raw + 4*i, swap_bytes);
+    }
+
+
+    return;
+}
+
+
+
+static void segy_decode_ieee (const unsigned char *raw, int n_samp,
+                              int swap_bytes, float *data)
+{
+    int            i;
+    unsigned int   u4;
+
+
+
+    for (i = 0; i < n_samp; i++)
+    {
+        u4 = segy_get4 (raw + 4*i, swap_bytes);
+        memcpy (&data[i], &u4, sizeof (u4));
+    }
+
+
+    return;
+}
+
+
+
+/* The 1 and 2 byte kernels run backwards so they can decode in place,       */
+/* with raw pointing at the start of data.                                   */
+
+static void segy_decode_int2 (const unsigned char *raw, int n_samp,
+                              int swap_bytes, float *data)
+{
+    int            i;
+    short int      i2;
+
+
+
+    for (i = n_samp - 1; i >= 0; i--)
+    {
+        if (swap_bytes)
+        {
+            i2 = (short int) ((raw[2*i] << 8) | raw[2*i+1]);
+        }
+        else
+        {
+            memcpy (&i2, raw + 2*i, sizeof (i2));
+        }
+        data[i] = i2;
+    }
+
+
+    return;
+}
+
+
+
+static void segy_decode_int1 (const unsigned char *raw, int n_samp,
+                              float *data)
+{
+    int            i;
+
+
+
+    for (i = n_samp - 1; i >= 0; i--)
+    {
+        data[i] = (signed char) raw[i];
+    }
+
+
+    return;
+}
+
+
+
+static double segy_seconds (void)
+{
+    struct timeval  tv;
+
+
+
+    gettimeofday (&tv, NULL);
+
+
+    return tv.tv_sec + tv.tv_usec * 1.0e-6;
+}
+
+
+
 static void segy_ebcdic_to_ascii (char *str, const int nchr)
 {
     static char ebc2asc[] = { 0x00, 0x01, 0x02, 0x03, 0x9c, 0x09, 0x86, 0x7f,
@@ -763,7 +954,7 @@ extern void segy_trace_destroy (SegyTrace *trace)
 {
     if (trace == NULL) return;
 
-    if (trace->data != NULL) free (trace->data);
+    if ((trace->data != NULL) && !trace->shared_data) free (trace->data);
 
     free (trace);
 
@@ -780,8 +971,9 @@ extern void segy_trace_init (SegyTrace *trace)
     memset (&(trace->hdr), 0, sizeof (SegyTrcHdr));
     if (trace->data != NULL)
     {
-        free (trace->data);
-        trace->data = NULL;
+        if (!trace->shared_data) free (trace->data);
+        trace->data        = NULL;
+        trace->shared_data = 0;
     }
 
 
@@ -793,7 +985,7 @@ extern void segy_trace_init (SegyTrace *trace)
 extern int segy_trace_read (SegyTrace *trace, SegyHeader *segy_header,
                             FILE *file)
 {
-    int         i, n_samp;
+    int         n_samp, samp_size;
     SegyTrcHdr  *trc_hdr;
 
 
@@ -822,7 +1014,16 @@ extern int segy_trace_read (SegyTrace *trace, SegyHeader *segy_header,
     }
 
 
-    n_samp      = trc_hdr->n_samp;
+    n_samp    = trc_hdr->n_samp;
+    samp_size = segy_sample_size (segy_header->bin_hdr->format);
+    if (samp_size == 0)
+    {
+        fseek (file, (long) n_samp * 4, SEEK_CUR);
+        trc_hdr->n_samp = 0;
+
+        return SEGY_OK;
+    }
+
     trace->data = (float *) malloc (n_samp * sizeof (float));
     if (trace->data == NULL)
     {
@@ -831,75 +1032,265 @@ extern int segy_trace_read (SegyTrace *trace, SegyHeader *segy_header,
         return SEGY_ERROR;
     }
 
-    switch (segy_header->bin_hdr->format)
+/* Read the whole payload at once into the sample array and decode it there */
+
+    if ((int) fread (trace->data, samp_size, n_samp, file) != n_samp)
     {
+        segy_error_msg ("couldn't read trace data");
+
+        free (trace->data);
+        trace->data     = NULL;
+        trc_hdr->n_samp = 0;
+
+        return SEGY_ERROR;
+    }
+
+    segy_samples_decode (trace->data, n_samp, segy_header->bin_hdr->format,
+                         segy_header->swap_bytes, trace->data);
+
+
+    return SEGY_OK;
+}
+
+
+
+extern int segy_sample_size (int format)
+{
+    switch (format)
+    {
+        case SEGY_FORMAT_IBM:
+        case SEGY_FORMAT_INT4:
+        case SEGY_FORMAT_IEEE:
+            return 4;
+
+        case SEGY_FORMAT_INT2:
+            return 2;
+
+        case SEGY_FORMAT_INT1:
+            return 1;
+    }
+
+
+    return 0;
+}
+
+
+
+extern int segy_samples_decode (const void *raw, int n_samp, int format,
+                                int swap_bytes, float *data)
+{
+    const unsigned char  *p_raw;
+
 
-/* The IBM binary format is not currently supported.
+
+    p_raw = (const unsigned char *) raw;
+
+    switch (format)
+    {
         case SEGY_FORMAT_IBM:
+            segy_decode_ibm (p_raw, n_samp, swap_bytes, data);
             break;
-*/
 
         case SEGY_FORMAT_INT4:
-        {
-            int        i4;
-
-            for (i = 0; i < n_samp; i++)
-            {
-                fread (&i4, sizeof (i4), 1, file);
-                if (segy_header->swap_bytes) segy_swap4 (&i4);
-                trace->data[i] = i4;
-            }
+            segy_decode_int4 (p_raw, n_samp, swap_bytes, data);
             break;
-        }
 
         case SEGY_FORMAT_INT2:
+            segy_decode_int2 (p_raw, n_samp, swap_bytes, data);
+            break;
+
+        case SEGY_FORMAT_IEEE:
+            segy_decode_ieee (p_raw, n_samp, swap_bytes, data);
+            break;
+
+        case SEGY_FORMAT_INT1:
+            segy_decode_int1 (p_raw, n_samp, data);
+            break;
+
+        default:
+            return SEGY_ERROR;
+    }
+
+
+    return SEGY_OK;
+}
+
+
+
+extern int segy_traces_read_bulk (SegyHeader *segy_header, FILE *file,
+                                  int n_samp, int max_traces,
+                                  SegyTrcHdr *trc_hdrs, float *data)
+{
+    int            n_read, n_run, n_got, t, samp_size, done;
+    long           trc_size;
+    unsigned char  *buffer, *p_trc;
+    SegyTrcHdr     trc_hdr;
+    static int     trc_hdr_sizes[] = { SEGY_TRC_HDR_SIZES };
+
+
+
+    samp_size = segy_sample_size (segy_header->bin_hdr->format);
+    if ((samp_size == 0) || (n_samp <= 0)) return 0;
+
+    trc_size = sizeof (SegyTrcHdr) + (long) n_samp * samp_size;
+    buffer   = (unsigned char *) malloc (SEGY_BULK_TRACES * trc_size);
+    if (buffer == NULL)
+    {
+        segy_error_msg ("couldn't allocate memory for trace buffer");
+
+        return 0;
+    }
+
+    n_read = 0;
+    done   = 0;
+    while (!done && (n_read < max_traces))
+    {
+        n_run = max_traces - n_read;
+        if (n_run > SEGY_BULK_TRACES) n_run = SEGY_BULK_TRACES;
+
+        n_got = fread (buffer, trc_size, n_run, file);
+        for (t = 0; t < n_got; t++)
         {
-            short int  i2;
+            p_trc = buffer + t * trc_size;
+            memcpy (&trc_hdr, p_trc, sizeof (SegyTrcHdr));
+            if (segy_header->swap_bytes)
+            {
+                segy_swap_bytes (&trc_hdr,
+                                 (sizeof (trc_hdr_sizes)/sizeof (int)),
+                                 trc_hdr_sizes);
+            }
 
-            for (i = 0; i < n_samp; i++)
+/* Stop at the first trace of another length; leave it for the caller */
+
+            if (trc_hdr.n_samp != n_samp)
             {
-                fread (&i2, sizeof (i2), 1, file);
-                if (segy_header->swap_bytes) segy_swap2 (&i2);
-                trace->data[i] = i2;
+                fseek (file, -(n_got - t) * trc_size, SEEK_CUR);
+                done = 1;
+                break;
             }
-            break;
+
+            if (trc_hdrs != NULL) trc_hdrs[n_read] = trc_hdr;
+            segy_samples_decode (p_trc + sizeof (SegyTrcHdr), n_samp,
+                                 segy_header->bin_hdr->format,
+                                 segy_header->swap_bytes,
+                                 data + (long) n_read * n_samp);
+            n_read++;
         }
+        if (n_got < n_run) done = 1;
+    }
 
-        case SEGY_FORMAT_IEEE:
-        {
-            float      x4;
+    free (buffer);
 
-            for (i = 0; i < n_samp; i++)
+
+    return n_read;
+}
+
+
+
+extern void segy_decode_benchmark (int n_samp, int n_traces)
+{
+    static int     formats[] = { SEGY_FORMAT_IBM, SEGY_FORMAT_INT4,
+                                 SEGY_FORMAT_INT2, SEGY_FORMAT_IEEE,
+                                 SEGY_FORMAT_INT1 };
+    static const char *names[] = { "IBM", "INT4", "INT2", "IEEE", "INT1" };
+    int            f, i, t, samp_size, n_iter;
+    long           n_bytes;
+    double         t_beg, mb;
+    unsigned char  *raw;
+    float          *data;
+    SegyHeader     segy_header;
+    SegyBinHdr     bin_hdr;
+    SegyTrcHdr     trc_hdr;
+    FILE           *file;
+
+
+
+    n_iter  = 10;
+    n_bytes = (long) n_samp * n_traces * 4;
+    raw     = (unsigned char *) malloc (n_bytes);
+    data    = (float *) malloc ((long) n_samp * n_traces * sizeof (float));
+    if ((raw == NULL) || (data == NULL))
+    {
+        segy_error_msg ("couldn't allocate memory for benchmark");
+        free (raw);
+        free (data);
+        return;
+    }
+    srand (1);
+    for (i = 0; i < n_bytes; i++) raw[i] = (unsigned char) rand ();
+
+/* Kernel throughput, big-endian input as in the files */
+
+    for (f = 0; f < (int) (sizeof (formats)/sizeof (int)); f++)
+    {
+        samp_size = segy_sample_size (formats[f]);
+        t_beg     = segy_seconds ();
+        for (i = 0; i < n_iter; i++)
+        {
+            for (t = 0; t < n_traces; t++)
             {
-                fread (&x4, sizeof (x4), 1, file);
-                if (segy_header->swap_bytes) segy_swap4 (&x4);
-                trace->data[i] = x4;
+                segy_samples_decode (raw + (long) t * n_samp * samp_size,
+                                     n_samp, formats[f], 1,
+                                     data + (long) t * n_samp);
             }
-            break;
         }
+        mb = (double) n_samp * n_traces * samp_size * n_iter / (1024.0 * 1024.0);
+        printf ("SEG-Y decode %s: %.1f MB/s\n", names[f],
+                mb / (segy_seconds () - t_beg));
+    }
 
-        case SEGY_FORMAT_INT1:
+/* Trace reading from a (cached) file: one fread per sample as before,    */
+/* against one fread per run of traces                                     */
+
+    file = tmpfile ();
+    if (file != NULL)
+    {
+        memset (&trc_hdr, 0, sizeof (trc_hdr));
+        trc_hdr.n_samp = n_samp;
+        segy_swap2 (&trc_hdr.n_samp);
+        for (t = 0; t < n_traces; t++)
         {
-            char       i1;
+            fwrite (&trc_hdr, sizeof (trc_hdr), 1, file);
+            fwrite (raw + (long) t * n_samp * 4, 4, n_samp, file);
+        }
 
+        memset (&bin_hdr, 0, sizeof (bin_hdr));
+        bin_hdr.format         = SEGY_FORMAT_IBM;
+        segy_header.bin_hdr    = &bin_hdr;
+        segy_header.swap_bytes = 1;
+        mb = (double) n_traces * (sizeof (SegyTrcHdr) + n_samp * 4) / (1024.0 * 1024.0);
+
+        rewind (file);
+        t_beg = segy_seconds ();
+        for (t = 0; t < n_traces; t++)
+        {
+            unsigned int  u4;
+
+            fread (&trc_hdr, sizeof (trc_hdr), 1, file);
             for (i = 0; i < n_samp; i++)
             {
-                fread (&i1, sizeof (i1), 1, file);
-                trace->data[i] = i1;
+                fread (&u4, sizeof (u4), 1, file);
+                segy_swap4 (&u4);
+                data[(long) t * n_samp + i] = (float) u4;
             }
-            break;
         }
+        printf ("SEG-Y read per sample: %.1f MB/s\n",
+                mb / (segy_seconds () - t_beg));
 
-        default:
-        {
-            free (trace->data);
-            trace->data     = NULL;
-            trc_hdr->n_samp = 0;
-        }
+        rewind (file);
+        t_beg = segy_seconds ();
+        segy_traces_read_bulk (&segy_header, file, n_samp, n_traces, NULL, data);
+        printf ("SEG-Y read bulk: %.1f MB/s\n",
+                mb / (segy_seconds () - t_beg));
+
+        fclose (file);
     }
 
+    free (raw);
+    free (data);
 
-    return SEGY_OK;
+
+    return;
 }
 
 
@@ -926,8 +1317,11 @@ extern void segy_traces_destroy (SegyTrace **traces, int n_traces)
 
 extern int segy_traces_read (SegyData *segy_data, FILE *file)
 {
-    int         n_traces;
+    int         i, n_traces, n_bulk, n_samp, samp_size, max_traces;
+    long        pos, end;
+    float       *samples;
     SegyTrace   **traces, *p_trc;
+    SegyTrcHdr  trc_hdr, *trc_hdrs;
     SegyLink    beg_link, *cur_link;
 
 
@@ -936,10 +1330,67 @@ extern int segy_traces_read (SegyData *segy_data, FILE *file)
     {
         segy_traces_destroy (segy_data->traces, segy_data->n_traces);
     }
+    if (segy_data->samples != NULL) free (segy_data->samples);
     traces   = NULL;
+    samples  = NULL;
+    trc_hdrs = NULL;
     n_traces = 0;
+    n_bulk   = 0;
+    n_samp   = 0;
+
+/* Peek at the first trace to get the trace length, then read the run of */
+/* traces of that length in bulk into one contiguous sample array        */
+
+    samp_size = segy_sample_size (segy_data->header->bin_hdr->format);
+    if ((samp_size > 0) && (fread (&trc_hdr, sizeof (SegyTrcHdr), 1, file) == 1))
+    {
+        fseek (file, -(long) sizeof (SegyTrcHdr), SEEK_CUR);
+        if (segy_data->header->swap_bytes) segy_swap2 (&trc_hdr.n_samp);
+        n_samp = trc_hdr.n_samp;
+
+        pos = ftell (file);
+        fseek (file, 0, SEEK_END);
+        end = ftell (file);
+        fseek (file, pos, SEEK_SET);
+        max_traces = (n_samp > 0) ? (end - pos) /
+                     (long) (sizeof (SegyTrcHdr) + n_samp * samp_size) : 0;
+
+        if (max_traces > 0)
+        {
+            samples  = (float *) malloc ((long) max_traces * n_samp * sizeof (float));
+            trc_hdrs = (SegyTrcHdr *) malloc (max_traces * sizeof (SegyTrcHdr));
+            if ((samples != NULL) && (trc_hdrs != NULL))
+            {
+                n_bulk = segy_traces_read_bulk (segy_data->header, file, n_samp,
+                                                max_traces, trc_hdrs, samples);
+            }
+            if (n_bulk == 0)
+            {
+                free (samples);
+                samples = NULL;
+            }
+            else if (n_bulk < max_traces)
+            {
+                samples = (float *) realloc (samples,
+                                      (long) n_bulk * n_samp * sizeof (float));
+            }
+        }
+    }
 
     cur_link = &beg_link;
+    for (i = 0; i < n_bulk; i++)
+    {
+        p_trc              = segy_trace_create ();
+        p_trc->hdr         = trc_hdrs[i];
+        p_trc->data        = samples + (long) i * n_samp;
+        p_trc->shared_data = 1;
+        cur_link = segy_chain_set (cur_link, p_trc);
+        n_traces++;
+    }
+    free (trc_hdrs);
+
+/* Any traces of other lengths are read one at a time */
+
     while (1)
     {
         p_trc = segy_trace_create ();
@@ -965,6 +1416,7 @@ extern int segy_traces_read (SegyData *segy_data, FILE *file)
 
     segy_data->n_traces = n_traces;
     segy_data->traces   = traces;
+    segy_data->samples  = samples;
 
 
     return SEGY_OK;
@@ -998,6 +1450,7 @@ extern void segy_data_destroy (SegyData *segy_data)
 {
     segy_header_destroy (segy_data->header);
     segy_traces_destroy (segy_data->traces, segy_data->n_traces);
+    if (segy_data->samples != NULL) free (segy_data->samples);
     free (segy_data);
 
 
@@ -1012,7 +1465,10 @@ extern void segy_data_init (SegyData *segy_data)
 
     segy_header_init    (segy_data->header);
     segy_traces_destroy (segy_data->traces, segy_data->n_traces);
+    if (segy_data->samples != NULL) free (segy_data->samples);
     segy_data->n_traces = 0;
+    segy_data->traces   = NULL;
+    segy_data->samples  = NULL;
 
 
     return;
@@ -1083,3 +1539,432 @@ extern SegyData *segy_file_read (const char *file_name)
 
     return segy_data;
 }
+
+
+
+extern int segy_file_stream (const char *file_name, int max_traces,
+                             SegyTraceFunc trace_func, void *client)
+{
+    int         n_traces, n_read, n_samp, max_samp, t;
+    float       *data;
+    FILE        *file;
+    SegyHeader  *segy_header;
+    SegyTrcHdr  trc_hdrs[SEGY_BULK_TRACES];
+
+
+
+    if ((file = fopen (file_name, "r")) == NULL)
+    {
+        segy_error_msg ("could not open file +");
+        segy_error_msg (file_name);
+        return SEGY_ERROR;
+    }
+
+    segy_header = segy_header_create ();
+    if (segy_header_read (segy_header, file) != SEGY_OK)
+    {
+        segy_error_msg ("could not read file +");
+        segy_error_msg (file_name);
+        segy_header_destroy (segy_header);
+        fclose (file);
+        return SEGY_ERROR;
+    }
+
+/* Only one run of SEGY_BULK_TRACES traces is resident at a time */
+
+    n_traces = 0;
+    max_samp = 0;
+    data     = NULL;
+    while ((max_traces < 0) || (n_traces < max_traces))
+    {
+        if (fread (&trc_hdrs[0], sizeof (SegyTrcHdr), 1, file) != 1) break;
+        fseek (file, -(long) sizeof (SegyTrcHdr), SEEK_CUR);
+        if (segy_header->swap_bytes) segy_swap2 (&trc_hdrs[0].n_samp);
+        n_samp = trc_hdrs[0].n_samp;
+        if (n_samp <= 0) break;
+
+        if (n_samp > max_samp)
+        {
+            free (data);
+            max_samp = n_samp;
+            data     = (float *) malloc ((long) SEGY_BULK_TRACES * max_samp *
+                                         sizeof (float));
+            if (data == NULL)
+            {
+                segy_error_msg ("couldn't allocate memory for trace data");
+                break;
+            }
+        }
+
+        n_read = SEGY_BULK_TRACES;
+        if ((max_traces >= 0) && (n_read > max_traces - n_traces))
+        {
+            n_read = max_traces - n_traces;
+        }
+        n_read = segy_traces_read_bulk (segy_header, file, n_samp, n_read,
+                                        trc_hdrs, data);
+        if (n_read == 0) break;
+
+        for (t = 0; t < n_read; t++)
+        {
+            trace_func (&trc_hdrs[t], data + (long) t * n_samp, client);
+        }
+        n_traces += n_read;
+    }
+
+    free (data);
+    segy_header_destroy (segy_header);
+    fclose (file);
+
+
+    return n_traces;
+}
+
+
+
+/*****************************************************************************/
+/*                                                                           */
+/* Trace index functions                                                     */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+/* The index is cached next to the file as <file_name>.idx, in host byte   */
+/* order, and is rebuilt whenever the file's size or time stamp changes.   */
+
+#define SEGY_INDEX_MAGIC             "SEGYIDX1"
+
+typedef struct
+{
+    char        magic[8];
+    long        file_size;
+    long        file_mtime;
+    int         n_traces;
+
+} SegyIndexCacheHdr;
+
+
+
+static int segy_index_cache_read (SegyIndex *segy_index, const char *cache_name,
+                                  struct stat *file_stat)
+{
+    FILE               *file;
+    SegyIndexCacheHdr  cache_hdr;
+
+
+
+    if ((file = fopen (cache_name, "rb")) == NULL) return SEGY_ERROR;
+
+    if ((fread (&cache_hdr, sizeof (cache_hdr), 1, file) != 1)      ||
+        (memcmp (cache_hdr.magic, SEGY_INDEX_MAGIC, 8) != 0)        ||
+        (cache_hdr.file_size  != (long) file_stat->st_size)         ||
+        (cache_hdr.file_mtime != (long) file_stat->st_mtime)        ||
+        (cache_hdr.n_traces < 0))
+    {
+        fclose (file);
+        return SEGY_ERROR;
+    }
+
+    segy_index->n_traces = cache_hdr.n_traces;
+    segy_index->entries  = (SegyIndexEntry *)
+                           malloc ((cache_hdr.n_traces + 1) * sizeof (SegyIndexEntry));
+    if ((segy_index->entries == NULL) ||
+        ((int) fread (segy_index->entries, sizeof (SegyIndexEntry),
+                      cache_hdr.n_traces, file) != cache_hdr.n_traces))
+    {
+        free (segy_index->entries);
+        segy_index->entries  = NULL;
+        segy_index->n_traces = 0;
+        fclose (file);
+        return SEGY_ERROR;
+    }
+    fclose (file);
+
+
+    return SEGY_OK;
+}
+
+
+
+static void segy_index_cache_write (SegyIndex *segy_index, const char *cache_name,
+                                    struct stat *file_stat)
+{
+    FILE               *file;
+    SegyIndexCacheHdr  cache_hdr;
+
+
+
+/* Not being able to cache (read-only survey directory) is not an error */
+
+    if ((file = fopen (cache_name, "wb")) == NULL) return;
+
+    memset (&cache_hdr, 0, sizeof (cache_hdr));
+    memcpy (cache_hdr.magic, SEGY_INDEX_MAGIC, 8);
+    cache_hdr.file_size  = file_stat->st_size;
+    cache_hdr.file_mtime = file_stat->st_mtime;
+    cache_hdr.n_traces   = segy_index->n_traces;
+
+    if ((fwrite (&cache_hdr, sizeof (cache_hdr), 1, file) != 1) ||
+        ((int) fwrite (segy_index->entries, sizeof (SegyIndexEntry),
+                       segy_index->n_traces, file) != segy_index->n_traces))
+    {
+        fclose (file);
+        remove (cache_name);
+        return;
+    }
+    fclose (file);
+
+
+    return;
+}
+
+
+
+static int segy_index_build (SegyIndex *segy_index, long data_beg)
+{
+    int         n_traces, max_traces, samp_size;
+    long        offset;
+    SegyTrcHdr  trc_hdr;
+    static int  trc_hdr_sizes[] = { SEGY_TRC_HDR_SIZES };
+
+
+
+    samp_size = segy_sample_size (segy_index->header->bin_hdr->format);
+    if (samp_size == 0)
+    {
+        segy_error_msg ("unsupported sample format");
+        return SEGY_ERROR;
+    }
+
+    n_traces   = 0;
+    max_traces = 1024;
+    segy_index->entries = (SegyIndexEntry *)
+                          malloc (max_traces * sizeof (SegyIndexEntry));
+
+/* Hop from trace header to trace header through the mapping */
+
+    offset = data_beg;
+    while (offset + (long) sizeof (SegyTrcHdr) <= (long) segy_index->map_size)
+    {
+        memcpy (&trc_hdr, segy_index->map + offset, sizeof (SegyTrcHdr));
+        if (segy_index->header->swap_bytes)
+        {
+            segy_swap_bytes (&trc_hdr, (sizeof (trc_hdr_sizes)/sizeof (int)),
+                             trc_hdr_sizes);
+        }
+        if ((trc_hdr.n_samp <= 0) ||
+            (offset + (long) sizeof (SegyTrcHdr) + (long) trc_hdr.n_samp * samp_size >
+             (long) segy_index->map_size)) break;
+
+        if (n_traces == max_traces)
+        {
+            max_traces *= 2;
+            segy_index->entries = (SegyIndexEntry *)
+                realloc (segy_index->entries, max_traces * sizeof (SegyIndexEntry));
+        }
+        if (segy_index->entries == NULL)
+        {
+            segy_error_msg ("couldn't allocate memory for trace index");
+            return SEGY_ERROR;
+        }
+
+        if ((trc_hdr.pstk_inline_num != 0) || (trc_hdr.pstk_crline_num != 0))
+        {
+            segy_index->entries[n_traces].inline_num = trc_hdr.pstk_inline_num;
+            segy_index->entries[n_traces].crline_num = trc_hdr.pstk_crline_num;
+        }
+        else
+        {
+            segy_index->entries[n_traces].inline_num = 0;
+            segy_index->entries[n_traces].crline_num = n_traces;
+        }
+        segy_index->entries[n_traces].cdp    = trc_hdr.ens_num;
+        segy_index->entries[n_traces].n_samp = trc_hdr.n_samp;
+        segy_index->entries[n_traces].offset = offset;
+        n_traces++;
+
+        offset += sizeof (SegyTrcHdr) + (long) trc_hdr.n_samp * samp_size;
+    }
+    segy_index->n_traces = n_traces;
+
+
+    return SEGY_OK;
+}
+
+
+
+extern SegyIndex *segy_index_open (const char *file_name)
+{
+    int          i;
+    long         data_beg;
+    char         *cache_name;
+    FILE         *file;
+    struct stat  file_stat;
+    SegyIndex    *segy_index;
+    SegyIndexEntry  *entry;
+
+
+
+    if ((file = fopen (file_name, "r")) == NULL)
+    {
+        segy_error_msg ("could not open file +");
+        segy_error_msg (file_name);
+        return NULL;
+    }
+
+    segy_index = (SegyIndex *) calloc (1, sizeof (SegyIndex));
+    segy_index->fd     = -1;
+    segy_index->header = segy_header_create ();
+    if (segy_header_read (segy_index->header, file) != SEGY_OK)
+    {
+        segy_error_msg ("could not read file +");
+        segy_error_msg (file_name);
+        fclose (file);
+        segy_index_close (segy_index);
+        return NULL;
+    }
+    data_beg = ftell (file);
+    fclose (file);
+
+    segy_index->fd = open (file_name, O_RDONLY);
+    if ((segy_index->fd < 0) || (fstat (segy_index->fd, &file_stat) != 0))
+    {
+        segy_error_msg ("could not open file +");
+        segy_error_msg (file_name);
+        segy_index_close (segy_index);
+        return NULL;
+    }
+    segy_index->map_size = file_stat.st_size;
+    segy_index->map      = (unsigned char *) mmap (NULL, segy_index->map_size,
+                                                   PROT_READ, MAP_SHARED,
+                                                   segy_index->fd, 0);
+    if (segy_index->map == (unsigned char *) MAP_FAILED)
+    {
+        segy_error_msg ("could not map file +");
+        segy_error_msg (file_name);
+        segy_index->map = NULL;
+        segy_index_close (segy_index);
+        return NULL;
+    }
+
+    cache_name = (char *) malloc (strlen (file_name) + 5);
+    strcpy (cache_name, file_name);
+    strcat (cache_name, ".idx");
+    if (segy_index_cache_read (segy_index, cache_name, &file_stat) != SEGY_OK)
+    {
+        if (segy_index_build (segy_index, data_beg) != SEGY_OK)
+        {
+            free (cache_name);
+            segy_index_close (segy_index);
+            return NULL;
+        }
+        segy_index_cache_write (segy_index, cache_name, &file_stat);
+    }
+    free (cache_name);
+
+/* Extents of the survey, for callers that want everything */
+
+    for (i = 0; i < segy_index->n_traces; i++)
+    {
+        entry = &segy_index->entries[i];
+        if ((i == 0) || (entry->inline_num < segy_index->inline_min))
+            segy_index->inline_min = entry->inline_num;
+        if ((i == 0) || (entry->inline_num > segy_index->inline_max))
+            segy_index->inline_max = entry->inline_num;
+        if ((i == 0) || (entry->crline_num < segy_index->crline_min))
+            segy_index->crline_min = entry->crline_num;
+        if ((i == 0) || (entry->crline_num > segy_index->crline_max))
+            segy_index->crline_max = entry->crline_num;
+        if (entry->n_samp > segy_index->n_samp_max)
+            segy_index->n_samp_max = entry->n_samp;
+    }
+
+
+    return segy_index;
+}
+
+
+
+extern void segy_index_close (SegyIndex *segy_index)
+{
+    if (segy_index == NULL) return;
+
+    if (segy_index->map != NULL) munmap (segy_index->map, segy_index->map_size);
+    if (segy_index->fd >= 0) close (segy_index->fd);
+    free (segy_index->entries);
+    segy_header_destroy (segy_index->header);
+    free (segy_index);
+
+
+    return;
+}
+
+
+
+extern int segy_index_read_box (SegyIndex *segy_index,
+                                int inline_beg, int inline_end,
+                                int crline_beg, int crline_end,
+                                int samp_beg, int samp_end,
+                                SegyTraceFunc trace_func, void *client)
+{
+    int             i, n_read, n_samp, samp_size, format, swap_bytes;
+    float           *data;
+    unsigned char   *p_trc;
+    SegyTrcHdr      trc_hdr;
+    SegyIndexEntry  *entry;
+    static int      trc_hdr_sizes[] = { SEGY_TRC_HDR_SIZES };
+
+
+
+    if ((samp_beg < 0) || (samp_end < samp_beg)) return 0;
+
+    format     = segy_index->header->bin_hdr->format;
+    swap_bytes = segy_index->header->swap_bytes;
+    samp_size  = segy_sample_size (format);
+    data       = (float *) malloc ((samp_end - samp_beg + 1) * sizeof (float));
+    if (data == NULL)
+    {
+        segy_error_msg ("couldn't allocate memory for trace data");
+        return 0;
+    }
+
+/* All ranges are inclusive; only the pages of the traces inside the box */
+/* are ever touched.  The headers passed on carry the index keys and the */
+/* number of samples actually decoded.                                   */
+
+    n_read = 0;
+    for (i = 0; i < segy_index->n_traces; i++)
+    {
+        entry = &segy_index->entries[i];
+        if ((entry->inline_num < inline_beg) || (entry->inline_num > inline_end) ||
+            (entry->crline_num < crline_beg) || (entry->crline_num > crline_end))
+            continue;
+
+        n_samp = entry->n_samp;
+        if (n_samp > samp_end + 1) n_samp = samp_end + 1;
+        n_samp -= samp_beg;
+        if (n_samp <= 0) continue;
+
+        p_trc = segy_index->map + entry->offset;
+        memcpy (&trc_hdr, p_trc, sizeof (SegyTrcHdr));
+        if (swap_bytes)
+        {
+            segy_swap_bytes (&trc_hdr, (sizeof (trc_hdr_sizes)/sizeof (int)),
+                             trc_hdr_sizes);
+        }
+        trc_hdr.n_samp          = n_samp;
+        trc_hdr.pstk_inline_num = entry->inline_num;
+        trc_hdr.pstk_crline_num = entry->crline_num;
+
+        segy_samples_decode (p_trc + sizeof (SegyTrcHdr) + (long) samp_beg * samp_size,
+                             n_samp, format, swap_bytes, data);
+        trace_func (&trc_hdr, data, client);
+        n_read++;
+    }
+
+    free (data);
+
+
+    return n_read;
+}
@@ -326,6 +326,7 @@ typedef struct
 {
     SegyTrcHdr  hdr;
     float       *data;
+    char        shared_data;     /* data points into SegyData samples */
 
 } SegyTrace;
 
@@ -355,10 +356,47 @@ typedef struct
     SegyHeader  *header;
     int         n_traces;
     SegyTrace   **traces;
+    float       *samples;        /* one block for all bulk read traces */
 
 } SegyData;
 
 
+/****************************************************************************/
+/* Called for every trace of a streamed file                                */
+/****************************************************************************/
+
+typedef void (*SegyTraceFunc) (SegyTrcHdr *trc_hdr, float *data, void *client);
+
+
+/****************************************************************************/
+/* Random access to the traces of a memory mapped file                      */
+/****************************************************************************/
+
+typedef struct
+{
+    int         inline_num;       /* pstk_inline_num, or 0                  */
+    int         crline_num;       /* pstk_crline_num, or the trace ordinal  */
+    int         cdp;              /* ens_num                                */
+    int         n_samp;
+    long        offset;           /* of the trace header in the file        */
+
+} SegyIndexEntry;
+
+typedef struct
+{
+    SegyHeader      *header;
+    int             n_traces;
+    SegyIndexEntry  *entries;
+    int             inline_min, inline_max;
+    int             crline_min, crline_max;
+    int             n_samp_max;
+    int             fd;
+    unsigned char   *map;
+    size_t          map_size;
+
+} SegyIndex;
+
+
 /*****************************************************************************/
 /*                                                                           */
 /* Text Header and Extended Text Header functions                            */
@@ -405,6 +443,13 @@ extern void segy_trace_destroy (SegyTrace *trace);
 extern void segy_trace_init (SegyTrace *trace);
 extern int segy_trace_read (SegyTrace *trace, SegyHeader *segy_header,
                             FILE *file);
+extern int segy_sample_size (int format);
+extern int segy_samples_decode (const void *raw, int n_samp, int format,
+                                int swap_bytes, float *data);
+extern int segy_traces_read_bulk (SegyHeader *segy_header, FILE *file,
+                                  int n_samp, int max_traces,
+                                  SegyTrcHdr *trc_hdrs, float *data);
+extern void segy_decode_benchmark (int n_samp, int n_traces);
 extern void segy_traces_destroy (SegyTrace **traces, int n_traces);
 extern int segy_traces_read (SegyData *segy_data, FILE *file);
 
@@ -419,6 +464,22 @@ extern void segy_data_destroy (SegyData *segy_data);
 extern void segy_data_init (SegyData *segy_data);
 extern int segy_data_read (SegyData *segy_data, FILE *file);
 extern SegyData *segy_file_read (const char *file_name);
+extern int segy_file_stream (const char *file_name, int max_traces,
+                             SegyTraceFunc trace_func, void *client);
+
+/*****************************************************************************/
+/*                                                                           */
+/* Trace index functions                                                     */
+/*                                                                           */
+/*****************************************************************************/
+
+extern SegyIndex *segy_index_open (const char *file_name);
+extern void segy_index_close (SegyIndex *segy_index);
+extern int segy_index_read_box (SegyIndex *segy_index,
+                                int inline_beg, int inline_end,
+                                int crline_beg, int crline_end,
+                                int samp_beg, int samp_end,
+                                SegyTraceFunc trace_func, void *client);
 
 
 
@@ -175,6 +175,16 @@ void ShaderObject::getUniformiv(const char * name, GLint* values) {
 
 } // end getUniformiv()
 
+/*
+ * hasUniform - Whether the linked program kept the uniform variable; unlike the senders it prints no error.
+ *
+ * parameter name - const char *
+ * return - bool
+ */
+bool ShaderObject::hasUniform(const char * name) {
+	return glGetUniformLocationARB(shaderObject, name) != -1;
+} // end hasUniform()
+
 /*
  * link - Link the shader object.
  *
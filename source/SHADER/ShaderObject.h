@@ -22,6 +22,7 @@ public:
 	void getUniformfv(const char * name, GLfloat* values);
 	void getUniformiv(const char * name, GLint* values);
 	bool glslEnabled(void);
+	bool hasUniform(const char * name);
 	bool link(void);
 	bool sendUniform1f(const char * name, GLfloat value);
 	bool sendUniform2f(const char * name, GLfloat value0, GLfloat value1);
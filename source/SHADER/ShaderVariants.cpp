@@ -0,0 +1,70 @@
+/*
+ * ShaderVariants.cpp - Methods for ShaderVariants class.
+ *
+ * Author: Patrick O'Leary
+ * Created: October 19, 2026
+ * Copyright 2007. All rights reserved.
+ */
+#include <iostream>
+
+#include <SHADER/ShaderManager.h>
+#include <SHADER/ShaderObject.h>
+#include <SHADER/ShaderVariants.h>
+
+static const char* featureNames[NUMBER_OF_SHADING_FEATURES] = { "NORMAL_SHADING", "TONE_SHADING", "TOON_SHADING",
+		"BOUNDARY_SHADING", "SILHOUETTE_SHADING", "EDGE_SHADING", "GRADIENT_TEXTURE" };
+
+/*
+ * ShaderVariants - Constructor for ShaderVariants.
+ *
+ * parameter _shaderManager - ShaderManager* (owns the compiled variants)
+ * parameter _vertexMemory - const char*
+ * parameter _fragmentMemory - const char*
+ */
+ShaderVariants::ShaderVariants(ShaderManager* _shaderManager, const char* _vertexMemory, const char* _fragmentMemory) :
+	fragmentMemory(_fragmentMemory), shaderManager(_shaderManager), vertexMemory(_vertexMemory) {
+} // end ShaderVariants()
+
+/*
+ * ~ShaderVariants - Destructor for ShaderVariants.
+ */
+ShaderVariants::~ShaderVariants(void) {
+} // end ~ShaderVariants()
+
+/*
+ * getDefines - The preprocessor lines selecting features.
+ *
+ * parameter features - unsigned int
+ * return - std::string
+ */
+std::string ShaderVariants::getDefines(unsigned int features) {
+	std::string defines;
+	for (int i = 0; i < NUMBER_OF_SHADING_FEATURES; i++) {
+		if (features & (1 << i)) {
+			defines += "#define ";
+			defines += featureNames[i];
+			defines += "\n";
+		}
+	}
+	return defines;
+} // end getDefines()
+
+/*
+ * getShaderObject - Get the variant for features, compiling it on first use.
+ *
+ * A variant that fails to compile is remembered as 0 so it is not retried every frame.
+ *
+ * parameter features - unsigned int
+ * return - ShaderObject*
+ */
+ShaderObject* ShaderVariants::getShaderObject(unsigned int features) {
+	std::map<unsigned int, ShaderObject*>::iterator iterator = variants.find(features);
+	if (iterator != variants.end())
+		return iterator->second;
+	std::string fragmentSource = getDefines(features) + fragmentMemory;
+	ShaderObject* shaderObject = shaderManager->loadFromMemory(vertexMemory, fragmentSource.c_str());
+	if (shaderObject == 0)
+		std::cout << "Error: can't init shader variant " << features << "!\n";
+	variants[features] = shaderObject;
+	return shaderObject;
+} // end getShaderObject()
@@ -0,0 +1,50 @@
+/*
+ * ShaderVariants.h - Class for the specialized variants of one shader program.
+ *
+ * The fragment source guards every optional shading term, and the gradient texture lookup that
+ * replaces central differences, with #ifdef. A variant is
+ * compiled the first time its combination of terms is asked for, with a #define for
+ * each enabled term prepended, and is kept for the life of the GL context. Terms that
+ * are switched off are not in the variant at all, so they cost no fragment work.
+ *
+ * Author: Patrick O'Leary
+ * Created: October 19, 2026
+ * Copyright 2007. All rights reserved.
+ */
+#ifndef SHADERVARIANTS_H_
+#define SHADERVARIANTS_H_
+
+#include <map>
+#include <string>
+
+#define NORMAL_SHADING 0x01
+#define TONE_SHADING 0x02
+#define TOON_SHADING 0x04
+#define BOUNDARY_SHADING 0x08
+#define SILHOUETTE_SHADING 0x10
+#define EDGE_SHADING 0x20
+#define GRADIENT_TEXTURE 0x40
+#define NUMBER_OF_SHADING_FEATURES 7
+// The terms that read the light and the eye position; a variant without them has neither uniform
+#define LIGHT_SHADING (NORMAL_SHADING | TONE_SHADING | TOON_SHADING)
+#define VIEW_SHADING (NORMAL_SHADING | SILHOUETTE_SHADING | EDGE_SHADING)
+
+// begin Forward Declarations
+class ShaderManager;
+class ShaderObject;
+// end Forward Declarations
+
+class ShaderVariants {
+public:
+	ShaderVariants(ShaderManager* _shaderManager, const char* _vertexMemory, const char* _fragmentMemory);
+	~ShaderVariants(void);
+	static std::string getDefines(unsigned int features);
+	ShaderObject* getShaderObject(unsigned int features);
+private:
+	const char* fragmentMemory;
+	ShaderManager* shaderManager;
+	std::map<unsigned int, ShaderObject*> variants;
+	const char* vertexMemory;
+};
+
+#endif /*SHADERVARIANTS_H_*/
@@ -5,6 +5,7 @@
  * Created: October 21, 2007
  * Copyright: 2007 - 2008
  */
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <stdexcept>
@@ -13,9 +14,11 @@
 #include <GL/gl.h>
 
 /* Vrui includes */
+#include <Comm/MulticastPipe.h>
 #include <GL/GLContextData.h>
 #include <GLMotif/Button.h>
 #include <GLMotif/CascadeButton.h>
+#include <GLMotif/Label.h>
 #include <GLMotif/SubMenu.h>
 #include <GLMotif/WidgetManager.h>
 #include <Misc/ThrowStdErr.h>
@@ -35,7 +38,11 @@
 #include <ANALYSIS/MeasurementLocator.h>
 #include <ANALYSIS/PerspectiveTool.h>
 #include <COLORMAP/ColorMap.h>
+#include <DATA/CompressedVolume.h>
 #include <DATA/Volume.h>
+#include <GRAPHIC/Compositor.h>
+#include <GRAPHIC/Benchmark.h>
+#include <GRAPHIC/FrameGovernor.h>
 #include <GRAPHIC/Scene.h>
 #include <GUI/Animation.h>
 #include <GUI/DownSampling.h>
@@ -48,8 +55,12 @@
 #include <GUI/Slices.h>
 #include <GUI/TransferFunction1D.h>
 #include <GUI/TransferFunction2_5D.h>
+#include <IO/ClusterVolume.h>
 #include <IO/IOHelper.h>
+#include <IO/ProgressiveLoader.h>
+#include <IO/segy.h>
 #include <MATH/Vector4.h>
+#include <UTILITY/MemoryAccount.h>
 #include <UTILITY/Stringify.h>
 #include <UTILITY/StringTokenizer.h>
 
@@ -64,18 +75,22 @@
  */
 Toirt_Samhlaigh::Toirt_Samhlaigh(int& argc, char**& argv, char**& appDefaults) :
     Vrui::Application(argc, argv, appDefaults), alphaChanged(false), analysisTool(0), animating(false), animation(NULL),
-    baseLocators(0), blueScale(1.0), blueVolumeFile(NULL), clippingPlanes(0), colorMapChanged(true), creditInformation(false), downSampling(NULL),
-    firstFrame(true), focusAndContextPlanes(0), greenScale(1.0), greenVolumeFile(NULL), interactive(false),
+    baseLocators(0), benchmark(NULL), benchmarkFile(NULL), benchmarkReportFile("benchmark.json"),
+    benchmarkTimeStep(BENCHMARK_TIME_STEP), blueScale(1.0), blueVolumeFile(NULL), clippingPlanes(0), colorMapChanged(true), composite(false),
+    compositeHosts(NULL), compositePort(47000), compositor(NULL), compressVolume(false),
+    creditInformation(false), decodeBenchmark(false), distributeVolume(true), downSampling(NULL),
+    firstFrame(true), focusAndContextPlanes(0), frameGovernor(NULL), governorLogFile(NULL), greenScale(1.0), greenVolumeFile(NULL), interactive(false),
             lighting(NULL), materials(NULL),
             mainMenu(NULL), maximumPriorityQueueSize(0), maximumPriorityQueueSizeChanged(false), maximumPriorityQueueSizeDialog(
-                    NULL), maximumPriorityQueueSizeValue(NULL), maximumPriorityQueueTest(false), numberOfComponents(0),
-            priorityQueueTestToggle(NULL), ratioOfVisibilityTest(false), ratioOfVisibilityThreshold(1.0),
+                    NULL), maximumPriorityQueueSizeSlider(NULL), maximumPriorityQueueSizeValue(NULL), maximumPriorityQueueTest(false), memoryDialog(NULL), numberOfComponents(0),
+            previewScene(NULL), previewVolume(NULL), priorityQueueTestToggle(NULL), progressive(false), progressiveLoader(NULL),
+            ratioOfVisibilityTest(false), ratioOfVisibilityThreshold(1.0),
             ratioOfVisibilityThresholdDialog(NULL), ratioOfVisibilityThresholdValue(NULL), ratioTestToggle(NULL), redScale(1.0),
             redVolumeFile(NULL), renderingCost(0.2), renderingCostFunctionDialog(NULL), renderingCostFunctionTest(true),
             renderingCostFunctionTestToggle(NULL), renderingCostValue(NULL), rgbChanged(false), rgbTransferFunction1D(NULL),
-            secondFrame(false), scene(NULL), shading(NULL), showBricks(false), showOcNodes(false), showOutline(true),
+            secondFrame(false), scene(NULL), shading(NULL), showBricks(false), showMemoryDialog(false), showOcNodes(false), showOutline(true),
             showTransferFunction1DToggle(NULL), showTransferFunction2_5DToggle(NULL), showVolume(false),
-            sliceColorMapChanged(true), sliceFactorDialog(NULL), slices(NULL), sliceFactorValue(NULL), transferFunction1D(NULL),
+            sliceColorMapChanged(true), sliceFactorDialog(NULL), slices(NULL), sliceFactorValue(NULL), targetFrameRate(0.0), tileVolume(false), transferFunction1D(NULL),
             transferFunction2_5DChanged(false), transferFunction2_5D(NULL), typeOfComponents(0), volumeFile(NULL) {
     volume = new Volume;
     try {
@@ -97,6 +112,13 @@ Toirt_Samhlaigh::Toirt_Samhlaigh(int& argc, char**& argv, char**& appDefaults) :
  * ~Toirt_Samhlaigh - Destructor for Toirt_Samhlaigh class.
  */
 Toirt_Samhlaigh::~Toirt_Samhlaigh(void) {
+    // Wait for the background loading first, it works on the volume and the scene
+    if (progressiveLoader != NULL)
+        delete progressiveLoader;
+    if (previewScene != NULL)
+        delete previewScene;
+    if (previewVolume != NULL)
+        delete previewVolume;
     if (animation != NULL)
         delete animation;
     delete[] alpha;
@@ -107,6 +129,16 @@ Toirt_Samhlaigh::~Toirt_Samhlaigh(void) {
     delete[] colormap;
     if (downSampling != NULL)
         delete downSampling;
+    if (compositor != NULL)
+        delete compositor;
+    compositeHosts = NULL;
+    if (benchmark != NULL)
+        delete benchmark;
+    benchmarkFile = NULL;
+    benchmarkReportFile = NULL;
+    if (frameGovernor != NULL)
+        delete frameGovernor;
+    governorLogFile = NULL;
     delete[] sliceColormap;
     blueVolumeFile = NULL;
     greenVolumeFile = NULL;
@@ -124,6 +156,8 @@ Toirt_Samhlaigh::~Toirt_Samhlaigh(void) {
         delete materials;
     if (maximumPriorityQueueSizeDialog != NULL)
         delete maximumPriorityQueueSizeDialog;
+    if (memoryDialog != NULL)
+        delete memoryDialog;
     if (ratioOfVisibilityThresholdDialog != NULL)
         delete ratioOfVisibilityThresholdDialog;
     if (renderingCostFunctionDialog != NULL)
@@ -176,6 +210,24 @@ void Toirt_Samhlaigh::alphaChangedCallback(Misc::CallbackData* callBackData) {
     Vrui::requestUpdate();
 } // end alphaChangedCallback()
 
+/*
+ * applyQuality - Scale the level of detail by the quality level of the frame governor.
+ *
+ * The sample spacing grows as the quality drops; the node budget of the priority queue test,
+ * or the threshold of the ratio of visibility test, shrinks with it. The renderer can not
+ * tell these from the values the sliders set, which stay the full quality values.
+ */
+void Toirt_Samhlaigh::applyQuality(void) {
+    float quality = getQuality();
+    scene->setSliceFactor(volume->getSliceFactor() / quality);
+    if (maximumPriorityQueueTest) {
+        scene->setMaximumPriorityQueueSize(int(maximumPriorityQueueSize * quality));
+        maximumPriorityQueueSizeChanged = true;
+    } else if (ratioOfVisibilityTest) {
+        scene->setRatioOfVisibilityThreshold(ratioOfVisibilityThreshold * quality);
+    }
+} // end applyQuality()
+
 /*
  * assignCreditInformation - Assign Credit Information to VRindow
  */
@@ -236,13 +288,15 @@ void Toirt_Samhlaigh::blueChangedCallback(Misc::CallbackData* callBackData) {
  * d = log(s/c)/log(2)
  *
  * s is the maximum texture size and c is the maximum leaf
- * size.
+ * size. The node budget is shared by the octrees of all
+ * bricks, so n is multiplied by the number of bricks of the
+ * partition, regular or adaptive; 1 until it is partitioned.
  *
  * return - float
  */
 float Toirt_Samhlaigh::calculateNumberOfLeafNodesInOctree(void) {
     float result = float(pow(8, floor(log(double(volume->getTextureSize()) / double(volume->getLeafSize()) - 1.0f) / log(2))));
-    return result;
+    return result * float(std::max(1, scene->getNumberOfBricks()));
 }
 /*
  * centerDisplayCallback - Center the display for world coordinates of the volume.
@@ -719,7 +773,7 @@ GLMotif::PopupWindow* Toirt_Samhlaigh::createMaximumPriorityQueueSizeDialog(void
     maximumPriorityQueueSizeValue->setFieldWidth(6);
     maximumPriorityQueueSizeValue->setPrecision(0);
     maximumPriorityQueueSizeValue->setValue(0);
-    GLMotif::Slider * maximumPriorityQueueSizeSlider = new GLMotif::Slider("MaximumPriorityQueueSizeSlider", dialog,
+    maximumPriorityQueueSizeSlider = new GLMotif::Slider("MaximumPriorityQueueSizeSlider", dialog,
             GLMotif::Slider::HORIZONTAL, ss.fontHeight * 10.0f);
     maximumPriorityQueueSizeSlider->setValueRange(0, calculateNumberOfLeafNodesInOctree(), 1);
     maximumPriorityQueueSizeSlider->setValue(0);
@@ -728,6 +782,32 @@ GLMotif::PopupWindow* Toirt_Samhlaigh::createMaximumPriorityQueueSizeDialog(void
     return dialogPopup;
 }
 
+/*
+ * createMemoryDialog - Megabytes held by each subsystem, the host and the GL textures of every window.
+ *
+ * return - GLMotif::PopupWindow*
+ */
+GLMotif::PopupWindow* Toirt_Samhlaigh::createMemoryDialog(void) {
+    GLMotif::PopupWindow * dialogPopup = new GLMotif::PopupWindow("MemoryDialogPopup", Vrui::getWidgetManager(), "Memory (MB)");
+    GLMotif::RowColumn * dialog = new GLMotif::RowColumn("MemoryDialog", dialogPopup, false);
+    dialog->setNumMinorWidgets(2);
+    for (int i = 0; i < NUMBER_OF_MEMORY_SUBSYSTEMS + 2; i++) {
+        std::string name = "textures";
+        if (i < NUMBER_OF_MEMORY_SUBSYSTEMS)
+            name = MemoryAccount::getName(i);
+        else if (i == NUMBER_OF_MEMORY_SUBSYSTEMS)
+            name = "host";
+        new GLMotif::Label((name + "Label").c_str(), dialog, name.c_str());
+        GLMotif::TextField * memoryValue = new GLMotif::TextField((name + "Value").c_str(), dialog, 8);
+        memoryValue->setFieldWidth(8);
+        memoryValue->setPrecision(1);
+        memoryValue->setValue(0.0);
+        memoryValues.push_back(memoryValue);
+    } // end for
+    dialog->manageChild();
+    return dialogPopup;
+} // end createMemoryDialog()
+
 /*
  * createRatioOfVisibilityThresholdDialog
  *
@@ -824,6 +904,10 @@ GLMotif::Popup* Toirt_Samhlaigh::createSettingsSubMenu(void) {
             "Show Slice Factor Dialog");
     showSliceFactorDialogToggle->setToggle(false);
     showSliceFactorDialogToggle->getValueChangedCallbacks().add(this, &Toirt_Samhlaigh::menuToggleSelectCallback);
+    GLMotif::ToggleButton * showMemoryDialogToggle = new GLMotif::ToggleButton("ShowMemoryDialogToggle", settingsSubMenu,
+            "Show Memory Dialog");
+    showMemoryDialogToggle->setToggle(false);
+    showMemoryDialogToggle->getValueChangedCallbacks().add(this, &Toirt_Samhlaigh::menuToggleSelectCallback);
     settingsSubMenu->manageChild();
     return settingsSubMenuPopup;
 } // end createSettingsSubMenu()
@@ -875,7 +959,8 @@ void Toirt_Samhlaigh::display(GLContextData& glContextData) const {
             ++clippingPlaneIndex;
         }
     }
-    scene->display(glContextData); // draw the scene
+    Scene* shownScene = (previewScene != NULL) ? previewScene : scene;
+    shownScene->display(glContextData); // draw the scene
     clippingPlaneIndex = 0;
     for (int i = 0; i < numberOfClippingPlanes && clippingPlaneIndex < numberOfSupportedClippingPlanes; ++i) {
         if (clippingPlanes[i].isActive()) {
@@ -894,11 +979,11 @@ void Toirt_Samhlaigh::display(GLContextData& glContextData) const {
     for (int i = baseLocators.size() - 1; i > -1; --i) {
         PerspectiveTool* pt = dynamic_cast<PerspectiveTool*> (baseLocators[i]);
         if (pt) {
-            scene->clearSpheres();
-            scene->setPerspective(true);
+            shownScene->clearSpheres();
+            shownScene->setPerspective(true);
             if (pt->drawsphere) {
                 for (int x = 0; x < pt->Frames.size(); x++) {
-                    scene->setSphere(Geometry::invert(pt->Frames[x]).getOrigin());
+                    shownScene->setSphere(Geometry::invert(pt->Frames[x]).getOrigin());
                 }
             }
         }
@@ -913,10 +998,24 @@ void Toirt_Samhlaigh::frame(void) {
     	assignCreditInformation();
         firstFrame = false;
         secondFrame = true;
-        scene->initialize();
-        scene->setShowDisplay(true);
     } else if (secondFrame) {
+        // Every GL context has been initialized by now; brick the volume for all of them
         secondFrame = false;
+        Scene* shownScene = (previewScene != NULL) ? previewScene : scene;
+        shownScene->initialize();
+        if (shownScene == scene)
+            updateMaximumPriorityQueueSizeSlider();
+        shownScene->setShowDisplay(true);
+        shownScene->frame();
+    } else if (previewScene != NULL) {
+        // The transfer functions cannot be edited before the hand over, so the preview keeps its color maps
+        previewScene->setAlphaChanged(false);
+        previewScene->setColorMapChanged(false);
+        previewScene->setRGBChanged(false);
+        previewScene->setSliceColorMapChanged(false);
+        previewScene->frame();
+        if (progressiveLoader != NULL)
+            updatePreview();
     } else {
         if (downSamplingChanged) {
             scene->setDownSamplingChanged(downSamplingChanged);
@@ -958,15 +1057,42 @@ void Toirt_Samhlaigh::frame(void) {
         } else {
             scene->setSliceColorMapChanged(sliceColorMapChanged);
         }
+        if (frameGovernor != NULL && frameGovernor->update())
+            applyQuality();
         if (maximumPriorityQueueSizeChanged) {
             scene->setMaximumPriorityQueueSizeChanged(maximumPriorityQueueSizeChanged);
             maximumPriorityQueueSizeChanged = false;
         } else {
             scene->setMaximumPriorityQueueSizeChanged(maximumPriorityQueueSizeChanged);
         }
-        if (animating) {
+        if (benchmark != NULL) {
+            // Fly the path in fixed steps of path time, however long each frame takes
+            benchmark->endFrame();
+            if (animation->setPathTime(benchmark->getPathTime()))
+                benchmark->startFrame();
+            else {
+                if (Vrui::getNodeIndex() == 0) {
+                    try {
+                        MemoryAccount memoryAccount;
+                        scene->accountMemory(memoryAccount);
+                        benchmark->setMemoryAccount(memoryAccount);
+                        benchmark->writeReport();
+                    } catch (std::runtime_error e) {
+                        std::cerr << "Error: Exception " << e.what() << "!" << std::endl;
+                    }
+                }
+                scene->setBenchmark(NULL);
+                delete benchmark;
+                benchmark = NULL;
+                Vrui::shutdown();
+            }
+        } else if (animating) {
             animation->setCurrentNavigationTransformation();
         }
+        // Classify, sort and prepare color maps once here; every eye of every window only draws
+        scene->frame();
+        if (showMemoryDialog)
+            updateMemoryDialog();
     }
     // This requestUpdate() is necessary for the animation and for some unknown reason must be outside of the if statement
     requestUpdate();
@@ -1026,6 +1152,15 @@ int Toirt_Samhlaigh::getNumberOfFocusAndContextPlanes(void) {
     return numberOfFocusAndContextPlanes;
 } // end getNumberOfFocusAndContextPlanes()
 
+/*
+ * getQuality - Get the quality level of the frame governor, 1 without one.
+ *
+ * return - float
+ */
+float Toirt_Samhlaigh::getQuality(void) const {
+    return (frameGovernor != NULL) ? frameGovernor->getQuality() : 1.0f;
+} // end getQuality()
+
 /*
  * setSliceColorMapChanged
  *
@@ -1064,11 +1199,10 @@ void Toirt_Samhlaigh::greenChangedCallback(Misc::CallbackData* callBackData) {
 } // end greenChangedCallback()
 
 /*
- * initialize - Initialize the GUI portion of the application.
- *
- * parameter volumeFile - const char*& volumeFile
+ * loadVolume - Read the data set named on the command-line.
+ *     throws std::runtime_error for I/O problems
  */
-void Toirt_Samhlaigh::initialize(void) {
+void Toirt_Samhlaigh::loadVolume(void) {
     if (volumeFile != 0) {
         IOHelper::readVolume(volumeFile, volume);
     } else if (numberOfComponents != 0) {
@@ -1090,21 +1224,76 @@ void Toirt_Samhlaigh::initialize(void) {
     } else {
         IOHelper::readVolume("../data/C60.vol", volume);
     }
-    if (volume->getNumberOfComponents() == 0) {
-        alphaChanged = true;
-        rgbChanged = false;
-        transferFunction1D = new TransferFunction1D(*this, volume);
-        transferFunction1D->createTransferFunction1D(CINVERSE_RAINBOW, UP_RAMP, 0.0, 1.0);
-        transferFunction1D->getColorMapChangedCallbacks().add(this, &Toirt_Samhlaigh::colorMapChangedCallback);
-        transferFunction1D->getAlphaChangedCallbacks().add(this, &Toirt_Samhlaigh::alphaChangedCallback);
-        transferFunction1D->exportAlpha(colormap);
-        transferFunction1D->exportColorMap(colormap);
-        for (int i = 0; i < 256; i++) {
-            alpha[i] = float(colormap[4 * (i * 256 + i) + 3]) / 255.0f;
+} // end loadVolume()
+
+/*
+ * initialize - Initialize the GUI portion of the application.
+ *
+ * parameter volumeFile - const char*& volumeFile
+ */
+void Toirt_Samhlaigh::initialize(void) {
+    numberOfClippingPlanes = 6;
+    clippingPlanes = new ClippingPlane[numberOfClippingPlanes];
+    for (int i = 0; i < numberOfClippingPlanes; ++i) {
+        clippingPlanes[i].setAllocated(false);
+        clippingPlanes[i].setActive(false);
+    }
+    numberOfFocusAndContextPlanes = 1;
+    focusAndContextPlanes = new FocusAndContextPlane[numberOfFocusAndContextPlanes];
+    for (int i = 0; i < numberOfFocusAndContextPlanes; ++i) {
+        focusAndContextPlanes[i].setAllocated(false);
+        focusAndContextPlanes[i].setActive(false);
+    }
+    if (progressive && (volumeFile == 0 || Vrui::getNumNodes() > 1)) {
+        if (Vrui::getNodeIndex() == 0)
+            std::cout << "Progressive loading needs one scalar volume file on a single node, loading the whole volume" << std::endl;
+        progressive = false;
+    }
+    if (progressive) {
+        progressiveLoader = new ProgressiveLoader(volumeFile, volume, compressVolume, tileVolume);
+        previewVolume = progressiveLoader->readPreview();
+        // The preview histogram stands in for the one of the volume
+        createTransferFunction1D(previewVolume);
+        previewVolume->calculateGradient();
+        showVolume = true;
+        previewScene = new Scene(previewVolume, colormap, alpha, alpha2_5D, red, green, blue, sliceColormap);
+        previewScene->setShowVolume(showVolume);
+        Vrui::Point center = Geometry::mid(previewVolume->getMinimum(), previewVolume->getMaximum());
+        Vrui::Scalar radius = Geometry::dist(previewVolume->getMinimum(), previewVolume->getMaximum());
+        Vrui::setNavigationTransformation(center, radius);
+        progressiveLoader->startVolume();
+        return;
+    }
+    Comm::MulticastPipe* volumePipe = (distributeVolume) ? Vrui::openPipe() : NULL;
+    if (volumePipe != NULL && !Vrui::isMaster()) {
+        ClusterVolume clusterVolume(volumePipe);
+        try {
+            clusterVolume.receiveVolume(volume);
+        } catch (std::runtime_error e) {
+            delete volumePipe;
+            throw;
+        }
+    } else {
+        try {
+            loadVolume();
+        } catch (std::runtime_error e) {
+            if (volumePipe != NULL) {
+                ClusterVolume clusterVolume(volumePipe);
+                clusterVolume.sendFailure();
+                delete volumePipe;
+            }
+            throw;
         }
+        if (volumePipe != NULL) {
+            ClusterVolume clusterVolume(volumePipe);
+            clusterVolume.sendVolume(volume);
+        }
+    }
+    delete volumePipe;
+    volume->fitMemoryBudget();
+    if (volume->getNumberOfComponents() == 0) {
+        createTransferFunction1D(volume);
         volume->calculateGradient();
-        transferFunction2_5D = new TransferFunction2_5D(volume, *this);
-        transferFunction2_5D->getHistogramWidgetChangedCallbacks().add(this, &Toirt_Samhlaigh::colorMap2_5DChangedCallback);
     } else {
         alphaChanged = false;
         rgbChanged = true;
@@ -1122,7 +1311,50 @@ void Toirt_Samhlaigh::initialize(void) {
             blue[i] = blueScale * float(colormap[4 * (i * 256 + i) + 2]) / 255.0f;
         }
     }
+    if (compressVolume) {
+        volume->compress();
+        if (decodeBenchmark && Vrui::getNodeIndex() == 0) {
+            if (volume->getCompressedVoxels() != NULL)
+                volume->getCompressedVoxels()->benchmark(volume->getNumberOfDecodeThreads(), 10);
+            if (volume->getCompressedRedVoxels() != NULL)
+                volume->getCompressedRedVoxels()->benchmark(volume->getNumberOfDecodeThreads(), 10);
+            if (volume->getCompressedGreenVoxels() != NULL)
+                volume->getCompressedGreenVoxels()->benchmark(volume->getNumberOfDecodeThreads(), 10);
+            if (volume->getCompressedBlueVoxels() != NULL)
+                volume->getCompressedBlueVoxels()->benchmark(volume->getNumberOfDecodeThreads(), 10);
+        }
+    }
+    if (tileVolume)
+        volume->tile();
+    if (volume->getNumberOfComponents() != 0)
+        volume->interleave();
+    if (decodeBenchmark && Vrui::getNodeIndex() == 0)
+        segy_decode_benchmark(1500, 4096);
+    createInterface();
+}
+
+/*
+ * createInterface - Create the scene of the loaded volume and the GUI around it.
+ *
+ * With a preview the main menu waits for the hand over, and the view stays where it is.
+ */
+void Toirt_Samhlaigh::createInterface(void) {
+    if (volume->getNumberOfComponents() == 0) {
+        transferFunction2_5D = new TransferFunction2_5D(volume, *this);
+        transferFunction2_5D->getHistogramWidgetChangedCallbacks().add(this, &Toirt_Samhlaigh::colorMap2_5DChangedCallback);
+    }
     scene = new Scene(volume, colormap, alpha, alpha2_5D, red, green, blue, sliceColormap);
+    scene->setShowVolume(showVolume);
+    if (composite && Vrui::getNumNodes() > 1) {
+        compositor = new Compositor(Vrui::getNodeIndex(), Vrui::getNumNodes(), compositeHosts, compositePort);
+        compositor->connect();
+        scene->setCompositor(compositor);
+    }
+    if (targetFrameRate > 0.0) {
+        frameGovernor = new FrameGovernor(targetFrameRate);
+        if (governorLogFile != NULL && Vrui::getNodeIndex() == 0)
+            frameGovernor->setLogFile(governorLogFile);
+    }
     downSampling = new DownSampling(scene, *this, 4);
     float * extent = new float[3];
     extent[0] = volume->getExtent(0);
@@ -1140,27 +1372,42 @@ void Toirt_Samhlaigh::initialize(void) {
     slices->setSlicesColorMap(CINVERSE_RAINBOW, 0.0, 1.0);
     slices->exportSlicesColorMap(sliceColormap);
     scene->updateSliceColorMap(sliceColormap);
-    numberOfClippingPlanes = 6;
-    clippingPlanes = new ClippingPlane[numberOfClippingPlanes];
-    for (int i = 0; i < numberOfClippingPlanes; ++i) {
-        clippingPlanes[i].setAllocated(false);
-        clippingPlanes[i].setActive(false);
-    }
-    numberOfFocusAndContextPlanes = 1;
-    focusAndContextPlanes = new FocusAndContextPlane[numberOfFocusAndContextPlanes];
-    for (int i = 0; i < numberOfFocusAndContextPlanes; ++i) {
-        focusAndContextPlanes[i].setAllocated(false);
-        focusAndContextPlanes[i].setActive(false);
-    }
     mainMenu = createMainMenu();
-    Vrui::setMainMenu(mainMenu);
-    centerDisplayCallback(0);
+    if (previewScene == NULL) {
+        Vrui::setMainMenu(mainMenu);
+        centerDisplayCallback(0);
+    }
     animation = new Animation(*this, scene);
+    if (benchmarkFile != NULL) {
+        animation->loadKeyframes(benchmarkFile);
+        benchmark = new Benchmark(benchmarkReportFile, benchmarkTimeStep);
+        scene->setBenchmark(benchmark);
+    }
     sliceFactorDialog = createSliceFactorDialog();
+    memoryDialog = createMemoryDialog();
     maximumPriorityQueueSizeDialog = createMaximumPriorityQueueSizeDialog();
     ratioOfVisibilityThresholdDialog = createRatioOfVisibilityThresholdDialog();
     renderingCostFunctionDialog = createRenderingCostFunctionDialog();
-}
+} // end createInterface()
+
+/*
+ * createTransferFunction1D - Create the transfer function of a scalar volume and export its color map and alpha.
+ *
+ * parameter histogramVolume - Volume*
+ */
+void Toirt_Samhlaigh::createTransferFunction1D(Volume* histogramVolume) {
+    alphaChanged = true;
+    rgbChanged = false;
+    transferFunction1D = new TransferFunction1D(*this, histogramVolume);
+    transferFunction1D->createTransferFunction1D(CINVERSE_RAINBOW, UP_RAMP, 0.0, 1.0);
+    transferFunction1D->getColorMapChangedCallbacks().add(this, &Toirt_Samhlaigh::colorMapChangedCallback);
+    transferFunction1D->getAlphaChangedCallbacks().add(this, &Toirt_Samhlaigh::alphaChangedCallback);
+    transferFunction1D->exportAlpha(colormap);
+    transferFunction1D->exportColorMap(colormap);
+    for (int i = 0; i < 256; i++) {
+        alpha[i] = float(colormap[4 * (i * 256 + i) + 3]) / 255.0f;
+    }
+} // end createTransferFunction1D()
 
 /*
  * menuToggleSelectCallback - Adjust the program state based on which toggle button changed state.
@@ -1199,6 +1446,17 @@ void Toirt_Samhlaigh::menuToggleSelectCallback(GLMotif::ToggleButton::ValueChang
             /* Close the slice factor dialog: */
             Vrui::popdownPrimaryWidget(sliceFactorDialog);
         }
+    } else if (strcmp(callBackData->toggle->getName(), "ShowMemoryDialogToggle") == 0) {
+        showMemoryDialog = callBackData->set;
+        if (callBackData->set) {
+            /* Open the memory dialog at the same position as the main menu: */
+            updateMemoryDialog();
+            Vrui::getWidgetManager()->popupPrimaryWidget(memoryDialog, Vrui::getWidgetManager()->calcWidgetTransformation(
+                    mainMenu));
+        } else {
+            /* Close the memory dialog: */
+            Vrui::popdownPrimaryWidget(memoryDialog);
+        }
     } else if (strcmp(callBackData->toggle->getName(), "ShowRatioOfVisibilityThresholdDialogToggle") == 0) {
         if (callBackData->set) {
             /* Open the ratio of visibility threshold dialog at the same position as the main menu: */
@@ -1217,6 +1475,11 @@ void Toirt_Samhlaigh::menuToggleSelectCallback(GLMotif::ToggleButton::ValueChang
             /* Close the rendering cost function dialog: */
             Vrui::popdownPrimaryWidget(renderingCostFunctionDialog);
         }
+    } else if (strcmp(callBackData->toggle->getName(), "RenderingCostFunctionTestToggle") == 0 && callBackData->set
+            && volume->isTextureAtlas() && volume->getNumberOfComponents() == 0) {
+        // The texture atlas is drawn at full resolution whatever nodes the test selects
+        renderingCostFunctionTestToggle->setToggle(false);
+        std::cout << "The texture atlas renders at full resolution only, the rendering cost function test is not supported" << std::endl;
     } else if (strcmp(callBackData->toggle->getName(), "RenderingCostFunctionTestToggle") == 0) {
         renderingCostFunctionTestToggle->setToggle(callBackData->set);
         renderingCostFunctionTest = callBackData->set;
@@ -1237,9 +1500,14 @@ void Toirt_Samhlaigh::menuToggleSelectCallback(GLMotif::ToggleButton::ValueChang
         priorityQueueTestToggle->setToggle(false);
         renderingCostFunctionTestToggle->setToggle(!callBackData->set);
         scene->setRatioOfVisibilityTest(callBackData->set);
-        scene->setRatioOfVisibilityThreshold(ratioOfVisibilityThreshold);
+        scene->setRatioOfVisibilityThreshold(ratioOfVisibilityThreshold * getQuality());
         scene->setMaximumPriorityQueueTest(false);
         alphaChanged = true;
+    } else if (strcmp(callBackData->toggle->getName(), "PriorityQueueTestToggle") == 0 && callBackData->set
+            && volume->isTextureAtlas() && volume->getNumberOfComponents() == 0) {
+        // The texture atlas is drawn at full resolution whatever nodes the test selects
+        priorityQueueTestToggle->setToggle(false);
+        std::cout << "The texture atlas renders at full resolution only, the priority queue test is not supported" << std::endl;
     } else if (strcmp(callBackData->toggle->getName(), "PriorityQueueTestToggle") == 0) {
         priorityQueueTestToggle->setToggle(callBackData->set);
         ratioTestToggle->setToggle(!callBackData->set);
@@ -1248,7 +1516,7 @@ void Toirt_Samhlaigh::menuToggleSelectCallback(GLMotif::ToggleButton::ValueChang
         ratioOfVisibilityTest = !callBackData->set;
         renderingCostFunctionTest = false;
         scene->setMaximumPriorityQueueTest(callBackData->set);
-        scene->setMaximumPriorityQueueSize(maximumPriorityQueueSize);
+        scene->setMaximumPriorityQueueSize(int(maximumPriorityQueueSize * getQuality()));
         scene->setRatioOfVisibilityTest(!callBackData->set);
         scene->setRenderingCostFunctionTest(false);
         alphaChanged = true;
@@ -1356,12 +1624,18 @@ void Toirt_Samhlaigh::menuToggleSelectCallback(GLMotif::ToggleButton::ValueChang
  * return - const char* (Volume File Name)
  */
 void Toirt_Samhlaigh::processCommandLineArguments(int& argc, char**& argv) throw (std::runtime_error) {
+    const char* benchmarkTimeStepString = 0;
+    const char* compositePortString = 0;
+    const char* decodeThreadsString = 0;
     const char* leafSizeString = 0;
     const char* ratioOfVisibilityThresholdString = 0;
     const char* maximumPriorityQueueSizeString = 0;
+    const char* memoryBudgetString = 0;
+    const char* regionString = 0;
     const char* scaleString = 0;
     const char* sizeString = 0;
     const char* sliceFactorString = 0;
+    const char* targetFrameRateString = 0;
     const char* textureSizeString = 0;
     for (int i = 1; i < argc; ++i) {
         if (argv[i][0] == '-') {
@@ -1389,6 +1663,17 @@ void Toirt_Samhlaigh::processCommandLineArguments(int& argc, char**& argv) throw
                     volume->setSize(size);
                 } else
                     Misc::throwStdErr("Toirt_Samhlaigh::parseCommandLineArguments: Invalid volume size command-line syntax");
+            } else if (strcasecmp(argv[i] + 1, "region") == 0) {
+                ++i;
+                regionString = argv[i];
+                StringTokenizer stringTokenizer(regionString, ",");
+                int region[6];
+                if (stringTokenizer.getNumberOfTokens() == 6) {
+                    for (int j = 0; j < 6; j++)
+                        region[j] = stringTokenizer.nextIntToken();
+                    volume->setRegionOfInterest(region);
+                } else
+                    Misc::throwStdErr("Toirt_Samhlaigh::parseCommandLineArguments: Invalid region command-line syntax");
             } else if (strcasecmp(argv[i] + 1, "textureSize") == 0) {
                 ++i;
                 textureSizeString = argv[i];
@@ -1449,6 +1734,72 @@ void Toirt_Samhlaigh::processCommandLineArguments(int& argc, char**& argv) throw
                     volume->setSliceFactor(_sliceFactor);
                 } else
                     Misc::throwStdErr("Toirt_Samhlaigh::parseCommandLineArguments: Unrecognized slice factor command-line argument");
+            } else if (strcasecmp(argv[i] + 1, "benchmark") == 0) {
+                ++i;
+                benchmarkFile = argv[i];
+            } else if (strcasecmp(argv[i] + 1, "benchmarkReport") == 0) {
+                ++i;
+                benchmarkReportFile = argv[i];
+            } else if (strcasecmp(argv[i] + 1, "benchmarkTimeStep") == 0) {
+                ++i;
+                benchmarkTimeStepString = argv[i];
+                benchmarkTimeStep = Stringify::toFloat(benchmarkTimeStepString);
+                if (benchmarkTimeStep <= 0.0)
+                    Misc::throwStdErr("Toirt_Samhlaigh::parseCommandLineArguments: Unrecognized benchmark time step command-line argument");
+            } else if (strcasecmp(argv[i] + 1, "composite") == 0) {
+                composite = true;
+            } else if (strcasecmp(argv[i] + 1, "compositeHosts") == 0) {
+                ++i;
+                compositeHosts = argv[i];
+            } else if (strcasecmp(argv[i] + 1, "compositePort") == 0) {
+                ++i;
+                compositePortString = argv[i];
+                compositePort = Stringify::toInt(compositePortString);
+                if (compositePort <= 0)
+                    Misc::throwStdErr("Toirt_Samhlaigh::parseCommandLineArguments: Unrecognized composite port command-line argument");
+            } else if (strcasecmp(argv[i] + 1, "compress") == 0) {
+                compressVolume = true;
+            } else if (strcasecmp(argv[i] + 1, "decodeThreads") == 0) {
+                ++i;
+                decodeThreadsString = argv[i];
+                int _numberOfDecodeThreads = Stringify::toInt(decodeThreadsString);
+                if (_numberOfDecodeThreads > 0) {
+                    volume->setNumberOfDecodeThreads(_numberOfDecodeThreads);
+                } else
+                    Misc::throwStdErr("Toirt_Samhlaigh::parseCommandLineArguments: Unrecognized decode threads command-line argument");
+            } else if (strcasecmp(argv[i] + 1, "decodeBenchmark") == 0) {
+                decodeBenchmark = true;
+            } else if (strcasecmp(argv[i] + 1, "governorLog") == 0) {
+                ++i;
+                governorLogFile = argv[i];
+            } else if (strcasecmp(argv[i] + 1, "gradientTexture") == 0) {
+                volume->setGradientTexture(true);
+            } else if (strcasecmp(argv[i] + 1, "readOnEveryNode") == 0) {
+                distributeVolume = false;
+            } else if (strcasecmp(argv[i] + 1, "targetFrameRate") == 0) {
+                ++i;
+                targetFrameRateString = argv[i];
+                targetFrameRate = Stringify::toFloat(targetFrameRateString);
+                if (targetFrameRate <= 0.0)
+                    Misc::throwStdErr("Toirt_Samhlaigh::parseCommandLineArguments: Unrecognized target frame rate command-line argument");
+            } else if (strcasecmp(argv[i] + 1, "tile") == 0) {
+                tileVolume = true;
+            } else if (strcasecmp(argv[i] + 1, "textureAtlas") == 0) {
+                volume->setTextureAtlas(true);
+            } else if (strcasecmp(argv[i] + 1, "adaptiveBricks") == 0) {
+                volume->setAdaptiveBricks(true);
+            } else if (strcasecmp(argv[i] + 1, "progressive") == 0) {
+                progressive = true;
+            } else if (strcasecmp(argv[i] + 1, "illuminationCache") == 0) {
+                volume->setIlluminationCache(true);
+            } else if (strcasecmp(argv[i] + 1, "memoryBudget") == 0) {
+                ++i;
+                memoryBudgetString = argv[i];
+                int _memoryBudget = Stringify::toInt(memoryBudgetString);
+                if (_memoryBudget > 0)
+                    volume->setMemoryBudget(size_t(_memoryBudget) * 1048576);
+                else
+                    Misc::throwStdErr("Toirt_Samhlaigh::parseCommandLineArguments: Unrecognized memory budget command-line argument");
             } else if(strcasecmp(argv[i] + 1,"creditFile")==0) {
             	++i;
             	readCreditFile(argv[i]);
@@ -1458,6 +1809,12 @@ void Toirt_Samhlaigh::processCommandLineArguments(int& argc, char**& argv) throw
             Misc::throwStdErr("Toirt_Samhlaigh::parseCommandLineArguments: Unrecognized command-line argument");
         }
     }
+    // The texture atlas of a scalar volume is drawn at full resolution, so there is no level of detail to govern
+    if (volume->isTextureAtlas() && numberOfComponents == 0 && targetFrameRate > 0.0)
+        Misc::throwStdErr("Toirt_Samhlaigh::parseCommandLineArguments: -textureAtlas renders at full resolution only, -targetFrameRate is not supported with it");
+    // The frame governor follows the wall clock, so a benchmark would render different work on every run
+    if (benchmarkFile != NULL && targetFrameRate > 0.0)
+        Misc::throwStdErr("Toirt_Samhlaigh::parseCommandLineArguments: -benchmark renders a fixed workload, -targetFrameRate is not supported with it");
 }
 
 /*
@@ -1661,14 +2018,15 @@ void Toirt_Samhlaigh::showTransferFunction2_5DCallback(GLMotif::ToggleButton::Va
 void Toirt_Samhlaigh::sliderCallback(GLMotif::Slider::ValueChangedCallbackData* callBackData) {
     if (strcmp(callBackData->slider->getName(), "SliceFactorSlider") == 0) {
         sliceFactorValue->setValue(callBackData->value);
-        scene->setSliceFactor(callBackData->value);
+        volume->setSliceFactor(callBackData->value);
+        scene->setSliceFactor(callBackData->value / getQuality());
         Vrui::requestUpdate();
     }
     if (strcmp(callBackData->slider->getName(), "RatioOfVisibilityThresholdSlider") == 0) {
         ratioOfVisibilityThreshold = callBackData->value;
         ratioOfVisibilityThresholdValue->setValue(ratioOfVisibilityThreshold);
         if (ratioOfVisibilityTest) {
-            scene->setRatioOfVisibilityThreshold(ratioOfVisibilityThreshold);
+            scene->setRatioOfVisibilityThreshold(ratioOfVisibilityThreshold * getQuality());
         }
         Vrui::requestUpdate();
     }
@@ -1685,7 +2043,7 @@ void Toirt_Samhlaigh::sliderCallback(GLMotif::Slider::ValueChangedCallbackData*
         maximumPriorityQueueSize = int(callBackData->value);
         maximumPriorityQueueSizeValue->setValue(maximumPriorityQueueSize);
         if (!ratioOfVisibilityTest) {
-            scene->setMaximumPriorityQueueSize(int(maximumPriorityQueueSize));
+            scene->setMaximumPriorityQueueSize(int(maximumPriorityQueueSize * getQuality()));
             maximumPriorityQueueSizeChanged = true;
         }
         Vrui::requestUpdate();
@@ -1743,8 +2101,9 @@ void Toirt_Samhlaigh::toolDestructionCallback(Vrui::ToolManager::ToolDestruction
                 }
                 PerspectiveTool* perspectiveTool = dynamic_cast<PerspectiveTool*> (*blIt);
                 if (perspectiveTool) {
-                    scene->clearSpheres();
-                    scene->setPerspective(false);
+                    Scene* shownScene = (previewScene != NULL) ? previewScene : scene;
+                    shownScene->clearSpheres();
+                    shownScene->setPerspective(false);
                 }
                 /* Remove the locator: */
                 delete *blIt;
@@ -1755,6 +2114,83 @@ void Toirt_Samhlaigh::toolDestructionCallback(Vrui::ToolManager::ToolDestruction
     }
 } // end toolDestructionCallback()
 
+/*
+ * updateMaximumPriorityQueueSizeSlider - Fit the slider range to the bricks of the partition once it is known.
+ */
+void Toirt_Samhlaigh::updateMaximumPriorityQueueSizeSlider(void) {
+    if (maximumPriorityQueueSizeSlider != NULL)
+        maximumPriorityQueueSizeSlider->setValueRange(0, calculateNumberOfLeafNodesInOctree(), 1);
+} // end updateMaximumPriorityQueueSizeSlider()
+
+/*
+ * updateMemoryDialog - Account the memory of the scene into the memory dialog.
+ */
+void Toirt_Samhlaigh::updateMemoryDialog(void) {
+    MemoryAccount memoryAccount;
+    scene->accountMemory(memoryAccount);
+    for (int i = 0; i < NUMBER_OF_MEMORY_SUBSYSTEMS; i++)
+        memoryValues[i]->setValue(double(memoryAccount.getBytes(i)) / 1048576.0);
+    memoryValues[NUMBER_OF_MEMORY_SUBSYSTEMS]->setValue(double(memoryAccount.getHostBytes()) / 1048576.0);
+    memoryValues[NUMBER_OF_MEMORY_SUBSYSTEMS + 1]->setValue(double(memoryAccount.getTextureBytes()) / 1048576.0);
+} // end updateMemoryDialog()
+
+/*
+ * updatePreview - Take the next step of the background loading once the last one has finished.
+ *
+ * The loaded volume gets its scene and GUI first, and is bricked from the next frame on, once
+ * the GL contexts of the scene exist: the volume is partitioned in the background, the bricks
+ * are created here and their octrees are built in the background. The scene then replaces the
+ * preview at once; the bricks of the preview cover the whole volume, so they cannot be mixed
+ * with the bricks of the scene. If the background loading fails, the preview is dropped and
+ * the volume is loaded on the render thread as without progressive loading.
+ */
+void Toirt_Samhlaigh::updatePreview(void) {
+    if (progressiveLoader->isRunning())
+        return;
+    if (progressiveLoader->hasFailed()) {
+        // Only the volume is loaded before the scene exists, so the scene is still to be created
+        std::cerr << "Error: Exception " << progressiveLoader->getError() << "!" << std::endl;
+        std::cout << "Progressive loading failed, loading the whole volume" << std::endl;
+        delete progressiveLoader;
+        progressiveLoader = NULL;
+        delete previewScene;
+        previewScene = NULL;
+        loadVolume();
+        volume->fitMemoryBudget();
+        volume->calculateGradient();
+        if (compressVolume)
+            volume->compress();
+        if (tileVolume)
+            volume->tile();
+        // Without a preview the interface installs the main menu; the scene is bricked once its GL contexts exist
+        createInterface();
+        secondFrame = true;
+        return;
+    }
+    if (scene == NULL) {
+        createInterface();
+        return;
+    }
+    if (!progressiveLoader->isPartitioned()) {
+        progressiveLoader->startPartition(scene);
+        return;
+    }
+    if (!progressiveLoader->isBricked()) {
+        // The bricks are GL objects, so only the render thread creates them
+        scene->createBricks();
+        updateMaximumPriorityQueueSizeSlider();
+        progressiveLoader->startOcTrees();
+        return;
+    }
+    delete progressiveLoader;
+    progressiveLoader = NULL;
+    delete previewScene;
+    previewScene = NULL;
+    Vrui::setMainMenu(mainMenu);
+    scene->setShowDisplay(true);
+    scene->frame();
+} // end updatePreview()
+
 /*
  * main - The application main method.
  *
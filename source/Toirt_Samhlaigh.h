@@ -28,12 +28,16 @@
 // begin Forward Declarations
 class Animation;
 class BaseLocator;
+class Benchmark;
 class ClippingPlane;
+class Compositor;
 class DownSampling;
 class FeatureEnhancement;
 class FocusAndContextPlane;
+class FrameGovernor;
 class Lighting;
 class Materials;
+class ProgressiveLoader;
 class RGBTransferFunction1D;
 class Scene;
 class Shading;
@@ -90,17 +94,30 @@ private:
     bool animating;
     Animation * animation;
     BaseLocatorList baseLocators;
+    Benchmark* benchmark; // flies a keyframe path in fixed steps and reports the frame timings
+    const char* benchmarkFile;
+    const char* benchmarkReportFile;
+    double benchmarkTimeStep;
     float* blue;
     float blueScale;
     const char* blueVolumeFile;
     ClippingPlane * clippingPlanes;
     unsigned char* colormap;
     bool colorMapChanged;
+    bool composite;
+    const char* compositeHosts;
+    int compositePort;
+    Compositor* compositor;
+    bool compressVolume;
+    bool decodeBenchmark;
+    bool distributeVolume; // read the data set on the master node only and send it to the slaves
     DownSampling * downSampling;
     bool downSamplingChanged;
     FeatureEnhancement * featureEnhancement;
     bool firstFrame;
     FocusAndContextPlane * focusAndContextPlanes;
+    FrameGovernor* frameGovernor; // trades level of detail for frame time when a target frame rate is set
+    const char* governorLogFile;
     float* green;
     float greenScale;
     const char* greenVolumeFile;
@@ -113,10 +130,17 @@ private:
     bool maximumPriorityQueueSizeChanged;
     GLMotif::PopupWindow* maximumPriorityQueueSizeDialog;
     GLMotif::ToggleButton* priorityQueueTestToggle;
+    GLMotif::Slider* maximumPriorityQueueSizeSlider;
     GLMotif::TextField* maximumPriorityQueueSizeValue;
+    GLMotif::PopupWindow* memoryDialog;
+    std::vector<GLMotif::TextField*> memoryValues; // megabytes of each subsystem, then of the host and the textures
     int numberOfClippingPlanes;
     int numberOfComponents;
     int numberOfFocusAndContextPlanes;
+    Scene* previewScene; // drawn in place of the scene until the volume has been loaded and bricked
+    Volume* previewVolume;
+    bool progressive; // show a preview while the volume loads in the background
+    ProgressiveLoader* progressiveLoader;
     bool ratioOfVisibilityTest;
     float ratioOfVisibilityThreshold;
     GLMotif::PopupWindow* ratioOfVisibilityThresholdDialog;
@@ -137,6 +161,7 @@ private:
     Shading * shading;
     bool showBricks;
     bool showOcNodes;
+    bool showMemoryDialog;
     bool showOutline;
     bool showVolume;
     GLMotif::ToggleButton * showTransferFunction1DToggle;
@@ -146,12 +171,15 @@ private:
     bool sliceColorMapChanged;
     GLMotif::PopupWindow* sliceFactorDialog;
     GLMotif::TextField* sliceFactorValue;
+    bool tileVolume;
     TransferFunction1D * transferFunction1D;
     TransferFunction2_5D * transferFunction2_5D;
     bool transferFunction2_5DChanged;
+    double targetFrameRate;
     int typeOfComponents;
      Volume* volume;
     const char* volumeFile;
+    void applyQuality(void);
     void changeAnalysisToolsCallback(GLMotif::RadioBox::ValueChangedCallbackData* cbData);
     void createAlphaSubMenu(GLMotif::Menu* mainMenu);
     GLMotif::Popup* createAnalysisToolsSubMenu(void);
@@ -160,18 +188,26 @@ private:
     GLMotif::Popup* createComponentSubMenu(void);
     GLMotif::Popup* createGreenSubMenu(void);
     GLMotif::Popup* createGridSubMenu(void);
+    void createInterface(void);
     GLMotif::PopupMenu* createMainMenu(void);
     GLMotif::PopupWindow* createMaximumPriorityQueueSizeDialog(void);
+    GLMotif::PopupWindow* createMemoryDialog(void);
     GLMotif::PopupWindow* createMotionInterpolationDialog(void);
     GLMotif::PopupWindow* createRatioOfVisibilityThresholdDialog(void);
     GLMotif::Popup* createRedSubMenu(void);
     GLMotif::PopupWindow* createRenderingCostFunctionDialog(void);
     GLMotif::Popup* createSettingsSubMenu(void);
     GLMotif::PopupWindow* createSliceFactorDialog(void);
+    void createTransferFunction1D(Volume* histogramVolume);
+    float getQuality(void) const;
     void initialize(void);
+    void loadVolume(void);
     void processCommandLineArguments(int& argc, char**& argv) throw (std::runtime_error);
     virtual void toolCreationCallback(Vrui::ToolManager::ToolCreationCallbackData* cbData);
     virtual void toolDestructionCallback(Vrui::ToolManager::ToolDestructionCallbackData* cbData);
+    void updateMaximumPriorityQueueSizeSlider(void);
+    void updateMemoryDialog(void);
+    void updatePreview(void);
 
 	/* Credit Information - Elements and Methods */
 	bool creditInformation;
@@ -0,0 +1,112 @@
+/*
+ * MemoryAccount.cpp - Methods for MemoryAccount class.
+ *
+ * Author: Patrick O'Leary
+ * Created: October 19, 2026
+ * Copyright 2007. All rights reserved.
+ */
+#include <sstream>
+
+#include <UTILITY/MemoryAccount.h>
+
+static const char* names[NUMBER_OF_MEMORY_SUBSYSTEMS] = { "voxels", "sourceVoxels", "gradients", "octrees", "staging",
+        "illumination", "brickTextures", "atlasTexture" };
+
+/*
+ * MemoryAccount - Constructor for MemoryAccount class.
+ */
+MemoryAccount::MemoryAccount(void) {
+    for (int i = 0; i < NUMBER_OF_MEMORY_SUBSYSTEMS; i++)
+        bytes[i] = 0;
+} // end MemoryAccount()
+
+/*
+ * ~MemoryAccount - Destructor for MemoryAccount class.
+ */
+MemoryAccount::~MemoryAccount(void) {
+} // end ~MemoryAccount()
+
+/*
+ * add - Account bytes to a subsystem.
+ *
+ * parameter subsystem - int (MEMORY_VOXELS to MEMORY_ATLAS_TEXTURE)
+ * parameter _bytes - size_t
+ */
+void MemoryAccount::add(int subsystem, size_t _bytes) {
+    bytes[subsystem] += _bytes;
+} // end add()
+
+/*
+ * getBytes
+ *
+ * parameter subsystem - int
+ * return - size_t
+ */
+size_t MemoryAccount::getBytes(int subsystem) const {
+    return bytes[subsystem];
+} // end getBytes()
+
+/*
+ * getHostBytes - Bytes of all subsystems but the GL textures.
+ *
+ * return - size_t
+ */
+size_t MemoryAccount::getHostBytes(void) const {
+    size_t hostBytes = 0;
+    for (int i = 0; i < NUMBER_OF_MEMORY_SUBSYSTEMS; i++)
+        if (!isTexture(i))
+            hostBytes += bytes[i];
+    return hostBytes;
+} // end getHostBytes()
+
+/*
+ * getName - The name of a subsystem in the logs and the reports.
+ *
+ * parameter subsystem - int
+ * return - const char*
+ */
+const char* MemoryAccount::getName(int subsystem) {
+    return names[subsystem];
+} // end getName()
+
+/*
+ * getTextureBytes - Estimated bytes of the GL textures of all contexts.
+ *
+ * return - size_t
+ */
+size_t MemoryAccount::getTextureBytes(void) const {
+    size_t textureBytes = 0;
+    for (int i = 0; i < NUMBER_OF_MEMORY_SUBSYSTEMS; i++)
+        if (isTexture(i))
+            textureBytes += bytes[i];
+    return textureBytes;
+} // end getTextureBytes()
+
+/*
+ * isTexture - The subsystem is held by the GL contexts rather than the host.
+ *
+ * parameter subsystem - int
+ * return - bool
+ */
+bool MemoryAccount::isTexture(int subsystem) {
+    return subsystem == MEMORY_BRICK_TEXTURES || subsystem == MEMORY_ATLAS_TEXTURE;
+} // end isTexture()
+
+/*
+ * toString - One line of megabytes per subsystem for the logs.
+ *
+ * return - std::string
+ */
+std::string MemoryAccount::toString(void) const {
+    std::ostringstream o;
+    o << "Memory: host " << double(getHostBytes()) / 1048576.0 << " MB (";
+    for (int i = 0; i < NUMBER_OF_MEMORY_SUBSYSTEMS; i++) {
+        if (isTexture(i))
+            continue;
+        o << ((i == 0) ? "" : ", ") << names[i] << " " << double(bytes[i]) / 1048576.0;
+    } // end for
+    o << "), textures " << double(getTextureBytes()) / 1048576.0 << " MB (" << names[MEMORY_BRICK_TEXTURES] << " "
+            << double(bytes[MEMORY_BRICK_TEXTURES]) / 1048576.0 << ", " << names[MEMORY_ATLAS_TEXTURE] << " "
+            << double(bytes[MEMORY_ATLAS_TEXTURE]) / 1048576.0 << ")";
+    return o.str();
+} // end toString()
@@ -0,0 +1,46 @@
+/*
+ * MemoryAccount.h - Class for accounting the memory held by each subsystem.
+ *
+ * Every subsystem adds the bytes it currently holds under its own tag: the voxels of the
+ * volume, the float and int voxels they were converted from, the gradients, the pooled
+ * octree nodes and boxes, the brick texture staging, the baked illumination, and an
+ * estimate of the GL textures of the bricks and of the texture atlas. The GL estimate counts
+ * every GL context, at the bytes per texel the drivers store the internal formats with.
+ * Host memory is everything but the GL textures.
+ *
+ * Author: Patrick O'Leary
+ * Created: October 19, 2026
+ * Copyright 2007. All rights reserved.
+ */
+#ifndef MEMORYACCOUNT_H_
+#define MEMORYACCOUNT_H_
+
+#include <cstddef>
+#include <string>
+
+#define MEMORY_VOXELS 0
+#define MEMORY_SOURCE_VOXELS 1
+#define MEMORY_GRADIENTS 2
+#define MEMORY_OCTREES 3
+#define MEMORY_STAGING 4
+#define MEMORY_ILLUMINATION 5
+#define MEMORY_BRICK_TEXTURES 6
+#define MEMORY_ATLAS_TEXTURE 7
+#define NUMBER_OF_MEMORY_SUBSYSTEMS 8
+
+class MemoryAccount {
+public:
+    MemoryAccount(void);
+    ~MemoryAccount(void);
+    void add(int subsystem, size_t bytes);
+    size_t getBytes(int subsystem) const;
+    size_t getHostBytes(void) const;
+    static const char* getName(int subsystem);
+    size_t getTextureBytes(void) const;
+    static bool isTexture(int subsystem);
+    std::string toString(void) const;
+private:
+    size_t bytes[NUMBER_OF_MEMORY_SUBSYSTEMS];
+};
+
+#endif /*MEMORYACCOUNT_H_*/